@@ -0,0 +1,65 @@
+#!/bin/sh
+#
+# rxmqbnch.sh - time from a REXX script's start to its first put, with
+#               each run connecting for itself and then through rxmqbrkr
+#
+#   rxmqbnch.sh [runs] [QM] [queue]          (default 20 BNCH.QM BNCH.Q)
+#
+#   Builds librxmqn.so with the broker mode (RXMQ_BROKER) and rxmqbrkr in
+#   this directory, then runs RXMQBPUT.REX the given number of times each
+#   way and shows the mean and largest time to its first put.
+#
+#   Both are linked with RXMQMEM.c, the in-memory stand-in for the MQI,
+#   which takes RXMQMEM_CONN_US (default 20000) for an MQCONN(X) and
+#   RXMQMEM_OPEN_US (default 1000) for an MQOPEN. Set MQ_LIBS (for example
+#   "-L/opt/mqm/lib64 -lmqm") to link the MQ library instead.
+#
+#   MQ_INC      MQ headers               (default /opt/mqm/inc)
+#   REXX        REXX interpreter         (default rexx)
+#   REXX_CFLAGS to compile with its rexx.h, and REXX_LIBS to link with it
+#
+
+RUNS=${1:-20}
+QM=${2:-BNCH.QM}
+Q=${3:-BNCH.Q}
+SRC=../../src
+MQ_INC=${MQ_INC:-/opt/mqm/inc}
+REXX=${REXX:-rexx}
+MQ_OBJS=${MQ_LIBS:-$SRC/RXMQMEM.c}
+RXMQMEM_CONN_US=${RXMQMEM_CONN_US:-20000}
+RXMQMEM_OPEN_US=${RXMQMEM_OPEN_US:-1000}
+SOCK=/tmp/rxmqbnch.$$.sock
+export RXMQMEM_CONN_US RXMQMEM_OPEN_US
+
+cc -O2 -fPIC -shared -D_RXMQN -DRXMQ_BROKER -I$MQ_INC $REXX_CFLAGS \
+   $SRC/MA95.c $MQ_OBJS $REXX_LIBS -lpthread -o librxmqn.so || exit 1
+cc -O2 -I$MQ_INC $SRC/RXMQBRKR.c $MQ_OBJS -lpthread -o rxmqbrkr || exit 1
+
+LD_LIBRARY_PATH=.:$LD_LIBRARY_PATH ; export LD_LIBRARY_PATH
+LIBPATH=.:$LIBPATH                 ; export LIBPATH
+
+# run - RXMQBPUT.REX $RUNS times, showing the mean and largest times
+run ( ) {
+  i=0
+  while [ $i -lt $RUNS ]
+  do
+    $REXX RXMQBPUT.REX $QM $Q
+    i=`expr $i + 1`
+  done | awk -v what="$1" '
+    /^FIRSTPUT/ { n++ ; t += $2 ; if ($2 > m) m = $2 }
+    /^FAILED/   { print what ": " $0 ; bad++ }
+    END         { if (n) printf("%-26s %3d runs  mean %8.2f ms  max %8.2f ms\n", what, n, t*1000/n, m*1000) }'
+}
+
+unset RXMQBROKER
+run "Connecting each run"
+
+./rxmqbrkr -s $SOCK -c $QM -o $Q > rxmqbrkr.out 2>&1 &
+BRKR=$!
+sleep 1
+RXMQBROKER=$SOCK ; export RXMQBROKER
+run "Through rxmqbrkr"
+kill -TERM $BRKR
+wait $BRKR
+cat rxmqbrkr.out
+rm -f rxmqbrkr.out
@@ -7,8 +7,6 @@
 //
 //      INQ and SET only take a single attribute.
 //
-//      MQCONNX not implemented
-//
 //      MQBEGIN not implemented
 //
 // The MQ API is extended in several ways:
@@ -23,10 +21,17 @@
 //
 //      * Output areas contain .ZLIST which contains a list of all the
 //            components within the output stem (without the dot)
+//            An output area may be followed by the components wanted
+//            ('OMD. MSGID CID'), when .ZLIST is only set if ZLIST is
+//            listed, or omitted altogether to return nothing
 //
 //      * A Browse function is provided which just returns the
 //            message data
 //
+//      * Message data may be given and returned as plain strings
+//            (RXMQPUTD, RXMQGETD, RXMQBRWD) instead of via stem.0
+//            and stem.1, the outcome then being in RXMQ.LASTxx
+//
 //      * A Header Extraction function will interprete Dead Letter
 //           and Transmission Headers from suitable messages
 //
@@ -36,6 +41,100 @@
 //
 //      * Function to only set up MQ Constants
 //
+//      * Any number of queues and subscriptions may be open at once;
+//            the handle of a closed object is not valid again, even
+//            once its slot is reused
+//
+//      * RXMQCONNX (RXMQCONX on z/OS) connects with MQCNO options, such
+//            as fastpath binding or handle sharing, and optionally a
+//            client channel definition; it can also make read ahead the
+//            default for the input opens on that connection
+//
+//      * Several connections may be held at once: RXMQCONN and RXMQCONNX
+//            set a connection id when given a variable for it, which
+//            RXMQOPEN, RXMQPUT1, RXMQSUB, RXMQCMIT, RXMQBACK and
+//            RXMQDISC take as an optional last parameter. Object
+//            handles belong to the connection they were opened on
+//
+//      * RXMQSESS holds named connections, and queues opened on them,
+//            for the whole process, so that any thread may attach to
+//            one rather than do its own MQCONN and MQOPENs; RXMQINIT
+//            may open them from a list in RXMQ.SESSION.
+//
+//      * RXMQCACH keeps closed queue handles open for reuse by a later
+//            RXMQOPEN or RXMQPUT1 of the same queue (opt-in)
+//
+//      * RXMQAUTO sets a connection's auto-commit policy, under which
+//            syncpoint puts and gets are committed by MA95 after a
+//            number of messages, bytes or milliseconds, with the time
+//            spent committing counted in RXMQ.COMMIT.xxx
+//
+//      * RXMQGETN (and RXMQBRWN to browse) takes up to a given number
+//            of messages in one call, into data.1 to data.n (or packed
+//            into data.PACK) and optionally mdstem.i.xxx, stopping
+//            early at a byte budget, a deadline or an empty queue
+//
+//      * RXMQPUTN puts data.1 to data.n in one call, optionally as a
+//            logical group, with per message MD overrides from
+//            mdstem.i.xxx, committing every k messages, and sets the
+//            reason code of each message in a stem
+//
+//      * RXMQCOPY copies or moves messages from one queue to another,
+//            in batches under syncpoint and optionally filtered on MD
+//            fields, the data never passing through REXX variables.
+//
+//      * Distribution lists may be opened from .OR.i object records in
+//            the input OD, and put to with per-queue .PMR.i records,
+//            the response for each queue being set in .RR.i
+//
+//      * RXMQREQ puts a request and waits for its reply, or leaves it in
+//            flight for RXMQRPLY to take the replies of many; the reply
+//            queues are temporary dynamic queues kept per connection,
+//            and replies are matched to requests by CorrelId
+//
+//      * Puts made with MQPMO_ASYNC_RESPONSE are counted per connection,
+//            and RXMQSTAT sets how many worked or failed (MQSTAT), as
+//            do RXMQCMIT and RXMQDISC, in RXMQ.STAT.xxx, when any were
+//            made since the last check
+//
+//      * RXMQASYN has queues consumed asynchronously (MQCB and MQCTL),
+//            the messages being held in a bounded ring per queue until
+//            RXMQPOLL takes them, the consumer being suspended while
+//            its ring is full. A message is only removed from its queue
+//            once it has a slot, and those left in a ring when its
+//            queue stops being consumed are counted in the return code.
+//
+//      * RXMQWANY waits on a list of queues being consumed until any
+//            has a message, taking from those that have in a weighted
+//            fair rotation, with nothing polled
+//
+//      * RXMQSUBM hands a put, get or request to a pool of worker
+//            threads, each with connections of its own, returning a
+//            ticket that RXMQWAIT waits on, so a script may have several
+//            MQ calls in progress at once; puts with the same key are
+//            done in order (on Windows the pool needs Vista or later)
+//
+//      * RXMQFAN puts a message to a list of queues on several queue
+//            managers at once, through the worker pool, setting each
+//            put's reason code and time, so a broadcast takes as long
+//            as its slowest queue manager rather than all of them
+//
+//      * On AIX and Linux, built with RXMQ_BROKER and run with RXMQBROKER
+//            set, the connections are made through the rxmqbrkr broker
+//            (RXMQBRKR.c), which keeps MQ connections and open queues
+//            from one script to the next, so that a short script need
+//            not wait for its own MQCONN and MQOPENs (see Broker mode)
+//
+//      * RXMQGET and RXMQGETD size their own buffer when data.0 (or the
+//            maximum length) is 0, from recent message sizes on that
+//            handle, retrying internally if a message is bigger
+//
+//      * Descriptors (MD, PMO, GMO, OD, SD) may be compiled once by
+//            RXMQDEF into a template, whose token ('&n') is then given
+//            instead of an input stem name, optionally followed by a
+//            stem and the mnemonics to override for this call only:
+//                 '&3'   or   '&3 OVR.'   or   '&3 OVR. CID PRI'
+//
 //
 //   In order to use this Rexx/MQ Interface, initialization function
 //        must be called before usage.
@@ -97,6 +196,12 @@
 //          RXMQ.LASTOP     -> current operation RXMQ function
 //          RXMQ.LASTMSG    -> current operation Return String
 //
+//   A thread may use RXMQRETM to cut this down: 'NEW' sets only the
+//      RXMQ.LASTxx variables, and 'NUMERIC' sets none of them, the
+//      Return String then being just the first three words ('FULL'
+//      going back to the above). RXMQGETD and RXMQBRWD, whose result
+//      is the message, still set RXMQ.LASTxx under 'NUMERIC'.
+//
 //   As a nice little bonus, there are also defined lots of variables
 //        called RXMQ.RCMAP.nn , where nn is a MQAC number, whose
 //        value is the name of the Reason Code (MQRC_ERROR_THING).
@@ -112,7 +217,9 @@
 //
 //   Tracing MAY be enabled (if this module has been compiled with
 //        the relevant setting of the TRACE macro) by setting
-//        values into a Rexx Variable call RXMQTRACE. The settings are:
+//        values into a Rexx Variable call RXMQTRACE, or by giving them
+//        to RXMQTRAC, after which the variable is no longer looked at
+//        by that thread. The settings are:
 //
 //                              CONN  -> mqconn
 //                              DISC  -> mqdisc
@@ -133,6 +240,12 @@
 //                              TM    -> Trigger message extension
 //                              COM   -> Command interface
 //                              MQV   -> Debug a RXMQV
+//                              DEF   -> Descriptor templates
+//                              CACHE -> Open handle cache
+//                              SESS  -> Shared sessions
+//                              ASYNC -> Asynchronous consume
+//                              REQ   -> Request/reply
+//                              WORK  -> Worker pool
 //
 //                              INIT  -> initialization processing
 //                              TERM  -> Deregistration processing
@@ -151,13 +264,32 @@
 //
 // Standard Header file includes
 //
+// Windows needs Vista or later, for the worker pool's condition variables
+//   and GetTickCount64, so say so before any header settles _WIN32_WINNT
+//
+#if defined(_WIN32) && (!defined(_WIN32_WINNT) || (_WIN32_WINNT < 0x0600))
+ #undef  _WIN32_WINNT
+ #define _WIN32_WINNT 0x0600
+#endif
  #include <string.h>
  #include <stdlib.h>
+ #include <stddef.h>
  #include <stdio.h>
  #include <ctype.h>
 #define __USE_MINGW_ANSI_STDIO 1
  #include <inttypes.h>
  #include <errno.h>
+#ifndef __MVS__
+ #ifdef _WIN32
+ #include <windows.h>
+ #else
+ #include <pthread.h>
+ #endif
+#endif
+#ifndef _WIN32
+ #include <sys/time.h>
+ #include <time.h>
+#endif
 
 // Required for Win MINGW only
 #define _int64 __int64
@@ -178,6 +310,704 @@
 
 #include <cmqc.h>
 #include <cmqcfc.h>
+#include <cmqxc.h>
+
+//
+// Broker mode (AIX and Linux, built with RXMQ_BROKER defined)
+//
+//   When RXMQBROKER is set in the environment as the first connection
+//   is made (to the path of the broker's socket, or empty for the
+//   default, BRK_SOCKET), every MQ connection of the process is made
+//   through the rxmqbrkr connection broker (see RXMQBRKR.h), and the MQ
+//   calls on it are done there. The broker keeps its connections, and
+//   the queues opened on them, from one script to the next, so a short
+//   script does not wait for an MQCONN or MQOPEN of its own.
+//
+//   The MQ calls below are redefined to the brk_ ones, which call MQ
+//   themselves when not in broker mode. A connection handle is then one
+//   of the process's sockets to the broker (its number + 1), and an
+//   object handle is the broker's. MQCONN, MQCONNX, MQDISC, MQOPEN,
+//   MQCLOSE, MQPUT, MQPUT1, MQGET, MQINQ, MQCMIT and MQBACK are sent to
+//   the broker; MQCB, MQCTL, MQSUB, MQSET and MQSTAT, distribution lists,
+//   object and selection strings, and the TLS, security or CCDT settings
+//   of MQCONNX fail with MQRC_FUNCTION_NOT_SUPPORTED. A broker that cannot be
+//   reached fails MQCONN(X) with MQRC_Q_MGR_NOT_AVAILABLE, and one lost
+//   later fails any call with MQRC_CONNECTION_BROKEN.
+//
+#if defined(RXMQ_BROKER) && !defined(_WIN32) && !defined(__MVS__)
+ #include <sys/socket.h>
+ #include <sys/uio.h>
+ #include <sys/un.h>
+ #include "RXMQBRKR.h"
+
+ #define BRKCONNS  256    // Broker connections of a process
+
+ typedef struct _RXMQBRKC {
+     int        fd                           ; // Socket to the broker (-1 lost)
+     MQLONG     inuse                        ; // Slot in use
+     pthread_mutex_t lock                    ; // One call at a time on it
+ } RXMQBRKC;
+
+ static RXMQBRKC        brk_conns[BRKCONNS]  ;  // Connections (MQHCONN n+1)
+ static pthread_mutex_t brk_lock = PTHREAD_MUTEX_INITIALIZER ; // Guards inuse
+ static pthread_once_t  brk_once = PTHREAD_ONCE_INIT ;         // brk_setup done
+ static const char    * brk_path = NULL      ;  // Socket (NULL, not broker mode)
+
+//
+// brk_setup - see whether the process is in broker mode (once)
+//
+static void brk_setup ( void )
+{
+ const char            * path = getenv("RXMQBROKER") ;  // Broker socket
+ int                     i                ;  // Looper
+
+ for ( i = 0 ; i < BRKCONNS ; i++ )
+   {
+    brk_conns[i].fd = -1                         ;
+    pthread_mutex_init(&brk_conns[i].lock, NULL) ;
+   }
+ if ( path != NULL ) brk_path = ( *path != '\0' ) ? path : BRK_SOCKET ;
+
+ return ;
+} // End of brk_setup
+
+static int brk_on ( void )
+{
+ pthread_once(&brk_once, brk_setup) ;
+ return ( brk_path != NULL ) ;
+} // End of brk_on
+
+//
+// brk_get - the connection of a handle, locked, or NULL (the CC and RC
+//           set) if it is not one or has been lost
+//
+static RXMQBRKC * brk_get ( MQHCONN    hconn        // Connection handle
+                          , PMQLONG    cc           // MQ CC
+                          , PMQLONG    rc           // MQ RC
+                          )
+{
+ RXMQBRKC              * c                ;  // The connection
+
+ *cc = MQCC_FAILED ;
+ if ( (hconn < 1) || (hconn > BRKCONNS) || !brk_conns[hconn-1].inuse )
+   {
+    *rc = MQRC_HCONN_ERROR ;
+    return NULL            ;
+   }
+ c = &brk_conns[hconn-1]   ;
+ pthread_mutex_lock(&c->lock) ;
+ if ( c->fd < 0 )
+   {
+    pthread_mutex_unlock(&c->lock) ;
+    *rc = MQRC_CONNECTION_BROKEN   ;
+    return NULL                    ;
+   }
+
+ return c ;
+} // End of brk_get
+
+//
+// brk_call - send a request on a connection (locked by the caller) and
+//            read the reply into the parts given, the rest of it into
+//            rest (up to *restlen, which is set to its length). The
+//            connection is lost if that fails.
+//
+static void brk_call ( RXMQBRKC * c            // The connection
+                     , uint32_t   op           // BRK_xxx
+                     , struct iovec * in       // Request body
+                     , int        nin          //   parts
+                     , struct iovec * out      // Reply body
+                     , int        nout         //   parts
+                     , void     * rest         // Rest of reply (or NULL)
+                     , MQLONG   * restlen      //   its length
+                     , PMQLONG    cc           // MQ CC
+                     , PMQLONG    rc           // MQ RC
+                     )
+{
+ struct iovec            iov[8]           ;  // Header and body
+ RXMQBRKQ                q                ;  // Request header
+ RXMQBRKA                a                ;  // Reply header
+ size_t                  fixed = 0        ;  // Reply parts length
+ int                     ok               ;  // Not lost
+ int                     i                ;  // Looper
+
+ q.op     = op ;
+ q.length = 0  ;
+ iov[0].iov_base = &q         ;
+ iov[0].iov_len  = sizeof(q)  ;
+ for ( i = 0 ; i < nin ; i++ )
+   {
+    q.length  += (uint32_t) in[i].iov_len ;
+    iov[i+1]   = in[i]                    ;
+   }
+ for ( i = 0 ; i < nout ; i++ ) fixed += out[i].iov_len ;
+
+ ok = ( brk_writev(c->fd, iov, nin + 1) == 0 )
+   && ( brk_read(c->fd, &a, sizeof(a)) == 0 )
+   && ( a.length >= fixed )
+   && ( a.length - fixed <= (size_t)((restlen != NULL) ? *restlen : 0) ) ;
+ for ( i = 0 ; ok && (i < nout) ; i++ )
+    ok = ( brk_read(c->fd, out[i].iov_base, out[i].iov_len) == 0 ) ;
+ if ( ok && (restlen != NULL) )
+   {
+    *restlen = (MQLONG)(a.length - fixed)                       ;
+    ok = ( brk_read(c->fd, rest, (size_t) *restlen) == 0 )      ;
+   }
+
+ if ( !ok )
+   {
+    close(c->fd) ;
+    c->fd = -1   ;
+    *cc = MQCC_FAILED            ;
+    *rc = MQRC_CONNECTION_BROKEN ;
+    return ;
+   }
+ *cc = a.cc ;
+ *rc = a.rc ;
+
+ return ;
+} // End of brk_call
+
+//
+// brk_MQCONNX - connect through the broker, the MQCNO (and MQCD) going
+//               with the QM name
+//
+static void brk_MQCONNX ( PMQCHAR    qmname       // QM name
+                        , PMQCNO     cnop         // Connect options
+                        , PMQHCONN   hconn        // Connection handle
+                        , PMQLONG    cc           // MQ CC
+                        , PMQLONG    rc           // MQ RC
+                        )
+{
+ struct sockaddr_un      sa               ;  // Broker address
+ struct iovec            in[4]            ;  // Request body
+ RXMQBRKC              * c = NULL         ;  // The connection
+ MQCHAR48                qm               ;  // QM name
+ MQCNO                   cno              ;  // Connect options
+ MQLONG                  cdlen = 0        ;  // Length of an MQCD
+ int                     i                ;  // Looper
+
+ if ( !brk_on() )
+   {
+    MQCONNX ( qmname, cnop, hconn, cc, rc ) ;
+    return ;
+   }
+
+ memcpy(&cno, cnop, sizeof(MQCNO)) ;
+ *cc = MQCC_FAILED                 ;
+ if ( ((cno.Version >= MQCNO_VERSION_2) && (cno.ClientConnOffset != 0))
+   || ((cno.Version >= MQCNO_VERSION_4) && ((cno.SSLConfigPtr != NULL) || (cno.SSLConfigOffset != 0)))
+   || ((cno.Version >= MQCNO_VERSION_5) && ((cno.SecurityParmsPtr != NULL) || (cno.SecurityParmsOffset != 0)))
+   || ((cno.Version >= MQCNO_VERSION_6) && ((cno.CCDTUrlPtr != NULL) || (cno.CCDTUrlOffset != 0))) )
+   {
+    *rc = MQRC_FUNCTION_NOT_SUPPORTED ;
+    return ;
+   }
+ if ( (cno.Version >= MQCNO_VERSION_2) && (cno.ClientConnPtr != NULL) ) cdlen = sizeof(MQCD) ;
+
+ pthread_mutex_lock(&brk_lock) ;
+ for ( i = 0 ; i < BRKCONNS ; i++ )
+   if ( !brk_conns[i].inuse )
+     {
+      c = &brk_conns[i] ;
+      c->inuse = 1      ;
+      break             ;
+     }
+ pthread_mutex_unlock(&brk_lock) ;
+ if ( c == NULL )
+   {
+    *rc = MQRC_MAX_CONNS_LIMIT_REACHED ;
+    return ;
+   }
+
+ memset(&sa, 0, sizeof(sa))                           ;
+ sa.sun_family = AF_UNIX                              ;
+ strncpy(sa.sun_path, brk_path, sizeof(sa.sun_path)-1) ;
+ pthread_mutex_lock(&c->lock)                         ;
+ c->fd = socket(AF_UNIX, SOCK_STREAM, 0)              ;
+ if ( (c->fd >= 0) && (connect(c->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) )
+   {
+    close(c->fd) ;
+    c->fd = -1   ;
+   }
+ if ( c->fd < 0 ) *rc = MQRC_Q_MGR_NOT_AVAILABLE ;
+ else
+   {
+    memset(qm, 0, sizeof(qm))                          ;
+    for ( i = 0 ; (i < (int)sizeof(qm)) && (qmname[i] != '\0') ; i++ ) qm[i] = qmname[i] ;
+    in[0].iov_base = qm             ; in[0].iov_len = sizeof(qm)     ;
+    in[1].iov_base = &cno           ; in[1].iov_len = sizeof(MQCNO)  ;
+    in[2].iov_base = &cdlen         ; in[2].iov_len = sizeof(MQLONG) ;
+    in[3].iov_base = cno.ClientConnPtr ; in[3].iov_len = (size_t) cdlen ;
+    brk_call(c, BRK_CONN, in, 4, NULL, 0, NULL, NULL, cc, rc) ;
+   }
+ if ( (*cc == MQCC_FAILED) && (c->fd >= 0) )
+   {
+    close(c->fd) ;
+    c->fd = -1   ;
+   }
+ pthread_mutex_unlock(&c->lock) ;
+
+ if ( *cc == MQCC_FAILED )
+   {
+    pthread_mutex_lock(&brk_lock)   ;
+    c->inuse = 0                    ;
+    pthread_mutex_unlock(&brk_lock) ;
+    return ;
+   }
+ *hconn = (MQHCONN)(c - brk_conns) + 1 ;
+
+ return ;
+} // End of brk_MQCONNX
+
+static void brk_MQCONN ( PMQCHAR    qmname       // QM name
+                       , PMQHCONN   hconn        // Connection handle
+                       , PMQLONG    cc           // MQ CC
+                       , PMQLONG    rc           // MQ RC
+                       )
+{
+ MQCNO                   cno = {MQCNO_DEFAULT} ;  // Connect options
+
+ if ( !brk_on() ) MQCONN ( qmname, hconn, cc, rc )     ;
+ else             brk_MQCONNX ( qmname, &cno, hconn, cc, rc ) ;
+
+ return ;
+} // End of brk_MQCONN
+
+static void brk_MQDISC ( PMQHCONN   hconn        // Connection handle
+                       , PMQLONG    cc           // MQ CC
+                       , PMQLONG    rc           // MQ RC
+                       )
+{
+ RXMQBRKC              * c                ;  // The connection
+
+ if ( !brk_on() )
+   {
+    MQDISC ( hconn, cc, rc ) ;
+    return ;
+   }
+
+ if ( (*hconn >= 1) && (*hconn <= BRKCONNS) && brk_conns[*hconn-1].inuse )
+   {
+    c = &brk_conns[*hconn-1]       ;
+    pthread_mutex_lock(&c->lock)   ;
+    if ( c->fd < 0 )
+      {
+       *cc = MQCC_FAILED            ;
+       *rc = MQRC_CONNECTION_BROKEN ;
+      }
+    else brk_call(c, BRK_DISC, NULL, 0, NULL, 0, NULL, NULL, cc, rc) ;
+    if ( c->fd >= 0 ) close(c->fd) ;
+    c->fd = -1                     ;
+    pthread_mutex_unlock(&c->lock) ;
+    pthread_mutex_lock(&brk_lock)  ;
+    c->inuse = 0                   ;
+    pthread_mutex_unlock(&brk_lock) ;
+    *hconn = MQHC_UNUSABLE_HCONN   ;
+   }
+ else
+   {
+    *cc = MQCC_FAILED      ;
+    *rc = MQRC_HCONN_ERROR ;
+   }
+
+ return ;
+} // End of brk_MQDISC
+
+//
+// brk_od - check an MQOD can go to the broker. Returns 0 if it cannot
+//          (the CC and RC set).
+//
+static int brk_od ( PMQOD      od           // Object descriptor
+                  , PMQLONG    cc           // MQ CC
+                  , PMQLONG    rc           // MQ RC
+                  )
+{
+ if ( ((od->Version >= MQOD_VERSION_2) && (od->RecsPresent != 0))
+   || ((od->Version >= MQOD_VERSION_4) && (od->ObjectString.VSLength != 0))
+   || ((od->Version >= MQOD_VERSION_4) && (od->SelectionString.VSLength != 0)) )
+   {
+    *cc = MQCC_FAILED                 ;
+    *rc = MQRC_FUNCTION_NOT_SUPPORTED ;
+    return 0 ;
+   }
+
+ return 1 ;
+} // End of brk_od
+
+//
+// brk_od_back - take the MQOD the broker returned, keeping the pointers
+//               of the one given
+//
+static void brk_od_back ( PMQOD      od           // Object descriptor given
+                        , PMQOD      ret          // That returned
+                        )
+{
+ memcpy(&ret->ObjectString,    &od->ObjectString,    sizeof(MQCHARV)) ;
+ memcpy(&ret->SelectionString, &od->SelectionString, sizeof(MQCHARV)) ;
+ memcpy(&ret->ResObjectString, &od->ResObjectString, sizeof(MQCHARV)) ;
+ ret->ResObjectString.VSLength = 0                  ;
+ ret->ObjectRecPtr   = od->ObjectRecPtr             ;
+ ret->ResponseRecPtr = od->ResponseRecPtr           ;
+ memcpy(od, ret, sizeof(MQOD))                      ;
+
+ return ;
+} // End of brk_od_back
+
+//
+// brk_pmo_back - take the MQPMO the broker returned, keeping the
+//                pointers and message handles of the one given
+//
+static void brk_pmo_back ( PMQPMO     pmo          // Put options given
+                         , PMQPMO     ret          // Those returned
+                         )
+{
+ ret->PutMsgRecPtr      = pmo->PutMsgRecPtr      ;
+ ret->ResponseRecPtr    = pmo->ResponseRecPtr    ;
+ ret->OriginalMsgHandle = pmo->OriginalMsgHandle ;
+ ret->NewMsgHandle      = pmo->NewMsgHandle      ;
+ memcpy(pmo, ret, sizeof(MQPMO))                 ;
+
+ return ;
+} // End of brk_pmo_back
+
+static void brk_MQOPEN ( MQHCONN    hconn        // Connection handle
+                       , PMQVOID    odp          // Object descriptor
+                       , MQLONG     options      // Open options
+                       , PMQHOBJ    hobj         // Object handle
+                       , PMQLONG    cc           // MQ CC
+                       , PMQLONG    rc           // MQ RC
+                       )
+{
+ RXMQBRKC              * c                ;  // The connection
+ PMQOD                   od = (PMQOD) odp ;  // Object descriptor
+ MQOD                    ret              ;  //   as returned
+ struct iovec            in[2]            ;  // Request body
+ struct iovec            out[2]           ;  // Reply body
+
+ if ( !brk_on() )
+   {
+    MQOPEN ( hconn, odp, options, hobj, cc, rc ) ;
+    return ;
+   }
+ if ( !brk_od(od, cc, rc) )                        return ;
+ if ( (c = brk_get(hconn, cc, rc)) == NULL )       return ;
+
+ in[0].iov_base  = &options ; in[0].iov_len  = sizeof(MQLONG) ;
+ in[1].iov_base  = od       ; in[1].iov_len  = sizeof(MQOD)   ;
+ out[0].iov_base = hobj     ; out[0].iov_len = sizeof(MQHOBJ) ;
+ out[1].iov_base = &ret     ; out[1].iov_len = sizeof(MQOD)   ;
+ brk_call(c, BRK_OPEN, in, 2, out, 2, NULL, NULL, cc, rc) ;
+ if ( c->fd >= 0 ) brk_od_back(od, &ret) ;
+ pthread_mutex_unlock(&c->lock) ;
+
+ return ;
+} // End of brk_MQOPEN
+
+static void brk_MQCLOSE ( MQHCONN    hconn        // Connection handle
+                        , PMQHOBJ    hobj         // Object handle
+                        , MQLONG     options      // Close options
+                        , PMQLONG    cc           // MQ CC
+                        , PMQLONG    rc           // MQ RC
+                        )
+{
+ RXMQBRKC              * c                ;  // The connection
+ struct iovec            in[2]            ;  // Request body
+
+ if ( !brk_on() )
+   {
+    MQCLOSE ( hconn, hobj, options, cc, rc ) ;
+    return ;
+   }
+ if ( (c = brk_get(hconn, cc, rc)) == NULL ) return ;
+
+ in[0].iov_base = hobj     ; in[0].iov_len = sizeof(MQHOBJ) ;
+ in[1].iov_base = &options ; in[1].iov_len = sizeof(MQLONG) ;
+ brk_call(c, BRK_CLOSE, in, 2, NULL, 0, NULL, NULL, cc, rc) ;
+ pthread_mutex_unlock(&c->lock) ;
+ if ( *cc != MQCC_FAILED ) *hobj = MQHO_UNUSABLE_HOBJ ;
+
+ return ;
+} // End of brk_MQCLOSE
+
+static void brk_MQPUT ( MQHCONN    hconn        // Connection handle
+                      , MQHOBJ     hobj         // Object handle
+                      , PMQVOID    mdp          // Message descriptor
+                      , PMQVOID    pmop         // Put message options
+                      , MQLONG     datalen      // Data length
+                      , PMQVOID    data         // Data
+                      , PMQLONG    cc           // MQ CC
+                      , PMQLONG    rc           // MQ RC
+                      )
+{
+ RXMQBRKC              * c                ;  // The connection
+ MQMD                    md = {MQMD_DEFAULT} ;  // Message descriptor (all versions)
+ MQPMO                   pmo              ;  // Put message options returned
+ size_t                  mdlen            ;  // Length of that given
+ struct iovec            in[5]            ;  // Request body
+ struct iovec            out[2]           ;  // Reply body
+
+ if ( !brk_on() )
+   {
+    MQPUT ( hconn, hobj, mdp, pmop, datalen, data, cc, rc ) ;
+    return ;
+   }
+ if ( (((PMQPMO) pmop)->Version >= MQPMO_VERSION_2) && (((PMQPMO) pmop)->RecsPresent != 0) )
+   {
+    *cc = MQCC_FAILED                 ;
+    *rc = MQRC_FUNCTION_NOT_SUPPORTED ;
+    return ;
+   }
+ if ( (c = brk_get(hconn, cc, rc)) == NULL ) return ;
+
+ mdlen = ( ((PMQMD) mdp)->Version >= MQMD_VERSION_2 ) ? sizeof(MQMD) : sizeof(MQMD1) ;
+ memcpy(&md, mdp, mdlen) ;
+ in[0].iov_base  = &hobj    ; in[0].iov_len  = sizeof(MQHOBJ) ;
+ in[1].iov_base  = &md      ; in[1].iov_len  = sizeof(MQMD)   ;
+ in[2].iov_base  = pmop     ; in[2].iov_len  = sizeof(MQPMO)  ;
+ in[3].iov_base  = &datalen ; in[3].iov_len  = sizeof(MQLONG) ;
+ in[4].iov_base  = data     ; in[4].iov_len  = (size_t) datalen ;
+ out[0].iov_base = &md      ; out[0].iov_len = sizeof(MQMD)   ;
+ out[1].iov_base = &pmo     ; out[1].iov_len = sizeof(MQPMO)  ;
+ brk_call(c, BRK_PUT, in, 5, out, 2, NULL, NULL, cc, rc) ;
+ if ( c->fd >= 0 )
+   {
+    memcpy(mdp, &md, mdlen)                  ;
+    brk_pmo_back((PMQPMO) pmop, &pmo)        ;
+   }
+ pthread_mutex_unlock(&c->lock) ;
+
+ return ;
+} // End of brk_MQPUT
+
+static void brk_MQPUT1 ( MQHCONN    hconn        // Connection handle
+                       , PMQVOID    odp          // Object descriptor
+                       , PMQVOID    mdp          // Message descriptor
+                       , PMQVOID    pmop         // Put message options
+                       , MQLONG     datalen      // Data length
+                       , PMQVOID    data         // Data
+                       , PMQLONG    cc           // MQ CC
+                       , PMQLONG    rc           // MQ RC
+                       )
+{
+ RXMQBRKC              * c                ;  // The connection
+ PMQOD                   od = (PMQOD) odp ;  // Object descriptor
+ MQOD                    ret              ;  //   as returned
+ MQMD                    md = {MQMD_DEFAULT} ;  // Message descriptor (all versions)
+ MQPMO                   pmo              ;  // Put message options returned
+ size_t                  mdlen            ;  // Length of that given
+ struct iovec            in[5]            ;  // Request body
+ struct iovec            out[3]           ;  // Reply body
+
+ if ( !brk_on() )
+   {
+    MQPUT1 ( hconn, odp, mdp, pmop, datalen, data, cc, rc ) ;
+    return ;
+   }
+ if ( !brk_od(od, cc, rc) ) return ;
+ if ( (((PMQPMO) pmop)->Version >= MQPMO_VERSION_2) && (((PMQPMO) pmop)->RecsPresent != 0) )
+   {
+    *cc = MQCC_FAILED                 ;
+    *rc = MQRC_FUNCTION_NOT_SUPPORTED ;
+    return ;
+   }
+ if ( (c = brk_get(hconn, cc, rc)) == NULL ) return ;
+
+ mdlen = ( ((PMQMD) mdp)->Version >= MQMD_VERSION_2 ) ? sizeof(MQMD) : sizeof(MQMD1) ;
+ memcpy(&md, mdp, mdlen) ;
+ in[0].iov_base  = od       ; in[0].iov_len  = sizeof(MQOD)   ;
+ in[1].iov_base  = &md      ; in[1].iov_len  = sizeof(MQMD)   ;
+ in[2].iov_base  = pmop     ; in[2].iov_len  = sizeof(MQPMO)  ;
+ in[3].iov_base  = &datalen ; in[3].iov_len  = sizeof(MQLONG) ;
+ in[4].iov_base  = data     ; in[4].iov_len  = (size_t) datalen ;
+ out[0].iov_base = &ret     ; out[0].iov_len = sizeof(MQOD)   ;
+ out[1].iov_base = &md      ; out[1].iov_len = sizeof(MQMD)   ;
+ out[2].iov_base = &pmo     ; out[2].iov_len = sizeof(MQPMO)  ;
+ brk_call(c, BRK_PUT1, in, 5, out, 3, NULL, NULL, cc, rc) ;
+ if ( c->fd >= 0 )
+   {
+    brk_od_back(od, &ret)                    ;
+    memcpy(mdp, &md, mdlen)                  ;
+    brk_pmo_back((PMQPMO) pmop, &pmo)        ;
+   }
+ pthread_mutex_unlock(&c->lock) ;
+
+ return ;
+} // End of brk_MQPUT1
+
+static void brk_MQGET ( MQHCONN    hconn        // Connection handle
+                      , MQHOBJ     hobj         // Object handle
+                      , PMQVOID    mdp          // Message descriptor
+                      , PMQVOID    gmop         // Get message options
+                      , MQLONG     buflen       // Buffer length
+                      , PMQVOID    buf          // Buffer
+                      , PMQLONG    datalen      // Message length
+                      , PMQLONG    cc           // MQ CC
+                      , PMQLONG    rc           // MQ RC
+                      )
+{
+ RXMQBRKC              * c                ;  // The connection
+ MQMD                    md = {MQMD_DEFAULT} ;  // Message descriptor (all versions)
+ MQGMO                   gmo              ;  // Get message options returned
+ MQLONG                  got = buflen     ;  // Data returned
+ size_t                  mdlen            ;  // Length of that given
+ struct iovec            in[4]            ;  // Request body
+ struct iovec            out[3]           ;  // Reply body
+
+ if ( !brk_on() )
+   {
+    MQGET ( hconn, hobj, mdp, gmop, buflen, buf, datalen, cc, rc ) ;
+    return ;
+   }
+ if ( (c = brk_get(hconn, cc, rc)) == NULL ) return ;
+
+ mdlen = ( ((PMQMD) mdp)->Version >= MQMD_VERSION_2 ) ? sizeof(MQMD) : sizeof(MQMD1) ;
+ memcpy(&md, mdp, mdlen) ;
+ in[0].iov_base  = &hobj    ; in[0].iov_len  = sizeof(MQHOBJ) ;
+ in[1].iov_base  = &md      ; in[1].iov_len  = sizeof(MQMD)   ;
+ in[2].iov_base  = gmop     ; in[2].iov_len  = sizeof(MQGMO)  ;
+ in[3].iov_base  = &buflen  ; in[3].iov_len  = sizeof(MQLONG) ;
+ out[0].iov_base = &md      ; out[0].iov_len = sizeof(MQMD)   ;
+ out[1].iov_base = &gmo     ; out[1].iov_len = sizeof(MQGMO)  ;
+ out[2].iov_base = datalen  ; out[2].iov_len = sizeof(MQLONG) ;
+ brk_call(c, BRK_GET, in, 4, out, 3, buf, &got, cc, rc) ;
+ if ( c->fd >= 0 )
+   {
+    memcpy(mdp, &md, mdlen)                  ;
+    gmo.MsgHandle = ((PMQGMO) gmop)->MsgHandle ;
+    memcpy(gmop, &gmo, sizeof(MQGMO))        ;
+   }
+ pthread_mutex_unlock(&c->lock) ;
+
+ return ;
+} // End of brk_MQGET
+
+static void brk_MQINQ ( MQHCONN    hconn        // Connection handle
+                      , MQHOBJ     hobj         // Object handle
+                      , MQLONG     selcount     // Selectors
+                      , PMQLONG    sels         //   them
+                      , MQLONG     intcount     // Integer attributes
+                      , PMQLONG    ints         //   them
+                      , MQLONG     charlen      // Character attributes length
+                      , PMQCHAR    chars        //   them
+                      , PMQLONG    cc           // MQ CC
+                      , PMQLONG    rc           // MQ RC
+                      )
+{
+ RXMQBRKC              * c                ;  // The connection
+ struct iovec            in[5]            ;  // Request body
+ struct iovec            out[2]           ;  // Reply body
+
+ if ( !brk_on() )
+   {
+    MQINQ ( hconn, hobj, selcount, sels, intcount, ints, charlen, chars, cc, rc ) ;
+    return ;
+   }
+ if ( (c = brk_get(hconn, cc, rc)) == NULL ) return ;
+
+ in[0].iov_base  = &hobj     ; in[0].iov_len  = sizeof(MQHOBJ) ;
+ in[1].iov_base  = &selcount ; in[1].iov_len  = sizeof(MQLONG) ;
+ in[2].iov_base  = &intcount ; in[2].iov_len  = sizeof(MQLONG) ;
+ in[3].iov_base  = &charlen  ; in[3].iov_len  = sizeof(MQLONG) ;
+ in[4].iov_base  = sels      ; in[4].iov_len  = (size_t) selcount * sizeof(MQLONG) ;
+ out[0].iov_base = ints      ; out[0].iov_len = (size_t) intcount * sizeof(MQLONG) ;
+ out[1].iov_base = chars     ; out[1].iov_len = (size_t) charlen  ;
+ brk_call(c, BRK_INQ, in, 5, out, 2, NULL, NULL, cc, rc) ;
+ pthread_mutex_unlock(&c->lock) ;
+
+ return ;
+} // End of brk_MQINQ
+
+static void brk_MQCMIT ( MQHCONN    hconn        // Connection handle
+                       , PMQLONG    cc           // MQ CC
+                       , PMQLONG    rc           // MQ RC
+                       )
+{
+ RXMQBRKC              * c                ;  // The connection
+
+ if ( !brk_on() )
+   {
+    MQCMIT ( hconn, cc, rc ) ;
+    return ;
+   }
+ if ( (c = brk_get(hconn, cc, rc)) == NULL ) return ;
+ brk_call(c, BRK_CMIT, NULL, 0, NULL, 0, NULL, NULL, cc, rc) ;
+ pthread_mutex_unlock(&c->lock) ;
+
+ return ;
+} // End of brk_MQCMIT
+
+static void brk_MQBACK ( MQHCONN    hconn        // Connection handle
+                       , PMQLONG    cc           // MQ CC
+                       , PMQLONG    rc           // MQ RC
+                       )
+{
+ RXMQBRKC              * c                ;  // The connection
+
+ if ( !brk_on() )
+   {
+    MQBACK ( hconn, cc, rc ) ;
+    return ;
+   }
+ if ( (c = brk_get(hconn, cc, rc)) == NULL ) return ;
+ brk_call(c, BRK_BACK, NULL, 0, NULL, 0, NULL, NULL, cc, rc) ;
+ pthread_mutex_unlock(&c->lock) ;
+
+ return ;
+} // End of brk_MQBACK
+
+//
+// The calls not sent to the broker
+//
+ #define BRK_NOTSUP(cc,rc) { *(cc) = MQCC_FAILED ; *(rc) = MQRC_FUNCTION_NOT_SUPPORTED ; }
+
+static void brk_MQCB ( MQHCONN h, MQLONG op, PMQVOID cbd, MQHOBJ o, PMQVOID md, PMQVOID gmo, PMQLONG cc, PMQLONG rc )
+{
+ if ( !brk_on() ) MQCB ( h, op, cbd, o, md, gmo, cc, rc ) ;
+ else             BRK_NOTSUP(cc, rc)                     ;
+} // End of brk_MQCB
+
+static void brk_MQCTL ( MQHCONN h, MQLONG op, PMQVOID ctlo, PMQLONG cc, PMQLONG rc )
+{
+ if ( !brk_on() ) MQCTL ( h, op, ctlo, cc, rc ) ;
+ else             BRK_NOTSUP(cc, rc)           ;
+} // End of brk_MQCTL
+
+static void brk_MQSUB ( MQHCONN h, PMQVOID sd, PMQHOBJ o, PMQHOBJ s, PMQLONG cc, PMQLONG rc )
+{
+ if ( !brk_on() ) MQSUB ( h, sd, o, s, cc, rc ) ;
+ else             BRK_NOTSUP(cc, rc)           ;
+} // End of brk_MQSUB
+
+static void brk_MQSET ( MQHCONN h, MQHOBJ o, MQLONG n, PMQLONG sels, MQLONG ni, PMQLONG ints, MQLONG nc, PMQCHAR chars, PMQLONG cc, PMQLONG rc )
+{
+ if ( !brk_on() ) MQSET ( h, o, n, sels, ni, ints, nc, chars, cc, rc ) ;
+ else             BRK_NOTSUP(cc, rc)                                  ;
+} // End of brk_MQSET
+
+static void brk_MQSTAT ( MQHCONN h, MQLONG type, PMQVOID sts, PMQLONG cc, PMQLONG rc )
+{
+ if ( !brk_on() ) MQSTAT ( h, type, sts, cc, rc ) ;
+ else             BRK_NOTSUP(cc, rc)             ;
+} // End of brk_MQSTAT
+
+ #define MQCONN   brk_MQCONN
+ #define MQCONNX  brk_MQCONNX
+ #define MQDISC   brk_MQDISC
+ #define MQOPEN   brk_MQOPEN
+ #define MQCLOSE  brk_MQCLOSE
+ #define MQPUT    brk_MQPUT
+ #define MQPUT1   brk_MQPUT1
+ #define MQGET    brk_MQGET
+ #define MQINQ    brk_MQINQ
+ #define MQCMIT   brk_MQCMIT
+ #define MQBACK   brk_MQBACK
+ #define MQCB     brk_MQCB
+ #define MQCTL    brk_MQCTL
+ #define MQSUB    brk_MQSUB
+ #define MQSET    brk_MQSET
+ #define MQSTAT   brk_MQSTAT
+#endif
 
 #ifdef __MVS__
 //
@@ -206,6 +1036,29 @@
   #define RXMQC    CPPMC
   #define RXMQV    CPPMV
   #define RXMQVC   CPPMVC
+  #define RXMQDEF  CPPMDEF
+  #define RXMQPUTD CPPMPUTD
+  #define RXMQGETD CPPMGETD
+  #define RXMQBRWD CPPMBRWD
+  #define RXMQCACH CPPMCACH
+  #define RXMQCONX CPPMCONX
+  #define RXMQSESS CPPMSESS
+  #define RXMQTRAC CPPMTRAC
+  #define RXMQRETM CPPMRETM
+  #define RXMQGETN CPPMGETN
+  #define RXMQBRWN CPPMBRWN
+  #define RXMQPUTN CPPMPUTN
+  #define RXMQAUTO CPPMAUTO
+  #define RXMQCOPY CPPMCOPY
+  #define RXMQASYN CPPMASYN
+  #define RXMQPOLL CPPMPOLL
+  #define RXMQSTAT CPPMSTAT
+  #define RXMQREQ  CPPMREQ
+  #define RXMQRPLY CPPMRPLY
+  #define RXMQWANY CPPMWANY
+  #define RXMQSUBM CPPMSUBM
+  #define RXMQWAIT CPPMWAIT
+  #define RXMQFAN  CPPMFAN
 //
 // Function to print to stdout (REXX terminal or standard output)
 //
@@ -225,59 +1078,449 @@
 //
 // Global definitions
 //
-//  MINQS     -> Start scan of Queues allowed to process (not 0!)
-//  MAXQS     -> maximum number of Queues allowed to process
+//  OBJMIN      -> initial size of the object handle table
+//  OBJSLOTBITS -> bits of a handle number that are the table slot,
+//                 the rest being the slot's generation
 //
- #define MINQS 1
- #define MAXQS 100
+ #define OBJMIN       16
+ #define OBJSLOTBITS  16
+ #define OBJSLOTMASK  ((1 << OBJSLOTBITS) - 1)
+ #define OBJGENMASK   0x7FFF
  #define MAXCOMMLEN 5000
 
+ #define MAXTMPL 64
+
+ #define MAXBUFS   2      // Reusable payload buffers in the RXMQCB
+ #define BUF_DATA  0      //   message data
+ #define BUF_WORK  1      //   second area (RXMQC reply etc)
+ #define BUFMIN    4096   // Smallest payload buffer size class
+ #define ARENAMIN  1024   // Smallest per-call scratch arena
+
+ #define RET_FULL  0      // Return mode (RXMQRETM): all LASTxx variables
+ #define RET_NEW   1      //   only RXMQ.LASTxx
+ #define RET_NUM   2      //   none, and a numeric return string
+ #define RETMODE(a)  ( ((a) == NULL) ? RET_FULL : (a)->RetMode )
+
  #define RXMQANCHOR "RXMQANCHOR"
  #define RXMQeyecatcher "RXMQ"
- typedef struct _RXMQCB {
-     MQCHAR4    StrucId                      ; // Structure identifier
-     MQULONG    tracebits                    ; // Variable to contain current trace status
-     char       QMname[MQ_Q_MGR_NAME_LENGTH] ; // QM name
-     MQHCONN    QMh                          ; // Connection handle
-     MQHOBJ     Qh[MAXQS]                    ; // Queue handle
- } RXMQCB;
+ typedef struct _RXMQTMPL {
+     MQLONG     type                         ; // TMPL_xx (0 if slot free)
+     void     * cb                           ; // Compiled MQ structure
+     MQULONG    outmask                      ; // Output fields wanted
+ } RXMQTMPL;
+
+ typedef struct _RXMQBUF {
+     void     * ptr                          ; // Buffer (or NULL)
+     MQLONG     size                         ; // Size class allocated
+ } RXMQBUF;
+
+ typedef struct _RXMQARENA {
+     char     * base                         ; // Arena storage
+     size_t     size                         ; // Size allocated
+     size_t     used                         ; // Handed out this call
+     size_t     need                         ; // Asked for this call
+     void     * spill                        ; // Overflow blocks this call
+ } RXMQARENA;
+
+ typedef struct _RXMQSTATS {
+     MQULONG    bufnew                       ; // Payload buffer mallocs
+     MQULONG    bufreuse                     ; // Payload buffers reused
+     MQULONG    arenanew                     ; // Arena/overflow mallocs
+     MQULONG    arenareuse                   ; // Arena requests, no malloc
+ } RXMQSTATS;
 
-//
-// Trace/Return variables
-//
-#ifdef __MVS__
-  #define PREFIX   "RXMQV."
-  #define TRACEVAR "RXMQVTRACE"
-  #define RCMAP    "RXMQV.RCMAP.%lu"
+ //
+ // Asynchronous consume (RXMQASYN, RXMQPOLL), see async_msg
+ //
+ #define ASYNSLOTS 64     // Ring size if not given
+ #define ASYNMAX   65536  //   and the most
+ #define WANYMAX   1000   // Most weight of a queue (RXMQWANY)
+
+ typedef struct _RXMQWAKE {
+     MQULONG    waiting                      ; // RXMQPOLL waiting to be woken
+     MQLONG     made                         ; // Made (by the first RXMQASYN)
+#if defined(_WIN32)
+     HANDLE     event                        ; // Auto-reset event
+#elif !defined(__MVS__)
+     pthread_mutex_t mutex                   ; // Guards the wait
+     pthread_cond_t  cond                    ; //   signalled by async_msg
 #endif
+ } RXMQWAKE;
+
+ typedef struct _RXMQSLOT {
+     MQMD2      md                           ; // Message descriptor
+     MQLONG     datalen                      ; // Message length
+     MQLONG     size                         ; // Buffer size
+     char     * data                         ; // Buffer (kept for the next)
+ } RXMQSLOT;
+
+ typedef struct _RXMQRING {
+     MQULONG    head                         ; // Messages taken (by RXMQPOLL)
+     MQULONG    tail                         ; // Messages kept (by async_msg)
+     MQULONG    slots                        ; // Ring size, a power of two
+     MQULONG    suspended                    ; // Consumer suspended, ring full
+     MQULONG    stopping                     ; // MQCTL stopping, keep nothing
+     MQULONG    rewind                       ; // A message left, browse again
+     MQULONG    reason                       ; // Failure from MQ (0 none)
+     MQLONG     browse                       ; // Browsing only (nothing removed)
+     MQLONG     weight                       ; // Weight while RXMQWANY waits (0 not)
+     MQLONG     credit                       ; //   its turn in the rotation
+     RXMQWAKE * wake                         ; // Wakes RXMQPOLL
+     MQGMO      gmo                          ; // Get options registered
+     RXMQSLOT   slot[1]                      ; // The slots (slots of them)
+ } RXMQRING;
 
-#ifdef _RXMQN
-  #define PREFIX   "RXMQN."
-  #define TRACEVAR "RXMQNTRACE"
-  #define RCMAP    "RXMQN.RCMAP.%lu"
-  #define THISDLL  "RXMQN"
  //
- // This is a table of functions to be registered with Rexx
+ // The head and tail of a ring are each written by one thread and read
+ // by the other, through these
  //
-  static PSZ funcs[] = {"RXMQV"       ,
-                            "RXMQCONN"    ,  "RXMQNCONN"   ,
-                            "RXMQDISC"    ,  "RXMQNDISC"   ,
-                            "RXMQOPEN"    ,  "RXMQNOPEN"   ,
-                            "RXMQCLOS"    ,  "RXMQNCLOSE"  ,
-                            "RXMQGET"     ,  "RXMQNGET"    ,
-                            "RXMQPUT"     ,  "RXMQNPUT"    ,
-                            "RXMQINQ"     ,  "RXMQNINQ"    ,
-                            "RXMQSET"     ,  "RXMQNSET"    ,
-                            "RXMQSUB"     ,  "RXMQNSUB"    ,
-                            "RXMQCMIT"    ,  "RXMQNCMIT"   ,
-                            "RXMQBACK"    ,  "RXMQNBACK"   ,
-                            "RXMQBRWS"    ,  "RXMQNBROWSE" ,
-                            "RXMQHXT"     ,  "RXMQNHXT"    ,
-                            "RXMQEVNT"    ,  "RXMQNEVENT"  ,
+#if defined(__MVS__)
+ #define RING_GET(x)    (*(volatile MQULONG *)&(x))
+ #define RING_SET(x,v)  (*(volatile MQULONG *)&(x) = (MQULONG)(v))
+#elif defined(_WIN32)
+ #define RING_GET(x)    ((MQULONG)InterlockedCompareExchange((volatile LONG *)&(x), 0, 0))
+ #define RING_SET(x,v)  InterlockedExchange((volatile LONG *)&(x), (LONG)(v))
+#else
+ #define RING_GET(x)    __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+ #define RING_SET(x,v)  __atomic_store_n(&(x), (MQULONG)(v), __ATOMIC_SEQ_CST)
+#endif
+
+ typedef struct _RXMQOBJ {
+     MQHOBJ     Qh                           ; // MQ object handle (0 if free)
+     MQLONG     gen                          ; // Generation, bumped on close
+     MQLONG     conn                         ; // Connection (QM index)
+     MQLONG     shared                       ; // A session's queue (RXMQSESS)
+     MQLONG     next                         ; // Next free (or idle) slot
+     MQLONG     prev                         ; // Previous idle slot
+     MQLONG     idle                         ; // Closed, but kept open in cache
+     MQLONG     key                          ; // Cache key hash (0 no caching)
+     MQLONG     options                      ; // Open options (0 for MQSUB)
+     MQLONG     maxmsgl                      ; // MAXMSGL (0 if not known)
+     MQLONG     est                          ; // Recent message size estimate
+     MQLONG     dests                        ; // Queues in a distribution list
+     RXMQRING * ring                         ; // Being consumed (RXMQASYN)
+     MQCHAR48   name                         ; // Object name
+     MQCHAR48   qmgr                         ; // Object QM name (as given)
+     MQCHAR48   rname                        ; // Resolved Q name from open
+     MQCHAR48   rqmgr                        ; // Resolved QM name from open
+ } RXMQOBJ;
+
+ typedef struct _RXMQCACHE {
+     MQLONG     max                          ; // Most idle handles kept (0 off)
+     MQLONG     idle                         ; // Idle handles now
+     MQLONG     head                         ; // Most recently closed slot
+     MQLONG     tail                         ; // Least recently closed slot
+     MQULONG    hits                         ; // Opens met from the cache
+     MQULONG    misses                       ; // Cacheable opens done by MQ
+ } RXMQCACHE;
+
+ //
+ // Request/reply (RXMQREQ, RXMQRPLY), see req_pool
+ //
+ #define REQMODEL  "SYSTEM.DEFAULT.MODEL.QUEUE" // Reply queue model if none given
+ #define REQ_LEFT  0      // Reply queue of requests left in flight
+ #define REQ_WAIT  1      //   and of requests waited for
+ #define REQMIN    16     // Requests in flight first made room for
+
+ typedef struct _RXMQFLIGHT {
+     MQLONG     id                           ; // Request number
+     MQBYTE24   key                          ; // CorrelId of its reply
+     uint64_t   sent                         ; // Time put (microseconds)
+ } RXMQFLIGHT;
+
+ typedef struct _RXMQRPC {
+     RXMQOBJ    q[2]                         ; // Reply queues (REQ_xx, Qh 0 not made)
+     MQCHAR48   model                        ; //   the model they are made from
+     MQLONG     lastid                       ; // Last request number given
+     MQLONG     count                        ; // Requests in flight
+     MQLONG     size                         ; //   room for them
+     RXMQFLIGHT * flight                     ; //   them, in no order
+     MQULONG    stale                        ; // Replies to no request discarded
+ } RXMQRPC;
+
+ //
+ // Worker pool (RXMQSUBM, RXMQWAIT, RXMQFAN), see pool_give
+ //
+ #define WORKERS   8      // Workers in a pool
+ #define WORKQMS   8      // Queue managers a worker connects to
+ #define WORKBUF   4096   // Buffer of a worker's first get
+
+ #define WORK_PUT  1      // Task puts a message
+ #define WORK_GET  2      //   gets one
+ #define WORK_REQ  3      //   puts a request and gets its reply
+
+ typedef struct _RXMQTASK {
+     struct _RXMQTASK * next                 ; // Next of the worker's to do
+     struct _RXMQTASK * all                  ; // Next of the pool's not waited for
+     MQULONG    ticket                       ; // Ticket (RXMQSUBM)
+     MQLONG     op                           ; // WORK_xx
+     MQLONG     done                         ; // Done (set under the pool lock)
+     MQULONG    traceid                      ; // Trace id of the submitter
+     MQULONG    key                          ; // Hash of its ordering key (0 none)
+     char       QMname[MQ_Q_MGR_NAME_LENGTH] ; // QM to do it on
+     MQCHAR48   qname                        ; // Queue
+     MQLONG     wait                         ; // Wait of a get or request (ms)
+     MQMD2      md                           ; // MD given, then put or got
+     MQLONG     datalen                      ; // Data length
+     char     * data                         ; // Data put, or got (malloc)
+     MQLONG     mqrc                         ; // MQ CC
+     MQLONG     mqac                         ; // MQ RC
+     uint64_t   took                         ; // Time taken (microseconds)
+ } RXMQTASK;
+
+ typedef struct _RXMQWORKQM {
+     char       QMname[MQ_Q_MGR_NAME_LENGTH] ; // QM name
+     MQHCONN    QMh                          ; // Connection (0 none)
+     MQLONG     own                          ; //   made by the worker (else shared)
+     MQULONG    used                         ; //   last used (its worker's task count)
+     MQHOBJ     Qh                           ; // Queue last used, kept open (0 none)
+     MQLONG     Qopts                        ; //   its open options
+     MQCHAR48   Qname                        ; //   and name
+     MQHOBJ     Rh                           ; // Reply queue of requests (0 none)
+     MQCHAR48   Rname                        ; //   its name
+ } RXMQWORKQM;
+
+ typedef struct _RXMQWORKER {
+     struct _RXMQPOOL * pool                 ; // Its pool
+     MQLONG     started                      ; // Thread started
+#if defined(_WIN32)
+     HANDLE     thread                       ; // The thread
+#elif !defined(__MVS__)
+     pthread_t  thread                       ; // The thread
+#endif
+     MQULONG    traceid                      ; // Trace id of its last task
+     MQULONG    tasks                        ; // Tasks it has begun
+     RXMQTASK * head                         ; // Tasks to do, oldest first
+     RXMQTASK * tail                         ; //   newest
+     MQLONG     queued                       ; //   how many (with the one being done)
+     RXMQWORKQM qm[WORKQMS]                  ; // Its connections
+ } RXMQWORKER;
+
+ typedef struct _RXMQPOOL {
+#if defined(_WIN32)
+     CRITICAL_SECTION   lock                 ; // Guards the workers' tasks
+     CONDITION_VARIABLE work                 ; //   signalled when one is given
+     CONDITION_VARIABLE done                 ; //   and when one is done
+#elif !defined(__MVS__)
+     pthread_mutex_t    lock                 ; // Guards the workers' tasks
+     pthread_cond_t     work                 ; //   signalled when one is given
+     pthread_cond_t     done                 ; //   and when one is done
+#endif
+     MQLONG     stop                         ; // Workers to end
+     MQULONG    tickets                      ; // Last ticket given
+     RXMQTASK * tasks                        ; // Tasks not yet waited for
+     RXMQWORKER worker[WORKERS]              ; // The workers
+ } RXMQPOOL;
+
+#if defined(__MVS__)
+ #define POOL_LOCK(p)                        // No worker threads
+ #define POOL_UNLOCK(p)
+ #define POOL_SLEEP(p,c)
+ #define POOL_WAKE(p,c)
+#elif defined(_WIN32)
+ #define POOL_LOCK(p)     EnterCriticalSection(&(p)->lock)
+ #define POOL_UNLOCK(p)   LeaveCriticalSection(&(p)->lock)
+ #define POOL_SLEEP(p,c)  SleepConditionVariableCS(&(p)->c, &(p)->lock, INFINITE)
+ #define POOL_WAKE(p,c)   WakeAllConditionVariable(&(p)->c)
+#else
+ #define POOL_LOCK(p)     pthread_mutex_lock(&(p)->lock)
+ #define POOL_UNLOCK(p)   pthread_mutex_unlock(&(p)->lock)
+ #define POOL_SLEEP(p,c)  pthread_cond_wait(&(p)->c, &(p)->lock)
+ #define POOL_WAKE(p,c)   pthread_cond_broadcast(&(p)->c)
+#endif
+
+ //
+ // Connections
+ //
+ //   QM[0] is made by RXMQCONN or RXMQCONNX when no connection variable
+ //   is given, and is used by calls that give no connection id. The
+ //   others are made when a variable is given to receive their id.
+ //
+ #define MAXCONNS  16                        // Connections per thread
+
+ typedef struct _RXMQUOWST {
+     MQULONG    commits                      ; // MQCMITs done (RXMQCMIT or auto)
+     MQULONG    autos                        ; //   of them by the policy
+     MQULONG    backouts                     ; // RXMQBACKs done
+     MQULONG    limits                       ; // Syncpoint limit reached
+     uint64_t   time                         ; // Time in MQCMIT (microseconds)
+     uint64_t   maxtime                      ; //   longest one
+ } RXMQUOWST;
+
+ typedef struct _RXMQQM {
+     char       QMname[MQ_Q_MGR_NAME_LENGTH] ; // QM name
+     MQHCONN    QMh                          ; // Connection handle
+     MQLONG     ReadAhead                    ; // Added to input opens (RXMQCONNX)
+     MQLONG     Sess                         ; // Session attached, index+1 (0 none)
+     MQLONG     AutoMsgs                     ; // Auto-commit (RXMQAUTO) after n ops
+     MQLONG     AutoBytes                    ; //   or n bytes
+     MQLONG     AutoMs                       ; //   or n ms (0 each off)
+     MQLONG     AutoLimit                    ; //   ops now (lowered at the limit)
+     MQLONG     AutoCap                      ; //   most it grows back to
+     MQLONG     Async                        ; // MQCTL started (RXMQASYN)
+     RXMQRPC  * Rpc                          ; // Reply queues (RXMQREQ)
+     MQLONG     AsyncPuts                    ; // MQPMO_ASYNC_RESPONSE puts not
+                                               //   yet checked (MQSTAT)
+     MQLONG     Pending                      ; // Ops counted, not yet committed
+     uint64_t   PendBytes                    ; //   their bytes
+     uint64_t   PendSince                    ; //   time of the first (ms)
+     RXMQUOWST  Uow                          ; // Commit counters
+ } RXMQQM;
+
+ #define UOW_AUTO(q) ( ((q)->AutoMsgs | (q)->AutoBytes | (q)->AutoMs) != 0 )
+ #define GMO_IN_UOW(g,m) (    ((g).Options & MQGMO_SYNCPOINT)                         \
+                           || (    ((g).Options & MQGMO_SYNCPOINT_IF_PERSISTENT)      \
+                                && ((m).Persistence == MQPER_PERSISTENT) ) )
+ #define PUT_ASYNC(q,p,cc) ( (q)->AsyncPuts += ( ((p).Options & MQPMO_ASYNC_RESPONSE)  \
+                                              && ((cc) != MQCC_FAILED) ) )
+
+ typedef struct _RXMQCB {
+     MQCHAR4    StrucId                      ; // Structure identifier
+     MQULONG    tracebits                    ; // Variable to contain current trace status
+     MQLONG     traceset                     ; //   set by RXMQTRAC (variables not read)
+     char       tracevar[2][100]             ; //   trace variables when last read
+     MQLONG     RetMode                      ; // Return mode (RET_xx)
+     RXMQQM     QM[MAXCONNS]                 ; // Connections (0 the default)
+     MQLONG     Conns                        ; //   how many are connected
+     RXMQOBJ  * Obj                          ; // Object handle table
+     MQLONG     Objsize                      ; //   its size in slots
+     MQLONG     Objfree                      ; //   first free slot (0 none)
+     RXMQCACHE  Cache                        ; // Open handle cache
+     RXMQTMPL   Tmpl[MAXTMPL]                ; // Descriptor templates (RXMQDEF)
+     RXMQBUF    Buf[MAXBUFS]                 ; // Reusable payload buffers
+     RXMQARENA  Arena                        ; // Per-call scratch storage
+     RXMQSTATS  Stats                        ; // Allocation counters
+     RXMQWAKE   Wake                         ; // Wakes RXMQPOLL
+     MQLONG     Rings                        ; // Queues being consumed
+     MQLONG     PollNext                     ; //   slot RXMQPOLL looks at first
+     RXMQPOOL * Pool                         ; // Worker pool (RXMQSUBM)
+ } RXMQCB;
+
+ //
+ // Sessions
+ //
+ //   A session (RXMQSESS) is a named connection made with
+ //   MQCNO_HANDLE_SHARE_BLOCK, and queues opened on it, held for the
+ //   whole process rather than by one thread. A thread attaches to it
+ //   as one of its connections, being given handles for the queues,
+ //   with no MQCONN or MQOPEN of its own; MQ has threads that use the
+ //   connection at the same time take turns. The table is changed only
+ //   under SESS_LOCK, and once a thread has attached it is not looked
+ //   at again, the connection then being in the thread's own RXMQCB.
+ //
+ #define MAXSESS   16                        // Sessions per process
+ #define MAXSESSQ  16                        // Queues opened per session
+
+ #define SESS_FREE   0                       // Slot not in use
+ #define SESS_BUSY   1                       // Being opened or closed
+ #define SESS_READY  2                       // May be attached to
+
+ typedef struct _RXMQSESSCB {
+     MQLONG     state                        ; // SESS_xx
+     MQLONG     users                        ; // Connections attached
+     MQCHAR48   name                         ; // Session name
+     char       QMname[MQ_Q_MGR_NAME_LENGTH] ; // QM name
+     MQHCONN    QMh                          ; // Shared connection handle
+     MQLONG     options                      ; // Open options of the queues
+     MQLONG     Qs                           ; // Queues opened
+     MQCHAR48   Qname[MAXSESSQ]              ; //   their names
+     MQHOBJ     Qh[MAXSESSQ]                 ; //   and handles
+ } RXMQSESSCB;
+
+ static RXMQSESSCB Sess[MAXSESS]             ; // Sessions of the process
+
+ //
+ // Thread-local storage
+ //
+ //   Each thread's RXMQCB is found from tls_anchor, rather than the REXX
+ //   variable RXMQANCHOR being fetched on every call; on z/OS, where
+ //   RXMQTLS is empty, the variable is still used.
+ //
+#ifdef __MVS__
+ #define RXMQTLS
+#elif defined(_MSC_VER)
+ #define RXMQTLS        __declspec(thread)
+#else
+ #define RXMQTLS        __thread
+#endif
+
+#ifndef __MVS__
+ static RXMQTLS RXMQCB * tls_anchor = NULL  ; // This thread's RXMQCB
+#endif
+
+#ifdef __MVS__
+ #define SESS_LOCK()                         // TSO/E runs one exec at a time
+ #define SESS_UNLOCK()
+#elif defined(_WIN32)
+ static CRITICAL_SECTION sess_cs             ; // Guards Sess[]
+ static volatile LONG    sess_csinit = 0     ; //   made (0 no, 1 being, 2 yes)
+ #define SESS_LOCK()    sess_lock_win()
+ #define SESS_UNLOCK()  LeaveCriticalSection(&sess_cs)
+#else
+ static pthread_mutex_t  sess_mutex = PTHREAD_MUTEX_INITIALIZER ; // Guards Sess[]
+ #define SESS_LOCK()    pthread_mutex_lock(&sess_mutex)
+ #define SESS_UNLOCK()  pthread_mutex_unlock(&sess_mutex)
+#endif
+
+//
+// Trace/Return variables
+//
+#ifdef __MVS__
+  #define PREFIX   "RXMQV."
+  #define TRACEVAR "RXMQVTRACE"
+  #define RCMAP    "RXMQV.RCMAP.%lu"
+#endif
+
+#ifdef _RXMQN
+  #define PREFIX   "RXMQN."
+  #define TRACEVAR "RXMQNTRACE"
+  #define RCMAP    "RXMQN.RCMAP.%lu"
+  #define THISDLL  "RXMQN"
+ //
+ // This is a table of functions to be registered with Rexx
+ //
+  static PSZ funcs[] = {"RXMQV"       ,
+                            "RXMQCONN"    ,  "RXMQNCONN"   ,
+                            "RXMQDISC"    ,  "RXMQNDISC"   ,
+                            "RXMQOPEN"    ,  "RXMQNOPEN"   ,
+                            "RXMQCLOS"    ,  "RXMQNCLOSE"  ,
+                            "RXMQGET"     ,  "RXMQNGET"    ,
+                            "RXMQPUT"     ,  "RXMQNPUT"    ,
+                            "RXMQINQ"     ,  "RXMQNINQ"    ,
+                            "RXMQSET"     ,  "RXMQNSET"    ,
+                            "RXMQSUB"     ,  "RXMQNSUB"    ,
+                            "RXMQCMIT"    ,  "RXMQNCMIT"   ,
+                            "RXMQBACK"    ,  "RXMQNBACK"   ,
+                            "RXMQBRWS"    ,  "RXMQNBROWSE" ,
+                            "RXMQHXT"     ,  "RXMQNHXT"    ,
+                            "RXMQEVNT"    ,  "RXMQNEVENT"  ,
                             "RXMQTM"      ,  "RXMQNTM"     ,
                             "RXMQPUT1"    ,  "RXMQNPUT1"   ,
                             "RXMQC"       ,  "RXMQNC"      ,
                             "RXMQCONS"    ,  "RXMQNCONS"   ,
+                            "RXMQDEF"     ,  "RXMQNDEF"    ,
+                            "RXMQPUTD"    ,  "RXMQNPUTD"   ,
+                            "RXMQGETD"    ,  "RXMQNGETD"   ,
+                            "RXMQBRWD"    ,  "RXMQNBROWSED",
+                            "RXMQCACH"    ,  "RXMQNCACHE"  ,
+                            "RXMQCONX"    ,  "RXMQNCONNX"  ,
+                            "RXMQSESS"    ,  "RXMQNSESSION",
+                            "RXMQTRAC"    ,  "RXMQNTRACE"  ,
+                            "RXMQRETM"    ,  "RXMQNRETMODE",
+                            "RXMQGETN"    ,  "RXMQNGETN"   ,
+                            "RXMQBRWN"    ,  "RXMQNBROWSEN",
+                            "RXMQPUTN"    ,  "RXMQNPUTN"   ,
+                            "RXMQAUTO"    ,  "RXMQNAUTOCOMMIT",
+                            "RXMQCOPY"    ,  "RXMQNCOPY"   ,
+                            "RXMQASYN"    ,  "RXMQNASYNC"  ,
+                            "RXMQPOLL"    ,  "RXMQNPOLL"   ,
+                            "RXMQSTAT"    ,  "RXMQNSTAT"   ,
+                            "RXMQREQ"     ,  "RXMQNREQUEST",
+                            "RXMQRPLY"    ,  "RXMQNREPLY"  ,
+                            "RXMQWANY"    ,  "RXMQNWAITANY",
+                            "RXMQSUBM"    ,  "RXMQNSUBMIT" ,
+                            "RXMQWAIT"    ,  "RXMQNWAIT"   ,
+                            "RXMQFAN"     ,  "RXMQNFANOUT" ,
                             "RXMQTERM"    ,  "RXMQNTERM"
               } ;
  static MQULONG numfuncs = sizeof(funcs)/sizeof(char *) ;
@@ -310,6 +1553,29 @@
                            "RXMQPUT1"    ,  "RXMQTPUT1"   ,
                            "RXMQC"       ,  "RXMQTC"      ,
                            "RXMQCONS"    ,  "RXMQTCONS"   ,
+                           "RXMQDEF"     ,  "RXMQTDEF"    ,
+                           "RXMQPUTD"    ,  "RXMQTPUTD"   ,
+                           "RXMQGETD"    ,  "RXMQTGETD"   ,
+                           "RXMQBRWD"    ,  "RXMQTBROWSED",
+                           "RXMQCACH"    ,  "RXMQTCACHE"  ,
+                           "RXMQCONX"    ,  "RXMQTCONNX"  ,
+                           "RXMQSESS"    ,  "RXMQTSESSION",
+                           "RXMQTRAC"    ,  "RXMQTTRACE"  ,
+                           "RXMQRETM"    ,  "RXMQTRETMODE",
+                           "RXMQGETN"    ,  "RXMQTGETN"   ,
+                           "RXMQBRWN"    ,  "RXMQTBROWSEN",
+                           "RXMQPUTN"    ,  "RXMQTPUTN"   ,
+                           "RXMQAUTO"    ,  "RXMQTAUTOCOMMIT",
+                           "RXMQCOPY"    ,  "RXMQTCOPY"   ,
+                           "RXMQASYN"    ,  "RXMQTASYNC"  ,
+                           "RXMQPOLL"    ,  "RXMQTPOLL"   ,
+                           "RXMQSTAT"    ,  "RXMQTSTAT"   ,
+                           "RXMQREQ"     ,  "RXMQTREQUEST",
+                           "RXMQRPLY"    ,  "RXMQTREPLY"  ,
+                           "RXMQWANY"    ,  "RXMQTWAITANY",
+                           "RXMQSUBM"    ,  "RXMQTSUBMIT" ,
+                           "RXMQWAIT"    ,  "RXMQTWAIT"   ,
+                           "RXMQFAN"     ,  "RXMQTFANOUT" ,
                            "RXMQTERM"    ,  "RXMQTTERM"
                           } ;
  static MQULONG numfuncs = sizeof(funcs)/sizeof(char *) ;
@@ -321,7 +1587,7 @@
  typedef struct _RETMSG
                 {
                  int    retcode  ;  // Internal (minus) retcode
-                 char * retmsgc  ;  // Text part of message
+                 const char * retmsgc  ;  // Text part of message
                 } RETMSG, *PRETMSG         ;
 
 //
@@ -332,6 +1598,14 @@
  MQMD2   md_default    = {MQMD2_DEFAULT}  ;
  MQPMO   pmo_default   = {MQPMO_DEFAULT}  ;
  MQGMO   gmo_default   = {MQGMO_DEFAULT}  ;
+ MQCNO   cno_default   = {MQCNO_DEFAULT}  ;
+ MQCD    cd_default    = {MQCD_CLIENT_CONN_DEFAULT} ;
+ MQOR    or_default    = {MQOR_DEFAULT}   ;
+ MQRR    rr_default    = {MQRR_DEFAULT}   ;
+ MQPMR   pmr_default   = {MQPMR_DEFAULT}  ;
+ MQCBD   cbd_default   = {MQCBD_DEFAULT}  ;
+ MQCTLO  ctlo_default  = {MQCTLO_DEFAULT} ;
+ MQSTS   sts_default   = {MQSTS_DEFAULT}  ;
 
 //
 //  Global debug variable for controlling current trace status
@@ -356,6 +1630,12 @@
   #define MQV   0x00010000
   #define COM   0x00008000
   #define SUB   0x00004000
+  #define DEF   0x00002000
+  #define CACHE 0x00001000
+  #define SESS  0x00000800
+  #define ASYNC 0x00000400
+  #define REQ   0x00000200
+  #define WORK  0x00000100
   #define INIT  0x00000020
   #define TERM  0x00000010
   #define ALL   0xFFFFFFFF
@@ -530,6 +1810,7 @@
   MQGMO   * gmop    ; // pointer to MQGMO
   MQPMO   * pmop    ; // pointer to MQPMO
   MQSD    * sdp     ; // pointer to MQSD
+  MQCNO   * cnop    ; // pointer to MQCNO
 
   if ( !memcmp(cbptr, RXMQeyecatcher, sizeof(MQCHAR4)))        // Format RXMQCB
    {
@@ -537,13 +1818,42 @@
     printf( "\n")  ;
     DumpString  ( "RXMQCB StrucId           :", rxmqcbp->StrucId,   sizeof(MQCHAR4)  ) ;
     DumpLongHex ( "       tracebits         :", rxmqcbp->tracebits                   ) ;
-    DumpString  ( "       QMname            :", rxmqcbp->QMname ,   sizeof(MQCHAR48) ) ;
-    DumpLongHex ( "       QMh               :", rxmqcbp->QMh                         ) ;
-
-    for(i=0; i < MAXQS; i++)
-      if (rxmqcbp->Qh[i])
-        printf("       Qh[%.2d]            :<%0*"PRIX32">\n",
-               i, (int)(2*sizeof(MQHOBJ)), (uint32_t)rxmqcbp->Qh[i] ) ;
+    DumpLongDec ( "       Return mode       :", rxmqcbp->RetMode                     ) ;
+    DumpLongDec ( "       Connections       :", rxmqcbp->Conns                       ) ;
+    for ( i = 0 ; i < MAXCONNS ; i++ )
+      if ( rxmqcbp->QM[i].QMh != 0 )
+        printf("       QM[%.2d] %.48s handle %0*"PRIX32" read ahead %"PRId32" session %"PRId32"\n",
+               i, rxmqcbp->QM[i].QMname, (int)(2*sizeof(MQHCONN)),
+               (uint32_t)rxmqcbp->QM[i].QMh, (int32_t)rxmqcbp->QM[i].ReadAhead,
+               (int32_t)rxmqcbp->QM[i].Sess) ;
+    for ( i = 0 ; i < MAXCONNS ; i++ )
+      if ( (rxmqcbp->QM[i].QMh != 0) && UOW_AUTO(&rxmqcbp->QM[i]) )
+        printf("       QM[%.2d] auto-commit %"PRId32" ops %"PRId32" bytes %"PRId32" ms limit %"PRId32" pending %"PRId32"\n",
+               i, (int32_t)rxmqcbp->QM[i].AutoMsgs, (int32_t)rxmqcbp->QM[i].AutoBytes,
+               (int32_t)rxmqcbp->QM[i].AutoMs, (int32_t)rxmqcbp->QM[i].AutoLimit,
+               (int32_t)rxmqcbp->QM[i].Pending) ;
+
+    DumpLongDec ( "       Object slots      :", rxmqcbp->Objsize             ) ;
+    DumpLongDec ( "       Cache size        :", rxmqcbp->Cache.max           ) ;
+    DumpLongDec ( "       Cache idle        :", rxmqcbp->Cache.idle          ) ;
+    DumpLongDec ( "       Cache hits        :", rxmqcbp->Cache.hits          ) ;
+    DumpLongDec ( "       Cache misses      :", rxmqcbp->Cache.misses        ) ;
+    for(i=1; i < rxmqcbp->Objsize; i++)
+      if (rxmqcbp->Obj[i].Qh)
+        printf("       Obj[%.2d] %-10"PRId32" :<%0*"PRIX32">%s QM[%.2d] %.48s opts %"PRId32" maxmsgl %"PRId32" est %"PRId32"\n",
+               i, (int32_t)((rxmqcbp->Obj[i].gen << OBJSLOTBITS) | i),
+               (int)(2*sizeof(MQHOBJ)), (uint32_t)rxmqcbp->Obj[i].Qh,
+               rxmqcbp->Obj[i].idle ? " idle" : (rxmqcbp->Obj[i].shared ? " shared" : ""), (int)rxmqcbp->Obj[i].conn, rxmqcbp->Obj[i].name, (int32_t)rxmqcbp->Obj[i].options,
+               (int32_t)rxmqcbp->Obj[i].maxmsgl, (int32_t)rxmqcbp->Obj[i].est ) ;
+    for(i=0; i < MAXBUFS; i++)
+      if (rxmqcbp->Buf[i].ptr)
+        printf("       Buf[%d]            :%p <%"PRId32">\n",
+               i, rxmqcbp->Buf[i].ptr, (int32_t)rxmqcbp->Buf[i].size ) ;
+    DumpLongDec ( "       Arena size        :", (MQLONG)rxmqcbp->Arena.size  ) ;
+    DumpLongDec ( "       Buffer mallocs    :", rxmqcbp->Stats.bufnew        ) ;
+    DumpLongDec ( "       Buffers reused    :", rxmqcbp->Stats.bufreuse      ) ;
+    DumpLongDec ( "       Arena mallocs     :", rxmqcbp->Stats.arenanew      ) ;
+    DumpLongDec ( "       Arena reuses      :", rxmqcbp->Stats.arenareuse    ) ;
     printf( "\n") ;
    }
 
@@ -720,6 +2030,19 @@
      DumpLongDec ( "     ResObjectString.CCSI:", sdp->ResObjectString.VSCCSID )               ;
      printf( "\n") ;
     }
+
+  if ( !memcmp(cbptr, MQCNO_STRUC_ID, sizeof(MQCHAR4)))       // Format MQCNO
+    {
+     cnop = (MQCNO *) cbptr;
+     printf( "\n") ;
+     DumpString  ( "MQCNO StrucId            :", cnop->StrucId, sizeof(MQCHAR4)  )            ;
+     DumpLongDec ( "     Version             :", cnop->Version )                              ;
+     DumpLongHex ( "     Options             :", cnop->Options )                              ;
+     DumpPointer ( "     ClientConnPtr       :", cnop->ClientConnPtr )                        ;
+     DumpBytes   ( "     ConnectionId        :", cnop->ConnectionId, sizeof(MQBYTE24) )       ;
+     DumpString  ( "     ApplName            :", cnop->ApplName, sizeof(MQCHAR28) )           ;
+     printf( "\n") ;
+    }
  }
 
 
@@ -746,6 +2069,45 @@ void parm_to_ulong ( RXSTRING   parm    // parameter REXX string
   }
 }
 
+//
+// conn_qm - the handle of a connection to the named QM, or 0 if there
+//           is none
+//
+MQHCONN conn_qm ( RXMQCB   * anchor       // RXMQ Control Block
+                , char     * qm           // QM name
+                )
+{
+ int                     i                ;  // Connection
+
+ for ( i = 0 ; i < MAXCONNS ; i++ )
+   if ( (anchor->QM[i].QMh != 0) && !strcmp(anchor->QM[i].QMname, qm) ) return anchor->QM[i].QMh ;
+
+ return 0 ;
+}
+
+//
+// Fetch connection id from optional REXX function parameter n,
+//       0 (the default connection) when it is omitted.
+//       Returns 0, or -1 if it is not a connection id.
+//
+int parm_to_conn ( MQLONG     aargc   // number of parameters
+                 , PRXSTRING  aargv   // parameters
+                 , int        n       // which one (from 0)
+                 , int      * conn    // received connection id
+                 )
+{
+  MQULONG i  ;
+ *conn = 0   ;
+ if ( (aargc <= n) || RXNULLSTRING(aargv[n]) ) return 0 ;
+ if ( (aargv[n].strlength == 0) || (aargv[n].strlength > 2) ) return -1 ;
+ for(i=0; i<aargv[n].strlength; i++)
+  {
+   if((aargv[n].strptr[i] < '0') || (aargv[n].strptr[i] > '9')) return -1 ;
+   else *conn = (*conn)*10 + ((aargv[n].strptr[i]) & 0x0f);
+  }
+ return ( *conn < MAXCONNS ) ? 0 : -1 ;
+}
+
 //
 // Fetch MQPTR value from REXX variable (no conversion required!)
 //
@@ -822,87 +2184,6 @@ void stem_to_long ( MQULONG    traceid      // trace id of caller
  return ;
 } // End of stem_to_long
 
-//
-// Fetch MQINT64 value from REXX stem variable
-//
-void stem_to_int64 ( MQULONG    traceid      // trace id of caller
-                   , RXSTRING   stem         // stem variable name high
-                   , char       name[]       // stem variable name low
-                   , MQINT64 *  number       // received value
-                   )
-{
- char                    varnamc[100] ;  // Char version of variable name
- char                    varvalc[100] ;  // Char version of variable value
- SHVBLOCK                sv1          ;  // REXX var interface CB
- int                     sv1rc        ;  // REXX var interface RC
-
- memset(&varvalc,0,sizeof(varvalc))   ; // Clear REXX variable value buffer
- sv1.shvnext     = 0                  ; // Fetch only one variable
- sv1.shvcode     = RXSHV_SYFET        ; // Fetch operation
- sv1.shvret      = 0                  ; // Zero out RC
-
- sprintf(varnamc,"%.*s%s",(int)stem.strlength,stem.strptr,name)    ; // Construct REXX variable name
- MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))                 ; // Construct REXX variable name structure
- sv1.shvnamelen  = sv1.shvname.strlength                           ; // REXX variable name length
-
- sv1.shvvalue.strptr    = varvalc                   ; // Set pointer to value buffer for REXX
- sv1.shvvalue.strlength = sizeof(varvalc)           ; // Set max accepted value length
- sv1.shvvaluelen        = sv1.shvvalue.strlength    ; // Actual length will be here
-
- sv1rc           = RexxVariablePool(&sv1)           ; // Call REXX variable interface
-
- TRACE(traceid, ("RXfetch rc = %d, %s ->%s<-%"PRIu32"/%"PRIu32"\n",
-                 sv1rc,varnamc,varvalc,(uint32_t)sv1.shvvaluelen,(uint32_t)sizeof(varvalc))
-                ) ;
-
- if (    (sv1rc               == RXSHV_OK)
-      && (strlen(varvalc)     != 0       ) )
-//        sscanf(varvalc,"%llu",number)                 ; // long int value
-          sscanf(varvalc,"%"SCNu64"",(uint64_t*)number) ; // workaround for UNIX/Linux
- return ;
-} // End of stem_to_int64
-
-//
-// Fetch single MQCHAR value from REXX variable
-//
-void stem_to_char ( MQULONG    traceid      // trace id of caller
-                  , RXSTRING   stem         // stem variable name high
-                  , char       name[]       // stem variable name low
-                  , MQCHAR *   letter       // received value
-                  )
-{
- char                    varnamc[100] ;  // Char version of variable name
- char                    varvalc[100] ;  // Char version of variable value
- SHVBLOCK                sv1          ;  // REXX var interface CB
- int                     sv1rc        ;  // REXX var interface RC
-
- memset(&varvalc,0,sizeof(varvalc))   ; // Clear REXX variable value buffer
- sv1.shvnext     = 0                  ; // Fetch only one variable
- sv1.shvcode     = RXSHV_SYFET        ; // Fetch operation
- sv1.shvret      = 0                  ; // Zero out RC
-
- sprintf(varnamc,"%.*s%s",(int)stem.strlength,stem.strptr,name) ; // Construct REXX variable name
- MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))        ; // Construct REXX variable name structure
- sv1.shvnamelen  = sv1.shvname.strlength                  ; // REXX variable name length
-
- sv1.shvvalue.strptr    = varvalc                         ; // Set pointer to value buffer for REXX
- sv1.shvvalue.strlength = sizeof(varvalc)                 ; // Set max accepted value length
- sv1.shvvaluelen        = sv1.shvvalue.strlength          ; // Actual length will be here
-
- sv1rc           = RexxVariablePool(&sv1)                 ; // Call REXX variable interface
-
- TRACE(traceid, ("RXfetch rc = %d, %s ->%s<-%"PRIu32"/%"PRIu32"\n",
-                 sv1rc,varnamc,varvalc,(uint32_t)sv1.shvvaluelen,(uint32_t)sizeof(varvalc))
-      ) ;
-
- if (    (sv1rc                          == RXSHV_OK)
-         && (strlen(varvalc)             != 0       ))
-         *letter = varvalc[0]                         ; // char value
-
- return ;
-} // End of stem_to_char
-
-
 //
 // Fetch string MQCHAR value from REXX variable
 //
@@ -950,54 +2231,6 @@ void stem_to_string ( MQULONG    traceid      // trace id of caller
  return ;
 } // End of stem_to_string
 
-//
-// Fetch MQBYTE value from REXX variable
-// Use this only for MQBYTExx variables
-//
-void stem_to_bytes  ( MQULONG    traceid      // trace id of caller
-                    , RXSTRING   stem         // stem variable name high
-                    , char       name[]   // stem variable name low
-                    , MQBYTE     string[] // received value
-                    , int        size         // max size of value
-                    )
-{
- char                    varnamc[100] ;  // Char version of variable name
- MQBYTE                  varvalc[100] ;  // Char version of variable value
- SHVBLOCK                sv1          ;  // REXX var interface CB
- int                     sv1rc        ;  // REXX var interface RC
-
- if ( size > (int) sizeof(varvalc) )   // should never happen
-   {
-   TRACE(traceid, ("Size = %d more than buffer length %"PRIu32" !\n",
-                   size,(uint32_t)sizeof(varvalc))
-        ) ;
-    return ;
-   }
- memset(&varvalc,0,sizeof(varvalc))   ; // For readability only
-
- sv1.shvnext     = 0                  ; // Fetch only one variable
- sv1.shvcode     = RXSHV_SYFET        ; // Fetch operation
- sv1.shvret      = 0                  ; // Zero out RC
-
- sprintf(varnamc,"%.*s%s",(int)stem.strlength,stem.strptr,name) ; // Construct REXX variable name
- MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))              ; // Construct REXX variable name structure
- sv1.shvnamelen  = sv1.shvname.strlength                        ; // REXX variable name length
-
- sv1.shvvalue.strptr    = (char *) varvalc       ; // Set pointer to value buffer for REXX
- sv1.shvvalue.strlength = size                   ; // Set max accepted value length
- sv1.shvvaluelen        = sv1.shvvalue.strlength ; // Actual length will be here
-
- sv1rc           = RexxVariablePool(&sv1)        ; // Call REXX variable interface
-
- TRACE(traceid, ("RXfetch rc = %d, %s ->",sv1rc,varnamc) )               ;
- TRACX(traceid, (varvalc,sv1.shvvaluelen) )                              ;
- TRACE(traceid, ("<-%"PRIu32"/%d\n",(uint32_t)sv1.shvvaluelen,size) )    ;
-
- if (sv1rc == RXSHV_OK) memcpy(string, &varvalc, sv1.shvvalue.strlength) ;
-                                                   // Return value, only if OK!
- return ;
-} // End of stem_to_bytes
-
 //
 // Fetch long MQBYTE value from REXX variable
 // Buffer is provided by the caller
@@ -1035,44 +2268,6 @@ MQULONG stem_to_data ( MQULONG    traceid      // trace id of caller
  else                   return 0                           ;
 } // End of stem_to_data
 
-//
-// Fetch MQCHARV value from REXX variable
-//
-void stem_to_strinv ( MQULONG    traceid     // trace id of caller
-                    , RXSTRING   stem        // stem variable name high
-                    , char       name[]  // stem variable name low
-                    , MQCHARV *  string      // received value
-                    )
-{
- char                    varnamc[100] ;  // Char version of variable name
- RXSTRING                varname          ;  // REXX variable name
-
- sprintf(varnamc,"%.*s%s",(int)stem.strlength,stem.strptr,name) ; // Construct REXX variable name
- MAKERXSTRING(varname,varnamc,strlen(varnamc))                  ; // Construct REXX variable name structure
-
- stem_to_long  (traceid, varname, ".0" ,    &string->VSBufSize)    ; // Assume it is buffer length
- stem_to_long  (traceid, varname, ".CCSI" , &string->VSCCSID)      ; // CCSID may be required
-
- //
- // Allocate data buffer to store stem.name.1 variable data.
- // Buffer will be freed during call to stem_from_strinv
- //
- if ( string->VSBufSize != 0 )
-   {
-    TRACE(traceid, ("Doing malloc for %"PRId32" bytes",(int32_t)string->VSBufSize))  ;
-    string->VSPtr = malloc(string->VSBufSize)                         ;
-    if ( string->VSPtr == NULL )
-      {
-       TRACE(traceid, ("malloc rc %d\n",errno) )                      ;
-       string->VSBufSize = 0                                          ;
-      }
-    else string->VSLength = stem_to_data(traceid, varname, ".1",
-                                   (MQBYTE *)string->VSPtr, string->VSBufSize) ;
-   }
-
- return ;
-} // End of stem_to_strinv
-
 //
 // Set REXX variable to MQPTR value (no conversion required!)
 //
@@ -1146,17 +2341,17 @@ void stem_from_long ( MQULONG    traceid  // trace id of caller
 } // End of stem_from_long
 
 //
-// Set REXX variable to MQINT64 value
+// Set REXX variable to MQCHAR string value
 //
-void stem_from_int64 ( MQULONG    traceid  // trace id of caller
-                     , char       zlist[]  // .ZLIST string for accumulation
-                     , RXSTRING   stem     // stem variable name high
-                     , char       name[]   // stem variable name low
-                     , MQINT64    number   // value to set
-                     )
+void stem_from_string ( MQULONG    traceid  // trace id of caller
+                      , char       zlist[]  // .ZLIST string for accumulation
+                      , RXSTRING   stem     // stem variable name high
+                      , char       name[]   // stem variable name low
+                      , MQCHAR     string[] // value to set
+                      , int        size     // full size of value
+                      )
 {
  char                    varnamc[100] ;  // Char version of variable name
- char                    varvalc[100] ;  // Char version of variable value
  SHVBLOCK                sv1          ;  // REXX var interface CB
  int                     sv1rc        ;  // REXX var interface RC
 
@@ -1168,15 +2363,14 @@ void stem_from_int64 ( MQULONG    traceid  // trace id of caller
  MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))              ; // Construct REXX variable name structure
  sv1.shvnamelen  = sv1.shvname.strlength                        ; // REXX variable name length
 
-// sprintf((char *)varvalc,"%lld",number)              ; // Convert MQINT64 to char
- sprintf((char *)varvalc,"%"PRIu64,(uint64_t)number) ; // Convert MQINT64 to char (workaround for ..IX)
- MAKERXSTRING(sv1.shvvalue,varvalc,strlen(varvalc))  ; // Construct REXX variable value structure
- sv1.shvvaluelen = sv1.shvvalue.strlength            ; // Set actual value length for REXX
+ if ( memchr(string,0,size) != NULL ) sv1.shvvaluelen = strlen(string) ; // If null-terminated
+ else sv1.shvvaluelen = size                                           ; // else take full string
+ MAKERXSTRING(sv1.shvvalue,string,sv1.shvvaluelen)   ; // Construct REXX variable value structure
 
  sv1rc           = RexxVariablePool(&sv1)            ; // Call REXX variable interface
 
- TRACE(traceid, ("RXset rc = %d, %s ->%s<-%"PRIu32"/%"PRIu32"\n",
-                 sv1rc,varnamc,varvalc,(uint32_t)sv1.shvvaluelen,(uint32_t)strlen(varvalc))
+ TRACE(traceid, ("RXset rc = %d, %s ->%.*s<-%"PRIu32"/%d\n",
+                 sv1rc,varnamc,size,string,(uint32_t)sv1.shvvaluelen,size)
       ) ;
 
  if (   ((sv1rc == RXSHV_OK) || (sv1rc == RXSHV_NEWV))
@@ -1185,1554 +2379,7612 @@ void stem_from_int64 ( MQULONG    traceid  // trace id of caller
      strcat(zlist," ")        ;
      strcat(zlist,name)       ;
  }
+
  return ;
-} // End of stem_from_int64
+} // End of stem_from_string
 
 //
-// Set REXX variable to single MQCHAR value
+// Set REXX variable to MQBYTE string value
 //
-void stem_from_char ( MQULONG    traceid  // trace id of caller
-                    , char       zlist[]  // .ZLIST string for accumulation
-                    , RXSTRING   stem     // stem variable name high
-                    , char       name[]   // stem variable name low
-                    , MQCHAR     letter   // value to set
-                    )
+void stem_from_bytes  ( MQULONG    traceid   // trace id of caller
+                      , char       zlist[]   // .ZLIST string for accumulation
+                      , RXSTRING   stem      // stem variable name high
+                      , char     * name      // stem variable name low
+                      , MQBYTE   * string    // value to set
+                      , int        size      // full size of value
+                      )
 {
- char                    varnamc[100] ;  // Char version of variable name
- SHVBLOCK                sv1          ;  // REXX var interface CB
- int                     sv1rc        ;  // REXX var interface RC
+ char                    varnamc[100]     ;  // Char version of variable name
+ SHVBLOCK                sv1              ;  // REXX var interface CB
+ int                     sv1rc            ;  // REXX var interface RC
 
- sv1.shvnext     = 0           ; // Set only one variable
- sv1.shvcode     = RXSHV_SYSET ; // Set operation
- sv1.shvret      = 0           ; // Zero out RC
+ sv1.shvnext     = 0                      ; // Set only one variable
+ sv1.shvcode     = RXSHV_SYSET            ; // Set operation
+ sv1.shvret      = 0                      ; // Zero out RC
 
  sprintf(varnamc,"%.*s%s",(int)stem.strlength,stem.strptr,name) ; // Construct REXX variable name
  MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))              ; // Construct REXX variable name structure
  sv1.shvnamelen  = sv1.shvname.strlength                        ; // REXX variable name length
 
- MAKERXSTRING(sv1.shvvalue,&letter,sizeof(MQCHAR))  ; // Construct REXX variable value structure
- sv1.shvvaluelen = sv1.shvvalue.strlength           ; // Set actual value length for REXX
-
- sv1rc           = RexxVariablePool(&sv1)           ; // Call REXX variable interface
+ MAKERXSTRING(sv1.shvvalue,(char*)string,size)                  ; // Construct REXX variable value structure
+ sv1.shvvaluelen = sv1.shvvalue.strlength                       ; // Set actual value length for REXX
 
- TRACE(traceid, ("RXset rc = %d, %s ->%c<-%"PRIu32"/%"PRIu32"\n",
-                 sv1rc,varnamc,letter,(uint32_t)sv1.shvvaluelen,(uint32_t)sizeof(MQCHAR))
-      ) ;
+ sv1rc           = RexxVariablePool(&sv1)                       ; // Call REXX variable interface
+
+ TRACE(traceid, ("RXset rc = %d, %s ->",sv1rc,varnamc) )       ;
+ TRACX(traceid, (string,sv1.shvvaluelen) )                      ;
+ TRACE(traceid, ("<-%"PRIu32"/%d\n",(uint32_t)sv1.shvvaluelen,size) ) ;
 
  if (   ((sv1rc == RXSHV_OK) || (sv1rc == RXSHV_NEWV))
      && (zlist != NULL))
  {
-     strcat(zlist," ")        ;
-     strcat(zlist,name)       ;
+     strcat(zlist," ")                      ;
+     strcat(zlist,(const char *)name)       ;
  }
 
  return ;
-} // End of stem_from_char
+} // End of stem_from_bytes
 
 //
-// Set REXX variable to MQCHAR string value
+// Chained variable pool access
+//
+//   A descriptor is transferred to/from REXX by building one SHVBLOCK
+//   list (linked by shvnext) and handing it to a single RexxVariablePool
+//   call, rather than calling the pool once per field. The individual
+//   result of every block is then found in its shvret.
+//
+//   SHVCHAIN holds the blocks together with the buffers for variable
+//   names and short (numeric, name, id) values, so nothing is allocated.
 //
-void stem_from_string ( MQULONG    traceid  // trace id of caller
-                      , char       zlist[]  // .ZLIST string for accumulation
-                      , RXSTRING   stem     // stem variable name high
-                      , char       name[]   // stem variable name low
-                      , MQCHAR     string[] // value to set
-                      , int        size     // full size of value
-                      )
-{
- char                    varnamc[100] ;  // Char version of variable name
- SHVBLOCK                sv1          ;  // REXX var interface CB
- int                     sv1rc        ;  // REXX var interface RC
-
- sv1.shvnext     = 0                  ; // Set only one variable
- sv1.shvcode     = RXSHV_SYSET        ; // Set operation
- sv1.shvret      = 0                  ; // Zero out RC
 
- sprintf(varnamc,"%.*s%s",(int)stem.strlength,stem.strptr,name) ; // Construct REXX variable name
- MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))              ; // Construct REXX variable name structure
- sv1.shvnamelen  = sv1.shvname.strlength                        ; // REXX variable name length
+ #define MAXCHAIN  48    // Max SHVBLOCKs in a chain
+ #define VARNAMLEN 100   // Max length of a REXX variable name
+ #define VARVALLEN 100   // Max length of a short REXX variable value
 
- if ( memchr(string,0,size) != NULL ) sv1.shvvaluelen = strlen(string) ; // If null-terminated
- else sv1.shvvaluelen = size                                           ; // else take full string
- MAKERXSTRING(sv1.shvvalue,string,sv1.shvvaluelen)   ; // Construct REXX variable value structure
+ typedef struct _SHVCHAIN {
+     int        count                      ; // Number of blocks in use
+     SHVBLOCK   sv[MAXCHAIN]               ; // The chained blocks
+     char       bin[MAXCHAIN]              ; // Value is binary (for trace)
+     char       name[MAXCHAIN][VARNAMLEN]  ; // Variable names
+     char       value[MAXCHAIN][VARVALLEN] ; // Short variable values
+ } SHVCHAIN ;
 
- sv1rc           = RexxVariablePool(&sv1)            ; // Call REXX variable interface
+//
+// Build a REXX variable name from stem + tail + suffix.
+// Returns the name length, or 0 if it will not fit.
+//
+size_t make_varname ( char       varnamc[]  // output name buffer (VARNAMLEN)
+                    , RXSTRING   stem       // stem variable name high
+                    , char       tail[]     // stem variable name low
+                    , char       suffix[]   // added after tail (or NULL)
+                    )
+{
+ size_t                  taillen   = strlen(tail)                         ;
+ size_t                  sufflen   = (suffix == NULL) ? 0 : strlen(suffix) ;
 
- TRACE(traceid, ("RXset rc = %d, %s ->%.*s<-%"PRIu32"/%d\n",
-                 sv1rc,varnamc,size,string,(uint32_t)sv1.shvvaluelen,size)
-      ) ;
+ if ( stem.strlength + taillen + sufflen >= VARNAMLEN ) return 0          ;
 
- if (   ((sv1rc == RXSHV_OK) || (sv1rc == RXSHV_NEWV))
-     && (zlist != NULL))
- {
-     strcat(zlist," ")        ;
-     strcat(zlist,name)       ;
- }
+ memcpy(varnamc, stem.strptr, stem.strlength)                             ;
+ memcpy(varnamc + stem.strlength, tail, taillen)                          ;
+ if ( sufflen != 0 ) memcpy(varnamc + stem.strlength + taillen, suffix, sufflen) ;
+ varnamc[stem.strlength + taillen + sufflen] = '\0'                       ;
 
- return ;
-} // End of stem_from_string
+ return stem.strlength + taillen + sufflen                                ;
+} // End of make_varname
 
 //
-// Set REXX variable to MQBYTE string value
+// Convert a REXX number to binary, like sscanf("%d") would:
+//   leading blanks, an optional sign, then at least one digit.
+// Returns 1 if a number was found, 0 otherwise (value untouched).
 //
-void stem_from_bytes  ( MQULONG    traceid   // trace id of caller
-                      , char       zlist[]   // .ZLIST string for accumulation
-                      , RXSTRING   stem      // stem variable name high
-                      , char     * name      // stem variable name low
-                      , MQBYTE   * string    // value to set
-                      , int        size      // full size of value
-                      )
+int str_to_num ( char     * string    // value characters
+               , size_t     len       // value length
+               , uint64_t * number    // received value
+               )
 {
- char                    varnamc[100]     ;  // Char version of variable name
- SHVBLOCK                sv1              ;  // REXX var interface CB
- int                     sv1rc            ;  // REXX var interface RC
+ size_t                  i     = 0    ;
+ size_t                  first        ;
+ int                     minus = 0    ;
+ uint64_t                value = 0    ;
 
- sv1.shvnext     = 0                      ; // Set only one variable
- sv1.shvcode     = RXSHV_SYSET            ; // Set operation
- sv1.shvret      = 0                      ; // Zero out RC
+ while ( (i < len) && isspace((unsigned char)string[i]) ) i++ ;
+ if ( (i < len) && ((string[i] == '-') || (string[i] == '+')) )
+    minus = (string[i++] == '-')                              ;
 
- sprintf(varnamc,"%.*s%s",(int)stem.strlength,stem.strptr,name) ; // Construct REXX variable name
- MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))              ; // Construct REXX variable name structure
- sv1.shvnamelen  = sv1.shvname.strlength                        ; // REXX variable name length
+ for ( first = i ; (i < len) && (string[i] >= '0') && (string[i] <= '9') ; i++ )
+    value = value*10 + (string[i] - '0')                      ;
 
- MAKERXSTRING(sv1.shvvalue,(char*)string,size)                  ; // Construct REXX variable value structure
- sv1.shvvaluelen = sv1.shvvalue.strlength                       ; // Set actual value length for REXX
+ if ( i == first ) return 0                                   ; // no digits
 
- sv1rc           = RexxVariablePool(&sv1)                       ; // Call REXX variable interface
+ *number = minus ? (uint64_t)0 - value : value                ;
+ return 1                                                     ;
+} // End of str_to_num
 
- TRACE(traceid, ("RXset rc = %d, %s ->",sv1rc,varnamc) )       ;
- TRACX(traceid, (string,sv1.shvvaluelen) )                      ;
- TRACE(traceid, ("<-%"PRIu32"/%d\n",(uint32_t)sv1.shvvaluelen,size) ) ;
+//
+// Convert a binary number to REXX characters (0-terminated).
+// Returns the number of characters produced.
+//
+size_t num_to_str ( char       string[]   // output buffer (21+ chars)
+                  , uint64_t   number     // magnitude
+                  , int        minus      // add a leading '-'
+                  )
+{
+ char                    digits[24]      ;
+ size_t                  n   = 0         ;
+ size_t                  len = 0         ;
 
- if (   ((sv1rc == RXSHV_OK) || (sv1rc == RXSHV_NEWV))
-     && (zlist != NULL))
- {
-     strcat(zlist," ")                      ;
-     strcat(zlist,(const char *)name)       ;
- }
+ do { digits[n++] = (char)('0' + number%10) ; number /= 10 ; } while ( number != 0 ) ;
 
- return ;
-} // End of stem_from_bytes
+ if ( minus ) string[len++] = '-'        ;
+ while ( n > 0 ) string[len++] = digits[--n] ;
+ string[len] = '\0'                      ;
+
+ return len                              ;
+} // End of num_to_str
 
 //
-// Set REXX variable to MQCHARV value
+// Add a block to a chain. Name is stem+tail+suffix.
+// The value points at the chain's own short value buffer, unless
+// the caller changes it. Returns NULL if the chain is full or the
+// name is too long.
 //
-void stem_from_strinv ( MQULONG    traceid      // trace id of caller
-                      , char       zlist[]      // .ZLIST string for accumulation
-                      , RXSTRING   stem         // stem variable name high
-                      , char       name[]       // stem variable name low
-                      , MQCHARV    string       // value to set
-                      )
+SHVBLOCK * shv_add ( SHVCHAIN   * chain     // chain to extend
+                   , int          code      // RXSHV_SYFET or RXSHV_SYSET
+                   , RXSTRING     stem      // stem variable name high
+                   , char         tail[]    // stem variable name low
+                   , char         suffix[]  // added after tail (or NULL)
+                   )
 {
- char                   varnamc[100] ;      // Char version of variable name
+ SHVBLOCK              * sv                ;
+ size_t                  namelen           ;
 
- stem_from_long  (traceid, zlist, stem,
-                  strcat(strcpy(varnamc,name),".0"),
-                  string.VSLength)                          ;
- stem_from_long  (traceid, zlist, stem,
-                  strcat(strcpy(varnamc,name),".CCSI"),
-                  string.VSCCSID)                           ;
- //
- // Free data buffer for stem.name.1 variable data, if allocated.
- //
- if ( string.VSPtr != 0 )
-    {
-     stem_from_bytes (traceid, zlist, stem,
-                      strcat(strcpy(varnamc,name),".1"),
-                      (MQBYTE *)string.VSPtr, string.VSLength)  ;
-     TRACE(traceid, ("Freemaining VS area\n"))                  ;
-     free(string.VSPtr)                                         ;
-    }
+ if ( chain->count >= MAXCHAIN ) return NULL ;
 
- return ;
-} // End of stem_from_strinv
+ namelen = make_varname(chain->name[chain->count], stem, tail, suffix) ;
+ if ( namelen == 0 ) return NULL            ;
 
+ sv = &chain->sv[chain->count]              ;
+ sv->shvnext     = NULL                     ;
+ sv->shvcode     = code                     ;
+ sv->shvret      = 0                        ;
+ MAKERXSTRING(sv->shvname, chain->name[chain->count], namelen) ;
+ sv->shvnamelen  = namelen                  ;
+ MAKERXSTRING(sv->shvvalue, chain->value[chain->count], VARVALLEN) ;
+ sv->shvvaluelen = VARVALLEN                ;
+ chain->bin[chain->count] = 0               ;
 
-// set_entry is called at the beginning of each external function execution
-//
-// Tracing is controlled by the TRACE macro.
-//
-//         If the dynamic usage of TRACE is set, then the
-//            set_entry routine determines whether or not data
-//            is printed (based on the RXMQTRACE Rexx var).
-//
+ if ( chain->count > 0 ) chain->sv[chain->count-1].shvnext = sv ;
+ chain->count++                             ;
+
+ return sv                                  ;
+} // End of shv_add
 
 //
-// set_entry will obtain the trace setting currently in effect,
-//             and set tracebits variable for later checking in DEBUG macros
-//
-//         Known settings are :
+// Add a fetch block; value goes to buffer (or the chain's own buffer
+// if buffer is NULL) up to size characters.
 //
-//                              CONN  -> mqconn
-//                              DISC  -> mqdisc
-//                              OPEN  -> mqopen
-//                              CLOSE -> mqclose
-//                              GET   -> mqget
-//                              PUT   -> mqput
-//                              PUT1  -> mqput1
-//                              INQ   -> mqinq
-//                              SET   -> mqset
-//                              CMIT  -> mqcmit
-//                              BACK  -> mqback
-//                              SUB   -> mqsub
+SHVBLOCK * shv_fetch ( SHVCHAIN   * chain     // chain to extend
+                     , RXSTRING     stem      // stem variable name high
+                     , char         tail[]    // stem variable name low
+                     , char         suffix[]  // added after tail (or NULL)
+                     , void       * buffer    // value buffer (or NULL)
+                     , size_t       size      // max size of value
+                     )
+{
+ SHVBLOCK              * sv = shv_add(chain, RXSHV_SYFET, stem, tail, suffix) ;
+
+ if ( sv == NULL ) return NULL                                      ;
+ if ( buffer != NULL )
+   {
+    MAKERXSTRING(sv->shvvalue, buffer, size)                        ;
+    chain->bin[chain->count-1] = 1                                  ;
+   }
+ else if ( size < VARVALLEN ) sv->shvvalue.strlength = size          ;
+ sv->shvvaluelen = sv->shvvalue.strlength                            ;
+
+ return sv                                                          ;
+} // End of shv_fetch
+
 //
-//                              BRO   -> Browse extension
-//                              HXT   -> Header extraction extension
-//                              EVENT -> Event determination extension
-//                              TM    -> Trigger message extension
-//                              COM   -> Command interface
-//                              MQV   -> Debug a RXMQV
+// Add a set block for a string/byte value (value is not copied!)
 //
-//                              INIT  -> initialization processing
-//                              TERM  -> Deregistration processing
+SHVBLOCK * shv_set ( SHVCHAIN   * chain     // chain to extend
+                   , RXSTRING     stem      // stem variable name high
+                   , char         tail[]    // stem variable name low
+                   , char         suffix[]  // added after tail (or NULL)
+                   , void       * value     // value to set
+                   , size_t       size      // length of value
+                   , int          binary    // value is binary (for trace)
+                   )
+{
+ SHVBLOCK              * sv = shv_add(chain, RXSHV_SYSET, stem, tail, suffix) ;
+
+ if ( sv == NULL ) return NULL                    ;
+ MAKERXSTRING(sv->shvvalue, value, size)          ;
+ sv->shvvaluelen = size                           ;
+ chain->bin[chain->count-1] = (char) binary       ;
+
+ return sv                                        ;
+} // End of shv_set
+
 //
-//                              *     -> Trace everything!!!
+// Add a set block for a MQLONG value
 //
+SHVBLOCK * shv_set_long ( SHVCHAIN   * chain     // chain to extend
+                        , RXSTRING     stem      // stem variable name high
+                        , char         tail[]    // stem variable name low
+                        , char         suffix[]  // added after tail (or NULL)
+                        , int32_t      number    // value to set
+                        )
+{
+ SHVBLOCK              * sv = shv_add(chain, RXSHV_SYSET, stem, tail, suffix) ;
+
+ if ( sv == NULL ) return NULL                                     ;
+ sv->shvvalue.strlength = num_to_str(sv->shvvalue.strptr,
+                                     (number < 0) ? (uint64_t)0 - (uint64_t)(int64_t)number
+                                                  : (uint64_t)number,
+                                     number < 0)                   ;
+ sv->shvvaluelen        = sv->shvvalue.strlength                   ;
+
+ return sv                                                         ;
+} // End of shv_set_long
+
 //
-//  These settings are extracted from the RXMQTRACE Rexx Variable
-//    (so RXMQTRACE = 'INQ OPEN' will trace Open and Inq operations)
+// Add a set block for a MQINT64 value (shown unsigned, as before)
 //
+SHVBLOCK * shv_set_int64 ( SHVCHAIN   * chain     // chain to extend
+                         , RXSTRING     stem      // stem variable name high
+                         , char         tail[]    // stem variable name low
+                         , char         suffix[]  // added after tail (or NULL)
+                         , MQINT64      number    // value to set
+                         )
+{
+ SHVBLOCK              * sv = shv_add(chain, RXSHV_SYSET, stem, tail, suffix) ;
+
+ if ( sv == NULL ) return NULL                                         ;
+ sv->shvvalue.strlength = num_to_str(sv->shvvalue.strptr, (uint64_t)number, 0) ;
+ sv->shvvaluelen        = sv->shvvalue.strlength                       ;
+
+ return sv                                                             ;
+} // End of shv_set_int64
+
 //
+// Pass the whole chain to REXX in one go, and trace the outcome
 //
-
-MQLONG  set_envir ( char     * func        // Current function executed
-                  , MQULONG  * traceidptr  // Trace bitmask
-                  , RXMQCB  ** anchorptr   // pointer to RXMQCB pointer
-                  )
+void shv_run ( MQULONG    traceid   // trace id of caller
+             , SHVCHAIN * chain     // chain to process
+             )
 {
-  RXSTRING              varname      ;  // Variable name
-  char                  varvalc[100] ;  // Char version of variable
-  MQLONG                rc = 0       ;
+ int                     i                ;
+ int                     sv1rc            ;  // REXX var interface RC
 
-// First of all let's try to access our anchor control block for the current thread.
-// It may or may not exist when calling RXMQ function.
-// If exists, use it; otherwise create it.
-// This control block is a RXMQCB structure, which address is assigned to REXX RXMQANCHOR variable.
+ if ( chain->count == 0 ) return          ;
 
- var_to_ptr (ZERO, RXMQANCHOR , (void **) anchorptr)  ;
+ sv1rc = RexxVariablePool(&chain->sv[0])  ; // Call REXX variable interface once
 
- if ( (*anchorptr) == NULL    )
+ TRACE(traceid, ("RXpool rc = %d for %d variables\n",sv1rc,chain->count) ) ;
+ for ( i = 0 ; i < chain->count ; i++ )
    {
-    TRACES(("Doing malloc for RXMQCB for %u bytes\n",(uint32_t)sizeof(RXMQCB))) ;
-    *anchorptr = (RXMQCB *) malloc(sizeof(RXMQCB))                    ;
-
-    if ( *anchorptr == NULL )
+    TRACE(traceid, ("RX%s rc = %d, %s ->",
+                    (chain->sv[i].shvcode == RXSHV_SYSET) ? "set" : "fetch",
+                    chain->sv[i].shvret, chain->name[i]) ) ;
+    if ( chain->bin[i] )
       {
-       TRACES(("malloc rc = %d\n",errno)) ;
-       rc = -77                           ;
+       TRACX(traceid, ((MQBYTE *)chain->sv[i].shvvalue.strptr,
+                       (MQULONG)chain->sv[i].shvvalue.strlength) ) ;
       }
     else
       {
-       var_from_ptr  (ZERO, RXMQANCHOR , *anchorptr)        ;
-       memset (*anchorptr, 0, sizeof(RXMQCB))                  ;
-       memcpy ((*anchorptr)->StrucId, RXMQeyecatcher, sizeof(MQCHAR4)) ;
+       TRACE(traceid, ("%.*s",(int)chain->sv[i].shvvalue.strlength,
+                       chain->sv[i].shvvalue.strptr) ) ;
       }
+    TRACE(traceid, ("<-%"PRIu32"\n",(uint32_t)chain->sv[i].shvvalue.strlength) ) ;
    }
 
- if (rc == 0 )
-   {
-    (*anchorptr)->tracebits = ZERO                                 ;
-
-    memset(&varvalc,0,sizeof(varvalc))                             ; // Clear REXX variable
-    MAKERXSTRING(varname,TRACEVAR,strlen(TRACEVAR))                ; // Make name like RXMQNTRACE
-    stem_to_string(ZERO, varname, "", varvalc, sizeof(varvalc))    ; // Get old-style trace variable
-    strcat(varvalc," ")                                            ; // Add a blank to tail
-
-    if ( strlen(varvalc) > 1)
-      {
-       if ( strstr(varvalc,"* "    ) != NULL) (*anchorptr)->tracebits |= ALL   ;
-       if ( strstr(varvalc,"CONN " ) != NULL) (*anchorptr)->tracebits |= CONN  ;
-       if ( strstr(varvalc,"DISC " ) != NULL) (*anchorptr)->tracebits |= DISC  ;
-       if ( strstr(varvalc,"OPEN " ) != NULL) (*anchorptr)->tracebits |= OPEN  ;
-       if ( strstr(varvalc,"CLOSE ") != NULL) (*anchorptr)->tracebits |= CLOSE ;
-       if ( strstr(varvalc,"GET "  ) != NULL) (*anchorptr)->tracebits |= GET   ;
-       if ( strstr(varvalc,"PUT "  ) != NULL) (*anchorptr)->tracebits |= PUT   ;
-       if ( strstr(varvalc,"PUT1 " ) != NULL) (*anchorptr)->tracebits |= PUT1  ;
-       if ( strstr(varvalc,"INQ "  ) != NULL) (*anchorptr)->tracebits |= INQ   ;
-       if ( strstr(varvalc,"SET "  ) != NULL) (*anchorptr)->tracebits |= SET   ;
-       if ( strstr(varvalc,"CMIT " ) != NULL) (*anchorptr)->tracebits |= CMIT  ;
-       if ( strstr(varvalc,"BACK " ) != NULL) (*anchorptr)->tracebits |= BACK  ;
-       if ( strstr(varvalc,"SUB "  ) != NULL) (*anchorptr)->tracebits |= SUB   ;
-       if ( strstr(varvalc,"BRO "  ) != NULL) (*anchorptr)->tracebits |= BRO   ;
-       if ( strstr(varvalc,"HXT "  ) != NULL) (*anchorptr)->tracebits |= HXT   ;
-       if ( strstr(varvalc,"EVENT ") != NULL) (*anchorptr)->tracebits |= EVENT ;
-       if ( strstr(varvalc,"TM "   ) != NULL) (*anchorptr)->tracebits |= TM    ;
-       if ( strstr(varvalc,"COM "  ) != NULL) (*anchorptr)->tracebits |= COM   ;
-       if ( strstr(varvalc,"MQV "  ) != NULL) (*anchorptr)->tracebits |= MQV   ;
-       if ( strstr(varvalc,"INIT " ) != NULL) (*anchorptr)->tracebits |= INIT  ;
-       if ( strstr(varvalc,"TERM " ) != NULL) (*anchorptr)->tracebits |= TERM  ;
-      }
-
-    memset(&varvalc,0,sizeof(varvalc))                             ; // Clear REXX variable
-    MAKERXSTRING(varname,"RXMQTRACE",strlen("RXMQTRACE"))          ; // Make name like RXMQTRACE
-    stem_to_string(ZERO, varname, "", varvalc, sizeof(varvalc))    ; // Get new-style trace variable
-    strcat(varvalc," ")                                            ; // Add a blank to tail
-
-    if ( strlen(varvalc) > 1)
-      {
-       if ( strstr(varvalc,"* "    ) != NULL) (*anchorptr)->tracebits |= ALL   ;
-       if ( strstr(varvalc,"CONN " ) != NULL) (*anchorptr)->tracebits |= CONN  ;
-       if ( strstr(varvalc,"DISC " ) != NULL) (*anchorptr)->tracebits |= DISC  ;
-       if ( strstr(varvalc,"OPEN " ) != NULL) (*anchorptr)->tracebits |= OPEN  ;
-       if ( strstr(varvalc,"CLOSE ") != NULL) (*anchorptr)->tracebits |= CLOSE ;
-       if ( strstr(varvalc,"GET "  ) != NULL) (*anchorptr)->tracebits |= GET   ;
-       if ( strstr(varvalc,"PUT "  ) != NULL) (*anchorptr)->tracebits |= PUT   ;
-       if ( strstr(varvalc,"PUT1 " ) != NULL) (*anchorptr)->tracebits |= PUT1  ;
-       if ( strstr(varvalc,"INQ "  ) != NULL) (*anchorptr)->tracebits |= INQ   ;
-       if ( strstr(varvalc,"SET "  ) != NULL) (*anchorptr)->tracebits |= SET   ;
-       if ( strstr(varvalc,"SUB "  ) != NULL) (*anchorptr)->tracebits |= SUB   ;
-       if ( strstr(varvalc,"CMIT " ) != NULL) (*anchorptr)->tracebits |= CMIT  ;
-       if ( strstr(varvalc,"BACK " ) != NULL) (*anchorptr)->tracebits |= BACK  ;
-       if ( strstr(varvalc,"SUB "  ) != NULL) (*anchorptr)->tracebits |= SUB   ;
-       if ( strstr(varvalc,"BRO "  ) != NULL) (*anchorptr)->tracebits |= BRO   ;
-       if ( strstr(varvalc,"HXT "  ) != NULL) (*anchorptr)->tracebits |= HXT   ;
-       if ( strstr(varvalc,"EVENT ") != NULL) (*anchorptr)->tracebits |= EVENT ;
-       if ( strstr(varvalc,"TM "   ) != NULL) (*anchorptr)->tracebits |= TM    ;
-       if ( strstr(varvalc,"COM "  ) != NULL) (*anchorptr)->tracebits |= COM   ;
-       if ( strstr(varvalc,"MQV "  ) != NULL) (*anchorptr)->tracebits |= MQV   ;
-       if ( strstr(varvalc,"INIT " ) != NULL) (*anchorptr)->tracebits |= INIT  ;
-       if ( strstr(varvalc,"TERM " ) != NULL) (*anchorptr)->tracebits |= TERM  ;
-      }
-   }
+ return ;
+} // End of shv_run
 
- if (rc == 0 )
-   {
-    *traceidptr &= (*anchorptr)->tracebits          ;
-    TRACE(*traceidptr, ("Function is <%s>\n",func)) ;
-    TRACE(*traceidptr, ("traceid = %"PRIX32"\n",(uint32_t)*traceidptr));
-    DUMPCB(*traceidptr, *anchorptr)                 ;
-   }
+//
+// Pass the chain to REXX and empty it, if fewer than room blocks are
+// left (so MAXCHAIN passes any blocks still to be done)
+//
+void shv_flush ( MQULONG    traceid   // trace id of caller
+               , SHVCHAIN * chain     // chain to process
+               , int        room      // blocks about to be added
+               )
+{
+ if ( chain->count <= MAXCHAIN - room ) return ;
 
- return rc;
-} // End of set_envir function
+ shv_run(traceid, chain) ;
+ chain->count = 0        ;
 
+ return ;
+} // End of shv_flush
 
 //
-// Return processing functions
-//
-//      set_return   : sets up the return variables
+// Reusable storage
 //
-//          LASTRC    -> current operation Return Code
-//          LASTCC    -> current operation MQ Completion Code
-//          LASTAC    -> current operation MQ Reason     Code
-//          LASTOP    -> current operation RXMQ Function
-//          LASTMSG   -> current operation text message
+//   Message data buffers belong to the RXMQCB and are kept from one call
+//   to the next, growing by size class (powers of two from BUFMIN) as
+//   bigger messages come along, so a steady flow of messages needs no
+//   malloc or free per call. RXMQTERM releases them.
 //
-//          The Return Code for the operation can be negative to
-//              show that this interface has detected the error,
-//              otherwise it will be the MQ Completion Code
+//   Scratch storage needed for one call only (MQCHARV .1 data, event
+//   .ZLIST lists) comes from a bump arena, which set_envir resets at the
+//   start of every call. Anything that does not fit is malloc'ed and
+//   freed at the next reset, when the arena is also grown to fit.
 //
-//          The Message is in text format as follows:
+//   RXMQCB.Stats counts the mallocs done and the requests met without
+//   one; RXMQDISC and RXMQTERM copy them to RXMQ.ALLOC.xxx.
 //
-//            Arg 1 : Return Code
-//            Arg 2 : MQ Completion Code (or 0 if MQ not done)
-//            Arg 2 : MQ Reason     Code (or 0 if MQ not done)
-//            Arg 4 : RXMQ... function being run
-//            Arg 5 : OK or an helpful error message
-//            Arg 6 : Trace id of caller
+
+ #define SPILLHDR 8      // Overflow block header (keeps data aligned)
+
 //
+// buf_get - return payload buffer n (BUF_xx) of at least size bytes,
+//           or NULL if it cannot be allocated. Contents are undefined.
 //
-void set_return ( const MQLONG   rc       //Function return Code
-                , const MQLONG   cc       //MQ Completion Code
-                , const MQLONG   ac       //MQ Reason Code
-                , char         * op       //Function name
-                , PRETMSG        pRetMsg  //Function message table
-                , PRXSTRING      aretstr  //REXX Return String
-                , MQULONG        traceid  //trace id of caller
-                , char         * moremsg  //additional message
-                )
+void * buf_get ( RXMQCB   * anchor       // RXMQ Control Block
+               , int        n            // BUF_xx wanted
+               , MQLONG     size         // Bytes needed
+               )
 {
- int                     i                ;
- RXSTRING                varname_new      ;  // Variable name
- RXSTRING                varname_old      ;  // Variable name
+ RXMQBUF               * buf = &anchor->Buf[n] ;  // The buffer
+ MQLONG                  want = BUFMIN          ;  // Size class needed
 
- TRACE(traceid,("Entering set_return\n")) ;
+ if ( (buf->ptr != NULL) && (buf->size >= size) )
+   {
+    anchor->Stats.bufreuse++ ;
+    return buf->ptr          ;
+   }
 
- MAKERXSTRING(varname_new, "RXMQ.", sizeof("RXMQ.")-1)  ;
- MAKERXSTRING(varname_old, PREFIX,  sizeof(PREFIX)-1)   ;
+ while ( (want < size) && (want < 0x40000000) ) want <<= 1 ;
+ if ( want < size ) want = size                            ;
 
- stem_from_long  (traceid, NULL, varname_new, "LASTRC", rc);
- stem_from_long  (traceid, NULL, varname_old, "LASTRC", rc);
+ if ( buf->ptr != NULL ) free(buf->ptr)                    ;
+ buf->ptr  = malloc(want)                                  ;
+ buf->size = ( buf->ptr == NULL ) ? 0 : want               ;
+ anchor->Stats.bufnew++                                    ;
 
- stem_from_long  (traceid, NULL, varname_new, "LASTCC", cc);
- stem_from_long  (traceid, NULL, varname_old, "LASTCC", cc);
+ return buf->ptr ;
+} // End of buf_get
 
- stem_from_long  (traceid, NULL, varname_new, "LASTAC", ac);
- stem_from_long  (traceid, NULL, varname_old, "LASTAC", ac);
+//
+// arena_get - return size bytes of scratch storage, valid until the
+//             end of this call, or NULL if it cannot be allocated
+//
+void * arena_get ( RXMQCB   * anchor       // RXMQ Control Block
+                 , size_t     size         // Bytes needed
+                 )
+{
+ RXMQARENA             * ar = &anchor->Arena ;  // The arena
+ char                  * blk                 ;  // Overflow block
 
- stem_from_string(traceid, NULL, varname_new, "LASTOP", op, strlen(op)) ;
- stem_from_string(traceid, NULL, varname_old, "LASTOP", op, strlen(op)) ;
+ size      = (size + 7) & ~(size_t)7 ; // Keep everything 8 byte aligned
+ ar->need += size                    ;
 
- if (rc < 0)
+ if ( ar->used + size <= ar->size )
    {
-    for (i = 0; ; i++)
-      {
-       if (pRetMsg[i].retcode == rc ) break ;
-       if (pRetMsg[i].retcode == -99) break ;
-      }
-    sprintf(aretstr->strptr,  "%"PRId32" %"PRId32" %"PRId32" %-s %s",
-        (uint32_t)rc, (uint32_t)cc, (uint32_t)ac, op, pRetMsg[i].retmsgc);
+    ar->used += size                  ;
+    anchor->Stats.arenareuse++        ;
+    return ar->base + ar->used - size ;
    }
- else sprintf(aretstr->strptr,"%"PRId32" %"PRIu32" %"PRIu32" %-s %s %s",
-              (uint32_t)rc, (uint32_t)cc, (uint32_t)ac, op,
-              ( (cc == MQCC_OK      ) ? "OK"      :
-                (cc == MQCC_WARNING ) ? "WARNING" :
-                (cc == MQCC_FAILED  ) ? "FAILED"  :
-                                        "UNKNOWN" ),
-              moremsg        ) ;
-
- aretstr->strlength  = strlen(aretstr->strptr)     ;
- stem_from_string(traceid, NULL, varname_new, "LASTMSG",
-                  aretstr->strptr, aretstr->strlength);
- stem_from_string(traceid, NULL, varname_old, "LASTMSG",
-                  aretstr->strptr, aretstr->strlength);
 
- TRACE(traceid,("Leaving set_return\n"))  ;
- TRACE(traceid,("Leaving %s\n",op))       ; // Leaving function
- fflush(NULL)                             ; // Required to flush trace buffer
+ blk = (char *) malloc(SPILLHDR + size) ;
+ anchor->Stats.arenanew++               ;
+ if ( blk == NULL ) return NULL         ;
+ *(void **)blk = ar->spill              ; // Chain it for arena_reset
+ ar->spill     = blk                    ;
 
- return ;
-} // End of set_return function
+ return blk + SPILLHDR ;
+} // End of arena_get
 
 //
-// Functions that manipulate MQ objects and Rexx Variables
+// arena_reset - start a new call: free any overflow blocks, and grow
+//               the arena if the last call needed more than it held
 //
-//           The make_??_from_stem  functions build the ??
-//                                  MQ object by trying to reference
-//                                  a stem variable (whose name ending
-//                                  with a dot) whose name is supplied.
-//                                  If the .xx part is present, then
-//                                  the contents are copied into the
-//                                  MQ Object.
+void arena_reset ( RXMQCB   * anchor       // RXMQ Control Block
+                 )
+{
+ RXMQARENA             * ar = &anchor->Arena ;  // The arena
+ void                  * blk                 ;  // Overflow block
+ size_t                  want = ARENAMIN     ;  // New arena size
+
+ while ( ar->spill != NULL )
+   {
+    blk       = ar->spill       ;
+    ar->spill = *(void **)blk   ;
+    free(blk)                   ;
+   }
+
+ if ( ar->need > ar->size )
+   {
+    while ( want < ar->need ) want <<= 1 ;
+    if ( ar->base != NULL ) free(ar->base) ;
+    ar->base = (char *) malloc(want)       ;
+    ar->size = ( ar->base == NULL ) ? 0 : want ;
+    anchor->Stats.arenanew++               ;
+   }
+
+ ar->used = 0 ;
+ ar->need = 0 ;
+
+ return ;
+} // End of arena_reset
+
 //
+// storage_free - release all the payload buffers and the arena
 //
-//            The make_stem_from_?? functions work the other way around.
-//                                  they are supplied with the name of
-//                                  a stem variable (including the dot)
-//                                  and build a Rexx representatation of
-//                                  the MQ object by setting xx.yy
-//                                  variables, where the yy is a
-//                                  component of the MQ object. In addition,
-//                                  (.)ZLIST is set to a list of the components
-//                                  in the stem (without the leading dot).
+void storage_free ( RXMQCB   * anchor       // RXMQ Control Block
+                  )
+{
+ int                     i                ;
+
+ for ( i = 0 ; i < MAXBUFS ; i++ )
+   {
+    if ( anchor->Buf[i].ptr != NULL ) free(anchor->Buf[i].ptr) ;
+    anchor->Buf[i].ptr  = NULL ;
+    anchor->Buf[i].size = 0    ;
+   }
+
+ arena_reset(anchor)                               ; // Drop overflow blocks
+ if ( anchor->Arena.base != NULL ) free(anchor->Arena.base) ;
+ anchor->Arena.base = NULL                         ;
+ anchor->Arena.size = 0                            ;
+
+ return ;
+} // End of storage_free
+
 //
+// storage_stats - copy the allocation counters to RXMQ.ALLOC.xxx
 //
-//   The names of the .extensions are described in the functions.
+//          BUFNEW     -> payload buffer mallocs
+//          BUFREUSE   -> payload buffers reused (mallocs avoided)
+//          ARENANEW   -> scratch arena and overflow mallocs
+//          ARENAREUSE -> scratch requests met by the arena (mallocs avoided)
 //
-//   Note that the make_stem_from_?? functions will ALWAYS build
-//        all of the .extensions, whereas the make_??_from_stem
-//        functions can cope with the omission of extensions.
+void storage_stats ( MQULONG    traceid      // trace id of caller
+                   , RXMQCB   * anchor       // RXMQ Control Block
+                   )
+{
+ RXSTRING                stem             ;  // RXMQ.ALLOC.
+ SHVCHAIN                chain            ;  // The four sets
+
+ MAKERXSTRING(stem, "RXMQ.ALLOC.", sizeof("RXMQ.ALLOC.")-1)          ;
+ chain.count = 0                                                     ;
+ shv_set_int64(&chain, stem, "BUFNEW", NULL, anchor->Stats.bufnew) ;
+ shv_set_int64(&chain, stem, "BUFREUSE", NULL, anchor->Stats.bufreuse) ;
+ shv_set_int64(&chain, stem, "ARENANEW", NULL, anchor->Stats.arenanew) ;
+ shv_set_int64(&chain, stem, "ARENAREUSE", NULL, anchor->Stats.arenareuse) ;
+ shv_run(traceid, &chain)                                            ;
+
+ return ;
+} // End of storage_stats
+
 //
+// Object handle table
 //
-// make_od_from_stem will return an Object Descriptor from the
-//                   contents of a Stem Variable:
+//   Open queues and subscriptions are kept in RXMQCB.Obj, which starts
+//   with OBJMIN slots and doubles when full. Free slots are chained from
+//   RXMQCB.Objfree, so taking or giving back a slot is a single step.
+//   Slot 0 is never used.
 //
-//                     .VER  -> Version
-//                     .OT   -> ObjectType
-//                     .ON   -> ObjectName
-//                     .OQM  -> ObjectQMgrName
-//                     .DQN  -> DynamicQueue
-//                     .AUID -> AlternateUserid
-//                     .RP   -> RecsPresent
-//                     .KDC  -> KnownDestCount (output only)
-//                     .UDC  -> UnknownDestCount (output only)
-//                     .IDC  -> InvalidDestCount (output only)
-//                     .ORO  -> ObjectRecOffset (not implemented)
-//                     .RRO  -> ResponseRecOffset (not implemented)
-//                     .ORP  -> ObjectRecPtr (not implemented)
-//                     .RRP  -> ResponseRecPtr (not implemented)
-//                     .ASID -> AlternateSecurityId (Windows only)
-//                     .RQN  -> ResolvedQName (output only)
-//                     .RQMN -> ResolvedQMgrName (output only)
-//                     .OS   -> ObjectString
-//                     .SS   -> SelectionString
-//                     .ROS  -> ResObjectString
-//                     .RT   -> ResolvedType
+//   The handle number given to REXX is the slot number with the slot's
+//   generation in the bits above OBJSLOTBITS. The generation is bumped
+//   whenever the slot is freed, so a handle that has been closed (or
+//   lost by a disconnect) no longer matches once the slot is reused.
+//   Generation 0 handle numbers are just the slot number, as before.
+//
+//   Each slot also records what was opened, for later calls to use.
 //
 
-void make_od_from_stem ( MQULONG    traceid      // trace id of caller
-                       , MQOD     * od           // target object descriptor
-                       , RXSTRING   stem         // name of stem variable
-                       )
-{
- TRACE(traceid, ("Entering make_od_from_stem\n") ) ;
+ #define AUTOSEED   65536   // Seed the GET size estimate from MAXMSGL up to this
+ #define AUTORETRY  4       // Times to resize before giving up
 
- memcpy(od, &od_default, sizeof(MQOD))         ;
+ #define OBJHANDLE(a,n)  (((a)->Obj[n].gen << OBJSLOTBITS) | (n))
+ #define OBJ(a,h)        (&(a)->Obj[(h) & OBJSLOTMASK])
+ #define OBJINRANGE(a,h) ( ((h) > 0) && (((h) & OBJSLOTMASK) != 0)         \
+                        && (((h) & OBJSLOTMASK) < (a)->Objsize) )
+#define OBJHCONN(a,h)   ( (a)->QM[OBJ(a,h)->conn].QMh )
+ #define OD_DESTS(od)    ( ((od)->Version >= MQOD_VERSION_2) && ((od)->ObjectRecPtr != NULL) \
+                         ? (od)->RecsPresent : 0 )
+ #define OBJOPEN(a,h)    ( (OBJ(a,h)->Qh != 0) && !OBJ(a,h)->idle          \
+                        && (OBJ(a,h)->gen == ((h) >> OBJSLOTBITS)) )
 
-//If the given variable is not a stem. variable, then take the
-//   quicker option of assuming it's a Queue to open
+//
+// obj_new - take a free slot, growing the table if there is none.
+//           Returns the slot number, or 0 if the table cannot grow.
+//
+int obj_new ( MQULONG    traceid      // trace id of caller
+            , RXMQCB   * anchor       // RXMQ Control Block
+            , int        conn         // Connection it is for
+            )
+{
+ RXMQOBJ               * obj              ;  // New table
+ MQLONG                  size             ;  //   and its size
+ MQLONG                  n                ;  // Slot number
 
- if ( stem.strptr[stem.strlength-1] != '.' )
+ if ( anchor->Objfree == 0 )
    {
-     memcpy(&od->ObjectName,
-            stem.strptr,
-            strlen(stem.strptr) ) ;
-     DUMPCB(traceid,  od )            ;
-     TRACE(traceid, ("Leaving make_od_from_stem\n") ) ;
-     return                       ;
-    }
+    size = ( anchor->Objsize == 0 ) ? OBJMIN : 2 * anchor->Objsize ;
+    if ( size > OBJSLOTMASK + 1 ) size = OBJSLOTMASK + 1          ;
+    if ( size <= anchor->Objsize ) return 0                       ;
 
- //The given variable is a stem. variable, so get its contents
+    TRACE(traceid, ("Growing object table to %"PRId32" slots\n",(int32_t)size) ) ;
+    obj = (RXMQOBJ *) realloc(anchor->Obj, size * sizeof(RXMQOBJ)) ;
+    if ( obj == NULL ) return 0                                   ;
+    memset(&obj[anchor->Objsize], 0, (size - anchor->Objsize) * sizeof(RXMQOBJ)) ;
 
- // Version 1 of MQOD
- stem_to_long  (traceid, stem, "VER" , &od->Version)                               ;
- stem_to_long  (traceid, stem, "OT"  , &od->ObjectType)                            ;
- stem_to_string(traceid, stem, "ON"  ,  od->ObjectName,          sizeof(MQCHAR48)) ;
- stem_to_string(traceid, stem, "OQM" ,  od->ObjectQMgrName,      sizeof(MQCHAR48)) ;
- stem_to_string(traceid, stem, "DQN" ,  od->DynamicQName,        sizeof(MQCHAR48)) ;
- stem_to_string(traceid, stem, "AUID",  od->AlternateUserId,     sizeof(MQCHAR12)) ;
- // Version 2 of MQOD
- stem_to_long  (traceid, stem, "RP"  , &od->RecsPresent)                           ;
- stem_to_long  (traceid, stem, "KDC" , &od->KnownDestCount)                        ;
- stem_to_long  (traceid, stem, "UDC" , &od->UnknownDestCount)                      ;
- stem_to_long  (traceid, stem, "IDC" , &od->InvalidDestCount)                      ;
- // Version 3 of MQOD
- stem_to_bytes (traceid, stem, "ASID",  od->AlternateSecurityId, sizeof(MQBYTE40)) ;
- stem_to_string(traceid, stem, "RQN" ,  od->ResolvedQName,       sizeof(MQCHAR48)) ;
- stem_to_string(traceid, stem, "RQMN",  od->ResolvedQMgrName,    sizeof(MQCHAR48)) ;
- // Version 4 of MQOD
- stem_to_strinv(traceid, stem, "OS"  , &od->ObjectString)                          ;
- stem_to_strinv(traceid, stem, "SS"  , &od->SelectionString)                       ;
- stem_to_strinv(traceid, stem, "ROS" , &od->ResObjectString)                       ;
- stem_to_long  (traceid, stem, "RT"  , &od->ResolvedType)                          ;
+    for ( n = size - 1 ; n >= anchor->Objsize && n > 0 ; n-- ) // Lowest first
+      {
+       obj[n].next     = anchor->Objfree ;
+       anchor->Objfree = n               ;
+      }
+    anchor->Obj     = obj  ;
+    anchor->Objsize = size ;
+   }
 
- DUMPCB(traceid, od )                             ;
- TRACE(traceid, ("Leaving make_od_from_stem\n") ) ;
+ n               = anchor->Objfree      ;
+ anchor->Objfree = anchor->Obj[n].next  ;
+ anchor->Obj[n].next = 0                ;
+ anchor->Obj[n].conn = conn             ;
 
- return ;
-} // End of make_od_from_stem function
+ return n ;
+} // End of obj_new
 
 //
-// make_stem_from_od will return an Object Descriptor as the
-//                   contents of a Stem Variable:
-//
-//                     .VER  -> Version
-//                     .OT   -> ObjectType
-//                     .ON   -> ObjectName
-//                     .OQM  -> ObjectQMgrName
-//                     .DQN  -> DynamicQueue
-//                     .AUID -> AlternateUserId
-//                     .RP   -> RecsPresent
-//                     .KDC  -> KnownDestCount
-//                     .UDC  -> UnknownDestCount
-//                     .IDC  -> InvalidDestCount
-//                     .ORO  -> ObjectRecOffset (not implemented)
-//                     .RRO  -> ResponseRecOffset (not implemented)
-//                     .ORP  -> ObjectRecPtr (not implemented)
-//                     .RRP  -> ResponseRecPtr (not implemented)
-//                     .ASID -> AlternateSecurityId (Windows only)
-//                     .RQN  -> ResolvedQName
-//                     .RQMN -> ResolvedQMgrName
-//                     .OS   -> ObjectString
-//                     .SS   -> SelectionString
-//                     .ROS  -> ResObjectString
-//                     .RT   -> ResolvedType
-//
-//                     .ZLIST -> 'VER OT ON OQM DQN AUID
-//                                RP
-//                                KDC UDC IDC
-//                                ASID
-//                                RQN RQMN
-//                                OS. SS. ROS. RT
+// cache_unlink - take an idle slot off the cache's LRU chain
 //
-
-void make_stem_from_od ( MQULONG    traceid      // trace id of caller
-                       , MQOD     * od           // source object descriptor
-                       , RXSTRING   stem         // name of stem variable
-                       )
+void cache_unlink ( RXMQCB   * anchor       // RXMQ Control Block
+                  , int        n            // Slot number
+                  )
 {
- char                        zlist[200]   ;  // Char version of .ZLIST
- zlist[0] = '\0'                          ;
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
 
- TRACE(traceid, ("Entering make_stem_from_od\n") ) ;
- DUMPCB(traceid, od )                              ;
+ if ( obj->prev != 0 ) anchor->Obj[obj->prev].next = obj->next ;
+ else                  anchor->Cache.head          = obj->next ;
+ if ( obj->next != 0 ) anchor->Obj[obj->next].prev = obj->prev ;
+ else                  anchor->Cache.tail          = obj->prev ;
 
+ obj->next = 0 ;
+ obj->prev = 0 ;
+ obj->idle = 0 ;
+ anchor->Cache.idle-- ;
 
- // Version 1 of MQOD
- stem_from_long  (traceid, zlist, stem, "VER" , od->Version)                               ;
- stem_from_long  (traceid, zlist, stem, "OT"  , od->ObjectType)                            ;
- stem_from_string(traceid, zlist, stem, "ON"  , od->ObjectName,          sizeof(MQCHAR48)) ;
- stem_from_string(traceid, zlist, stem, "OQM" , od->ObjectQMgrName,      sizeof(MQCHAR48)) ;
- stem_from_string(traceid, zlist, stem, "DQN" , od->DynamicQName,        sizeof(MQCHAR48)) ;
- stem_from_string(traceid, zlist, stem, "AUID", od->AlternateUserId,     sizeof(MQCHAR12)) ;
- // Version 2 of MQOD
- stem_from_long  (traceid, zlist, stem, "RP"  , od->RecsPresent)                           ;
- stem_from_long  (traceid, zlist, stem, "KDC" , od->KnownDestCount)                        ;
- stem_from_long  (traceid, zlist, stem, "UDC" , od->UnknownDestCount)                      ;
- stem_from_long  (traceid, zlist, stem, "IDC" , od->InvalidDestCount)                      ;
- // Version 3 of MQOD
- stem_from_bytes (traceid, zlist, stem, "ASID", od->AlternateSecurityId, sizeof(MQBYTE40)) ;
- stem_from_string(traceid, zlist, stem, "RQN" , od->ResolvedQName,       sizeof(MQCHAR48)) ;
- stem_from_string(traceid, zlist, stem, "RQMN", od->ResolvedQMgrName,    sizeof(MQCHAR48)) ;
- // Version 4 of MQOD
- stem_from_strinv(traceid, zlist, stem, "OS"  , od->ObjectString)                          ;
- stem_from_strinv(traceid, zlist, stem, "SS"  , od->SelectionString)                       ;
- stem_from_strinv(traceid, zlist, stem, "ROS" , od->ResObjectString)                       ;
- stem_from_long  (traceid, zlist, stem, "RT"  , od->ResolvedType)                          ;
+ return ;
+} // End of cache_unlink
 
- stem_from_string(traceid, zlist, stem, "ZLIST", zlist, strlen(zlist))                         ;
+//
+// obj_drop - give a slot back to the free chain, so ending the
+//            handle numbers that referred to it
+//
+void obj_drop ( RXMQCB   * anchor       // RXMQ Control Block
+              , int        n            // Slot number
+              )
+{
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
 
- TRACE(traceid, ("Leaving make_stem_from_od\n") ) ;
+ if ( obj->idle ) cache_unlink(anchor, n)        ;
+ obj->Qh      = 0                                ;
+ obj->key     = 0                                ;
+ obj->shared  = 0                                ;
+ obj->gen     = (obj->gen + 1) & OBJGENMASK      ;
+ obj->next    = anchor->Objfree                  ;
+ anchor->Objfree = n                             ;
 
  return ;
-} // End of make_stem_from_od function
+} // End of obj_drop
 
 //
-// make_po_from_stem will return a Put Message Options Desc from the
-//                   contents of a Stem Variable:
-//
-//                     .VER  -> Version
-//                     .OPT  -> Options
-//                     .TIME -> Timeout
-//                     .CON  -> Context
-//                     .KDC  -> KnownDestCount (output only)
-//                     .UDC  -> UnKnownDestCount (output only)
-//                     .IDC  -> InvalidDestCount (output only)
-//                     .RQN  -> ResolvedQName (output only)
-//                     .RQMN -> ResolvedQMgrName (output only)
-//                     .RP   -> RecsPresent
-//                     .PMRF -> PutMsgRecFields (not implemented)
-//                     .PMRO -> PutMsgRecOffset (not implemented)
-//                     .RRO  -> ResponseRecOffset (not implemented)
-//                     .PMRP -> PutMsgRecPtr (not implemented)
-//                     .RRP  -> ResponseRecPtr (not implemented)
-//                     .OMH  -> OriginalMsgHandle
-//                     .NMH  -> NewMsgHandle
-//                     .ACT  -> Action
-//                     .PL   -> PubLevel
+// obj_opened - record what a newly opened slot refers to, inquiring
+//              MAXMSGL if it was opened for input with MQOO_INQUIRE
 //
-
-void make_po_from_stem ( MQULONG    traceid      // trace id of caller
-                       , MQPMO    * pmo          // target PMO
-                       , RXSTRING   stem         // name of stem variable
-                       )
+void obj_opened ( MQULONG    traceid      // trace id of caller
+                , RXMQCB   * anchor       // RXMQ Control Block
+                , int        n            // Slot number
+                , MQLONG     options      // Open options (0 for MQSUB)
+                , PMQCHAR    name         // Object name
+                )
 {
- TRACE(traceid, ("Entering make_po_from_stem\n") ) ;
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
+ MQLONG                  sel = MQIA_MAX_MSG_LENGTH ;  // Attribute wanted
+ MQLONG                  mqrc = 0         ;  // MQ CC
+ MQLONG                  mqac = 0         ;  // MQ RC
+
+ memcpy(obj->name, name, sizeof(MQCHAR48)) ;
+ obj->options = options                    ;
+ obj->maxmsgl = 0                          ;
+ obj->est     = BUFMIN                     ;
+ obj->dests   = 0                          ;
+
+ if ( (options & MQOO_INQUIRE)
+   && (options & (MQOO_INPUT_AS_Q_DEF | MQOO_INPUT_SHARED
+                | MQOO_INPUT_EXCLUSIVE | MQOO_BROWSE)) )
+   {
+    MQINQ ( anchor->QM[obj->conn].QMh, obj->Qh, 1, &sel, 1, &obj->maxmsgl, 0, NULL, &mqrc, &mqac ) ;
+    TRACE(traceid, ("MAXMSGL inquire rc = %"PRId32", ac = %"PRId32", MAXMSGL = %"PRId32"\n",
+                    (int32_t)mqrc,(int32_t)mqac,(int32_t)obj->maxmsgl) ) ;
+    if ( mqrc != MQCC_OK ) obj->maxmsgl = 0                           ;
+    if ( (obj->maxmsgl > 0) && (obj->maxmsgl <= AUTOSEED) ) obj->est = obj->maxmsgl ;
+   }
 
- memcpy(pmo, &pmo_default, sizeof(MQPMO))      ;
+ return ;
+} // End of obj_opened
 
- // Version 1 of MQPMO
- stem_to_long  (traceid, stem, "VER" , &pmo->Version)                            ;
- stem_to_long  (traceid, stem, "OPT" , &pmo->Options)                            ;
- stem_to_long  (traceid, stem, "TIME", &pmo->Timeout)                            ;
- stem_to_long  (traceid, stem, "CON" , &pmo->Context)                            ;
- stem_to_long  (traceid, stem, "KDC" , &pmo->KnownDestCount)                     ;
- stem_to_long  (traceid, stem, "UDC" , &pmo->UnknownDestCount)                   ;
- stem_to_long  (traceid, stem, "IDC" , &pmo->InvalidDestCount)                   ;
- stem_to_string(traceid, stem, "RQN" ,  pmo->ResolvedQName,    sizeof(MQCHAR48)) ;
- stem_to_string(traceid, stem, "RQMN",  pmo->ResolvedQMgrName, sizeof(MQCHAR48)) ;
- // Version 2 of MQPMO
- stem_to_long  (traceid, stem, "RP"  , &pmo->RecsPresent)                        ;
- // Version 3 of MQPMO
- stem_to_int64 (traceid, stem, "OMH" , &pmo->OriginalMsgHandle)                  ;
- stem_to_int64 (traceid, stem, "NMH" , &pmo->NewMsgHandle)                       ;
- stem_to_long  (traceid, stem, "ACT" , &pmo->Action)                             ;
- stem_to_long  (traceid, stem, "PL"  , &pmo->PubLevel)                           ;
+//
+// obj_reset - drop every slot still open on a connection (after its
+//             MQDISC), or with release set free the whole table (RXMQTERM)
+//
+void obj_reset ( RXMQCB   * anchor       // RXMQ Control Block
+               , int        conn         // Connection ended
+               , int        release      // Free the table too
+               )
+{
+ int                     n                ;  // Slot number
 
- DUMPCB(traceid, pmo ) ;
- TRACE(traceid, ("Leaving make_po_from_stem\n") ) ;
+ for ( n = anchor->Objsize - 1 ; n > 0 ; n-- )     // Lowest ends up first
+   if ( (anchor->Obj[n].Qh != 0) && (release || (anchor->Obj[n].conn == conn)) )
+      obj_drop(anchor, n) ;
+
+ if ( release )
+   {
+    if ( anchor->Obj != NULL ) free(anchor->Obj) ;
+    anchor->Obj     = NULL ;
+    anchor->Objsize = 0    ;
+    anchor->Objfree = 0    ;
+   }
 
  return ;
-} // End of make_po_from_stem function
+} // End of obj_reset
 
 //
-// make_stem_from_po will return a Put Message Options Desc as the
-//                   contents of a Stem Variable:
+// Open handle cache
 //
-//                     .VER  -> Version
-//                     .OPT  -> Options
-//                     .TIME -> Timeout
-//                     .CON  -> Context
-//                     .KDC  -> KnownDestCount
-//                     .UDC  -> UnKnownDestCount
-//                     .IDC  -> InvalidDestCount
-//                     .RQN  -> ResolvedQName
-//                     .RQMN -> ResolvedQMgrName
-//                     .RP   -> RecsPresent
-//                     .PMRF -> PutMsgRecFields (not implemented)
-//                     .PMRO -> PutMsgRecOffset (not implemented)
-//                     .RRO  -> ResponseRecOffset (not implemented)
-//                     .PMRP -> PutMsgRecPtr (not implemented)
-//                     .RRP  -> ResponseRecPtr (not implemented)
-//                     .OMH  -> OriginalMsgHandle
-//                     .NMH  -> NewMsgHandle
-//                     .ACT  -> Action
-//                     .PL   -> PubLevel
+//   Once RXMQCACH has given the cache a size, RXMQCLOS (with no close
+//   options) of a queue opened by RXMQOPEN does not MQCLOSE it: the slot
+//   is marked idle, its generation bumped so the old handle number is
+//   dead, and it is put at the head of an LRU chain. A later RXMQOPEN of
+//   the same queue name and QM name with the same options takes it back
+//   under a new handle number, and RXMQPUT1 with a cacheable OD does an
+//   MQPUT on it rather than an MQPUT1. When there are more idle handles
+//   than the cache size, the least recently closed ones are MQCLOSEd.
 //
-//                     .ZLIST -> 'VER OPT CON CON TIME KDC UDC IDC RQN RQMN
-//                                RP OMH NMH ACT PL'
+//   Only opens that behave the same when reused are cached: queues (not
+//   topics or lists), not for browse (the cursor would carry over) or
+//   possibly exclusive input, not with alternate user authority, and not
+//   of model queues (the name changes to the dynamic queue created).
 //
 
-void make_stem_from_po ( MQULONG    traceid      // trace id of caller
-                       , MQPMO    * pmo          // source PMO
-                       , RXSTRING   stem         // name of stem variable
-                       )
+//
+// cache_key - hash of what identifies a cacheable open, or 0 if it
+//             may not be cached
+//
+MQLONG cache_key ( MQOD     * od           // Object descriptor
+                 , MQLONG     options      // Open options
+                 )
 {
- char                    zlist[200]   ;  // Char version of .ZLIST
- zlist[0] = '\0'                      ;
-
- TRACE(traceid, ("Entering make_stem_from_po\n") ) ;
- DUMPCB(traceid,  pmo )                            ;
-
- // Version 1 of MQPMO
- stem_from_long  (traceid, zlist, stem, "VER" , pmo->Version)                               ;
- stem_from_long  (traceid, zlist, stem, "OPT" , pmo->Options)                               ;
- stem_from_long  (traceid, zlist, stem, "TIME", pmo->Timeout)                               ;
- stem_from_long  (traceid, zlist, stem, "CON" , pmo->Context)                               ;
- stem_from_long  (traceid, zlist, stem, "KDC" , pmo->KnownDestCount)                        ;
- stem_from_long  (traceid, zlist, stem, "UDC" , pmo->UnknownDestCount)                      ;
- stem_from_long  (traceid, zlist, stem, "IDC" , pmo->InvalidDestCount)                      ;
- stem_from_string(traceid, zlist, stem, "RQN" , pmo->ResolvedQName,       sizeof(MQCHAR48)) ;
- stem_from_string(traceid, zlist, stem, "RQMN", pmo->ResolvedQMgrName,    sizeof(MQCHAR48)) ;
- // Version 2 of MQPMO
- stem_from_long  (traceid, zlist, stem, "RP"  , pmo->RecsPresent)                           ;
- // Version 3 of MQPMO
- stem_from_int64 (traceid, zlist, stem, "OMH" , pmo->OriginalMsgHandle)                     ;
- stem_from_int64 (traceid, zlist, stem, "NMH" , pmo->NewMsgHandle)                          ;
- stem_from_long  (traceid, zlist, stem, "ACT" , pmo->Action)                                ;
- stem_from_long  (traceid, zlist, stem, "PL"  , pmo->PubLevel)                              ;
+ MQULONG                 h = 2166136261U  ;  // FNV-1a hash
+ unsigned char         * p                ;  //   of the bytes
+ int                     i                ;
 
- stem_from_string(traceid, zlist, stem, "ZLIST", zlist, strlen(zlist))                      ;
+ if ( od->ObjectType != MQOT_Q )                                  return 0 ;
+ if ( (od->Version >= MQOD_VERSION_2) && (od->RecsPresent != 0) ) return 0 ;
+ if ( options & ( MQOO_BROWSE | MQOO_INPUT_AS_Q_DEF
+                | MQOO_INPUT_EXCLUSIVE | MQOO_ALTERNATE_USER_AUTHORITY ) ) return 0 ;
 
- TRACE(traceid,  ("Leaving make_stem_from_po\n") ) ;
+ p = (unsigned char *) od->ObjectName ;
+ for ( i = 0 ; i < (int)sizeof(MQCHAR48) ; i++ ) h = (h ^ p[i]) * 16777619U ;
+ p = (unsigned char *) od->ObjectQMgrName ;
+ for ( i = 0 ; i < (int)sizeof(MQCHAR48) ; i++ ) h = (h ^ p[i]) * 16777619U ;
+ h ^= (MQULONG) options ;
 
- return ;
-} // End of make_stem_from_po function
+ return ( h == 0 ) ? 1 : (MQLONG) h ;
+} // End of cache_key
 
 //
-// make_go_from_stem will return a Get Message Options Desc from the
-//                   contents of a Stem Variable:
-//
-//                     .VER   -> Version
-//                     .OPT   -> Options
-//                     .WAIT  -> WaitInterval
-//                     .RQN   -> ResolvedQueueName (output only)
-//                     .MOPT  -> MatchOptions
-//                     .GS    -> GroupStatus (output only)
-//                     .SS    -> SegmentStatus (output only)
-//                     .SEG   -> Segmentation (output only)
-//                     .MT    -> MsgToken
-//                     .RL    -> ReturnedLength (output only)
-//                     .MH    -> MsgHandle
+// cache_keep - make a slot just opened with key (from cache_key before
+//              the MQOPEN) cacheable, if the open left the name as it was
 //
-
-void make_go_from_stem ( MQULONG    traceid      // trace id of caller
-                       , MQGMO    * gmo          // target GMO
-                       , RXSTRING   stem         // name of stem variable
-                       )
+void cache_keep ( RXMQCB   * anchor       // RXMQ Control Block
+                , int        n            // Slot number
+                , MQLONG     key          // cache_key before the open
+                , MQOD     * od           // Object descriptor after it
+                )
 {
- TRACE(traceid, ("Entering make_go_from_stem\n") ) ;
-
- memcpy(gmo, &gmo_default, sizeof(MQGMO))      ;
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
 
- // Version 1 of MQGMO
- stem_to_long  (traceid, stem, "VER" , &gmo->Version)                         ;
- stem_to_long  (traceid, stem, "OPT" , &gmo->Options)                         ;
- stem_to_long  (traceid, stem, "WAIT", &gmo->WaitInterval)                    ;
- stem_to_string(traceid, stem, "RQN" ,  gmo->ResolvedQName, sizeof(MQCHAR48)) ;
- // Version 2 of MQGMO
- stem_to_long  (traceid, stem, "MOPT", &gmo->MatchOptions)                    ;
- stem_to_char  (traceid, stem, "GS"  , &gmo->GroupStatus)                     ;
- stem_to_char  (traceid, stem, "SS"  , &gmo->SegmentStatus)                   ;
- stem_to_char  (traceid, stem, "SEG" , &gmo->Segmentation)                    ;
- // Version 3 of MQGMO
- stem_to_bytes (traceid, stem, "MT"  ,  gmo->MsgToken,      sizeof(MQBYTE16)) ;
- stem_to_long  (traceid, stem, "RL"  , &gmo->ReturnedLength)                  ;
- // Version 4 of MQGMO
- stem_to_int64 (traceid, stem, "MH"  , &gmo->MsgHandle)                       ;
+ if ( (key == 0) || (cache_key(od, obj->options) != key) ) return ;
 
- DUMPCB(traceid,  gmo ) ;
- TRACE(traceid, ("Leaving make_go_from_stem\n") ) ;
+ obj->key = key                                             ;
+ memcpy(obj->qmgr, od->ObjectQMgrName, sizeof(MQCHAR48))    ;
+ memset(obj->rname, ' ', sizeof(MQCHAR48))                  ;
+ memset(obj->rqmgr, ' ', sizeof(MQCHAR48))                  ;
+ if ( od->Version >= MQOD_VERSION_3 )
+   {
+    memcpy(obj->rname, od->ResolvedQName,    sizeof(MQCHAR48)) ;
+    memcpy(obj->rqmgr, od->ResolvedQMgrName, sizeof(MQCHAR48)) ;
+   }
 
  return ;
-} // End of make_go_from_stem function
+} // End of cache_keep
 
 //
-// make_stem_from_go will return a Get Message Options Desc as the
-//                   contents of a Stem Variable:
-//
-//                     .VER   -> Version
-//                     .OPT   -> Options
-//                     .WAIT  -> WaitInterval
-//                     .RQN   -> ResolvedQueueName
-//                     .MOPT  -> MatchOptions
-//                     .GS    -> GroupStatus
-//                     .SS    -> SegmentStatus
-//                     .SEG   -> Segmentation
-//                     .MT    -> sgToken
-//                     .RL    -> ReturnedLength
-//                     .MH    -> MsgHandle
-//                     .ZLIST -> 'VER OPT WAIT RQN
-//                                MOPT GS SS SEG
-//                                MT RL MH'
+// cache_trim - MQCLOSE the least recently used idle handles until no
+//              more than keep are left
 //
-
-void make_stem_from_go ( MQULONG    traceid      // trace id of caller
-                       , MQGMO    * gmo          // source GMO
-                       , RXSTRING   stem         // name of stem variable
-                       )
+void cache_trim ( MQULONG    traceid      // trace id of caller
+                , RXMQCB   * anchor       // RXMQ Control Block
+                , MQLONG     keep         // Idle handles to leave
+                )
 {
- char                    zlist[200]   ;  // Char version of .ZLIST
- zlist[0] = '\0'                      ;
-
- TRACE(traceid, ("Entering make_stem_from_go\n") ) ;
- DUMPCB(traceid,  gmo )                            ;
+ int                     n                ;  // Slot number
+ MQLONG                  mqrc = 0         ;  // MQ CC
+ MQLONG                  mqac = 0         ;  // MQ RC
 
-// Version 1 of MQGMO
- stem_from_long  (traceid, zlist, stem, "VER" , gmo->Version)                         ;
- stem_from_long  (traceid, zlist, stem, "OPT" , gmo->Options)                         ;
- stem_from_long  (traceid, zlist, stem, "WAIT", gmo->WaitInterval)                    ;
- stem_from_string(traceid, zlist, stem, "RQN" , gmo->ResolvedQName, sizeof(MQCHAR48)) ;
-// Version 2 of MQGMO
- stem_from_long  (traceid, zlist, stem, "MOPT", gmo->MatchOptions)                    ;
- stem_from_char  (traceid, zlist, stem, "GS"  , gmo->GroupStatus)                     ;
- stem_from_char  (traceid, zlist, stem, "SS"  , gmo->SegmentStatus)                   ;
- stem_from_char  (traceid, zlist, stem, "SEG" , gmo->Segmentation)                    ;
-// Version 3 of MQGMO
- stem_from_bytes (traceid, zlist, stem, "MT"  , gmo->MsgToken,      sizeof(MQBYTE16)) ;
- stem_from_long  (traceid, zlist, stem, "RL"  , gmo->ReturnedLength)                  ;
-// Version 4 of MQGMO
- stem_from_int64 (traceid, zlist, stem, "MH"  , gmo->MsgHandle)                       ;
-
- stem_from_string(traceid, zlist, stem, "ZLIST", zlist, strlen(zlist))                ;
-
- TRACE(traceid, ("Leaving make_stem_from_go\n") ) ;
+ while ( anchor->Cache.idle > keep )
+   {
+    n = anchor->Cache.tail                                         ;
+    MQCLOSE ( OBJHCONN(anchor,n), &anchor->Obj[n].Qh, MQCO_NONE, &mqrc, &mqac ) ;
+    TRACE(traceid, ("Cache close of %.48s rc = %"PRId32", ac = %"PRId32"\n",
+                    anchor->Obj[n].name,(int32_t)mqrc,(int32_t)mqac) ) ;
+    obj_drop(anchor, n)                                            ;
+   }
 
  return ;
-} // End of make_stem_from_go function
+} // End of cache_trim
 
 //
-// make_md_from_stem will return a Put Message Options Desc from the
-//                   contents of a Stem Variable:
-//
-//                     .VER   -> Version
-//                     .REP   -> Report
-//                     .MSG   -> MsgType
-//                     .EXP   -> Expiry
-//                     .FBK   -> Feedback
-//                     .ENC   -> Encoding
-//                     .CCSI  -> CodedCharSetId
-//                     .FORM  -> Format
-//                     .PRI   -> Priority
-//                     .PER   -> Persistence
-//                     .MSGID -> MsgId
-//                     .CID   -> CorrelId
-//                     .BC    -> BackoutCount
-//                     .RTOQ  -> ReplyToQ
-//                     .RTOQM -> ReplyToQMgr
-//                     .UID   -> UserIdentifier
-//                     .AT    -> AccountingToken
-//                     .AID   -> ApplyIdentityData
-//                     .PAT   -> PutApplType
-//                     .PAN   -> PutApplName
-//                     .PD    -> PutDate
-//                     .PT    -> PutTime
-//                     .AOD   -> ApplOriginData
-//                     .GID   -> GroupId
-//                     .MSN   -> MsgSeqNumber
-//                     .OFF   -> Offset
-//                     .MF    -> MsgFlags
-//                     .OL    -> OriginalLength
-//
+// cache_idle - logically close slot n, keeping its handle in the cache
 //
-
-void make_md_from_stem ( MQULONG    traceid      // trace id of caller
-                       , MQMD2    * md           // target message descriptor
-                       , RXSTRING   stem         // name of stem variable
-                       )
+void cache_idle ( MQULONG    traceid      // trace id of caller
+                , RXMQCB   * anchor       // RXMQ Control Block
+                , int        n            // Slot number
+                )
 {
- TRACE(traceid, ("Entering make_md_from_stem\n") ) ;
-
- memcpy(md, &md_default, sizeof(MQMD2))        ;
- md->Version = MQMD_VERSION_1                  ;
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
 
- // Version 1 of MQMD
- stem_to_long  (traceid, stem, "VER"  , &md->Version)                           ;
- stem_to_long  (traceid, stem, "REP"  , &md->Report)                            ;
- stem_to_long  (traceid, stem, "MSG"  , &md->MsgType)                           ;
- stem_to_long  (traceid, stem, "EXP"  , &md->Expiry)                            ;
- stem_to_long  (traceid, stem, "FBK"  , &md->Feedback)                          ;
- stem_to_long  (traceid, stem, "ENC"  , &md->Encoding)                          ;
- stem_to_long  (traceid, stem, "CCSI" , &md->CodedCharSetId)                    ;
- stem_to_string(traceid, stem, "FORM" ,  md->Format,           sizeof(MQCHAR8)) ;
- stem_to_long  (traceid, stem, "PRI"  , &md->Priority)                          ;
- stem_to_long  (traceid, stem, "PER"  , &md->Persistence)                       ;
- stem_to_bytes (traceid, stem, "MSGID",  md->MsgId,            sizeof(MQBYTE24));
- stem_to_bytes (traceid, stem, "CID"  ,  md->CorrelId,         sizeof(MQBYTE24));
- stem_to_long  (traceid, stem, "BC"   , &md->BackoutCount)                      ;
- stem_to_string(traceid, stem, "RTOQ" ,  md->ReplyToQ,         sizeof(MQCHAR48));
- stem_to_string(traceid, stem, "RTOQM",  md->ReplyToQMgr,      sizeof(MQCHAR48));
- stem_to_string(traceid, stem, "UID"  ,  md->UserIdentifier,   sizeof(MQCHAR12));
- stem_to_bytes (traceid, stem, "AT"   ,  md->AccountingToken,  sizeof(MQBYTE32));
- stem_to_string(traceid, stem, "AID"  ,  md->ApplIdentityData, sizeof(MQCHAR32));
- stem_to_long  (traceid, stem, "PAT"  , &md->PutApplType)                       ;
- stem_to_string(traceid, stem, "PAN"  ,  md->PutApplName,      sizeof(MQCHAR28));
- stem_to_string(traceid, stem, "PD"   ,  md->PutDate,          sizeof(MQCHAR8)) ;
- stem_to_string(traceid, stem, "PT"   ,  md->PutTime,          sizeof(MQCHAR8)) ;
- stem_to_string(traceid, stem, "AOD"  ,  md->ApplOriginData,   sizeof(MQCHAR4)) ;
- // Version 2 of MQMD
- stem_to_bytes (traceid, stem, "GID"  ,  md->GroupId,          sizeof(MQBYTE24));
- stem_to_long  (traceid, stem, "MSN"  , &md->MsgSeqNumber)                      ;
- stem_to_long  (traceid, stem, "OFF"  , &md->Offset)                            ;
- stem_to_long  (traceid, stem, "MF"   , &md->MsgFlags)                          ;
- stem_to_long  (traceid, stem, "OL"   , &md->OriginalLength)                    ;
+ obj->gen  = (obj->gen + 1) & OBJGENMASK      ; // Old handle number is dead
+ obj->idle = 1                                ;
+ obj->prev = 0                                ;
+ obj->next = anchor->Cache.head               ;
+ if ( obj->next != 0 ) anchor->Obj[obj->next].prev = n ;
+ else                  anchor->Cache.tail          = n ;
+ anchor->Cache.head = n                       ;
+ anchor->Cache.idle++                         ;
 
- DUMPCB(traceid,  md ) ;
- TRACE(traceid, ("Leaving make_md_from_stem\n") ) ;
+ cache_trim(traceid, anchor, anchor->Cache.max) ;
 
  return ;
-} // End of make_md_from_stem function
+} // End of cache_idle
 
 //
-// make_stem_from_md will return a Message Descriptor as the
-//                   contents of a Stem Variable:
+// cache_find - take an idle handle for this open from the cache.
+//              Returns its slot (with od's resolved names set), or 0.
 //
-//                     .VER   -> Version
-//                     .REP   -> Report
-//                     .MSG   -> MsgType
-//                     .EXP   -> Expiry
-//                     .FBK   -> Feedback
-//                     .ENC   -> Encoding
-//                     .CCSI  -> CodedCharSetId
-//                     .FORM  -> Format
-//                     .PRI   -> Priority
-//                     .PER   -> Persistence
-//                     .MSGID -> MsgId
-//                     .CID   -> CorrelId
-//                     .BC    -> BackoutCount
-//                     .RTOQ  -> ReplyToQ
-//                     .RTOQM -> ReplyToQMgr
-//                     .UID   -> UserIdentifier
-//                     .AT    -> AccountingToken
-//                     .AID   -> ApplyIdentityData
-//                     .PAT   -> PutApplType
-//                     .PAN   -> PutApplName
-//                     .PD    -> PutDate
-//                     .PT    -> PutTime
-//                     .AOD   -> ApplOriginData
-//                     .GID   -> GroupId
-//                     .MSN   -> MsgSeqNumber
-//                     .OFF   -> Offset
-//                     .MF    -> MsgFlags
-//                     .OL    -> OriginalLength
+int cache_find ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        conn         // Connection to use
+               , MQOD     * od           // Object descriptor
+               , MQLONG     options      // Open options
+               , MQLONG     key          // cache_key(od, options)
+               )
+{
+ RXMQOBJ               * obj              ;  // A slot
+ int                     n                ;  // Slot number
+
+ if ( (key == 0) || (anchor->Cache.max == 0) ) return 0 ;
+
+ for ( n = anchor->Cache.head ; n != 0 ; n = obj->next )
+   {
+    obj = &anchor->Obj[n] ;
+    if ( (obj->key == key) && (obj->options == options) && (obj->conn == conn)
+      && !memcmp(obj->name, od->ObjectName,     sizeof(MQCHAR48))
+      && !memcmp(obj->qmgr, od->ObjectQMgrName, sizeof(MQCHAR48)) )
+      {
+       cache_unlink(anchor, n) ;
+       if ( od->Version >= MQOD_VERSION_3 )
+         {
+          memcpy(od->ResolvedQName,    obj->rname, sizeof(MQCHAR48)) ;
+          memcpy(od->ResolvedQMgrName, obj->rqmgr, sizeof(MQCHAR48)) ;
+         }
+       anchor->Cache.hits++ ;
+       TRACE(traceid, ("Cache hit for %.48s, slot %d\n",obj->name,n) ) ;
+       return n ;
+      }
+   }
+
+ anchor->Cache.misses++ ;
+ return 0 ;
+} // End of cache_find
+
 //
+// cache_open - with the cache on, a handle from it for an open of od for
+//              oopts, opening one to be cached after use if there is none.
+//              Returns the slot, or 0 if the cache is off, the open may
+//              not be cached or it failed (the MQPUT1 done then says why).
 //
-//                     .ZLIST -> 'VER REP MSG EXP FBK ENC CCSI FORM PRI PER MSGID CID BC
-//                                RTOQ RTOQM UID AT AID PAT PAN PD PT AOD
-//                                GID MSN OFF MF OL
+int cache_open ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        conn         // Connection
+               , MQOD     * od           // Object descriptor
+               , MQLONG     oopts        // Open options
+               )
+{
+ MQLONG                  key              ;  // Cache key (0 not cacheable)
+ int                     n                ;  // Slot number
+ MQLONG                  mqrc             ;  // MQ CC
+ MQLONG                  mqac             ;  // MQ RC
+
+ if ( anchor->Cache.max == 0 ) return 0 ;
+
+ key = cache_key(od, oopts)                          ;
+ n   = cache_find(traceid, anchor, conn, od, oopts, key) ;
+ if ( (n == 0) && (key != 0) && ((n = obj_new(traceid, anchor, conn)) != 0) )
+   {
+    MQOPEN ( anchor->QM[conn].QMh, od, oopts, &anchor->Obj[n].Qh, &mqrc, &mqac ) ;
+    TRACE(traceid, ("Cache MQOPEN rc = %"PRId32", ac = %"PRId32"\n",
+          (int32_t)mqrc,(int32_t)mqac) )                    ;
+    if ( anchor->Obj[n].Qh != 0 )
+      {
+       obj_opened(traceid, anchor, n, oopts, od->ObjectName) ;
+       cache_keep(anchor, n, key, od)                        ;
+      }
+    else
+      {
+       obj_drop(anchor, n)                                   ;
+       n = 0                                                 ;
+      }
+   }
+
+ return n ;
+} // End of cache_open
+
 //
+// cache_done - give back a handle from cache_open, to the cache, or
+//              closed if the open changed the name
 //
-
-void make_stem_from_md ( MQULONG    traceid      // trace id of caller
-                       , MQMD2    * md           // source message descriptor
-                       , RXSTRING   stem         // name of stem variable
-                       )
+void cache_done ( MQULONG    traceid      // trace id of caller
+                , RXMQCB   * anchor       // RXMQ Control Block
+                , int        n            // Slot number
+                )
 {
- char                         zlist[200]   ;  // Char version of .ZLIST
- zlist[0] = '\0'                           ;
+ MQLONG                  mqrc             ;  // MQCLOSE CC
+ MQLONG                  mqac             ;  // MQCLOSE RC
 
- TRACE(traceid, ("Entering make_stem_from_md\n") ) ;
- DUMPCB(traceid,  md )                             ;
-
-// Version 1 of MQMD
- stem_from_long  (traceid, zlist, stem, "VER"  , md->Version)                               ;
- stem_from_long  (traceid, zlist, stem, "REP"  , md->Report)                                ;
- stem_from_long  (traceid, zlist, stem, "MSG"  , md->MsgType)                               ;
- stem_from_long  (traceid, zlist, stem, "EXP"  , md->Expiry)                                ;
- stem_from_long  (traceid, zlist, stem, "FBK"  , md->Feedback)                              ;
- stem_from_long  (traceid, zlist, stem, "ENC"  , md->Encoding)                              ;
- stem_from_long  (traceid, zlist, stem, "CCSI" , md->CodedCharSetId)                        ;
- stem_from_string(traceid, zlist, stem, "FORM" , md->Format,              sizeof(MQCHAR8))  ;
- stem_from_long  (traceid, zlist, stem, "PRI"  , md->Priority)                              ;
- stem_from_long  (traceid, zlist, stem, "PER"  , md->Persistence)                           ;
- stem_from_bytes (traceid, zlist, stem, "MSGID", md->MsgId,               sizeof(MQBYTE24)) ;
- stem_from_bytes (traceid, zlist, stem, "CID"  , md->CorrelId,            sizeof(MQBYTE24)) ;
- stem_from_long  (traceid, zlist, stem, "BC"   , md->BackoutCount)                          ;
- stem_from_string(traceid, zlist, stem, "RTOQ" , md->ReplyToQ,            sizeof(MQCHAR48)) ;
- stem_from_string(traceid, zlist, stem, "RTOQM", md->ReplyToQMgr,         sizeof(MQCHAR48)) ;
- stem_from_string(traceid, zlist, stem, "UID"  , md->UserIdentifier,      sizeof(MQCHAR12)) ;
- stem_from_bytes (traceid, zlist, stem, "AT"   , md->AccountingToken,     sizeof(MQBYTE32)) ;
- stem_from_string(traceid, zlist, stem, "AID"  , md->ApplIdentityData,    sizeof(MQCHAR32)) ;
- stem_from_long  (traceid, zlist, stem, "PAT"  , md->PutApplType)                           ;
- stem_from_string(traceid, zlist, stem, "PAN"  , md->PutApplName,         sizeof(MQCHAR28)) ;
- stem_from_string(traceid, zlist, stem, "PD"   , md->PutDate,             sizeof(MQCHAR8))  ;
- stem_from_string(traceid, zlist, stem, "PT"   , md->PutTime,             sizeof(MQCHAR8))  ;
- stem_from_string(traceid, zlist, stem, "AOD"  , md->ApplOriginData,      sizeof(MQCHAR4))  ;
-// Version 2 of MQMD
- stem_from_bytes (traceid, zlist, stem, "GID"  , md->GroupId,             sizeof(MQBYTE24)) ;
- stem_from_long  (traceid, zlist, stem, "MSN"  , md->MsgSeqNumber)                          ;
- stem_from_long  (traceid, zlist, stem, "OFF"  , md->Offset)                                ;
- stem_from_long  (traceid, zlist, stem, "MF"   , md->MsgFlags)                              ;
- stem_from_long  (traceid, zlist, stem, "OL"   , md->OriginalLength)                        ;
-
- stem_from_string(traceid, zlist, stem, "ZLIST", zlist, strlen(zlist))                      ;
+ if ( anchor->Obj[n].key != 0 )
+   {
+    cache_idle(traceid, anchor, n) ;
+    return                         ;
+   }
 
- TRACE(traceid, ("Leaving make_stem_from_md\n") ) ;
+ MQCLOSE ( anchor->QM[anchor->Obj[n].conn].QMh, &anchor->Obj[n].Qh, MQCO_NONE, &mqrc, &mqac ) ;
+ TRACE(traceid, ("MQCLOSE rc = %"PRId32", ac = %"PRId32"\n",(int32_t)mqrc,(int32_t)mqac) ) ;
+ obj_drop(anchor, n) ;
 
  return ;
-} // End of make_stem_from_md function
+} // End of cache_done
 
 //
-// make_sd_from_stem will return a Subscription Descriptor from the
-//                   contents of a Stem Variable:
+// cache_stats - copy the cache size and counters to RXMQ.CACHE.xxx
 //
-//                     .VER  -> Version
-//                     .OPT  -> Options
-//                     .ON   -> ObjectName
-//                     .AUID -> AlternateUserId
-//                     .ASID -> AlternateSecurityId
-//                     .SE   -> SubExpiry
-//                     .OS   -> ObjectString
-//                     .SN   -> SubName
-//                     .SUD  -> SubUserData
-//                     .SCID -> SubCorrelId
-//                     .PP   -> PubPriority
-//                     .PAT  -> PubAccountingToken
-//                     .PAID -> PubAppIdentityData
-//                     .SS   -> SelectionString
-//                     .SL   -> SubLevel
-//                     .ROS  -> ResObjectString
+//          SIZE   -> most idle handles kept
+//          IDLE   -> idle handles now
+//          HITS   -> opens met from the cache
+//          MISSES -> cacheable opens that had to be done
 //
-
-void make_sd_from_stem ( MQULONG    traceid      // trace id of caller
-                       , MQSD     * subdesc      // target MQSD
-                       , RXSTRING   stem         // name of stem variable
-                       )
+void cache_stats ( MQULONG    traceid      // trace id of caller
+                 , RXMQCB   * anchor       // RXMQ Control Block
+                 )
 {
- TRACE(traceid, ("Entering make_sd_from_stem") ) ;
+ RXSTRING                stem             ;  // RXMQ.CACHE.
+ SHVCHAIN                chain            ;  // The four sets
 
- memcpy(subdesc, &sd_default, sizeof(MQSD));
+ MAKERXSTRING(stem, "RXMQ.CACHE.", sizeof("RXMQ.CACHE.")-1)       ;
+ chain.count = 0                                                  ;
+ shv_set_long (&chain, stem, "SIZE",   NULL, anchor->Cache.max)   ;
+ shv_set_long (&chain, stem, "IDLE",   NULL, anchor->Cache.idle)  ;
+ shv_set_int64(&chain, stem, "HITS",   NULL, anchor->Cache.hits)  ;
+ shv_set_int64(&chain, stem, "MISSES", NULL, anchor->Cache.misses) ;
+ shv_run(traceid, &chain)                                         ;
 
- //The given variable is a stem. variable, so get its contents
+ return ;
+} // End of cache_stats
 
- // Version 1 of MQSD
- stem_to_long  (traceid, stem, "VER" , &subdesc->Version)                               ;
- stem_to_long  (traceid, stem, "OPT" , &subdesc->Options)                               ;
- stem_to_string(traceid, stem, "ON"  ,  subdesc->ObjectName,          sizeof(MQCHAR48)) ;
- stem_to_string(traceid, stem, "AUID",  subdesc->AlternateUserId,     sizeof(MQCHAR12)) ;
- stem_to_bytes (traceid, stem, "ASID",  subdesc->AlternateSecurityId, sizeof(MQBYTE40)) ;
- stem_to_long  (traceid, stem, "SE"  , &subdesc->SubExpiry)                             ;
- stem_to_strinv(traceid, stem, "OS"  , &subdesc->ObjectString)                          ;
- stem_to_strinv(traceid, stem, "SN"  , &subdesc->SubName)                               ;
- stem_to_strinv(traceid, stem, "SUD" , &subdesc->SubUserData)                           ;
- stem_to_bytes (traceid, stem, "SCID",  subdesc->SubCorrelId,         sizeof(MQBYTE24)) ;
- stem_to_long  (traceid, stem, "PP"  , &subdesc->PubPriority)                           ;
- stem_to_bytes (traceid, stem, "PAT" ,  subdesc->PubAccountingToken,  sizeof(MQBYTE32)) ;
- stem_to_string(traceid, stem, "PAID",  subdesc->PubApplIdentityData, sizeof(MQCHAR32)) ;
- stem_to_strinv(traceid, stem, "SS"  , &subdesc->SelectionString)                       ;
- stem_to_long  (traceid, stem, "SL"  , &subdesc->SubLevel)                              ;
- stem_to_strinv(traceid, stem, "ROS" , &subdesc->ResObjectString)                       ;
+//
+// Session table (RXMQSESS)
+//
 
- DUMPCB(traceid, subdesc) ;
- TRACE(traceid, ("Leaving make_sd_from_stem\n") ) ;
+#ifdef _WIN32
+//
+// sess_lock_win - enter the critical section guarding Sess[], making it
+//                 on first use
+//
+void sess_lock_win ( void )
+{
+ if ( InterlockedCompareExchange(&sess_csinit, 1, 0) == 0 )
+   {
+    InitializeCriticalSection(&sess_cs) ;
+    InterlockedExchange(&sess_csinit, 2) ;
+   }
+ else while ( sess_csinit != 2 ) Sleep(0) ;
+
+ EnterCriticalSection(&sess_cs) ;
 
  return ;
-} // End of make_sd_from_stem function
+} // End of sess_lock_win
+#endif
 
 //
-// make_stem_from_sd will return a Subscription Descriptor as the
-//                   contents of a Stem Variable:
+// sess_find - the session of a name, or -1 (the caller holds SESS_LOCK)
 //
-//                     .VER  -> Version
-//                     .OPT  -> Options
-//                     .ON   -> ObjectName
-//                     .AUID -> AlternateUserId
-//                     .ASID -> AlternateSecurityId
-//                     .SE   -> SubExpiry
-//                     .OS   -> ObjectString
-//                     .SN   -> SubName
-//                     .SUD  -> SubUserData
-//                     .SCID -> SubCorrelId
-//                     .PP   -> PubPriority
-//                     .PAT  -> PubAccountingToken
-//                     .PAID -> PubAppIdentityData
-//                     .SS   -> SelectionString
-//                     .SL   -> SubLevel
-//                     .ROS  -> ResObjectString
+int sess_find ( PMQCHAR    name         // Session name
+              )
+{
+ int                     i                ;  // Looper
+
+ for ( i = 0 ; i < MAXSESS ; i++ )
+   if ( (Sess[i].state != SESS_FREE) && !memcmp(Sess[i].name, name, sizeof(MQCHAR48)) )
+      return i ;
+
+ return -1 ;
+} // End of sess_find
+
 //
-//                     .ZLIST -> 'VER OPT ON AUID ASID
-//                                SE OS. SN. SUD. SCID
-//                                PP PAT PAID
-//                                SS. SL ROS.
+// sess_shut - close a session's queues and disconnect it, then free its
+//             slot. The worst MQ outcome is returned.
 //
-
-void make_stem_from_sd ( MQULONG    traceid      // trace id of caller
-                       , MQSD     * subdesc      // source MQSD
-                       , RXSTRING   stem         // name of stem variable
-                       )
+void sess_shut ( MQULONG      traceid    // trace id of caller
+               , RXMQSESSCB * sess       // Session (SESS_BUSY)
+               , PMQLONG      mqrc       // MQ CC
+               , PMQLONG      mqac       // MQ RC
+               )
 {
- char                        zlist[200]   ;  // Char version of .ZLIST
- zlist[0] = '\0'                          ;
+ MQLONG                  cc               ;  // MQ CC of one call
+ MQLONG                  ac               ;  //   and its RC
+ int                     i                ;  // Looper
 
- TRACE(traceid, ("Entering make_stem_from_sd\n") ) ;
- DUMPCB(traceid, subdesc)                          ;
+ *mqrc = MQCC_OK   ;
+ *mqac = MQRC_NONE ;
 
- // Version 1 of MQSD
- stem_from_long  (traceid, zlist, stem, "VER" , subdesc->Version)                               ;
- stem_from_long  (traceid, zlist, stem, "OPT" , subdesc->Options)                               ;
- stem_from_string(traceid, zlist, stem, "ON"  , subdesc->ObjectName,          sizeof(MQCHAR48)) ;
- stem_from_string(traceid, zlist, stem, "AUID", subdesc->AlternateUserId,     sizeof(MQCHAR12)) ;
- stem_from_bytes (traceid, zlist, stem, "ASID", subdesc->AlternateSecurityId, sizeof(MQBYTE40)) ;
- stem_from_long  (traceid, zlist, stem, "SE"  , subdesc->SubExpiry)                             ;
- stem_from_strinv(traceid, zlist, stem, "OS"  , subdesc->ObjectString)                          ;
- stem_from_strinv(traceid, zlist, stem, "SN"  , subdesc->SubName)                               ;
- stem_from_strinv(traceid, zlist, stem, "SUD" , subdesc->SubUserData)                           ;
- stem_from_bytes (traceid, zlist, stem, "SCID", subdesc->SubCorrelId,         sizeof(MQBYTE24)) ;
- stem_from_long  (traceid, zlist, stem, "PP"  , subdesc->PubPriority)                           ;
- stem_from_bytes (traceid, zlist, stem, "PAT" , subdesc->PubAccountingToken,  sizeof(MQBYTE32)) ;
- stem_from_string(traceid, zlist, stem, "PAID", subdesc->PubApplIdentityData, sizeof(MQCHAR32)) ;
- stem_from_strinv(traceid, zlist, stem, "SS"  , subdesc->SelectionString)                       ;
- stem_from_long  (traceid, zlist, stem, "SL"  , subdesc->SubLevel)                              ;
- stem_from_strinv(traceid, zlist, stem, "ROS" , subdesc->ResObjectString)                       ;
-
- stem_from_string(traceid, zlist, stem, "ZLIST", zlist, strlen(zlist))                         ;
+ for ( i = 0 ; i <= sess->Qs ; i++ )
+   {
+    if ( i < sess->Qs ) MQCLOSE ( sess->QMh, &sess->Qh[i], MQCO_NONE, &cc, &ac ) ;
+    else                MQDISC  ( &sess->QMh, &cc, &ac )                        ;
+    TRACE(traceid, ("Session %.48s %s rc = %"PRId32", ac = %"PRId32"\n",
+          sess->name, (i < sess->Qs) ? "MQCLOSE" : "MQDISC", (int32_t)cc, (int32_t)ac) ) ;
+    if ( cc > *mqrc )
+      {
+       *mqrc = cc ;
+       *mqac = ac ;
+      }
+   }
 
- TRACE(traceid, ("Leaving make_stem_from_sd\n") ) ;
+ SESS_LOCK()                         ;
+ memset(sess, 0, sizeof(RXMQSESSCB)) ;  // Now SESS_FREE
+ SESS_UNLOCK()                       ;
 
  return ;
-} // End of make_stem_from_sd function
-
+} // End of sess_shut
 
 //
-// Genuine Internal functions, not concerned with specific things
+// sess_open - connect a session with handle sharing, and open its queues.
+//             Returns -1 if the name is in use, -2 if there is no free
+//             slot, else the MQ completion code.
 //
+MQLONG sess_open ( MQULONG    traceid      // trace id of caller
+                 , PMQCHAR    name         // Session name
+                 , char       qmname[]     // QM name
+                 , MQCHAR48   qname[]      // Queues to open
+                 , int        qs           //   how many
+                 , MQLONG     options      // Their open options
+                 , PMQLONG    mqrc         // MQ CC
+                 , PMQLONG    mqac         // MQ RC
+                 )
+{
+ RXMQSESSCB            * sess = NULL      ;  // Slot taken
+ MQCNO                   cno              ;  // MQ connect options
+ MQOD                    od               ;  // MQ object descriptor
+ MQLONG                  cc               ;  // MQ CC of the clean up
+ MQLONG                  ac               ;  //   and its RC
+ int                     found            ;  // Session of the name
+ int                     connected        ;  // MQCONNX worked
+ int                     i                ;  // Looper
 
 //
-// setcons - sets up the MQ constants in the Rexx Variable Space
-//           Traced by INIT setting
+// Take a slot, keeping the name from being opened twice meanwhile
 //
+ SESS_LOCK() ;
+ found = sess_find(name) ;
+ for ( i = 0 ; (found < 0) && (sess == NULL) && (i < MAXSESS) ; i++ )
+   if ( Sess[i].state == SESS_FREE ) sess = &Sess[i] ;
+ if ( sess != NULL )
+   {
+    memset(sess, 0, sizeof(RXMQSESSCB))         ;
+    sess->state = SESS_BUSY                     ;
+    memcpy(sess->name, name, sizeof(MQCHAR48))  ;
+   }
+ SESS_UNLOCK() ;
 
-void setcons (MQULONG traceid)
- {
+ if ( found >= 0 )  return -1 ;
+ if ( sess == NULL ) return -2 ;
 
 //
-// Structure to define MQ literals, to be setup in Variable Space
+// Connect and open, which may take a while, outside the lock
 //
+ memcpy(sess->QMname, qmname, sizeof(sess->QMname)) ;
+ memcpy(&cno, &cno_default, sizeof(MQCNO))        ;
+ cno.Options  = MQCNO_HANDLE_SHARE_BLOCK          ;
+ sess->options = options                          ;
 
- struct s_define_mq_ints
-        {
-          char           s_define_mq_ints_name[255] ; // Constant name
-          int32_t        s_define_mq_ints_value     ; // Constant value
-          uint32_t       s_define_mq_ints_type      ; // 0 -> number
-                                                      // 1 -> MQRC_
-                                                      // 2 -> not used
-                                                      // 3 -> MQCC_
-                                                      // 4 -> MQCA_
-        } ;
-
- typedef struct s_define_mq_ints   t_define_mq_ints ;
- typedef        t_define_mq_ints * p_define_mq_ints ;
+ MQCONNX ( sess->QMname, &cno, &sess->QMh, mqrc, mqac ) ;
+ connected = ( *mqrc != MQCC_FAILED )                   ;
+ TRACE(traceid, ("Session %.48s MQCONNX handle is %"PRIX32", QM is %.48s, rc = %"PRId32", ac = %"PRId32"\n",
+       sess->name, (uint32_t)sess->QMh, sess->QMname, (int32_t)*mqrc, (int32_t)*mqac) ) ;
 
- struct s_define_mq_str
-        {
-          char           s_define_mq_str_name[32]   ;  // 32 seems to be max
-          char           s_define_mq_str_value[9]   ;  // 8 is biggest so far
-          MQULONG        s_define_mq_str_type       ;  // 0 -> char
-        } ;
+ for ( i = 0 ; (*mqrc != MQCC_FAILED) && (i < qs) ; i++ )
+   {
+    memcpy(&od, &od_default, sizeof(MQOD))            ;
+    memcpy(od.ObjectName, qname[i], sizeof(MQCHAR48)) ;
+    MQOPEN ( sess->QMh, &od, options, &sess->Qh[i], mqrc, mqac ) ;
+    TRACE(traceid, ("Session %.48s MQOPEN of %.48s rc = %"PRId32", ac = %"PRId32"\n",
+          sess->name, qname[i], (int32_t)*mqrc, (int32_t)*mqac) ) ;
+    if ( *mqrc != MQCC_FAILED )
+      {
+       memcpy(sess->Qname[i], qname[i], sizeof(MQCHAR48)) ;
+       sess->Qs++                                         ;
+      }
+   }
 
- typedef struct s_define_mq_str   t_define_mq_str  ;
- typedef        t_define_mq_str * p_define_mq_str  ;
+//
+// Undo what was done if that failed, else let threads attach
+//
+ if ( *mqrc != MQCC_FAILED )
+   {
+    SESS_LOCK()                       ;
+    sess->state = SESS_READY          ;
+    SESS_UNLOCK()                     ;
+   }
+ else if ( connected ) sess_shut(traceid, sess, &cc, &ac) ;
+ else
+   {
+    SESS_LOCK()                         ;
+    memset(sess, 0, sizeof(RXMQSESSCB)) ;
+    SESS_UNLOCK()                       ;
+   }
 
- struct s_define_mq_byte
-        {
-          char           s_define_mq_byte_name[32]  ;  // 32 seems to be max
-          MQBYTE         s_define_mq_byte_value[33] ;  // 33 is biggest so far
-          MQULONG        s_define_mq_byte_size      ;
-        } ;
+ return *mqrc ;
+} // End of sess_open
 
- typedef struct s_define_mq_byte   t_define_mq_byte ;
- typedef        t_define_mq_byte * p_define_mq_byte ;
+//
+// sess_list - open session n of those listed in RXMQ.SESSION. (RXMQINIT),
+//             returning as sess_open does, or -3 if the entry is unusable
+//
+MQLONG sess_list ( MQULONG    traceid      // trace id of caller
+                 , int        n            // Entry in the list
+                 , PMQLONG    mqrc         // MQ CC
+                 , PMQLONG    mqac         // MQ RC
+                 )
+{
+ RXSTRING                RX_stem          ;  // RXMQ.SESSION.(n.)
+ char                    stemc[40]        ;  //   its characters
+ char                    tail[24]         ;  // Variable name tail
+ char                    value[MQ_Q_MGR_NAME_LENGTH+1] ; // Value fetched
+ MQCHAR48                name             ;  // Session name
+ char                    qmname[MQ_Q_MGR_NAME_LENGTH]  ; // QM name
+ MQCHAR48                qname[MAXSESSQ]  ;  // Queues to open
+ MQLONG                  qs      = 0      ;  //   how many
+ MQLONG                  options = MQOO_OUTPUT | MQOO_FAIL_IF_QUIESCING ; // Their open options
+ int                     i                ;  // Looper
 
- struct s_define_mq_char
-        {
-          char           s_define_mq_char_name[32]  ;  // 32 seems to be max
-          char           s_define_mq_char_value     ;  // 1-byte char
-          MQULONG        s_define_mq_char_type      ;  // 0 -> char
-        } ;
+ MAKERXSTRING(RX_stem, "RXMQ.SESSION.", strlen("RXMQ.SESSION.")) ;
+ sprintf(tail, "%d", n)                                            ;
+ memset(value, 0, sizeof(value))                                   ;
+ stem_to_string(traceid, RX_stem, tail, value, MQ_Q_MGR_NAME_LENGTH) ;
+ memset(name, 0, sizeof(name))                                     ;
+ memcpy(name, value, strlen(value))                                ;
+
+ sprintf(stemc, "RXMQ.SESSION.%d.", n)                             ;
+ MAKERXSTRING(RX_stem, stemc, strlen(stemc))                       ;
+ memset(value, 0, sizeof(value))                                   ;
+ stem_to_string(traceid, RX_stem, "QM", value, MQ_Q_MGR_NAME_LENGTH) ;
+ memset(qmname, 0, sizeof(qmname))                                 ;
+ memcpy(qmname, value, strlen(value))                              ;
+ stem_to_long(traceid, RX_stem, "OPTS", &options)                  ;
+ stem_to_long(traceid, RX_stem, "Q.0", &qs)                        ;
+
+ if ( (name[0] == 0) || (qs < 0) || (qs > MAXSESSQ) ) return -3 ;
+
+ for ( i = 0 ; i < qs ; i++ )
+   {
+    sprintf(tail, "Q.%d", i + 1)                                        ;
+    memset(value, 0, sizeof(value))                                     ;
+    stem_to_string(traceid, RX_stem, tail, value, MQ_Q_MGR_NAME_LENGTH) ;
+    memset(qname[i], 0, sizeof(MQCHAR48))                               ;
+    memcpy(qname[i], value, strlen(value))                              ;
+   }
 
- typedef struct s_define_mq_char   t_define_mq_char ;
- typedef        t_define_mq_char * p_define_mq_char ;
+ return sess_open(traceid, name, qmname, qname, qs, options, mqrc, mqac) ;
+} // End of sess_list
 
- //
- //  Usual local variables
- //
+//
+// sess_detach - end a thread's use of a session's connection, closing
+//               any queues it opened on it itself
+//
+void sess_detach ( MQULONG    traceid      // trace id of caller
+                 , RXMQCB   * anchor       // RXMQ Control Block
+                 , int        conn         // Connection attached
+                 )
+{
+ MQLONG                  mqrc             ;  // MQ CC
+ MQLONG                  mqac             ;  // MQ RC
+ MQHOBJ                  hobj             ;  // Handle being closed
+ int                     n                ;  // Slot number
 
- MQULONG                  i                ;  // Looper
- p_define_mq_ints         pi               ;  // Table pointer
- p_define_mq_str          ps               ;  // Table pointer
- p_define_mq_byte         pb               ;  // Table pointer
- p_define_mq_char         pc               ;  // Table pointer
- RXSTRING                 varname          ;  // Variable name
- RXSTRING                 varname_new      ;  // Variable name
- RXSTRING                 varname_old      ;  // Variable name
- char                     varvalc[100]     ;  // Char version of variable
+ for ( n = 1 ; n < anchor->Objsize ; n++ )
+   if ( (anchor->Obj[n].Qh != 0) && (anchor->Obj[n].conn == conn) && !anchor->Obj[n].shared )
+     {
+      hobj = anchor->Obj[n].Qh                                   ;  // Slot dropped below
+      MQCLOSE ( anchor->QM[conn].QMh, &hobj, MQCO_NONE, &mqrc, &mqac ) ;
+      TRACE(traceid, ("Closed [%d] on detach, rc = %"PRId32", ac = %"PRId32"\n",
+            n, (int32_t)mqrc, (int32_t)mqac) ) ;
+     }
+ obj_reset(anchor, conn, 0) ;
+
+ SESS_LOCK()                               ;
+ Sess[anchor->QM[conn].Sess - 1].users--   ;
+ SESS_UNLOCK()                             ;
+
+ memset(&anchor->QM[conn], 0, sizeof(RXMQQM)) ;
+ anchor->Conns--                              ;
+
+ return ;
+} // End of sess_detach
 
 //
-// Array and Structure to define MQ literals, to be setup in Variable Space
-// Constants are placed in separate header file for ease of use
+// now_us - a microsecond clock, for timing commits
 //
+uint64_t now_us ( void )
+{
+#ifdef _WIN32
+ static LARGE_INTEGER    freq             ;  // Counter ticks a second
+ LARGE_INTEGER           count            ;  // Counter now
+
+ if ( freq.QuadPart == 0 ) QueryPerformanceFrequency(&freq) ;
+ QueryPerformanceCounter(&count)                            ;
+ return (uint64_t) ( (count.QuadPart / freq.QuadPart) * 1000000
+                   + (count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart ) ;
+#else
+ struct timeval          tv               ;  // Time now
 
-#include <rxmqcons.h>
+ gettimeofday(&tv, NULL) ;
+ return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec ;
+#endif
+} // End of now_us
 
- TRACE(traceid, ("Entering setcons\n") ) ;
+//
+// now_ms - a millisecond clock, for the deadline of RXMQGETN
+//
+uint64_t now_ms ( void )
+{
+#ifdef _WIN32
+ return (uint64_t) GetTickCount64() ;
+#else
+ return now_us() / 1000 ;
+#endif
+} // End of now_ms
 
- //
- // initialize all the constants required.
- //
- // This is done by looping through the table of names and
- //      settings, invoking the RexxVariable interface to set up
- //      each literal.
- //
- // Additionally, if the constant represents Completion Code (MQCC_)
- //               then create an number->name entry in the
- //               RXMQ.CCMAP. stem variable
- //
- // Additionally, if the constant represents Reason Code (MQRC_)
- //               then create an number->name entry in the
- //               RXMQ.RCMAP. stem variable
- //
- // Additionally, if the constant represents Event (MQCA_,...)
- //               then create an number->name entry in the
- //               RXMQ.CAMAP. stem variable
- //
+//
+// sleep_ms - wait a number of milliseconds, for the pacing of RXMQCOPY
+//
+void sleep_ms ( MQLONG     ms           // Time to wait
+              )
+{
+#ifdef _WIN32
+ Sleep((DWORD)ms) ;
+#else
+ struct timespec         ts               ;  // Time to wait
 
- MAKERXSTRING(varname_new, "RXMQ.", sizeof("RXMQ.")-1)  ;
- MAKERXSTRING(varname_old, PREFIX,  sizeof(PREFIX)-1)   ;
+ ts.tv_sec  = ms / 1000                 ;
+ ts.tv_nsec = (long)(ms % 1000) * 1000000 ;
+ nanosleep(&ts, NULL)                   ;
+#endif
+} // End of sleep_ms
 
- for (i=0; ; i++)
+//
+// Asynchronous consume
+//
+//   A queue given to RXMQASYN has a message consumer, async_msg,
+//   registered with MQCB, which MQ runs on a thread of its own for the
+//   connection once MQCTL has started it. Each message is copied into
+//   the next slot of the queue's ring, and RXMQPOLL takes them from the
+//   rings on the REXX thread. A ring has one writer and one reader, so
+//   needs no lock: the writer fills the slot at tail and only then moves
+//   tail on, the reader empties the one at head and only then moves head
+//   on. A slot's buffer is kept, and grown when a message needs it.
+//
+//   When a message fills its ring the consumer suspends itself, so MQ
+//   holds the queue's messages back, and RXMQPOLL resumes it once the
+//   ring is half empty. A reader with nothing to take waits on the
+//   thread's RXMQWAKE, which a writer signals only while it waits.
+//
+//   The consumer browses, and a message is removed from the queue (by
+//   an MQGET of the message under the cursor) only once it has been
+//   copied into a slot. One that finds no slot, because the suspend
+//   failed or the connection is being stopped, is left on the queue,
+//   and the consumer registered again to browse from the first message
+//   when the connection is next started or resumed. The messages still
+//   in a ring when its consumer is deregistered have been removed, and
+//   are lost: async_drop returns how many, for the caller to report.
+//
+//   MQ calls other than MQCB and MQCTL fail on a connection while it is
+//   started, so RXMQCLOS of a queue being consumed stops the connection,
+//   deregisters the queue and starts it again for the others.
+//
+
+//
+// wake_make - make the RXMQWAKE of a thread, returning 0 if it was made
+//
+int wake_make ( RXMQWAKE * wake         // Wake up
+              )
+{
+ if ( wake->made ) return 0 ;
+
+#if defined(_WIN32)
+ wake->event = CreateEvent(NULL, FALSE, FALSE, NULL) ;
+ if ( wake->event == NULL ) return -1                 ;
+#elif !defined(__MVS__)
+ if ( pthread_mutex_init(&wake->mutex, NULL) != 0 ) return -1 ;
+ if ( pthread_cond_init(&wake->cond, NULL) != 0 )
    {
-    pi = &define_mq_ints[i]                           ;
-    if ( pi->s_define_mq_ints_name[0] == '?' )  break ;
+    pthread_mutex_destroy(&wake->mutex) ;
+    return -1                           ;
+   }
+#endif
+ wake->waiting = 0 ;
+ wake->made    = 1 ;
 
-    MAKERXSTRING(varname,
-                 &(pi->s_define_mq_ints_name[0]),
-                 strlen(pi->s_define_mq_ints_name))         ; // REXX variable name
-    stem_from_long  (traceid, NULL, varname, "", pi->s_define_mq_ints_value);
+ return 0 ;
+} // End of wake_make
 
-    if ( pi->s_define_mq_ints_type == 1 )    //Only for MQRC_ stuff
-     {
-      sprintf(varvalc, "RCMAP.%"PRId32, pi->s_define_mq_ints_value)   ;
-      stem_from_string(traceid, NULL, varname_new, varvalc,
-                       &(pi->s_define_mq_ints_name[0]),
-                       strlen(pi->s_define_mq_ints_name))   ; // like RXMQ.RCMAP.value
-      stem_from_string(traceid, NULL, varname_old, varvalc,
-                       &(pi->s_define_mq_ints_name[0]),
-                       strlen(pi->s_define_mq_ints_name))   ; // like RXMQV.RCMAP.value
-      }
+//
+// wake_free - free the RXMQWAKE of a thread (RXMQTERM)
+//
+void wake_free ( RXMQWAKE * wake         // Wake up
+               )
+{
+ if ( !wake->made ) return ;
 
-    if ( pi->s_define_mq_ints_type == 3 )    //Only for MQCC_ stuff
-     {
-      sprintf(varvalc, "CCMAP.%"PRId32, pi->s_define_mq_ints_value)   ;
-      stem_from_string(traceid, NULL, varname_new, varvalc,
-                       &(pi->s_define_mq_ints_name[0]),
-                       strlen(pi->s_define_mq_ints_name))   ; // like RXMQ.CCMAP.value
-     }
+#if defined(_WIN32)
+ CloseHandle(wake->event)            ;
+#elif !defined(__MVS__)
+ pthread_cond_destroy(&wake->cond)   ;
+ pthread_mutex_destroy(&wake->mutex) ;
+#endif
+ wake->made = 0 ;
 
-    if ( pi->s_define_mq_ints_type == 4 )    //Only for Selector/Event Attributes
-     {
-      sprintf(varvalc, "CAMAP.%"PRId32, pi->s_define_mq_ints_value)   ;
+ return ;
+} // End of wake_free
 
-      varname.strptr    = strstr(&(pi->s_define_mq_ints_name[0]), "_") + 1 ;
-      varname.strlength = strlen(varname.strptr)            ;
+//
+// wake_up - wake RXMQPOLL (on MQ's thread)
+//
+void wake_up ( RXMQWAKE * wake         // Wake up
+             )
+{
+#if defined(_WIN32)
+ SetEvent(wake->event) ;
+#elif !defined(__MVS__)
+ pthread_mutex_lock(&wake->mutex)   ;
+ pthread_cond_signal(&wake->cond)   ;
+ pthread_mutex_unlock(&wake->mutex) ;
+#endif
 
-      stem_from_string(traceid, NULL, varname_new, varvalc,
-                       varname.strptr, varname.strlength)   ; // like RXMQ.CAMAP.value
-     }
-   } // End of Integer initializations Loop
+ return ;
+} // End of wake_up
 
- for (i=0; ; i++)
+//
+// async_ready - whether RXMQPOLL has anything to take, from the queue
+//               of slot n (or any if 0, or those RXMQWANY waits on if
+//               -1)
+//
+int async_ready ( RXMQCB   * anchor       // RXMQ Control Block
+                , int        n            // Slot number (0 any, -1 RXMQWANY's)
+                )
+{
+ RXMQRING              * ring             ;  // A queue's ring
+ int                     k                ;  // Slot number
+
+ for ( k = 1 ; k < anchor->Objsize ; k++ )
    {
-    ps = &define_mq_str[i]                           ;
-    if ( ps->s_define_mq_str_name[0] == '?' ) break  ;
+    ring = anchor->Obj[k].ring ;
+    if ( (ring == NULL) || ((n > 0) && (k != n)) || ((n < 0) && (ring->weight == 0)) ) continue ;
+    if ( (RING_GET(ring->tail) != ring->head) || (RING_GET(ring->reason) != 0) ) return 1 ;
+   }
 
-    MAKERXSTRING(varname,
-                 &(ps->s_define_mq_str_name[0]),
-                 strlen(ps->s_define_mq_str_name))         ; // REXX variable name
-    stem_from_string(traceid, NULL, varname, "",
-                     &(ps->s_define_mq_str_value[0]),
-                     strlen(ps->s_define_mq_str_value))    ;
-   } // End of String initializations Loop
+ return 0 ;
+} // End of async_ready
 
- for (i=0; ; i++)
+//
+// wake_wait - wait up to ms milliseconds for a message for RXMQPOLL.
+//             The rings are looked at again once waiting is set (under
+//             the mutex), so a message kept just before is not missed.
+//
+void wake_wait ( RXMQCB   * anchor       // RXMQ Control Block
+               , int        n            // Slot number (0 any, -1 RXMQWANY's)
+               , MQLONG     ms           // Most to wait
+               )
+{
+#if defined(__MVS__)
+ sleep_ms( (ms < 10) ? ms : 10 ) ;
+#elif defined(_WIN32)
+ RXMQWAKE              * wake = &anchor->Wake ;  // Wake up
+
+ RING_SET(wake->waiting, 1)                              ;
+ if ( !async_ready(anchor, n) ) WaitForSingleObject(wake->event, (DWORD)ms) ;
+ RING_SET(wake->waiting, 0)                              ;
+#else
+ RXMQWAKE              * wake = &anchor->Wake ;  // Wake up
+ struct timeval          tv               ;  // Time now
+ struct timespec         ts               ;  //   and to wait until
+
+ gettimeofday(&tv, NULL)                                 ;
+ ts.tv_sec  = tv.tv_sec + ms / 1000                      ;
+ ts.tv_nsec = (long)tv.tv_usec * 1000 + (long)(ms % 1000) * 1000000 ;
+ if ( ts.tv_nsec >= 1000000000 )
    {
-    pb = &define_mq_byte[i]                           ;
-    if ( pb->s_define_mq_byte_name[0] == '?' ) break  ;
+    ts.tv_sec++                                          ;
+    ts.tv_nsec -= 1000000000                             ;
+   }
 
-    MAKERXSTRING(varname,
-                 &(pb->s_define_mq_byte_name[0]),
-                 strlen(pb->s_define_mq_byte_name))       ; // REXX variable name
-    stem_from_bytes(traceid, NULL, varname, "",
-                    &(pb->s_define_mq_byte_value[0]),
-                    pb->s_define_mq_byte_size)            ;
-   } // End of Byte initializations Loop
+ pthread_mutex_lock(&wake->mutex)                        ;
+ RING_SET(wake->waiting, 1)                              ;
+ if ( !async_ready(anchor, n) ) pthread_cond_timedwait(&wake->cond, &wake->mutex, &ts) ;
+ RING_SET(wake->waiting, 0)                              ;
+ pthread_mutex_unlock(&wake->mutex)                      ;
+#endif
 
- for (i=0; ; i++)
-   {
-    pc = &define_mq_char[i]                           ;
-    if ( pc->s_define_mq_char_name[0] == '?' ) break  ;
+ return ;
+} // End of wake_wait
 
-    MAKERXSTRING(varname,
-                 &(pc->s_define_mq_char_name[0]),
-                 strlen(pc->s_define_mq_char_name))   ; // REXX variable name
-    stem_from_char(traceid, NULL, varname, "",
-                   (pc->s_define_mq_char_value))      ;
-   } // End of Character initializations Loop
+//
+// async_leave - leave a message on the queue (on MQ's thread), the
+//               consumer suspending itself, and browsing from the first
+//               message again once it is started or resumed. A browsing
+//               consumer just passes it over.
+//
+void async_leave ( MQHCONN    hconn        // Connection handle
+                 , PMQCBC     context      // Consumer context
+                 , RXMQRING * ring         // The queue's ring
+                 )
+{
+ MQLONG                  cc               ;  // MQCB CC
+ MQLONG                  ac               ;  // MQCB RC
 
- TRACE(traceid, ("Leaving setcons\n") ) ;
+ if ( ring->browse || RING_GET(ring->rewind) ) return ;
+
+ RING_SET(ring->rewind, 1)                ;
+ MQCB ( hconn, MQOP_SUSPEND, NULL, context->Hobj, NULL, NULL, &cc, &ac ) ;
+ RING_SET(ring->suspended, 1)             ; // Resumed by RXMQPOLL even if that failed
 
  return ;
+} // End of async_leave
 
- } // End of setcons function
+//
+// async_msg - the message consumer (on MQ's thread), keeping a message
+//             in the queue's ring
+//
+void MQENTRY async_msg ( MQHCONN    hconn        // Connection handle
+                       , PMQVOID    pmd          // Message descriptor
+                       , PMQVOID    pgmo         // Get message options
+                       , PMQVOID    buffer       // Message data
+                       , PMQCBC     context      // Consumer context
+                       )
+{
+ RXMQRING              * ring = (RXMQRING *) context->CallbackArea ;
+ RXMQSLOT              * slot             ;  // Slot filled
+ MQULONG                 tail = ring->tail ;  // Only written here
+ MQLONG                  len              ;  // Message length
+ char                  * data             ;  //-> Bigger buffer
+ MQMD2                   md               ;  // MD of the removing MQGET
+ MQGMO                   gmo              ;  //   and its options
+ MQLONG                  datalen          ;  //   and data length
+ MQLONG                  cc               ;  // MQCB CC
+ MQLONG                  ac               ;  // MQCB RC
+
+//
+// A failure (or event) is kept for RXMQPOLL to return
+//
+ if (    ( (context->CallType != MQCBCT_MSG_REMOVED)
+        && (context->CallType != MQCBCT_MSG_NOT_REMOVED) )
+      || (context->CompCode == MQCC_FAILED) )
+   {
+    if ( (context->Reason != MQRC_NONE) && (context->Reason != MQRC_NO_MSG_AVAILABLE) )
+       RING_SET(ring->reason, context->Reason) ;
+    if ( RING_GET(ring->wake->waiting) ) wake_up(ring->wake) ;
+    return ;
+   }
 
 //
-// Routine geteventname - converts the NUMBER of an Event into
-//                        a name (for use as a Component Variable),
-//                        which is defined event name like MQCA_...
-//                        without MQCA_ prefix itself
+// The message is left on the queue if the connection is being stopped,
+// or there is no slot for it (the suspend having failed), or one before
+// it was left, the queue then being browsed again from the first
 //
-//         If the PCF field number is unknown, then the
-//            component is set to the character version of the
-//            PCF event number. This only works for EVENT PCFs!!!!
+ if (    RING_GET(ring->stopping) || RING_GET(ring->rewind)
+      || (tail - RING_GET(ring->head) >= ring->slots) )
+   {
+    async_leave(hconn, context, ring) ;
+    return ;
+   }
+
+ slot = &ring->slot[tail & (ring->slots - 1)] ;
+ len  = ( context->DataLength < context->BufferLength )
+      ? context->DataLength : context->BufferLength ;
+ if ( len > slot->size )
+   {
+    data = (char *) realloc(slot->data, len) ;
+    if ( data == NULL )
+      {
+       async_leave(hconn, context, ring) ;
+       RING_SET(ring->reason, MQRC_STORAGE_NOT_AVAILABLE) ;
+       if ( RING_GET(ring->wake->waiting) ) wake_up(ring->wake) ;
+       return ;
+      }
+    slot->data = data ;
+    slot->size = len  ;
+   }
+ memcpy(&slot->md, pmd, sizeof(MQMD2))           ;
+ if ( len > 0 ) memcpy(slot->data, buffer, len)  ;
+ slot->datalen = len                             ;
+
 //
-//         Tracing is via the EVENT setting
+// Now it has its slot, remove it (its data is not wanted again). One
+// another application got first is passed over.
+//
+ if ( !ring->browse )
+   {
+    memcpy(&md , &md_default , sizeof(MQMD2)) ;
+    memcpy(&gmo, &gmo_default, sizeof(MQGMO)) ;
+    gmo.Options = MQGMO_MSG_UNDER_CURSOR + MQGMO_NO_SYNCPOINT
+                + MQGMO_ACCEPT_TRUNCATED_MSG + MQGMO_FAIL_IF_QUIESCING ;
+    MQGET ( hconn, context->Hobj, &md, &gmo, 0, NULL, &datalen, &cc, &ac ) ;
+    if ( (cc == MQCC_FAILED) && (ac != MQRC_NO_MSG_UNDER_CURSOR) )
+      {
+       RING_SET(ring->reason, ac) ;
+       if ( RING_GET(ring->wake->waiting) ) wake_up(ring->wake) ;
+      }
+    if ( cc == MQCC_FAILED ) return ;
+   }
+ RING_SET(ring->tail, tail + 1)                  ;
+
 //
+// Suspend the consumer if that filled the ring, and wake RXMQPOLL
 //
+ if ( tail + 1 - RING_GET(ring->head) >= ring->slots )
+   {
+    MQCB ( hconn, MQOP_SUSPEND, NULL, context->Hobj, NULL, NULL, &cc, &ac ) ;
+    if ( cc != MQCC_FAILED ) RING_SET(ring->suspended, 1) ;
+   }
+ if ( RING_GET(ring->wake->waiting) ) wake_up(ring->wake) ;
 
-void geteventname(char * output, const MQLONG pcfnum )
- {
-  char                    varnamc[100] ;  // Char version of var name
-  char                    varvalc[31]  ;  // Char version of var value
-  SHVBLOCK                sv1          ;  // Var interface CB
-  MQULONG                 sv1rc        ;  // Var interface RC
+ return ;
+} // End of async_msg
 
-  // TRACE(EVENT, ("Entering geteventname for %"PRId32"\n",(int32_t)pcfnum) ) ;
+//
+// async_reg - register the consumer of the queue in slot n, with the
+//             get options of its ring (the connection not being started)
+//
+void async_reg ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        n            // Slot number
+               , RXMQRING * ring         // Its ring
+               , MQLONG   * mqrc         // MQ CC
+               , MQLONG   * mqac         // MQ RC
+               )
+{
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
+ MQCBD                   cbd              ;  // Callback descriptor
+ MQMD2                   md               ;  // Message descriptor
+ MQGMO                   gmo              ;  // Get message options
+
+ memcpy(&cbd, &cbd_default, sizeof(MQCBD)) ;
+ memcpy(&md , &md_default , sizeof(MQMD2)) ;
+ memcpy(&gmo, &ring->gmo  , sizeof(MQGMO)) ;
+ cbd.CallbackType     = MQCBT_MESSAGE_CONSUMER   ;
+ cbd.Options          = MQCBDO_FAIL_IF_QUIESCING ;
+ cbd.CallbackFunction = (MQPTR) async_msg        ;
+ cbd.CallbackArea     = (MQPTR) ring             ;
+ cbd.MaxMsgLength     = MQCBD_FULL_MSG_LENGTH    ;
+ MQCB ( anchor->QM[obj->conn].QMh, MQOP_REGISTER, &cbd, obj->Qh, &md, &gmo, mqrc, mqac ) ;
+ TRACE(traceid, ("MQCB register of slot %d (%"PRIu32" slots) rc = %"PRId32", ac = %"PRId32"\n",
+                 n,(uint32_t)ring->slots,(int32_t)*mqrc,(int32_t)*mqac) ) ;
 
-  sv1.shvnext     = 0           ; // Fetch only one variable
-  sv1.shvcode     = RXSHV_SYFET ; // Fetch operation
-  sv1.shvret      = 0           ; // Zero out RC
+ return ;
+} // End of async_reg
 
-  sprintf(varnamc,"RXMQ.CAMAP.%"PRId32,(int32_t)pcfnum) ; // Construct REXX variable name
-  MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))     ; // Construct REXX variable name structure
-  sv1.shvnamelen  = sv1.shvname.strlength               ; // REXX variable name length
+//
+// async_add - register the consumer of the queue in slot n, with a ring
+//             of slots messages (the connection not being started). It
+//             browses from the first message, unless gmo browses itself.
+//
+void async_add ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        n            // Slot number
+               , MQGMO    * gmo          // Get message options
+               , MQLONG     slots        // Ring size, a power of two
+               , MQLONG   * mqrc         // MQ CC
+               , MQLONG   * mqac         // MQ RC
+               )
+{
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
+ RXMQRING              * ring             ;  // Its ring
 
-  sv1.shvvalue.strptr   = varvalc                     ; // Set pointer to value buffer for REXX
-  sv1.shvvalue.strlength= 30                          ; // Set max value length for REXX
-  sv1.shvvaluelen       = 30                          ; // Set max accepted value length
+ ring = (RXMQRING *) calloc(1, sizeof(RXMQRING) + (slots - 1) * sizeof(RXMQSLOT)) ;
+ if ( ring == NULL )
+   {
+    *mqrc = MQCC_FAILED                 ;
+    *mqac = MQRC_STORAGE_NOT_AVAILABLE  ;
+    return                              ;
+   }
+ ring->slots = slots         ;
+ ring->wake  = &anchor->Wake ;
+ memcpy(&ring->gmo, gmo, sizeof(MQGMO)) ;
+ ring->browse = ( gmo->Options & (MQGMO_BROWSE_FIRST | MQGMO_BROWSE_NEXT) ) != 0 ;
+ if ( !ring->browse )
+    ring->gmo.Options = ( gmo->Options & ~(MQGMO_LOCK | MQGMO_MSG_UNDER_CURSOR) )
+                      | MQGMO_BROWSE_FIRST ;
+
+ async_reg(traceid, anchor, n, ring, mqrc, mqac) ;
+ if ( *mqrc == MQCC_FAILED )
+   {
+    free(ring) ;
+    return     ;
+   }
+ obj->ring = ring ;
+ anchor->Rings++  ;
 
-  sv1rc           = RexxVariablePool(&sv1)            ; // Call REXX variable interface
+ return ;
+} // End of async_add
+
+//
+// async_rewind - register the consumer of the queue in slot n again, to
+//                browse from the first message, a message having been
+//                left on the queue, and resume it if its ring has room
+//                (the connection not being started)
+//
+void async_rewind ( MQULONG    traceid      // trace id of caller
+                  , RXMQCB   * anchor       // RXMQ Control Block
+                  , int        n            // Slot number
+                  )
+{
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
+ RXMQRING              * ring = obj->ring ;  // Its ring
+ MQLONG                  cc               ;  // MQCB CC
+ MQLONG                  ac               ;  // MQCB RC
+
+ async_reg(traceid, anchor, n, ring, &cc, &ac) ;
+ if ( cc == MQCC_FAILED ) return               ; // Tried again next time
+ RING_SET(ring->rewind, 0)                     ;
+
+ if ( RING_GET(ring->suspended) && (ring->tail - ring->head < ring->slots) )
+   {
+    MQCB ( anchor->QM[obj->conn].QMh, MQOP_RESUME, NULL, obj->Qh, NULL, NULL, &cc, &ac ) ;
+    TRACE(traceid, ("MQCB resume of slot %d rc = %"PRId32", ac = %"PRId32"\n",
+                    n,(int32_t)cc,(int32_t)ac) ) ;
+    if ( cc != MQCC_FAILED ) RING_SET(ring->suspended, 0) ;
+   }
+
+ return ;
+} // End of async_rewind
+
+//
+// async_ctl - do an MQCTL on a connection, stopping, starting, suspending
+//             or resuming the consumers of its queues
+//
+void async_ctl ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        conn         // Connection
+               , MQLONG     op           // MQOP_xx
+               , MQLONG   * mqrc         // MQ CC
+               , MQLONG   * mqac         // MQ RC
+               )
+{
+ MQCTLO                  ctlo             ;  // Control options
+ int                     k                ;  // Slot number
+
+ for ( k = 1 ; k < anchor->Objsize ; k++ )
+   if ( (anchor->Obj[k].ring != NULL) && (anchor->Obj[k].conn == conn) )
+     {
+      RING_SET(anchor->Obj[k].ring->stopping, (op == MQOP_STOP) || (op == MQOP_SUSPEND)) ;
+      if ( ((op == MQOP_START) || (op == MQOP_RESUME)) && RING_GET(anchor->Obj[k].ring->rewind) )
+         async_rewind(traceid, anchor, k) ;
+     }
+
+ memcpy(&ctlo, &ctlo_default, sizeof(MQCTLO)) ;
+ ctlo.Options = MQCTLO_FAIL_IF_QUIESCING      ;
+ MQCTL ( anchor->QM[conn].QMh, op, &ctlo, mqrc, mqac ) ;
+ TRACE(traceid, ("MQCTL %"PRId32" of connection %d rc = %"PRId32", ac = %"PRId32"\n",
+                 (int32_t)op,conn,(int32_t)*mqrc,(int32_t)*mqac) ) ;
+
+ if ( op == MQOP_STOP )
+    anchor->QM[conn].Async = 0 ;
+ else if ( (op == MQOP_START) && (*mqrc != MQCC_FAILED) )
+    anchor->QM[conn].Async = 1 ;
+
+ return ;
+} // End of async_ctl
+
+//
+// async_drop - deregister the consumer of the queue in slot n, and free
+//              its ring (the connection not being started). Returns the
+//              number of messages lost, removed from the queue but not
+//              taken by RXMQPOLL (none if the consumer browsed).
+//
+MQLONG async_drop ( MQULONG    traceid      // trace id of caller
+                  , RXMQCB   * anchor       // RXMQ Control Block
+                  , int        n            // Slot number
+                  )
+{
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
+ RXMQRING              * ring = obj->ring ;  // Its ring
+ MQLONG                  mqrc = 0         ;  // MQ CC
+ MQLONG                  mqac = 0         ;  // MQ RC
+ MQLONG                  lost             ;  // Messages not taken
+ MQULONG                 i                ;  // Ring slot
+
+ lost = ring->browse ? 0 : (MQLONG)(ring->tail - ring->head) ;
+ MQCB ( anchor->QM[obj->conn].QMh, MQOP_DEREGISTER, NULL, obj->Qh, NULL, NULL, &mqrc, &mqac ) ;
+ TRACE(traceid, ("MQCB deregister of slot %d rc = %"PRId32", ac = %"PRId32", %"PRIu32" messages not taken\n",
+                 n,(int32_t)mqrc,(int32_t)mqac,(uint32_t)(ring->tail - ring->head)) ) ;
+
+ for ( i = 0 ; i < ring->slots ; i++ )
+   if ( ring->slot[i].data != NULL ) free(ring->slot[i].data) ;
+ free(ring)       ;
+ obj->ring = NULL ;
+ anchor->Rings--  ;
+
+ return lost ;
+} // End of async_drop
+
+//
+// async_end - stop consuming the queues of a connection, or with n set
+//             only the queue in slot n, the others going on. The
+//             messages lost (see async_drop) are added to *lost.
+//
+void async_end ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        conn         // Connection
+               , int        n            // Slot number (0 all)
+               , MQLONG   * lost         // Messages lost
+               , MQLONG   * mqrc         // MQ CC
+               , MQLONG   * mqac         // MQ RC
+               )
+{
+ int                     k                ;  // Slot number
+ int                     more = 0         ;  // Other queues still consumed
+
+ *mqrc = MQCC_OK   ;
+ *mqac = MQRC_NONE ;
+ if ( anchor->QM[conn].Async ) async_ctl(traceid, anchor, conn, MQOP_STOP, mqrc, mqac) ;
+
+ for ( k = 1 ; k < anchor->Objsize ; k++ )
+   if ( (anchor->Obj[k].ring != NULL) && (anchor->Obj[k].conn == conn) )
+     {
+      if ( (n == 0) || (k == n) ) *lost += async_drop(traceid, anchor, k) ;
+      else                        more   = 1                               ;
+     }
+
+ if ( more && (*mqrc != MQCC_FAILED) )
+    async_ctl(traceid, anchor, conn, MQOP_START, mqrc, mqac) ;
+
+ return ;
+} // End of async_end
+
+//
+// async_resume - resume the consumer of the queue in slot n, its ring
+//                having room again
+//
+void async_resume ( MQULONG    traceid      // trace id of caller
+                  , RXMQCB   * anchor       // RXMQ Control Block
+                  , int        n            // Slot number
+                  , MQLONG   * mqrc         // MQ CC
+                  , MQLONG   * mqac         // MQ RC
+                  )
+{
+ RXMQOBJ               * obj = &anchor->Obj[n] ;  // The slot
+ MQLONG                  cc               ;  // MQCTL CC
+ MQLONG                  ac               ;  // MQCTL RC
+
+ async_ctl(traceid, anchor, obj->conn, MQOP_SUSPEND, mqrc, mqac) ;
+ if ( *mqrc != MQCC_FAILED )
+   {
+    MQCB ( anchor->QM[obj->conn].QMh, MQOP_RESUME, NULL, obj->Qh, NULL, NULL, mqrc, mqac ) ;
+    TRACE(traceid, ("MQCB resume of slot %d rc = %"PRId32", ac = %"PRId32"\n",
+                    n,(int32_t)*mqrc,(int32_t)*mqac) ) ;
+    if ( *mqrc != MQCC_FAILED ) RING_SET(obj->ring->suspended, 0) ;
+    async_ctl(traceid, anchor, obj->conn, MQOP_RESUME, &cc, &ac) ;
+    if ( cc == MQCC_FAILED ) { *mqrc = cc ; *mqac = ac ; }
+   }
+
+ return ;
+} // End of async_resume
+
+//
+// Auto-commit
+//
+//   Under a connection's policy (RXMQAUTO) the MQPUTs and MQGETs done
+//   under syncpoint are counted, with their bytes and the time of the
+//   first, and the connection committed once any limit is reached. The
+//   time is only looked at when an operation is counted, as nothing
+//   runs between calls. Reaching the queue manager's syncpoint limit
+//   (MAXUMSGS) halves the message limit, which then grows back by a
+//   quarter with each full batch, up to where the limit was reached.
+//
+
+//
+// uow_commit - MQCMIT the connection, counting and timing it, and
+//              start a new batch
+//
+void uow_commit ( MQULONG    traceid      // trace id of caller
+                , RXMQCB   * anchor       // RXMQ Control Block
+                , int        conn         // Connection
+                , int        autoc        // Done by the policy
+                , MQLONG   * mqrc         // MQ CC
+                , MQLONG   * mqac         // MQ RC
+                )
+{
+ RXMQQM                * qm = &anchor->QM[conn] ;  // The connection
+ uint64_t                took = now_us()  ;  // Time in MQCMIT
+
+ MQCMIT ( qm->QMh, mqrc, mqac )                  ;
+ took = now_us() - took                          ;
+ TRACE(traceid, ("CMIT of %"PRId32" ops, rc = %"PRId32", ac = %"PRId32", %"PRIu32" us\n",
+       (int32_t)qm->Pending,(int32_t)*mqrc,(int32_t)*mqac,(uint32_t)took) ) ;
+
+ qm->Uow.commits++                               ;
+ if ( autoc ) qm->Uow.autos++                    ;
+ qm->Uow.time += took                            ;
+ if ( took > qm->Uow.maxtime ) qm->Uow.maxtime = took ;
+ qm->Pending   = 0                               ;
+ qm->PendBytes = 0                               ;
+
+ return ;
+} // End of uow_commit
+
+//
+// uow_count - count an MQPUT or MQGET against the connection's policy,
+//             committing if a limit is reached. *mqrc and *mqac are
+//             those of the operation, and become the commit's if that
+//             fails. An operation that failed is not retried.
+//
+void uow_count ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        conn         // Connection
+               , int        inuow        // Done under syncpoint
+               , MQLONG     bytes        // Message length
+               , MQLONG   * mqrc         // MQ CC
+               , MQLONG   * mqac         // MQ RC
+               )
+{
+ RXMQQM                * qm = &anchor->QM[conn] ;  // The connection
+ MQLONG                  cc               ;  // Commit CC
+ MQLONG                  ac               ;  // Commit RC
+ int                     full             ;  // Message limit reached
+
+ if ( !inuow || !UOW_AUTO(qm) ) return ;
+
+ if ( *mqrc == MQCC_FAILED )
+   {
+    if ( (*mqac != MQRC_SYNCPOINT_LIMIT_REACHED) || (qm->Pending == 0) ) return ;
+    qm->Uow.limits++                                          ;
+    qm->AutoCap   = qm->Pending                               ;
+    qm->AutoLimit = ( qm->Pending > 1 ) ? qm->Pending / 2 : 1 ;
+    TRACE(traceid, ("Syncpoint limit at %"PRId32" ops, batch now %"PRId32"\n",
+          (int32_t)qm->Pending,(int32_t)qm->AutoLimit) )      ;
+    uow_commit(traceid, anchor, conn, 1, &cc, &ac)            ;
+    if ( cc == MQCC_FAILED ) { *mqrc = cc ; *mqac = ac ; }
+    return ;
+   }
+
+ if ( qm->Pending++ == 0 ) qm->PendSince = now_ms()         ;
+ qm->PendBytes += (uint64_t)bytes                            ;
+
+ full = ( (qm->AutoLimit > 0) && (qm->Pending >= qm->AutoLimit) ) ;
+ if (    !full
+      && !( (qm->AutoBytes > 0) && (qm->PendBytes >= (uint64_t)qm->AutoBytes) )
+      && !( (qm->AutoMs > 0) && (now_ms() - qm->PendSince >= (uint64_t)qm->AutoMs) ) ) return ;
+
+ uow_commit(traceid, anchor, conn, 1, &cc, &ac)              ;
+ if ( cc == MQCC_FAILED ) { *mqrc = cc ; *mqac = ac ; return ; }
+
+ if ( full && (qm->AutoLimit < qm->AutoCap) )                 // Grow back
+   {
+    qm->AutoLimit += ( qm->AutoLimit >= 4 ) ? qm->AutoLimit / 4 : 1 ;
+    if ( qm->AutoLimit > qm->AutoCap ) qm->AutoLimit = qm->AutoCap ;
+    TRACE(traceid, ("Batch now %"PRId32"\n",(int32_t)qm->AutoLimit) ) ;
+   }
+
+ return ;
+} // End of uow_count
+
+//
+// uow_stats - copy the commit counters of a connection to RXMQ.COMMIT.xxx
+//
+//          COUNT    -> MQCMITs done (RXMQCMIT or automatic)
+//          AUTO     -> of them by the auto-commit policy
+//          BACK     -> RXMQBACKs done
+//          LIMITHIT -> times the syncpoint limit was reached
+//          TIME     -> microseconds in MQCMIT in all
+//          MAXTIME  -> microseconds of the longest MQCMIT
+//          LIMIT    -> operations in a batch now (0 no limit)
+//          PENDING  -> operations not yet committed
+//
+void uow_stats ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        conn         // Connection
+               )
+{
+ RXMQQM                * qm = &anchor->QM[conn] ;  // The connection
+ RXSTRING                stem             ;  // RXMQ.COMMIT.
+ SHVCHAIN                chain            ;  // The eight sets
+
+ MAKERXSTRING(stem, "RXMQ.COMMIT.", sizeof("RXMQ.COMMIT.")-1)          ;
+ chain.count = 0                                                       ;
+ shv_set_int64(&chain, stem, "COUNT",    NULL, qm->Uow.commits)        ;
+ shv_set_int64(&chain, stem, "AUTO",     NULL, qm->Uow.autos)          ;
+ shv_set_int64(&chain, stem, "BACK",     NULL, qm->Uow.backouts)       ;
+ shv_set_int64(&chain, stem, "LIMITHIT", NULL, qm->Uow.limits)         ;
+ shv_set_int64(&chain, stem, "TIME",     NULL, (MQINT64)qm->Uow.time)  ;
+ shv_set_int64(&chain, stem, "MAXTIME",  NULL, (MQINT64)qm->Uow.maxtime) ;
+ shv_set_long (&chain, stem, "LIMIT",    NULL, qm->AutoLimit)          ;
+ shv_set_long (&chain, stem, "PENDING",  NULL, qm->Pending)            ;
+ shv_run(traceid, &chain)                                              ;
+
+ return ;
+} // End of uow_stats
+
+//
+// put_stat - check the asynchronous puts of a connection (MQSTAT), the
+//            counts going to stem.xxx. *mqrc and *mqac are those of the
+//            first put that failed (or gave a warning), or of the MQSTAT
+//            if that fails.
+//
+void put_stat ( MQULONG    traceid      // trace id of caller
+              , RXMQCB   * anchor       // RXMQ Control Block
+              , int        conn         // Connection
+              , RXSTRING   stem         // Stem set
+              , MQLONG   * mqrc         // MQ CC
+              , MQLONG   * mqac         // MQ RC
+              )
+{
+ RXMQQM                * qm = &anchor->QM[conn] ;  // The connection
+ MQSTS                   sts              ;  // Status structure
+ SHVCHAIN                chain            ;  // The eight sets
+
+ memcpy(&sts, &sts_default, sizeof(MQSTS)) ;
+ MQSTAT ( qm->QMh, MQSTAT_TYPE_ASYNC_ERROR, &sts, mqrc, mqac ) ;
+ TRACE(traceid, ("MQSTAT of connection %d rc = %"PRId32", ac = %"PRId32", after %"PRId32" async puts\n",
+                 conn,(int32_t)*mqrc,(int32_t)*mqac,(int32_t)qm->AsyncPuts) ) ;
+ if ( *mqrc == MQCC_FAILED ) return ;
+ TRACE(traceid, ("%"PRId32" worked, %"PRId32" warnings, %"PRId32" failed, first reason %"PRId32"\n",
+                 (int32_t)sts.PutSuccessCount,(int32_t)sts.PutWarningCount,
+                 (int32_t)sts.PutFailureCount,(int32_t)sts.Reason) ) ;
+
+ chain.count = 0                                                      ;
+ shv_set_long(&chain, stem, "PUTS",    NULL, qm->AsyncPuts)           ;
+ shv_set_long(&chain, stem, "SUCCESS", NULL, sts.PutSuccessCount)     ;
+ shv_set_long(&chain, stem, "WARNING", NULL, sts.PutWarningCount)     ;
+ shv_set_long(&chain, stem, "FAILURE", NULL, sts.PutFailureCount)     ;
+ shv_set_long(&chain, stem, "CC",      NULL, sts.CompCode)            ;
+ shv_set_long(&chain, stem, "RC",      NULL, sts.Reason)              ;
+ shv_set(&chain, stem, "OBJNAME", NULL, sts.ObjectName,     sizeof(MQCHAR48), 0) ;
+ shv_set(&chain, stem, "QMNAME",  NULL, sts.ObjectQMgrName, sizeof(MQCHAR48), 0) ;
+ shv_run(traceid, &chain)                                             ;
+
+ qm->AsyncPuts = 0            ;
+ *mqrc         = sts.CompCode ;
+ *mqac         = sts.Reason   ;
+
+ return ;
+} // End of put_stat
+
+//
+// Adaptive GET sizing
+//
+//   RXMQGET with data.0 = 0, and RXMQGETD with a maximum length of 0,
+//   leave get_msg to size the buffer. It starts from an estimate kept
+//   per handle: the largest recent message, decaying by 1/8 of the gap
+//   for each smaller one, seeded by obj_opened from the queue's MAXMSGL
+//   when that is small. The whole size class from buf_get is offered
+//   to MQ, so messages a little over the estimate still fit.
+//
+//   A bigger message is never truncated: MQGMO_ACCEPT_TRUNCATED_MSG is
+//   turned off, so the MQGET fails leaving the message on the queue
+//   (and under syncpoint nothing has happened), and it is then redone
+//   with the original MD and GMO and a buffer of the length MQ gave.
+//   A failed browse has already moved the cursor onto the message, so
+//   a browse is redone with MQGMO_BROWSE_MSG_UNDER_CURSOR; a get is
+//   redone matching the MsgId MQ gave, so that on a shared queue it
+//   takes the message it was sized for.
+//
+
+//
+// get_msg - MQGET into payload buffer BUF_DATA. With *data0 = 0 the
+//           buffer is sized as above and *data0 is set to the size
+//           used, else it is a single MQGET of up to *data0 bytes.
+//           Returns the buffer, or NULL (with *mqac = errno) if it
+//           cannot be allocated.
+//
+void * get_msg ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , RXMQOBJ  * obj          // Object to get from
+               , MQMD2    * md           // Message descriptor
+               , MQGMO    * gmo          // Get message options
+               , MQLONG   * data0        // Buffer size (0 -> adaptive)
+               , MQLONG   * datalen      // Message length
+               , MQLONG   * mqrc         // MQ CC
+               , MQLONG   * mqac         // MQ RC
+               )
+{
+ MQMD2                   md_in            ;  // Input MD for a retry
+ MQGMO                   gmo_in           ;  // Input GMO for a retry
+ MQLONG                  size = *data0    ;  // Buffer size this MQGET
+ int                     autosize = (size == 0) ;
+ int                     tries = 0        ;  // Resizes done
+ void                  * data             ;  //-> Data buffer
+
+ if ( autosize )
+   {
+    size           = obj->est                      ;
+    gmo->Options  &= ~MQGMO_ACCEPT_TRUNCATED_MSG   ;
+    memcpy(&md_in , md , sizeof(MQMD2))            ;
+    memcpy(&gmo_in, gmo, sizeof(MQGMO))            ;
+   }
+
+ for ( ;; )
+   {
+    TRACE(traceid, ("Getting buffer for %"PRId32" bytes\n",(int32_t)size) ) ;
+    data = buf_get(anchor, BUF_DATA, size)                                 ;
+    if ( data == NULL )
+      {
+       *mqac = errno                                                       ;
+       TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)*mqac) )          ;
+       return NULL                                                         ;
+      }
+    if ( autosize ) size = anchor->Buf[BUF_DATA].size ; // All of the class
+
+    TRACE(traceid, ("GET Maxdatalen = %"PRId32"\n",(int32_t)size) )                      ;
+    MQGET ( anchor->QM[obj->conn].QMh, obj->Qh, md, gmo, size, data, datalen, mqrc, mqac )            ;
+    TRACE(traceid, ("GET rc = %"PRId32", ac = %"PRId32", datalen = %"PRId32"\n",
+          (int32_t)*mqrc,(int32_t)*mqac,(int32_t)*datalen) )                              ;
+
+    if ( !autosize || (*mqac != MQRC_TRUNCATED_MSG_FAILED) || (tries == AUTORETRY) ) break ;
+
+    tries++                                                      ;
+    size = *datalen                                              ;
+    if ( gmo_in.Options & (MQGMO_BROWSE_FIRST | MQGMO_BROWSE_NEXT) )
+      gmo_in.Options = (gmo_in.Options & ~(MQGMO_BROWSE_FIRST | MQGMO_BROWSE_NEXT))
+                     | MQGMO_BROWSE_MSG_UNDER_CURSOR             ;
+    else if ( !(gmo_in.Options & MQGMO_BROWSE_MSG_UNDER_CURSOR) )
+      {                                    // Take the message sized
+       memcpy(md_in.MsgId, md->MsgId, sizeof(MQBYTE24))         ;
+       if ( gmo_in.Version >= MQGMO_VERSION_2 )
+         {
+          if ( gmo_in.MatchOptions & MQMO_MATCH_CORREL_ID )
+            memcpy(md_in.CorrelId, md->CorrelId, sizeof(MQBYTE24)) ;
+          gmo_in.MatchOptions |= MQMO_MATCH_MSG_ID               ;
+         }
+      }
+    memcpy(md , &md_in , sizeof(MQMD2))                          ;
+    memcpy(gmo, &gmo_in, sizeof(MQGMO))                          ;
+    TRACE(traceid, ("Message is bigger, retry %d\n",tries) )     ;
+   }
+
+ if ( autosize && (*mqrc != MQCC_FAILED) )
+   {
+    if ( *datalen >= obj->est ) obj->est  = *datalen                 ;
+    else                        obj->est -= (obj->est - *datalen) / 8 ;
+    TRACE(traceid, ("Size estimate now %"PRId32"\n",(int32_t)obj->est) ) ;
+   }
+
+ *data0 = size ;
+ return data   ;
+} // End of get_msg
+
+//
+// Request/reply
+//
+//   RXMQREQ puts requests whose ReplyToQ is one of two temporary dynamic
+//   queues kept per connection, made from a model queue when first
+//   needed and deleted by RXMQDISC or RXMQTERM, so there is no MQOPEN
+//   and MQCLOSE of a reply queue per request. The replies to requests
+//   left in flight come to the REQ_LEFT queue, for RXMQRPLY, and those
+//   to a request waited for to the REQ_WAIT queue, so that neither has
+//   to get past the other's replies. A reply is matched to its request
+//   by CorrelId; one matching no request (its request having been given
+//   up) is discarded.
+//
+
+//
+// req_pool - the reply queues of a connection, set up (no queue yet
+//            opened) with the model given. The model only changes while
+//            neither queue is open. Returns NULL if there is no storage.
+//
+RXMQRPC * req_pool ( RXMQCB   * anchor       // RXMQ Control Block
+                   , int        conn         // Connection
+                   , PMQCHAR    model        // Model queue name
+                   )
+{
+ RXMQRPC               * rpc = anchor->QM[conn].Rpc ;  // The pool
+
+ if ( rpc != NULL )
+   {
+    if ( (rpc->q[REQ_LEFT].Qh == 0) && (rpc->q[REQ_WAIT].Qh == 0) )
+       memcpy(rpc->model, model, sizeof(MQCHAR48)) ;
+    return rpc ;
+   }
+
+ rpc = (RXMQRPC *) calloc(1, sizeof(RXMQRPC))   ;
+ if ( rpc == NULL ) return NULL                 ;
+ rpc->q[REQ_LEFT].conn = conn                   ;
+ rpc->q[REQ_WAIT].conn = conn                   ;
+ memcpy(rpc->model, model, sizeof(MQCHAR48))    ;
+ anchor->QM[conn].Rpc = rpc                     ;
+
+ return rpc ;
+} // End of req_pool
+
+//
+// req_queue - open reply queue which (REQ_xx) of a pool from its model,
+//             if it is not open already
+//
+void req_queue ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , RXMQRPC  * rpc          // The pool
+               , int        which        // REQ_xx
+               , MQLONG   * mqrc         // MQ CC
+               , MQLONG   * mqac         // MQ RC
+               )
+{
+ RXMQOBJ               * obj = &rpc->q[which] ;  // The queue
+ MQOD                    od               ;  // Model object descriptor
+
+ *mqrc = MQCC_OK   ;
+ *mqac = MQRC_NONE ;
+ if ( obj->Qh != 0 ) return ;
+
+ memcpy(&od, &od_default, sizeof(MQOD))          ;
+ memcpy(od.ObjectName, rpc->model, sizeof(MQCHAR48)) ;
+ strcpy(od.DynamicQName, "RXMQ.*")               ;
+ MQOPEN ( anchor->QM[obj->conn].QMh, &od, MQOO_INPUT_EXCLUSIVE | MQOO_FAIL_IF_QUIESCING,
+          &obj->Qh, mqrc, mqac )                 ;
+ TRACE(traceid, ("Reply queue %d from model %.48s is %.48s, rc = %"PRId32", ac = %"PRId32"\n",
+                 which,rpc->model,od.ObjectName,(int32_t)*mqrc,(int32_t)*mqac) ) ;
+ if ( *mqrc == MQCC_FAILED )
+   {
+    obj->Qh = 0 ;
+    return      ;
+   }
+
+ memcpy(obj->name, od.ObjectName, sizeof(MQCHAR48)) ;
+ obj->options = MQOO_INPUT_EXCLUSIVE              ;
+ obj->est     = BUFMIN                            ;
+
+ return ;
+} // End of req_queue
+
+//
+// req_add - record a request left in flight. Returns 0, or -1 if there
+//           is no storage.
+//
+int req_add ( RXMQRPC  * rpc          // The pool
+            , MQLONG     id           // Request number
+            , PMQBYTE    key          // CorrelId of its reply
+            , uint64_t   sent         // Time put
+            )
+{
+ RXMQFLIGHT            * flight           ;  // Bigger table
+ MQLONG                  size             ;  //   and its size
+
+ if ( rpc->count == rpc->size )
+   {
+    size   = ( rpc->size == 0 ) ? REQMIN : 2 * rpc->size ;
+    flight = (RXMQFLIGHT *) realloc(rpc->flight, size * sizeof(RXMQFLIGHT)) ;
+    if ( flight == NULL ) return -1                      ;
+    rpc->flight = flight                                 ;
+    rpc->size   = size                                   ;
+   }
+
+ rpc->flight[rpc->count].id   = id                        ;
+ memcpy(rpc->flight[rpc->count].key, key, sizeof(MQBYTE24)) ;
+ rpc->flight[rpc->count].sent = sent                      ;
+ rpc->count++                                             ;
+
+ return 0 ;
+} // End of req_add
+
+//
+// req_get - take the next reply from reply queue which, waiting until
+//           deadline (now_ms) for it, and discarding those that match
+//           no request: with want the request waited for, else one in
+//           flight. Returns the request's index in flight (0 for want),
+//           or -1 with *mqrc and *mqac set, *data being NULL if there
+//           was no storage. The data is good until the next MQGET.
+//
+int req_get ( MQULONG    traceid      // trace id of caller
+            , RXMQCB   * anchor       // RXMQ Control Block
+            , RXMQRPC  * rpc          // The pool
+            , int        which        // REQ_xx
+            , PMQBYTE    want         // CorrelId wanted (or NULL)
+            , uint64_t   deadline     // Time to wait until
+            , void    ** data         // Reply data
+            , MQLONG   * datalen      //   and its length
+            , MQLONG   * mqrc         // MQ CC
+            , MQLONG   * mqac         // MQ RC
+            )
+{
+ MQMD2                   md               ;  // Message descriptor
+ MQGMO                   gmo              ;  // Get message options
+ MQLONG                  data0            ;  // Buffer size (0 adaptive)
+ uint64_t                now              ;  // Time now
+ int                     i                ;  // Request in flight
+
+ for ( ;; )
+   {
+    now = now_ms()                                                  ;
+    memcpy(&md , &md_default , sizeof(MQMD2))                       ;
+    memcpy(&gmo, &gmo_default, sizeof(MQGMO))                       ;
+    gmo.Options      = MQGMO_WAIT | MQGMO_NO_SYNCPOINT | MQGMO_CONVERT
+                     | MQGMO_FAIL_IF_QUIESCING                      ;
+    gmo.WaitInterval = ( now < deadline ) ? (MQLONG)(deadline - now) : 0 ;
+    data0            = 0                                            ;
+    *data = get_msg(traceid, anchor, &rpc->q[which], &md, &gmo, &data0, datalen, mqrc, mqac) ;
+    if ( (*data == NULL) || (*mqrc == MQCC_FAILED) ) return -1      ;
+
+    if ( want != NULL )
+      {
+       if ( memcmp(md.CorrelId, want, sizeof(MQBYTE24)) == 0 ) return 0 ;
+      }
+    else
+      for ( i = 0 ; i < rpc->count ; i++ )
+        if ( memcmp(md.CorrelId, rpc->flight[i].key, sizeof(MQBYTE24)) == 0 ) return i ;
+
+    rpc->stale++                                                    ;
+    TRACE(traceid, ("Reply to no request discarded, %"PRIu32" so far\n",(uint32_t)rpc->stale) ) ;
+   }
+} // End of req_get
+
+//
+// req_end - delete the reply queues of a connection, and forget its
+//           requests in flight
+//
+void req_end ( MQULONG    traceid      // trace id of caller
+             , RXMQCB   * anchor       // RXMQ Control Block
+             , int        conn         // Connection
+             )
+{
+ RXMQRPC               * rpc = anchor->QM[conn].Rpc ;  // The pool
+ MQLONG                  mqrc             ;  // MQCLOSE CC
+ MQLONG                  mqac             ;  // MQCLOSE RC
+ int                     k                ;  // Reply queue
+
+ if ( rpc == NULL ) return ;
+
+ for ( k = REQ_LEFT ; k <= REQ_WAIT ; k++ )
+   if ( rpc->q[k].Qh != 0 )
+     {
+      MQCLOSE ( anchor->QM[conn].QMh, &rpc->q[k].Qh, MQCO_DELETE_PURGE, &mqrc, &mqac ) ;
+      TRACE(traceid, ("Reply queue %.48s deleted, rc = %"PRId32", ac = %"PRId32"\n",
+                      rpc->q[k].name,(int32_t)mqrc,(int32_t)mqac) ) ;
+     }
+ TRACE(traceid, ("%"PRId32" requests were in flight, %"PRIu32" replies discarded\n",
+                 (int32_t)rpc->count,(uint32_t)rpc->stale) ) ;
+
+ free(rpc->flight)          ;
+ free(rpc)                  ;
+ anchor->QM[conn].Rpc = NULL ;
+
+ return ;
+} // End of req_end
+
+//
+// Worker pool
+//
+//   RXMQSUBM gives each task to one of the pool's workers, threads that
+//   are started when first given one and do their tasks in the order
+//   given, on connections of their own (one per queue manager, made by
+//   MQCONN when first needed, and kept, that least recently used being
+//   ended for another once a worker has WORKQMS) and outside syncpoint. A task
+//   goes to the worker with least to do, unless a task with the same
+//   key is still waiting for (or being done by) a worker, when it goes
+//   to that one, so tasks with the same key are done in order. A worker
+//   keeps the queue it last used open, so a run of puts to a queue
+//   opens it once.
+//
+//   The pool lock guards the workers' lists of tasks and the done flags.
+//   A task is only looked at by its worker until it is done, and only
+//   by the REXX thread after; the pool's list of tasks not yet waited
+//   for (RXMQWAIT) is only used by the REXX thread. On z/OS, where there
+//   are no worker threads, RXMQSUBM does the task itself.
+//
+//   RXMQFAN gives its puts to the pool too, keyed by queue manager, so
+//   while the pool has a worker free for each queue manager the puts to
+//   different ones are done at once, each on one connection. It waits
+//   for them itself, so they are never on the pool's list of tasks.
+//
+
+//
+// work_disc - close what a worker has open on a connection, and
+//             disconnect it if the worker made it
+//
+void work_disc ( MQULONG    traceid      // trace id of caller
+               , RXMQWORKQM * wq         // The connection
+               )
+{
+ MQLONG                  cc               ;  // MQ CC
+ MQLONG                  ac               ;  // MQ RC
+
+ if ( wq->Qh != 0 ) MQCLOSE ( wq->QMh, &wq->Qh, MQCO_NONE, &cc, &ac )        ;
+ if ( wq->Rh != 0 ) MQCLOSE ( wq->QMh, &wq->Rh, MQCO_DELETE_PURGE, &cc, &ac ) ;
+ if ( wq->own )
+   {
+    MQDISC ( &wq->QMh, &cc, &ac ) ;
+    TRACE(traceid, ("Worker MQDISC of QM %s rc = %"PRId32", ac = %"PRId32"\n",
+          wq->QMname,(int32_t)cc,(int32_t)ac) ) ;
+   }
+ memset(wq, 0, sizeof(RXMQWORKQM)) ;
+
+ return ;
+} // End of work_disc
+
+//
+// work_conn - the worker's connection to a QM, made if it has none.
+//             Returns NULL if the MQCONN failed.
+//
+RXMQWORKQM * work_conn ( MQULONG    traceid      // trace id of caller
+                       , RXMQWORKER * w          // The worker
+                       , char       QMname[]     // QM name
+                       , MQLONG   * mqrc         // MQ CC
+                       , MQLONG   * mqac         // MQ RC
+                       )
+{
+ RXMQWORKQM            * wq = NULL        ;  // Connection
+ int                     i                ;  // Looper
+
+ w->tasks++ ;
+ for ( i = 0 ; i < WORKQMS ; i++ )
+   {
+    if ( (w->qm[i].QMh != 0) && !strncmp(w->qm[i].QMname, QMname, MQ_Q_MGR_NAME_LENGTH) )
+      {
+       w->qm[i].used = w->tasks ;
+       return &w->qm[i]         ;
+      }
+    if ( (wq == NULL) || ((wq->QMh != 0) && ((w->qm[i].QMh == 0) || (w->qm[i].used < wq->used))) )
+       wq = &w->qm[i] ;
+   }
+ if ( wq->QMh != 0 ) work_disc(traceid, wq)         ;    // Least recently used
+
+ memset(wq, 0, sizeof(RXMQWORKQM))                  ;
+ memcpy(wq->QMname, QMname, MQ_Q_MGR_NAME_LENGTH)   ;
+ wq->used = w->tasks                                ;
+ MQCONN ( wq->QMname, &wq->QMh, mqrc, mqac )        ;
+ TRACE(traceid, ("Worker %d MQCONN handle is %"PRIX32", QM is %s, rc = %"PRId32", ac = %"PRId32"\n",
+       (int)(w - w->pool->worker),(uint32_t)wq->QMh,wq->QMname,(int32_t)*mqrc,(int32_t)*mqac) ) ;
+ if ( *mqrc == MQCC_FAILED )
+   {
+    wq->QMh = 0 ;
+    return NULL ;
+   }
+ wq->own = ( *mqac != MQRC_ALREADY_CONNECTED ) ;
+
+ return wq ;
+} // End of work_conn
+
+//
+// work_open - have the queue open on the connection with the options
+//             given, closing the one last used if it is another
+//
+void work_open ( MQULONG    traceid      // trace id of caller
+               , RXMQWORKQM * wq         // The connection
+               , MQCHAR48   qname        // Queue
+               , MQLONG     options      // Open options
+               , MQLONG   * mqrc         // MQ CC
+               , MQLONG   * mqac         // MQ RC
+               )
+{
+ MQOD                    od               ;  // Object descriptor
+ MQLONG                  cc               ;  // MQCLOSE CC
+ MQLONG                  ac               ;  // MQCLOSE RC
+
+ *mqrc = MQCC_OK   ;
+ *mqac = MQRC_NONE ;
+ if ( (wq->Qh != 0) && (wq->Qopts == options) && !memcmp(wq->Qname, qname, sizeof(MQCHAR48)) )
+    return ;
+
+ if ( wq->Qh != 0 ) MQCLOSE ( wq->QMh, &wq->Qh, MQCO_NONE, &cc, &ac ) ;
+ memcpy(&od, &od_default, sizeof(MQOD))          ;
+ memcpy(od.ObjectName, qname, sizeof(MQCHAR48))  ;
+ MQOPEN ( wq->QMh, &od, options, &wq->Qh, mqrc, mqac ) ;
+ TRACE(traceid, ("Worker MQOPEN of %.48s rc = %"PRId32", ac = %"PRId32"\n",
+                 qname,(int32_t)*mqrc,(int32_t)*mqac) ) ;
+ if ( *mqrc == MQCC_FAILED )
+   {
+    wq->Qh = 0 ;
+    return     ;
+   }
+ memcpy(wq->Qname, qname, sizeof(MQCHAR48)) ;
+ wq->Qopts = options                         ;
+
+ return ;
+} // End of work_open
+
+//
+// work_get - get a message for a task into its data, matching the MD it
+//            has, growing the buffer if the message is bigger
+//
+void work_get ( RXMQWORKQM * wq         // The connection
+              , MQHOBJ     hobj         // Queue to get from
+              , MQGMO    * gmo          // Get message options
+              , RXMQTASK * task         // The task
+              )
+{
+ MQMD2                   md               ;  // MD to match
+ MQLONG                  size = WORKBUF   ;  // Buffer size
+ char                  * buf              ;  //-> bigger buffer
+
+ memcpy(&md, &task->md, sizeof(MQMD2)) ;
+ for (;;)
+   {
+    buf = (char *) realloc(task->data, size) ;
+    if ( buf == NULL )
+      {
+       task->mqrc = MQCC_FAILED                 ;
+       task->mqac = MQRC_STORAGE_NOT_AVAILABLE  ;
+       break                                    ;
+      }
+    task->data = buf                         ;
+    memcpy(&task->md, &md, sizeof(MQMD2))    ;
+    MQGET ( wq->QMh, hobj, &task->md, gmo, size, task->data,
+            &task->datalen, &task->mqrc, &task->mqac ) ;
+    if ( task->mqac != MQRC_TRUNCATED_MSG_FAILED ) break ;
+    size = task->datalen                     ;
+   }
+ if ( task->mqrc == MQCC_FAILED ) task->datalen = 0 ;
+
+ return ;
+} // End of work_get
+
+//
+// work_task - do a task, on the worker's connection to its QM
+//
+void work_task ( RXMQWORKER * w          // The worker
+               , RXMQTASK * task         // The task
+               )
+{
+ MQULONG                 traceid = task->traceid ;  // Submitter's trace id
+ RXMQWORKQM            * wq               ;  // The connection
+ MQOD                    od               ;  // Reply queue model
+ MQPMO                   pmo              ;  // Put message options
+ MQGMO                   gmo              ;  // Get message options
+ MQBYTE24                key              ;  // CorrelId of the reply
+ uint64_t                start = now_us() ;  // Time begun
+
+ wq = work_conn(traceid, w, task->QMname, &task->mqrc, &task->mqac) ;
+
+//
+// A request's reply queue is made from the model (the ReplyToQ given,
+// else REQMODEL) when the connection is first used for one
+//
+ if ( (wq != NULL) && (task->op == WORK_REQ) && (wq->Rh == 0) )
+   {
+    memcpy(&od, &od_default, sizeof(MQOD))                 ;
+    if ( (task->md.ReplyToQ[0] == ' ') || (task->md.ReplyToQ[0] == '\0') )
+       memcpy(od.ObjectName, REQMODEL, sizeof(REQMODEL)-1) ;
+    else
+       memcpy(od.ObjectName, task->md.ReplyToQ, sizeof(MQCHAR48)) ;
+    strcpy(od.DynamicQName, "RXMQ.*")                      ;
+    MQOPEN ( wq->QMh, &od, MQOO_INPUT_EXCLUSIVE | MQOO_FAIL_IF_QUIESCING,
+             &wq->Rh, &task->mqrc, &task->mqac )           ;
+    TRACE(traceid, ("Worker reply queue is %.48s, rc = %"PRId32", ac = %"PRId32"\n",
+                    od.ObjectName,(int32_t)task->mqrc,(int32_t)task->mqac) ) ;
+    if ( task->mqrc == MQCC_FAILED ) wq->Rh = 0                   ;
+    else memcpy(wq->Rname, od.ObjectName, sizeof(MQCHAR48))       ;
+   }
+
+//
+// Put the message (or the request, as for RXMQREQ)
+//
+ if ( (task->mqrc != MQCC_FAILED) && (task->op != WORK_GET) )
+   {
+    memcpy(&pmo, &pmo_default, sizeof(MQPMO))               ;
+    pmo.Options = MQPMO_NO_SYNCPOINT | MQPMO_FAIL_IF_QUIESCING ;
+    if ( task->op == WORK_REQ )
+      {
+       task->md.MsgType = MQMT_REQUEST                      ;
+       memcpy(task->md.ReplyToQ, wq->Rname, sizeof(MQCHAR48)) ;
+       memset(task->md.ReplyToQMgr, ' ', sizeof(MQCHAR48))  ;
+       pmo.Options |= MQPMO_NEW_MSG_ID                      ;
+      }
+    work_open(traceid, wq, task->qname, MQOO_OUTPUT | MQOO_FAIL_IF_QUIESCING,
+              &task->mqrc, &task->mqac)                     ;
+    if ( task->mqrc != MQCC_FAILED )
+       MQPUT ( wq->QMh, wq->Qh, &task->md, &pmo, task->datalen, task->data,
+               &task->mqrc, &task->mqac )                   ;
+    TRACE(traceid, ("Ticket %"PRIu32" PUT rc = %"PRId32", ac = %"PRId32"\n",
+                    (uint32_t)task->ticket,(int32_t)task->mqrc,(int32_t)task->mqac) ) ;
+    if ( task->op == WORK_PUT ) task->datalen = 0           ;
+   }
+
+//
+// Get the message (or the reply, by the CorrelId it is to have)
+//
+ if ( (task->mqrc != MQCC_FAILED) && (task->op != WORK_PUT) )
+   {
+    memcpy(&gmo, &gmo_default, sizeof(MQGMO))               ;
+    gmo.Options      = MQGMO_NO_SYNCPOINT | MQGMO_CONVERT | MQGMO_FAIL_IF_QUIESCING ;
+    if ( task->wait > 0 ) gmo.Options |= MQGMO_WAIT         ;
+    gmo.WaitInterval = task->wait                           ;
+    if ( task->op == WORK_GET )
+      {
+       work_open(traceid, wq, task->qname, MQOO_INPUT_AS_Q_DEF | MQOO_FAIL_IF_QUIESCING,
+                 &task->mqrc, &task->mqac)                  ;
+       if ( task->mqrc != MQCC_FAILED ) work_get(wq, wq->Qh, &gmo, task) ;
+      }
+    else
+      {
+       memcpy(key, ( task->md.Report & MQRO_PASS_CORREL_ID ) ? task->md.CorrelId
+                                                             : task->md.MsgId, sizeof(MQBYTE24)) ;
+       memcpy(&task->md, &md_default, sizeof(MQMD2))        ;
+       memcpy(task->md.CorrelId, key, sizeof(MQBYTE24))     ;
+       gmo.Version      = MQGMO_VERSION_2                   ;
+       gmo.MatchOptions = MQMO_MATCH_CORREL_ID              ;
+       work_get(wq, wq->Rh, &gmo, task)                     ;
+      }
+    TRACE(traceid, ("Ticket %"PRIu32" GET rc = %"PRId32", ac = %"PRId32", %"PRId32" bytes\n",
+                    (uint32_t)task->ticket,(int32_t)task->mqrc,(int32_t)task->mqac,(int32_t)task->datalen) ) ;
+   }
+
+//
+// A broken connection is made again for the next task
+//
+ if ( (wq != NULL) && (task->mqac == MQRC_CONNECTION_BROKEN) ) work_disc(traceid, wq) ;
+ task->took = now_us() - start ;
+
+ return ;
+} // End of work_task
+
+#ifndef __MVS__
+//
+// pool_work - a worker thread, doing its tasks until the pool stops,
+//             then closing its connections
+//
+#if defined(_WIN32)
+DWORD WINAPI pool_work ( LPVOID     parm         // The worker
+                       )
+#else
+void * pool_work ( void     * parm         // The worker
+                 )
+#endif
+{
+ RXMQWORKER            * w = (RXMQWORKER *) parm ;  // The worker
+ RXMQPOOL              * pool = w->pool   ;  // Its pool
+ RXMQTASK              * task             ;  // Task being done
+ int                     i                ;  // Looper
+
+ POOL_LOCK(pool) ;
+ for (;;)
+   {
+    while ( (w->head == NULL) && !pool->stop ) POOL_SLEEP(pool, work) ;
+    if ( pool->stop ) break ;
+
+    task       = w->head       ;
+    w->traceid = task->traceid ;
+    POOL_UNLOCK(pool)          ;
+    work_task(w, task)         ;
+    POOL_LOCK(pool)            ;
+
+    w->head = task->next                  ;
+    if ( w->head == NULL ) w->tail = NULL ;
+    w->queued--                           ;
+    task->done = 1                        ;
+    POOL_WAKE(pool, done)                 ;
+   }
+ POOL_UNLOCK(pool) ;
+
+ for ( i = 0 ; i < WORKQMS ; i++ )
+   if ( w->qm[i].QMh != 0 ) work_disc(w->traceid, &w->qm[i]) ;
+
+ return 0 ;
+} // End of pool_work
+#endif
+
+//
+// pool_give - give a task to a worker, the one with a task of the same
+//             key not yet done (else the one with least to do), starting
+//             its thread if it has none. Returns -1 (errno set) if that
+//             failed.
+//
+int pool_give ( MQULONG    traceid      // trace id of caller
+              , RXMQPOOL * pool         // The pool
+              , RXMQTASK * task         // Task to give
+              , RXSTRING   key          // Ordering key (or null)
+              )
+{
+ RXMQWORKER            * w                ;  // Worker given it
+ RXMQTASK              * t                ;  // A task not yet done
+ MQULONG                 h = 2166136261U  ;  // FNV-1a hash of the key
+ int                     k = 0            ;  // Worker number
+ int                     i                ;  // Looper
+
+ if ( !RXNULLSTRING(key) )
+   {
+    for ( i = 0 ; i < (int)key.strlength ; i++ ) h = (h ^ (unsigned char)key.strptr[i]) * 16777619U ;
+    task->key = ( h == 0 ) ? 1 : h ;
+   }
+
+ POOL_LOCK(pool) ;
+ for ( i = 1 ; i < WORKERS ; i++ )
+   if ( pool->worker[i].queued < pool->worker[k].queued ) k = i ;
+ for ( i = 0 ; (task->key != 0) && (i < WORKERS) ; i++ )
+   for ( t = pool->worker[i].head ; t != NULL ; t = t->next )
+     if ( t->key == task->key ) { k = i ; i = WORKERS ; break ; }
+ w = &pool->worker[k] ;
+
+#if defined(__MVS__)
+ POOL_UNLOCK(pool)  ;
+ work_task(w, task) ;
+ task->done = 1     ;
+#else
+ if ( !w->started )
+   {
+    w->pool = pool ;
+#if defined(_WIN32)
+    w->thread = CreateThread(NULL, 0, pool_work, w, 0, NULL) ;
+    if ( w->thread == NULL ) errno = (int)GetLastError() ;
+    else                     w->started = 1              ;
+#else
+    i = pthread_create(&w->thread, NULL, pool_work, w) ;
+    if ( i != 0 ) errno = i            ;
+    else          w->started = 1       ;
+#endif
+    if ( !w->started )
+      {
+       POOL_UNLOCK(pool) ;
+       return -1         ;
+      }
+   }
+
+ if ( w->tail != NULL ) w->tail->next = task ;
+ else                   w->head       = task ;
+ w->tail = task        ;
+ w->queued++           ;
+ POOL_WAKE(pool, work) ;
+ POOL_UNLOCK(pool)     ;
+#endif
+ TRACE(traceid, ("Ticket %"PRIu32" given to worker %d (%"PRId32" queued)\n",
+                 (uint32_t)task->ticket,k,(int32_t)w->queued) ) ;
+
+ return 0 ;
+} // End of pool_give
+
+//
+// pool_make - make the pool of a thread when RXMQSUBM is first called.
+//             Returns NULL if that failed.
+//
+RXMQPOOL * pool_make ( RXMQCB   * anchor       // RXMQ Control Block
+                     )
+{
+ RXMQPOOL              * pool             ;  // The pool
+ int                     i                ;  // Looper
+
+ if ( anchor->Pool != NULL ) return anchor->Pool ;
+
+ pool = (RXMQPOOL *) calloc(1, sizeof(RXMQPOOL)) ;
+ if ( pool == NULL ) return NULL ;
+#if defined(_WIN32)
+ InitializeCriticalSection(&pool->lock)  ;
+ InitializeConditionVariable(&pool->work) ;
+ InitializeConditionVariable(&pool->done) ;
+#elif !defined(__MVS__)
+ if ( pthread_mutex_init(&pool->lock, NULL) != 0 )
+   {
+    free(pool)  ;
+    return NULL ;
+   }
+ pthread_cond_init(&pool->work, NULL) ;
+ pthread_cond_init(&pool->done, NULL) ;
+#endif
+ for ( i = 0 ; i < WORKERS ; i++ ) pool->worker[i].pool = pool ;
+ anchor->Pool = pool ;
+
+ return pool ;
+} // End of pool_make
+
+//
+// pool_wait - wait up to ms milliseconds for a worker to finish a task,
+//             the pool lock being held
+//
+void pool_wait ( RXMQPOOL * pool         // The pool
+               , MQLONG     ms           // Most to wait
+               )
+{
+#if defined(__MVS__)
+ sleep_ms( (ms < 10) ? ms : 10 ) ;
+#elif defined(_WIN32)
+ SleepConditionVariableCS(&pool->done, &pool->lock, (DWORD)ms) ;
+#else
+ struct timeval          tv               ;  // Time now
+ struct timespec         ts               ;  //   and to wait until
+
+ gettimeofday(&tv, NULL)                                 ;
+ ts.tv_sec  = tv.tv_sec + ms / 1000                      ;
+ ts.tv_nsec = (long)tv.tv_usec * 1000 + (long)(ms % 1000) * 1000000 ;
+ if ( ts.tv_nsec >= 1000000000 )
+   {
+    ts.tv_sec++                                          ;
+    ts.tv_nsec -= 1000000000                             ;
+   }
+ pthread_cond_timedwait(&pool->done, &pool->lock, &ts)   ;
+#endif
+
+ return ;
+} // End of pool_wait
+
+//
+// pool_end - stop the workers once the tasks they are doing are done
+//            (those not begun are dropped), and free the pool (RXMQTERM)
+//
+void pool_end ( MQULONG    traceid      // trace id of caller
+              , RXMQCB   * anchor       // RXMQ Control Block
+              )
+{
+ RXMQPOOL              * pool = anchor->Pool ;  // The pool
+ RXMQTASK              * task             ;  // A task not waited for
+ int                     i                ;  // Looper
+
+ POOL_LOCK(pool)       ;
+ pool->stop = 1        ;
+ POOL_WAKE(pool, work) ;
+ POOL_UNLOCK(pool)     ;
+
+ for ( i = 0 ; i < WORKERS ; i++ )
+   {
+#if defined(__MVS__)
+    int                  k                ;  // Connection
+    for ( k = 0 ; k < WORKQMS ; k++ )
+      if ( pool->worker[i].qm[k].QMh != 0 ) work_disc(traceid, &pool->worker[i].qm[k]) ;
+#else
+    if ( !pool->worker[i].started ) continue ;
+#if defined(_WIN32)
+    WaitForSingleObject(pool->worker[i].thread, INFINITE) ;
+    CloseHandle(pool->worker[i].thread)                   ;
+#else
+    pthread_join(pool->worker[i].thread, NULL)            ;
+#endif
+#endif
+   }
+
+ while ( (task = pool->tasks) != NULL )
+   {
+    TRACE(traceid, ("Ticket %"PRIu32" not waited for (%s)\n",
+                    (uint32_t)task->ticket, task->done ? "done" : "dropped") ) ;
+    pool->tasks = task->all ;
+    free(task->data)        ;
+    free(task)              ;
+   }
+
+#if defined(_WIN32)
+ DeleteCriticalSection(&pool->lock) ;
+#elif !defined(__MVS__)
+ pthread_cond_destroy(&pool->work)  ;
+ pthread_cond_destroy(&pool->done)  ;
+ pthread_mutex_destroy(&pool->lock) ;
+#endif
+ free(pool)          ;
+ anchor->Pool = NULL ;
+
+ return ;
+} // End of pool_end
+
+//
+// Descriptor field tables
+//
+//   Each MQ structure that is exchanged with a stem variable is
+//   described by a table of its .extensions (terminated by "?"), which
+//   drives stem_to_fields and stem_from_fields below.
+//
+ #define FLD_LONG   0    // MQLONG
+ #define FLD_INT64  1    // MQINT64
+ #define FLD_CHAR   2    // Single MQCHAR
+ #define FLD_STRING 3    // MQCHARnn
+ #define FLD_BYTES  4    // MQBYTEnn
+ #define FLD_STRINV 5    // MQCHARV -> .x.0 .x.CCSI .x.1
+
+ #define MAXTAILLEN 16   // Longest extension (with .CCSI) in any table
+ #define WIDEVALLEN 512  // Room for the fields longer than VARVALLEN
+
+ #define ALLFIELDS  0xFFFFFFFF // Field mask: bit n is entry n of a table,
+ #define FLD_ZLIST  0x80000000 //   so a table has at most 31 entries, as
+                               //   the top bit asks for .ZLIST on output
+
+ typedef struct _RXMQFLD {
+     char     * name     ; // Stem extension
+     int        type     ; // FLD_xxx
+     size_t     offset   ; // Offset of the field in the structure
+     int        size     ; // Size of the field
+ } RXMQFLD, *PRXMQFLD    ;
+
+//
+// Fetch the fields in the table (selected by mask) from the stem into
+//   the structure. Fields whose variables are not set are left untouched.
+//   Fields longer than VARVALLEN (ConnectionName, ConnTag) are fetched
+//   into a buffer of their own size, so a long value is not truncated.
+//   MQCHARV buffers come from the caller's arena (so need no freeing), or
+//   are malloc'ed for a template when there is no anchor, but only when
+//   the .x.0 variable is set, so a buffer already there is kept.
+//
+void stem_to_fields ( MQULONG    traceid      // trace id of caller
+                    , RXMQCB   * anchor       // arena owner (NULL: malloc)
+                    , PRXMQFLD   fields       // field table
+                    , void     * cb           // target structure
+                    , RXSTRING   stem         // stem variable name high
+                    , MQULONG    mask         // fields wanted (ALLFIELDS)
+                    )
+{
+ SHVCHAIN                chain            ;  // Variable pool chain
+ SHVBLOCK              * sv               ;  // Current block
+ PRXMQFLD                fld              ;  // Current field
+ MQBYTE                * field            ;  // -> field in structure
+ MQCHARV               * string           ;  // -> MQCHARV field
+ uint64_t                number           ;  // Converted value
+ MQULONG                 got0 = 0         ;  // MQCHARV fields with .x.0 set
+ char                    wide[WIDEVALLEN] ;  // Values of the long fields
+ size_t                  used = 0         ;  // Bytes of wide in use
+ int                     i  = 0           ;  // Block index
+ int                     n                ;  // Field index
+
+ if ( stem.strlength + MAXTAILLEN >= VARNAMLEN )   // should never happen
+   {
+    TRACE(traceid, ("Stem name %.*s too long\n",(int)stem.strlength,stem.strptr) ) ;
+    return ;
+   }
+
+ chain.count = 0 ;
+
+ //
+ // Pass 1 : all fixed fields plus the .0/.CCSI of the MQCHARV ones
+ //
+ for ( n = 0, fld = fields ; fld->name[0] != '?' ; fld++, n++ )
+   {
+    if ( !(mask & (1UL << n)) ) continue ;
+    switch ( fld->type )
+      {
+       case FLD_STRING :
+       case FLD_BYTES  : if ( (fld->size > VARVALLEN) && (used + fld->size <= WIDEVALLEN) )
+                           {
+                            sv = shv_fetch(&chain, stem, fld->name, NULL, wide + used, fld->size) ;
+                            if ( sv != NULL ) chain.bin[chain.count-1] = (char)(fld->type == FLD_BYTES) ;
+                            used += fld->size ;
+                           }
+                         else shv_fetch(&chain, stem, fld->name, NULL, NULL, fld->size) ;
+                         break ;
+       case FLD_STRINV : shv_fetch(&chain, stem, fld->name, ".0",    NULL, VARVALLEN) ;
+                         shv_fetch(&chain, stem, fld->name, ".CCSI", NULL, VARVALLEN) ; break ;
+       default         : shv_fetch(&chain, stem, fld->name, NULL, NULL, VARVALLEN) ; break ;
+      }
+   }
+
+ if ( chain.count == 0 ) return ;
+
+ shv_run(traceid, &chain) ;
+
+ for ( n = 0, fld = fields ; fld->name[0] != '?' ; fld++, n++ )
+   {
+    if ( !(mask & (1UL << n)) ) continue ;
+    field = (MQBYTE *)cb + fld->offset ;
+    sv    = &chain.sv[i++]             ;
+
+    if ( fld->type == FLD_STRINV )     // Two blocks: .0 and .CCSI
+      {
+       string = (MQCHARV *) field ;
+       if (    (sv->shvret == RXSHV_OK)
+            && str_to_num(sv->shvvalue.strptr, sv->shvvalue.strlength, &number) )
+         {
+          string->VSBufSize = (MQLONG)(int32_t)(uint32_t)number ; // Assume it is buffer length
+          got0 |= 1UL << n ;
+         }
+       sv = &chain.sv[i++] ;
+       if (    (sv->shvret == RXSHV_OK)
+            && str_to_num(sv->shvvalue.strptr, sv->shvvalue.strlength, &number) )
+          string->VSCCSID = (MQLONG)(int32_t)(uint32_t)number ;   // CCSID may be required
+       continue ;
+      }
+
+    if ( sv->shvret != RXSHV_OK ) continue ; // Not there (or truncated): keep default
+
+    switch ( fld->type )
+      {
+       case FLD_LONG   :
+         if ( str_to_num(sv->shvvalue.strptr, sv->shvvalue.strlength, &number) )
+            *(MQLONG *)field = (MQLONG)(int32_t)(uint32_t)number ;
+         break ;
+       case FLD_INT64  :
+         if ( str_to_num(sv->shvvalue.strptr, sv->shvvalue.strlength, &number) )
+            *(MQINT64 *)field = (MQINT64)number ;
+         break ;
+       case FLD_CHAR   :
+         if ( sv->shvvalue.strlength != 0 ) *(MQCHAR *)field = sv->shvvalue.strptr[0] ;
+         break ;
+       case FLD_STRING :
+         memcpy(field, sv->shvvalue.strptr, sv->shvvalue.strlength) ;
+         if ( (int)sv->shvvalue.strlength < fld->size ) field[sv->shvvalue.strlength] = '\0' ;
+         break ;
+       case FLD_BYTES  :
+         memcpy(field, sv->shvvalue.strptr, sv->shvvalue.strlength) ;
+         break ;
+      }
+   }
+
+ //
+ // Pass 2 : the .1 data of the MQCHARV fields, into arena (or malloc'ed) buffers
+ //
+ chain.count = 0 ;
+ for ( n = 0, fld = fields ; fld->name[0] != '?' ; fld++, n++ )
+   {
+    if ( !(got0 & (1UL << n)) ) continue         ;
+    string = (MQCHARV *)((MQBYTE *)cb + fld->offset) ;
+    if ( (anchor == NULL) && (string->VSPtr != NULL) ) free(string->VSPtr) ;
+    string->VSPtr = NULL                         ;
+    if ( string->VSBufSize <= 0 ) continue       ;
+
+    TRACE(traceid, ("Getting %"PRId32" bytes for %s\n",(int32_t)string->VSBufSize,fld->name)) ;
+    if ( anchor != NULL ) string->VSPtr = arena_get(anchor, string->VSBufSize) ;
+    else                  string->VSPtr = malloc(string->VSBufSize)           ;
+    if ( string->VSPtr == NULL )
+      {
+       TRACE(traceid, ("malloc rc %d\n",errno) ) ;
+       string->VSBufSize = 0                     ;
+      }
+    else shv_fetch(&chain, stem, fld->name, ".1", string->VSPtr, string->VSBufSize) ;
+   }
+
+ if ( chain.count == 0 ) return ;
+
+ shv_run(traceid, &chain)       ;
+
+ for ( i = 0, n = 0, fld = fields ; fld->name[0] != '?' ; fld++, n++ )
+   {
+    if ( !(got0 & (1UL << n)) ) continue                     ;
+    string = (MQCHARV *)((MQBYTE *)cb + fld->offset)         ;
+    if ( string->VSPtr == NULL ) continue                    ;
+    sv = &chain.sv[i++]                                      ;
+    string->VSLength = (sv->shvret == RXSHV_OK) ? sv->shvvalue.strlength : 0 ;
+   }
+
+ return ;
+} // End of stem_to_fields
+
+//
+// Add sets of the fields in the table (selected by mask) from the
+//   structure to a chain, which must have room for them (see
+//   fields_blocks). Values are not copied, so the structure must stay
+//   as it is until the chain is run.
+//
+void fields_to_chain ( SHVCHAIN * chain        // chain to extend
+                     , PRXMQFLD   fields       // field table
+                     , void     * cb           // source structure
+                     , RXSTRING   stem         // stem variable name high
+                     , MQULONG    mask         // fields wanted
+                     )
+{
+ PRXMQFLD                fld              ;  // Current field
+ MQBYTE                * field            ;  // -> field in structure
+ MQBYTE                * nul              ;  // -> 0-terminator
+ MQCHARV               * string           ;  // -> MQCHARV field
+ int                     n                ;  // Field index
+
+ for ( n = 0, fld = fields ; fld->name[0] != '?' ; fld++, n++ )
+   {
+    if ( !(mask & (1UL << n)) ) continue ;
+    field = (MQBYTE *)cb + fld->offset ;
+    switch ( fld->type )
+      {
+       case FLD_LONG   : shv_set_long (chain, stem, fld->name, NULL, *(MQLONG *)field)  ; break ;
+       case FLD_INT64  : shv_set_int64(chain, stem, fld->name, NULL, *(MQINT64 *)field) ; break ;
+       case FLD_CHAR   : shv_set      (chain, stem, fld->name, NULL, field, sizeof(MQCHAR), 0) ; break ;
+       case FLD_STRING :
+         nul = memchr(field, 0, fld->size) ;                  // If null-terminated
+         shv_set(chain, stem, fld->name, NULL, field,
+                 (nul != NULL) ? (size_t)(nul - field) : (size_t)fld->size, 0) ;
+         break ;
+       case FLD_BYTES  : shv_set      (chain, stem, fld->name, NULL, field, fld->size, 1) ; break ;
+       case FLD_STRINV :
+         string = (MQCHARV *) field ;
+         shv_set_long(chain, stem, fld->name, ".0",    string->VSLength) ;
+         shv_set_long(chain, stem, fld->name, ".CCSI", string->VSCCSID)  ;
+         if ( string->VSPtr != 0 )
+            shv_set(chain, stem, fld->name, ".1", string->VSPtr, string->VSLength, 1) ;
+         break ;
+      }
+   }
+
+ return ;
+} // End of fields_to_chain
+
+//
+// fields_blocks - the most chain blocks fields_to_chain needs for a mask
+//
+int fields_blocks ( PRXMQFLD   fields       // field table
+                  , MQULONG    mask         // fields wanted
+                  )
+{
+ PRXMQFLD                fld              ;  // Current field
+ int                     n                ;  // Field index
+ int                     blocks = 0       ;  // Blocks needed
+
+ for ( n = 0, fld = fields ; fld->name[0] != '?' ; fld++, n++ )
+   if ( mask & (1UL << n) ) blocks += ( fld->type == FLD_STRINV ) ? 3 : 1 ;
+
+ return blocks ;
+} // End of fields_blocks
+
+//
+// async_take - take the message at the head of the ring of slot s (see
+//              Asynchronous consume) into data.n, with its handle, and
+//              its MD fields into msgdesc.n (if given), resuming the
+//              consumer once the ring is half empty. The slot is the
+//              writer's again once head has moved past it, so the data
+//              (and MD) set are copies, held in the caller's malloc'd
+//              buffer hold until the chain pointing to them has been run
+//              (the caller frees it at the end, as the arena would keep
+//              its high-water mark). Returns -16 (errno set) if there is
+//              no storage; a resume failure is left in warncc/warnac.
+//
+int async_take ( MQULONG    traceid      // trace id of caller
+               , RXMQCB   * anchor       // RXMQ Control Block
+               , int        s            // Slot number
+               , SHVCHAIN * chain        // chain to extend
+               , RXSTRING   RX_data      // Data stem
+               , PRXMQFLD   fields       // MD field table
+               , RXSTRING   RXo_md       // Msg Desc stem (or null)
+               , MQULONG    omask_md     // MD fields wanted
+               , int        blocks       // Chain blocks a message needs
+               , MQLONG     n            // Message number
+               , char    ** hold         //-> Copies the chain points to
+               , size_t   * holdlen      //   their length
+               , size_t   * holdsize     //   and size
+               , MQLONG   * warncc       // Resume CC
+               , MQLONG   * warnac       // Resume RC
+               )
+{
+ RXMQRING              * ring = anchor->Obj[s].ring ;  // The queue's ring
+ MQULONG                 head = ring->head ;  // Its head
+ RXMQSLOT              * slot             ;  //   the slot taken
+ MQMD2                 * mdcopy           ;  // MD kept for the chain
+ char                  * copy             ;  // Data kept for the chain
+ size_t                  want             ;  // Room for the copies
+ MQLONG                  cc               ;  // Resume CC
+ MQLONG                  ac               ;  // Resume RC
+ RXSTRING                RX_item          ;  // Msg Desc stem of the message
+ char                    tail[24]         ;  // Message number
+ char                    itemnam[VARNAMLEN] ; // Msg Desc stem name
+
+ slot = &ring->slot[head & (ring->slots - 1)]           ;
+ num_to_str(tail, (uint64_t)n, 0)                       ;
+ shv_flush(traceid, chain, blocks)                      ;
+ if ( chain->count == 0 ) *holdlen = 0                  ; // Copies done with
+
+ want = ( ((size_t)slot->datalen + 8) & ~(size_t)7 )
+      + ( RXNULLSTRING(RXo_md) ? 0 : sizeof(MQMD2) )    ;
+ if ( *holdlen + want > *holdsize )
+   {
+    shv_run(traceid, chain)                             ; // Let go of the copies
+    chain->count = 0                                    ;
+    *holdlen     = 0                                    ;
+   }
+ if ( want > *holdsize )
+   {
+    for ( *holdsize = *holdsize ? *holdsize : BUFMIN ; *holdsize < want ; *holdsize <<= 1 ) ;
+    free(*hold)                                         ;
+    *hold = (char *) malloc(*holdsize)                  ;
+    if ( *hold == NULL ) { *holdsize = 0 ; return -16 ; }
+   }
+
+ copy      = *hold + *holdlen                           ;
+ *holdlen += ( (size_t)slot->datalen + 8 ) & ~(size_t)7 ;
+ memcpy(copy, slot->data, slot->datalen)                ;
+ shv_set(chain, RX_data, tail, NULL, copy, slot->datalen, 1) ;
+ shv_set_long(chain, RX_data, tail, ".HANDLE", OBJHANDLE(anchor,s)) ;
+
+ if ( !RXNULLSTRING(RXo_md) )
+   {
+    mdcopy    = (MQMD2 *) (*hold + *holdlen)            ;
+    *holdlen += sizeof(MQMD2)                           ;
+    memcpy(mdcopy, &slot->md, sizeof(MQMD2))            ;
+    MAKERXSTRING(RX_item, itemnam, make_varname(itemnam, RXo_md, tail, ".")) ;
+    fields_to_chain(chain, fields, mdcopy, RX_item, omask_md) ;
+   }
+
+ RING_SET(ring->head, head + 1)                         ;
+
+ if ( RING_GET(ring->suspended) && (RING_GET(ring->tail) - (head + 1) <= ring->slots / 2) )
+   {
+    async_resume(traceid, anchor, s, &cc, &ac)          ;
+    if ( cc == MQCC_FAILED ) { *warncc = MQCC_WARNING ; *warnac = ac ; }
+   }
+
+ return 0 ;
+} // End of async_take
+
+//
+// Set the fields in the table (selected by mask) from the structure into
+//   the stem, plus .ZLIST listing the components set (without the dot)
+//   if FLD_ZLIST is in the mask. A null stem sets nothing.
+//   MQCHARV buffers are arena storage, so are not freed here.
+//
+void stem_from_fields ( MQULONG    traceid      // trace id of caller
+                      , PRXMQFLD   fields       // field table
+                      , void     * cb           // source structure
+                      , RXSTRING   stem         // stem variable name high
+                      , MQULONG    mask         // fields wanted (ALLFIELDS)
+                      )
+{
+ SHVCHAIN                chain            ;  // Variable pool chain
+ char                    zlist[400]       ;  // Char version of .ZLIST
+ size_t                  zlen   = 0       ;  // Length of .ZLIST
+ size_t                  len              ;
+ int                     failed = 0       ;  // Variables not set
+ int                     nset             ;  // Fields in chain (no .ZLIST)
+ int                     i                ;
+
+ if ( RXNULLSTRING(stem) || (mask == 0) ) return ;   // No output wanted
+ if ( stem.strlength + MAXTAILLEN >= VARNAMLEN )      // should never happen
+   {
+    TRACE(traceid, ("Stem name %.*s too long\n",(int)stem.strlength,stem.strptr) ) ;
+    return ;
+   }
+
+ chain.count = 0 ;
+ fields_to_chain(&chain, fields, cb, stem, mask) ;
+
+ //
+ // .ZLIST names every component, so build it from the chain itself
+ //
+ nset = chain.count ;
+ if ( mask & FLD_ZLIST )
+   {
+    for ( i = 0 ; i < nset ; i++ )
+      {
+       len = chain.sv[i].shvname.strlength - stem.strlength ;
+       if ( zlen + len + 1 >= sizeof(zlist) ) break ;
+       zlist[zlen++] = ' '                                   ;
+       memcpy(zlist + zlen, chain.name[i] + stem.strlength, len) ;
+       zlen += len                                           ;
+      }
+    shv_set(&chain, stem, "ZLIST", NULL, zlist, zlen, 0)      ;
+   }
+
+ shv_run(traceid, &chain) ;
+
+ //
+ // Should any variable not have been set, rebuild .ZLIST without it
+ //
+ for ( i = 0 ; i < nset ; i++ )
+    if ( (chain.sv[i].shvret & ~RXSHV_NEWV) != 0 ) failed++ ;
+
+ if ( (failed != 0) && (mask & FLD_ZLIST) )
+   {
+    for ( zlen = 0, i = 0 ; i < nset ; i++ )
+      {
+       if ( (chain.sv[i].shvret & ~RXSHV_NEWV) != 0 ) continue ;
+       len = chain.sv[i].shvname.strlength - stem.strlength    ;
+       if ( zlen + len + 1 >= sizeof(zlist) ) break            ;
+       zlist[zlen++] = ' '                                     ;
+       memcpy(zlist + zlen, chain.name[i] + stem.strlength, len) ;
+       zlen += len                                             ;
+      }
+    chain.count = 0 ;
+    shv_set(&chain, stem, "ZLIST", NULL, zlist, zlen, 0)        ;
+    shv_run(traceid, &chain)                                   ;
+   }
+
+ return ;
+} // End of stem_from_fields
+
+//
+// Make a list of mnemonics (blank separated, any case) into a field mask.
+//   ZLIST may be given too, for output.
+//   Returns 0, or -1 if a mnemonic is not in the table.
+//
+int fields_to_mask ( PRXMQFLD   fields       // field table
+                   , char     * list         // mnemonics
+                   , size_t     len          // length of list
+                   , MQULONG  * mask         // resulting field mask
+                   )
+{
+ PRXMQFLD                fld              ;  // Current field
+ size_t                  i = 0            ;  // Position in list
+ size_t                  j                ;  // End of current word
+ size_t                  k                ;  // Char in word
+ int                     n                ;  // Field index
+
+ *mask = 0 ;
+
+ while ( i < len )
+   {
+    if ( list[i] == ' ' ) { i++ ; continue ; }
+    for ( j = i ; (j < len) && (list[j] != ' ') ; j++ ) ;
+
+    for ( n = 0, fld = fields ; ; fld++, n++ )
+      {
+       if ( fld->name[0] == '?' )
+         {
+          fld = NULL ;                                 // Not a field ...
+          break      ;
+         }
+       if ( strlen(fld->name) != j - i ) continue ;
+       for ( k = 0 ; k < j - i ; k++ )
+          if ( toupper((unsigned char)list[i+k]) != fld->name[k] ) break ;
+       if ( k == j - i ) break ;
+      }
+
+    if ( fld != NULL )                 *mask |= 1UL << n ;
+    else if ( (j - i == 5) &&
+              !memcmp(list + i, "ZLIST", 5) ) *mask |= FLD_ZLIST ; // ... or .ZLIST
+    else                               return -1         ;
+    i = j ;
+   }
+
+ return 0 ;
+} // End of fields_to_mask
+
+//
+// fields_match - compare the fields in the mask of two structures.
+//   MQCHARV fields are not compared.
+//   Returns 1 if they are all the same, else 0.
+//
+int fields_match ( PRXMQFLD   fields       // field table
+                 , void     * a            // one structure
+                 , void     * b            // the other
+                 , MQULONG    mask         // fields to compare
+                 )
+{
+ PRXMQFLD                fld              ;  // Current field
+ int                     n                ;  // Field index
+
+ for ( n = 0, fld = fields ; fld->name[0] != '?' ; fld++, n++ )
+   {
+    if ( !(mask & (1UL << n)) || (fld->type == FLD_STRINV) ) continue ;
+    if ( memcmp((MQBYTE *)a + fld->offset, (MQBYTE *)b + fld->offset, fld->size) ) return 0 ;
+   }
+
+ return 1 ;
+} // End of fields_match
+
+//
+// Give a structure its own copy, in the caller's arena, of any MQCHARV
+//   buffers it points to (such as those of a template), so the template
+//   is left alone whatever this call does with them.
+//
+void fields_dup ( RXMQCB   * anchor       // arena owner
+                , PRXMQFLD   fields       // field table
+                , void     * cb           // structure
+                )
+{
+ PRXMQFLD                fld              ;  // Current field
+ MQCHARV               * string           ;  // -> MQCHARV field
+ void                  * copy             ;  // New buffer
+
+ for ( fld = fields ; fld->name[0] != '?' ; fld++ )
+   {
+    if ( fld->type != FLD_STRINV ) continue          ;
+    string = (MQCHARV *)((MQBYTE *)cb + fld->offset) ;
+    if ( string->VSPtr == NULL ) continue            ;
+
+    copy = arena_get(anchor, string->VSBufSize)      ;
+    if ( copy != NULL ) memcpy(copy, string->VSPtr, string->VSBufSize) ;
+    else string->VSBufSize = string->VSLength = 0    ;
+    string->VSPtr = copy                             ;
+   }
+
+ return ;
+} // End of fields_dup
+
+//
+// Free any MQCHARV buffers of a structure
+//
+void fields_free ( PRXMQFLD   fields       // field table
+                 , void     * cb           // structure
+                 )
+{
+ PRXMQFLD                fld              ;  // Current field
+ MQCHARV               * string           ;  // -> MQCHARV field
+
+ for ( fld = fields ; fld->name[0] != '?' ; fld++ )
+   {
+    if ( fld->type != FLD_STRINV ) continue          ;
+    string = (MQCHARV *)((MQBYTE *)cb + fld->offset) ;
+    if ( string->VSPtr != NULL ) free(string->VSPtr) ;
+    string->VSPtr = NULL                             ;
+   }
+
+ return ;
+} // End of fields_free
+
+
+// set_entry is called at the beginning of each external function execution
+//
+// Tracing is controlled by the TRACE macro.
+//
+//         If the dynamic usage of TRACE is set, then the
+//            set_entry routine determines whether or not data
+//            is printed (based on the RXMQTRACE Rexx var).
+//
+
+//
+// set_entry will obtain the trace setting currently in effect,
+//             and set tracebits variable for later checking in DEBUG macros
+//
+//         Known settings are :
+//
+//                              CONN  -> mqconn
+//                              DISC  -> mqdisc
+//                              OPEN  -> mqopen
+//                              CLOSE -> mqclose
+//                              GET   -> mqget
+//                              PUT   -> mqput
+//                              PUT1  -> mqput1
+//                              INQ   -> mqinq
+//                              SET   -> mqset
+//                              CMIT  -> mqcmit
+//                              BACK  -> mqback
+//                              SUB   -> mqsub
+//
+//                              BRO   -> Browse extension
+//                              HXT   -> Header extraction extension
+//                              EVENT -> Event determination extension
+//                              TM    -> Trigger message extension
+//                              COM   -> Command interface
+//                              MQV   -> Debug a RXMQV
+//                              DEF   -> Descriptor templates
+//                              CACHE -> Open handle cache
+//                              SESS  -> Shared sessions
+//                              ASYNC -> Asynchronous consume
+//                              REQ   -> Request/reply
+//                              WORK  -> Worker pool
+//
+//                              INIT  -> initialization processing
+//                              TERM  -> Deregistration processing
+//
+//                              *     -> Trace everything!!!
+//
+//
+//  These settings are extracted from the RXMQTRACE Rexx Variable
+//    (so RXMQTRACE = 'INQ OPEN' will trace Open and Inq operations)
+//
+//
+//
+
+//
+// Trace keywords, as set in RXMQTRACE (or given to RXMQTRAC)
+//
+ typedef struct _TRACEWORD {
+     char     * word                         ; // Keyword and a blank
+     MQULONG    bits                         ; // Trace bits it sets
+ } TRACEWORD;
+
+ static const TRACEWORD tracewords[] = {
+        { "* "    , ALL   },
+        { "CONN " , CONN  },
+        { "DISC " , DISC  },
+        { "OPEN " , OPEN  },
+        { "CLOSE ", CLOSE },
+        { "GET "  , GET   },
+        { "PUT "  , PUT   },
+        { "PUT1 " , PUT1  },
+        { "INQ "  , INQ   },
+        { "SET "  , SET   },
+        { "CMIT " , CMIT  },
+        { "BACK " , BACK  },
+        { "SUB "  , SUB   },
+        { "BRO "  , BRO   },
+        { "HXT "  , HXT   },
+        { "EVENT ", EVENT },
+        { "TM "   , TM    },
+        { "COM "  , COM   },
+        { "MQV "  , MQV   },
+        { "INIT " , INIT  },
+        { "TERM " , TERM  },
+        { "DEF "  , DEF   },
+        { "CACHE ", CACHE },
+        { "SESS " , SESS  },
+        { "ASYNC ", ASYNC },
+        { "REQ "  , REQ   },
+        { "WORK " , WORK  },
+        { "?"     , ZERO  }} ;
+
+//
+// trace_bits - the trace bits for a string of keywords
+//
+MQULONG trace_bits ( char     * keywords     // Keywords (0-terminated)
+                   )
+{
+ char                    words[102]       ;  // Keywords and a blank
+ const TRACEWORD       * tw               ;  // Current keyword
+ MQULONG                 bits = ZERO      ;  // Bits found
+
+ if ( keywords[0] == '\0' ) return ZERO   ;
+
+ sprintf(words, "%.100s ", keywords)      ; // Add a blank to tail
+ for ( tw = tracewords ; tw->word[0] != '?' ; tw++ )
+   if ( strstr(words, tw->word) != NULL ) bits |= tw->bits ;
+
+ return bits ;
+} // End of trace_bits
+
+MQLONG  set_envir ( char     * func        // Current function executed
+                  , MQULONG  * traceidptr  // Trace bitmask
+                  , RXMQCB  ** anchorptr   // pointer to RXMQCB pointer
+                  )
+{
+ RXSTRING              varname      ;  // Variable name
+ SHVCHAIN              chain        ;  // Trace variables fetch
+ SHVBLOCK            * sv           ;  // Current block
+ char                * old          ;  // Trace variable as last read
+ size_t                len          ;  //   and its length now
+ int                   changed = 0  ;  // Trace variables changed
+ int                   i            ;  // Looper
+ MQLONG                rc = 0       ;
+
+// First of all let's try to access our anchor control block for the current thread.
+// It may or may not exist when calling RXMQ function.
+// If exists, use it; otherwise create it.
+// This control block is a RXMQCB structure, which address is kept in
+// thread-local storage and also assigned to REXX RXMQANCHOR variable
+// (from which z/OS finds it).
+
+#ifdef __MVS__
+ var_to_ptr (ZERO, RXMQANCHOR , (void **) anchorptr)  ;
+#else
+ *anchorptr = tls_anchor                              ;
+#endif
+
+ if ( (*anchorptr) == NULL    )
+   {
+    TRACES(("Doing malloc for RXMQCB for %u bytes\n",(uint32_t)sizeof(RXMQCB))) ;
+    *anchorptr = (RXMQCB *) malloc(sizeof(RXMQCB))                    ;
+
+    if ( *anchorptr == NULL )
+      {
+       TRACES(("malloc rc = %d\n",errno)) ;
+       rc = -77                           ;
+      }
+    else
+      {
+       var_from_ptr  (ZERO, RXMQANCHOR , *anchorptr)        ;
+       memset (*anchorptr, 0, sizeof(RXMQCB))                  ;
+       memcpy ((*anchorptr)->StrucId, RXMQeyecatcher, sizeof(MQCHAR4)) ;
+#ifndef __MVS__
+       tls_anchor = *anchorptr                                 ;
+#endif
+      }
+   }
+
+ if (rc == 0 ) arena_reset(*anchorptr)                             ; // New call
+
+//
+// Unless RXMQTRAC has set the trace, fetch both trace variables (the
+// old-style one like RXMQNTRACE, and RXMQTRACE) together, only working
+// out the trace bits again when either has changed
+//
+ if ( (rc == 0) && !(*anchorptr)->traceset )
+   {
+    chain.count = 0                                                ;
+    MAKERXSTRING(varname,TRACEVAR,strlen(TRACEVAR))                ; // Make name like RXMQNTRACE
+    shv_fetch(&chain, varname, "", NULL, NULL, VARVALLEN-1)        ;
+    MAKERXSTRING(varname,"RXMQTRACE",strlen("RXMQTRACE"))          ; // Make name like RXMQTRACE
+    shv_fetch(&chain, varname, "", NULL, NULL, VARVALLEN-1)        ;
+    shv_run(ZERO, &chain)                                          ;
+
+    for ( i = 0 ; i < 2 ; i++ )
+      {
+       sv  = &chain.sv[i]                                          ;
+       old = (*anchorptr)->tracevar[i]                             ;
+       len = ( sv->shvret == RXSHV_OK ) ? sv->shvvalue.strlength : 0 ;
+       if ( (strlen(old) != len) || memcmp(old, sv->shvvalue.strptr, len) )
+         {
+          memcpy(old, sv->shvvalue.strptr, len)                    ;
+          old[len] = '\0'                                          ;
+          changed  = 1                                             ;
+         }
+      }
+
+    if ( changed )
+       (*anchorptr)->tracebits = trace_bits((*anchorptr)->tracevar[0])
+                               | trace_bits((*anchorptr)->tracevar[1]) ;
+   }
+
+ if (rc == 0 )
+   {
+    *traceidptr &= (*anchorptr)->tracebits          ;
+    TRACE(*traceidptr, ("Function is <%s>\n",func)) ;
+    TRACE(*traceidptr, ("traceid = %"PRIX32"\n",(uint32_t)*traceidptr));
+    DUMPCB(*traceidptr, *anchorptr)                 ;
+   }
+
+ return rc;
+} // End of set_envir function
+
+
+//
+// Return processing functions
+//
+//      set_return   : sets up the return variables
+//
+//          LASTRC    -> current operation Return Code
+//          LASTCC    -> current operation MQ Completion Code
+//          LASTAC    -> current operation MQ Reason     Code
+//          LASTOP    -> current operation RXMQ Function
+//          LASTMSG   -> current operation text message
+//
+//          The Return Code for the operation can be negative to
+//              show that this interface has detected the error,
+//              otherwise it will be the MQ Completion Code
+//
+//          The Message is in text format as follows:
+//
+//            Arg 1 : Return Code
+//            Arg 2 : MQ Completion Code (or 0 if MQ not done)
+//            Arg 2 : MQ Reason     Code (or 0 if MQ not done)
+//            Arg 4 : RXMQ... function being run
+//            Arg 5 : OK or an helpful error message
+//            Arg 6 : Return mode (RET_xx)
+//            Arg 7 : Trace id of caller
+//
+//          Under RET_NEW only the RXMQ.LASTxx variables are set, and
+//          under RET_NUM none are, the message being just Args 1-3
+//
+//
+void set_return ( const MQLONG   rc       //Function return Code
+                , const MQLONG   cc       //MQ Completion Code
+                , const MQLONG   ac       //MQ Reason Code
+                , char         * op       //Function name
+                , const RETMSG * pRetMsg  //Function message table
+                , PRXSTRING      aretstr  //REXX Return String
+                , MQLONG         retmode  //Return mode (RET_xx)
+                , MQULONG        traceid  //trace id of caller
+                , char         * moremsg  //additional message
+                )
+{
+ int                     i                ;
+ RXSTRING                varname_new      ;  // Variable name
+ RXSTRING                varname_old      ;  // Variable name
+ SHVCHAIN                chain            ;  // All LASTxx sets together
+
+ TRACE(traceid,("Entering set_return\n")) ;
+
+ if ( retmode == RET_NUM )
+   {
+    sprintf(aretstr->strptr, "%"PRId32" %"PRId32" %"PRId32,
+            (int32_t)rc, (int32_t)cc, (int32_t)ac) ;
+    aretstr->strlength = strlen(aretstr->strptr)   ;
+    TRACE(traceid,("Leaving set_return\n"))  ;
+    TRACE(traceid,("Leaving %s\n",op))       ; // Leaving function
+    return ;
+   }
+
+ MAKERXSTRING(varname_new, "RXMQ.", sizeof("RXMQ.")-1)  ;
+ MAKERXSTRING(varname_old, PREFIX,  sizeof(PREFIX)-1)   ;
+ chain.count = 0                                        ;
+
+ shv_set_long(&chain, varname_new, "LASTRC", NULL, rc)  ;
+ shv_set_long(&chain, varname_new, "LASTCC", NULL, cc)  ;
+ shv_set_long(&chain, varname_new, "LASTAC", NULL, ac)  ;
+ shv_set(&chain, varname_new, "LASTOP", NULL, op, strlen(op), 0) ;
+
+ if ( retmode == RET_FULL )
+   {
+    shv_set_long(&chain, varname_old, "LASTRC", NULL, rc)  ;
+    shv_set_long(&chain, varname_old, "LASTCC", NULL, cc)  ;
+    shv_set_long(&chain, varname_old, "LASTAC", NULL, ac)  ;
+    shv_set(&chain, varname_old, "LASTOP", NULL, op, strlen(op), 0) ;
+   }
+
+ if (rc < 0)
+   {
+    for (i = 0; ; i++)
+      {
+       if (pRetMsg[i].retcode == rc ) break ;
+       if (pRetMsg[i].retcode == -99) break ;
+      }
+    sprintf(aretstr->strptr,  "%"PRId32" %"PRId32" %"PRId32" %-s %s",
+        (uint32_t)rc, (uint32_t)cc, (uint32_t)ac, op, pRetMsg[i].retmsgc);
+   }
+ else sprintf(aretstr->strptr,"%"PRId32" %"PRIu32" %"PRIu32" %-s %s %s",
+              (uint32_t)rc, (uint32_t)cc, (uint32_t)ac, op,
+              ( (cc == MQCC_OK      ) ? "OK"      :
+                (cc == MQCC_WARNING ) ? "WARNING" :
+                (cc == MQCC_FAILED  ) ? "FAILED"  :
+                                        "UNKNOWN" ),
+              moremsg        ) ;
+
+ aretstr->strlength  = strlen(aretstr->strptr)     ;
+ shv_set(&chain, varname_new, "LASTMSG", NULL,
+         aretstr->strptr, aretstr->strlength, 0)  ;
+ if ( retmode == RET_FULL )
+    shv_set(&chain, varname_old, "LASTMSG", NULL,
+            aretstr->strptr, aretstr->strlength, 0)  ;
+
+ shv_run(traceid, &chain)                         ;
+
+ TRACE(traceid,("Leaving set_return\n"))  ;
+ TRACE(traceid,("Leaving %s\n",op))       ; // Leaving function
+ fflush(NULL)                             ; // Required to flush trace buffer
+
+ return ;
+} // End of set_return function
+
+//
+// Distribution lists
+//
+//   An input OD stem with .OR.0 set opens a list of that many queues,
+//   named by .OR.i.ON and .OR.i.OQM (the MQOR records). RXMQOPEN sets
+//   the response for each queue (the MQRR records) in the output OD
+//   stem as .RR.0 and .RR.i.CC and .RR.i.RC, and RXMQPUT to the list,
+//   or RXMQPUT1 to a list, sets them in the output PMO stem.
+//
+//   A put may give each queue its own MsgId, CorrelId, GroupId,
+//   Feedback and AccountingToken (the MQPMR records): .PMRF in the
+//   input PMO stem holds the MQPMRF_xxx flags of the fields given, in
+//   .PMR.i.MSGID, .CID, .GID, .FBK and .AT. The others come from the MD.
+//
+static RXMQFLD or_fields[] = {
+ { "ON"  , FLD_STRING, offsetof(MQOR, ObjectName)          , sizeof(MQCHAR48) },
+ { "OQM" , FLD_STRING, offsetof(MQOR, ObjectQMgrName)      , sizeof(MQCHAR48) },
+ { "?"   , 0         , 0                                   , 0                }
+ } ;
+
+static RXMQFLD rr_fields[] = {
+ { "CC"  , FLD_LONG  , offsetof(MQRR, CompCode)            , sizeof(MQLONG)   },
+ { "RC"  , FLD_LONG  , offsetof(MQRR, Reason)              , sizeof(MQLONG)   },
+ { "?"   , 0         , 0                                   , 0                }
+ } ;
+
+static RXMQFLD pmr_fields[] = {    // In the order of pmr_flags
+ { "MSGID", FLD_BYTES, offsetof(MQPMR, MsgId)              , sizeof(MQBYTE24) },
+ { "CID"  , FLD_BYTES, offsetof(MQPMR, CorrelId)           , sizeof(MQBYTE24) },
+ { "GID"  , FLD_BYTES, offsetof(MQPMR, GroupId)            , sizeof(MQBYTE24) },
+ { "FBK"  , FLD_LONG , offsetof(MQPMR, Feedback)           , sizeof(MQLONG)   },
+ { "AT"   , FLD_BYTES, offsetof(MQPMR, AccountingToken)    , sizeof(MQBYTE32) },
+ { "?"    , 0        , 0                                   , 0                }
+ } ;
+
+static const MQLONG pmr_flags[] = { MQPMRF_MSG_ID, MQPMRF_CORREL_ID, MQPMRF_GROUP_ID,
+                                    MQPMRF_FEEDBACK, MQPMRF_ACCOUNTING_TOKEN } ;
+
+//
+// recs_from_stem - fetch count records of size bytes from stem.name.i.
+//                  (i from 1) into the arena, each starting as *dflt.
+//                  Returns the records, or NULL if there is no storage.
+//
+void * recs_from_stem ( MQULONG    traceid      // trace id of caller
+                      , RXMQCB   * anchor       // RXMQ Control Block
+                      , PRXMQFLD   fields       // field table
+                      , size_t     size         // record size
+                      , void     * dflt         // record default
+                      , RXSTRING   stem         // stem variable name high
+                      , char       name[]       // records name
+                      , MQLONG     count        // records wanted
+                      , MQULONG    mask         // fields wanted
+                      )
+{
+ MQBYTE                * recs             ;  // The records
+ char                    tail[32]         ;  // name.i
+ size_t                  len = strlen(name) ;  //   name length
+ char                    itemnam[VARNAMLEN] ;  // Stem of one record
+ RXSTRING                RX_item          ;
+ MQLONG                  i                ;
+
+ recs = (MQBYTE *) arena_get(anchor, count * size) ;
+ if ( recs == NULL ) return NULL                   ;
+
+ memcpy(tail, name, len) ;
+ tail[len] = '.'         ;
+ for ( i = 0 ; i < count ; i++ )
+   {
+    memcpy(recs + i * size, dflt, size)                                ;
+    num_to_str(tail + len + 1, (uint64_t)(i + 1), 0)                    ;
+    MAKERXSTRING(RX_item, itemnam, make_varname(itemnam, stem, tail, ".")) ;
+    if ( RX_item.strlength != 0 )
+       stem_to_fields(traceid, anchor, fields, recs + i * size, RX_item, mask) ;
+   }
+
+ return recs ;
+} // End of recs_from_stem
+
+//
+// rr_new - count response records from the arena, or NULL
+//
+MQRR * rr_new ( RXMQCB   * anchor       // RXMQ Control Block
+              , MQLONG     count        // records wanted
+              )
+{
+ MQRR                  * rrs              ;  // The records
+ MQLONG                  i                ;
+
+ rrs = (MQRR *) arena_get(anchor, count * sizeof(MQRR)) ;
+ if ( rrs == NULL ) return NULL                        ;
+ for ( i = 0 ; i < count ; i++ ) memcpy(&rrs[i], &rr_default, sizeof(MQRR)) ;
+
+ return rrs ;
+} // End of rr_new
+
+//
+// pmo_dests - ready a PMO for a put to a list of count queues, with the
+//             response records rrs (or new ones if NULL), and the put
+//             message records of .PMRF read from the input PMO stem
+//             (none with a template). Returns 0, or -1 if there is no
+//             storage.
+//
+int pmo_dests ( MQULONG    traceid      // trace id of caller
+              , RXMQCB   * anchor       // RXMQ Control Block
+              , MQPMO    * pmo          // PMO to ready
+              , RXSTRING   stem         // input PMO stem
+              , int        fromstem     //   not a template
+              , MQLONG     count        // Queues in the list
+              , MQRR     * rrs          // Response records (or NULL)
+              )
+{
+ MQBYTE                * recs             ;  // Put message records
+ MQBYTE                * to               ;  //   packed to here
+ MQULONG                 mask = 0         ;  // Fields given
+ PRXMQFLD                fld              ;  // Current field
+ MQLONG                  i                ;
+ int                     n                ;  // Field index
+
+ if ( (rrs == NULL) && ((rrs = rr_new(anchor, count)) == NULL) ) return -1 ;
+
+ if ( pmo->Version < MQPMO_VERSION_2 ) pmo->Version = MQPMO_VERSION_2 ;
+ pmo->RecsPresent       = count ;
+ pmo->PutMsgRecOffset   = 0     ;
+ pmo->ResponseRecOffset = 0     ;
+ pmo->PutMsgRecPtr      = NULL  ;
+ pmo->ResponseRecPtr    = rrs   ;
+ if ( !fromstem ) pmo->PutMsgRecFields = MQPMRF_NONE ;
+
+ for ( n = 0 ; pmr_fields[n].name[0] != '?' ; n++ )
+    if ( pmo->PutMsgRecFields & pmr_flags[n] ) mask |= 1UL << n ;
+ TRACE(traceid, ("%"PRId32" queues, PMRF %"PRId32"\n",(int32_t)count,(int32_t)pmo->PutMsgRecFields) ) ;
+ if ( mask == 0 ) return 0 ;
+
+ recs = (MQBYTE *) recs_from_stem(traceid, anchor, pmr_fields, sizeof(MQPMR),
+                                  &pmr_default, stem, "PMR", count, mask) ;
+ if ( recs == NULL ) return -1 ;
+
+ // An MQPMR holds only the fields given, so pack them in place
+ for ( i = 0, to = recs ; i < count ; i++ )
+    for ( n = 0, fld = pmr_fields ; fld->name[0] != '?' ; fld++, n++ )
+      {
+       if ( !(mask & (1UL << n)) ) continue ;
+       memmove(to, recs + i * sizeof(MQPMR) + fld->offset, fld->size) ;
+       to += fld->size ;
+      }
+ pmo->PutMsgRecPtr = recs ;
+
+ return 0 ;
+} // End of pmo_dests
+
+//
+// rr_to_stem - set stem.RR.0 to count and stem.RR.i.CC and .RC to the
+//              response for each queue. The queue manager fills the
+//              records in only for MQRC_MULTIPLE_REASONS, else every
+//              queue had the call's own cc and rc.
+//
+void rr_to_stem ( MQULONG    traceid      // trace id of caller
+                , MQRR     * rrs          // Response records
+                , MQLONG     count        // Queues in the list
+                , MQLONG     cc           // MQ CC of the call
+                , MQLONG     rc           // MQ RC of the call
+                , RXSTRING   stem         // output stem (or null)
+                )
+{
+ SHVCHAIN                chain            ;  // Variable sets
+ char                    tail[32]         ;  // RR.i
+ char                    itemnam[VARNAMLEN] ;  // Stem of one record
+ RXSTRING                RX_item          ;
+ MQLONG                  i                ;
+
+ if ( RXNULLSTRING(stem) || (rrs == NULL) ) return ;
+
+ chain.count = 0                                ;
+ shv_set_long(&chain, stem, "RR.0", NULL, count) ;
+ memcpy(tail, "RR.", 3)                         ;
+ for ( i = 0 ; i < count ; i++ )
+   {
+    if ( rc != MQRC_MULTIPLE_REASONS )
+      {
+       rrs[i].CompCode = cc ;
+       rrs[i].Reason   = rc ;
+      }
+    num_to_str(tail + 3, (uint64_t)(i + 1), 0)                         ;
+    MAKERXSTRING(RX_item, itemnam, make_varname(itemnam, stem, tail, ".")) ;
+    if ( RX_item.strlength == 0 ) continue                             ;
+    shv_flush(traceid, &chain, 2)                                      ;
+    fields_to_chain(&chain, rr_fields, &rrs[i], RX_item, ALLFIELDS)    ;
+   }
+ shv_run(traceid, &chain) ;
+
+ return ;
+} // End of rr_to_stem
+
+//
+// Functions that manipulate MQ objects and Rexx Variables
+//
+//           The make_??_from_stem  functions build the ??
+//                                  MQ object by trying to reference
+//                                  a stem variable (whose name ending
+//                                  with a dot) whose name is supplied.
+//                                  If the .xx part is present, then
+//                                  the contents are copied into the
+//                                  MQ Object.
+//
+//
+//            The make_stem_from_?? functions work the other way around.
+//                                  they are supplied with the name of
+//                                  a stem variable (including the dot)
+//                                  and build a Rexx representatation of
+//                                  the MQ object by setting xx.yy
+//                                  variables, where the yy is a
+//                                  component of the MQ object. In addition,
+//                                  (.)ZLIST is set to a list of the components
+//                                  in the stem (without the leading dot).
+//
+//
+//   The names of the .extensions are described in the functions.
+//
+//   Note that the make_stem_from_?? functions will normally build
+//        all of the .extensions, whereas the make_??_from_stem
+//        functions can cope with the omission of extensions.
+//
+//        The output stem may however be followed by the mnemonics
+//        wanted, when only those (and .ZLIST only if ZLIST is listed)
+//        are set:
+//                 'OMD. MSGID CID PRI'
+//        and may be omitted altogether, when nothing is set.
+//
+static RXMQFLD od_fields[] = {
+ // Version 1 of MQOD
+ { "VER" , FLD_LONG  , offsetof(MQOD, Version)             , sizeof(MQLONG)   },
+ { "OT"  , FLD_LONG  , offsetof(MQOD, ObjectType)          , sizeof(MQLONG)   },
+ { "ON"  , FLD_STRING, offsetof(MQOD, ObjectName)          , sizeof(MQCHAR48) },
+ { "OQM" , FLD_STRING, offsetof(MQOD, ObjectQMgrName)      , sizeof(MQCHAR48) },
+ { "DQN" , FLD_STRING, offsetof(MQOD, DynamicQName)        , sizeof(MQCHAR48) },
+ { "AUID", FLD_STRING, offsetof(MQOD, AlternateUserId)     , sizeof(MQCHAR12) },
+ // Version 2 of MQOD
+ { "RP"  , FLD_LONG  , offsetof(MQOD, RecsPresent)         , sizeof(MQLONG)   },
+ { "KDC" , FLD_LONG  , offsetof(MQOD, KnownDestCount)      , sizeof(MQLONG)   },
+ { "UDC" , FLD_LONG  , offsetof(MQOD, UnknownDestCount)    , sizeof(MQLONG)   },
+ { "IDC" , FLD_LONG  , offsetof(MQOD, InvalidDestCount)    , sizeof(MQLONG)   },
+ // Version 3 of MQOD
+ { "ASID", FLD_BYTES , offsetof(MQOD, AlternateSecurityId) , sizeof(MQBYTE40) },
+ { "RQN" , FLD_STRING, offsetof(MQOD, ResolvedQName)       , sizeof(MQCHAR48) },
+ { "RQMN", FLD_STRING, offsetof(MQOD, ResolvedQMgrName)    , sizeof(MQCHAR48) },
+ // Version 4 of MQOD
+ { "OS"  , FLD_STRINV, offsetof(MQOD, ObjectString)        , sizeof(MQCHARV)  },
+ { "SS"  , FLD_STRINV, offsetof(MQOD, SelectionString)     , sizeof(MQCHARV)  },
+ { "ROS" , FLD_STRINV, offsetof(MQOD, ResObjectString)     , sizeof(MQCHARV)  },
+ { "RT"  , FLD_LONG  , offsetof(MQOD, ResolvedType)        , sizeof(MQLONG)   },
+ { "?"   , 0         , 0                                   , 0                }
+ } ;
+
+//
+// make_od_from_stem will return an Object Descriptor from the
+//                   contents of a Stem Variable:
+//
+//                     .VER  -> Version
+//                     .OT   -> ObjectType
+//                     .ON   -> ObjectName
+//                     .OQM  -> ObjectQMgrName
+//                     .DQN  -> DynamicQueue
+//                     .AUID -> AlternateUserid
+//                     .RP   -> RecsPresent
+//                     .KDC  -> KnownDestCount (output only)
+//                     .UDC  -> UnknownDestCount (output only)
+//                     .IDC  -> InvalidDestCount (output only)
+//                     .ORO  -> ObjectRecOffset (not implemented)
+//                     .RRO  -> ResponseRecOffset (not implemented)
+//                     .ORP  -> ObjectRecPtr (from .OR.i, see below)
+//                     .RRP  -> ResponseRecPtr (to .RR.i, see below)
+//                     .ASID -> AlternateSecurityId (Windows only)
+//                     .RQN  -> ResolvedQName (output only)
+//                     .RQMN -> ResolvedQMgrName (output only)
+//                     .OS   -> ObjectString
+//                     .SS   -> SelectionString
+//                     .ROS  -> ResObjectString
+//                     .RT   -> ResolvedType
+//
+//                   With .OR.0 set (and not for an RXMQDEF template) it
+//                   is a distribution list, see Distribution lists.
+//
+
+void make_od_from_stem ( MQULONG    traceid      // trace id of caller
+                       , RXMQCB   * anchor       // arena owner (NULL: malloc)
+                       , MQOD     * od           // target object descriptor
+                       , RXSTRING   stem         // name of stem variable
+                       )
+{
+ MQLONG                  count = 0        ;  // Queues in a list
+ MQOR                  * ors              ;  //   their object records
+ MQRR                  * rrs              ;  //   and response records
+
+ TRACE(traceid, ("Entering make_od_from_stem\n") ) ;
+
+ memcpy(od, &od_default, sizeof(MQOD))         ;
+
+//If the given variable is not a stem. variable, then take the
+//   quicker option of assuming it's a Queue to open
+
+ if ( stem.strptr[stem.strlength-1] != '.' )
+   {
+     memcpy(&od->ObjectName,
+            stem.strptr,
+            strlen(stem.strptr) ) ;
+     DUMPCB(traceid,  od )            ;
+     TRACE(traceid, ("Leaving make_od_from_stem\n") ) ;
+     return                       ;
+    }
+
+ //The given variable is a stem. variable, so get its contents
+ //    (all versions of MQOD, see od_fields)
+
+ stem_to_fields(traceid, anchor, od_fields, od, stem, ALLFIELDS) ;
+
+ //A distribution list has its object records in .OR.i, and records
+ //    for the responses
+
+ if ( anchor != NULL ) stem_to_long(traceid, stem, "OR.0", &count) ;
+ if ( count > 0 )
+   {
+    ors = (MQOR *) recs_from_stem(traceid, anchor, or_fields, sizeof(MQOR),
+                                  &or_default, stem, "OR", count, ALLFIELDS) ;
+    rrs = rr_new(anchor, count)                                      ;
+    if ( (ors != NULL) && (rrs != NULL) )
+      {
+       if ( od->Version < MQOD_VERSION_2 ) od->Version = MQOD_VERSION_2 ;
+       od->RecsPresent       = count                                 ;
+       od->ObjectRecOffset   = 0                                     ;
+       od->ResponseRecOffset = 0                                     ;
+       od->ObjectRecPtr      = ors                                   ;
+       od->ResponseRecPtr    = rrs                                   ;
+      }
+    else TRACE(traceid, ("No storage for %"PRId32" records\n",(int32_t)count) ) ;
+   }
+
+ DUMPCB(traceid, od )                             ;
+ TRACE(traceid, ("Leaving make_od_from_stem\n") ) ;
+
+ return ;
+} // End of make_od_from_stem function
+
+//
+// make_stem_from_od will return an Object Descriptor as the
+//                   contents of a Stem Variable:
+//
+//                     .VER  -> Version
+//                     .OT   -> ObjectType
+//                     .ON   -> ObjectName
+//                     .OQM  -> ObjectQMgrName
+//                     .DQN  -> DynamicQueue
+//                     .AUID -> AlternateUserId
+//                     .RP   -> RecsPresent
+//                     .KDC  -> KnownDestCount
+//                     .UDC  -> UnknownDestCount
+//                     .IDC  -> InvalidDestCount
+//                     .ORO  -> ObjectRecOffset (not implemented)
+//                     .RRO  -> ResponseRecOffset (not implemented)
+//                     .ORP  -> ObjectRecPtr (not set)
+//                     .RRP  -> ResponseRecPtr (to .RR.i, see below)
+//                     .ASID -> AlternateSecurityId (Windows only)
+//                     .RQN  -> ResolvedQName
+//                     .RQMN -> ResolvedQMgrName
+//                     .OS   -> ObjectString
+//                     .SS   -> SelectionString
+//                     .ROS  -> ResObjectString
+//                     .RT   -> ResolvedType
+//
+//                     .ZLIST -> 'VER OT ON OQM DQN AUID
+//                                RP
+//                                KDC UDC IDC
+//                                ASID
+//                                RQN RQMN
+//                                OS. SS. ROS. RT
+//
+
+void make_stem_from_od ( MQULONG    traceid      // trace id of caller
+                       , MQOD     * od           // source object descriptor
+                       , RXSTRING   stem         // name of stem variable
+                       , MQULONG    mask         // fields wanted (ALLFIELDS)
+                       )
+{
+ TRACE(traceid, ("Entering make_stem_from_od\n") ) ;
+ DUMPCB(traceid, od )                              ;
+
+ // All versions of MQOD, see od_fields
+ stem_from_fields(traceid, od_fields, od, stem, mask)    ;
+
+ TRACE(traceid, ("Leaving make_stem_from_od\n") ) ;
+
+ return ;
+} // End of make_stem_from_od function
+
+static RXMQFLD po_fields[] = {
+ // Version 1 of MQPMO
+ { "VER" , FLD_LONG  , offsetof(MQPMO, Version)           , sizeof(MQLONG)   },
+ { "OPT" , FLD_LONG  , offsetof(MQPMO, Options)           , sizeof(MQLONG)   },
+ { "TIME", FLD_LONG  , offsetof(MQPMO, Timeout)           , sizeof(MQLONG)   },
+ { "CON" , FLD_LONG  , offsetof(MQPMO, Context)           , sizeof(MQLONG)   },
+ { "KDC" , FLD_LONG  , offsetof(MQPMO, KnownDestCount)    , sizeof(MQLONG)   },
+ { "UDC" , FLD_LONG  , offsetof(MQPMO, UnknownDestCount)  , sizeof(MQLONG)   },
+ { "IDC" , FLD_LONG  , offsetof(MQPMO, InvalidDestCount)  , sizeof(MQLONG)   },
+ { "RQN" , FLD_STRING, offsetof(MQPMO, ResolvedQName)     , sizeof(MQCHAR48) },
+ { "RQMN", FLD_STRING, offsetof(MQPMO, ResolvedQMgrName)  , sizeof(MQCHAR48) },
+ // Version 2 of MQPMO
+ { "RP"  , FLD_LONG  , offsetof(MQPMO, RecsPresent)       , sizeof(MQLONG)   },
+ { "PMRF", FLD_LONG  , offsetof(MQPMO, PutMsgRecFields)   , sizeof(MQLONG)   },
+ // Version 3 of MQPMO
+ { "OMH" , FLD_INT64 , offsetof(MQPMO, OriginalMsgHandle) , sizeof(MQINT64)  },
+ { "NMH" , FLD_INT64 , offsetof(MQPMO, NewMsgHandle)      , sizeof(MQINT64)  },
+ { "ACT" , FLD_LONG  , offsetof(MQPMO, Action)            , sizeof(MQLONG)   },
+ { "PL"  , FLD_LONG  , offsetof(MQPMO, PubLevel)          , sizeof(MQLONG)   },
+ { "?"   , 0         , 0                                  , 0                }
+ } ;
+
+//
+// make_po_from_stem will return a Put Message Options Desc from the
+//                   contents of a Stem Variable:
+//
+//                     .VER  -> Version
+//                     .OPT  -> Options
+//                     .TIME -> Timeout
+//                     .CON  -> Context
+//                     .KDC  -> KnownDestCount (output only)
+//                     .UDC  -> UnKnownDestCount (output only)
+//                     .IDC  -> InvalidDestCount (output only)
+//                     .RQN  -> ResolvedQName (output only)
+//                     .RQMN -> ResolvedQMgrName (output only)
+//                     .RP   -> RecsPresent (set for a distribution list)
+//                     .PMRF -> PutMsgRecFields
+//                     .PMRO -> PutMsgRecOffset (not implemented)
+//                     .RRO  -> ResponseRecOffset (not implemented)
+//                     .PMRP -> PutMsgRecPtr (from .PMR.i, see below)
+//                     .RRP  -> ResponseRecPtr (to .RR.i, see below)
+//                     .OMH  -> OriginalMsgHandle
+//                     .NMH  -> NewMsgHandle
+//                     .ACT  -> Action
+//                     .PL   -> PubLevel
+//
+
+void make_po_from_stem ( MQULONG    traceid      // trace id of caller
+                       , MQPMO    * pmo          // target PMO
+                       , RXSTRING   stem         // name of stem variable
+                       )
+{
+ TRACE(traceid, ("Entering make_po_from_stem\n") ) ;
+
+ memcpy(pmo, &pmo_default, sizeof(MQPMO))      ;
+
+ // All versions of MQPMO, see po_fields
+ stem_to_fields(traceid, NULL, po_fields, pmo, stem, ALLFIELDS) ;
+
+ DUMPCB(traceid, pmo ) ;
+ TRACE(traceid, ("Leaving make_po_from_stem\n") ) ;
+
+ return ;
+} // End of make_po_from_stem function
+
+//
+// make_stem_from_po will return a Put Message Options Desc as the
+//                   contents of a Stem Variable:
+//
+//                     .VER  -> Version
+//                     .OPT  -> Options
+//                     .TIME -> Timeout
+//                     .CON  -> Context
+//                     .KDC  -> KnownDestCount
+//                     .UDC  -> UnKnownDestCount
+//                     .IDC  -> InvalidDestCount
+//                     .RQN  -> ResolvedQName
+//                     .RQMN -> ResolvedQMgrName
+//                     .RP   -> RecsPresent
+//                     .PMRF -> PutMsgRecFields
+//                     .PMRO -> PutMsgRecOffset (not implemented)
+//                     .RRO  -> ResponseRecOffset (not implemented)
+//                     .PMRP -> PutMsgRecPtr (not set)
+//                     .RRP  -> ResponseRecPtr (to .RR.i, see below)
+//                     .OMH  -> OriginalMsgHandle
+//                     .NMH  -> NewMsgHandle
+//                     .ACT  -> Action
+//                     .PL   -> PubLevel
+//
+//                     .ZLIST -> 'VER OPT CON CON TIME KDC UDC IDC RQN RQMN
+//                                RP PMRF OMH NMH ACT PL'
+//
+
+void make_stem_from_po ( MQULONG    traceid      // trace id of caller
+                       , MQPMO    * pmo          // source PMO
+                       , RXSTRING   stem         // name of stem variable
+                       , MQULONG    mask         // fields wanted (ALLFIELDS)
+                       )
+{
+ TRACE(traceid, ("Entering make_stem_from_po\n") ) ;
+ DUMPCB(traceid,  pmo )                            ;
+
+ // All versions of MQPMO, see po_fields
+ stem_from_fields(traceid, po_fields, pmo, stem, mask)   ;
+
+ TRACE(traceid,  ("Leaving make_stem_from_po\n") ) ;
+
+ return ;
+} // End of make_stem_from_po function
+
+static RXMQFLD go_fields[] = {
+ // Version 1 of MQGMO
+ { "VER" , FLD_LONG  , offsetof(MQGMO, Version)           , sizeof(MQLONG)   },
+ { "OPT" , FLD_LONG  , offsetof(MQGMO, Options)           , sizeof(MQLONG)   },
+ { "WAIT", FLD_LONG  , offsetof(MQGMO, WaitInterval)      , sizeof(MQLONG)   },
+ { "RQN" , FLD_STRING, offsetof(MQGMO, ResolvedQName)     , sizeof(MQCHAR48) },
+ // Version 2 of MQGMO
+ { "MOPT", FLD_LONG  , offsetof(MQGMO, MatchOptions)      , sizeof(MQLONG)   },
+ { "GS"  , FLD_CHAR  , offsetof(MQGMO, GroupStatus)       , sizeof(MQCHAR)   },
+ { "SS"  , FLD_CHAR  , offsetof(MQGMO, SegmentStatus)     , sizeof(MQCHAR)   },
+ { "SEG" , FLD_CHAR  , offsetof(MQGMO, Segmentation)      , sizeof(MQCHAR)   },
+ // Version 3 of MQGMO
+ { "MT"  , FLD_BYTES , offsetof(MQGMO, MsgToken)          , sizeof(MQBYTE16) },
+ { "RL"  , FLD_LONG  , offsetof(MQGMO, ReturnedLength)    , sizeof(MQLONG)   },
+ // Version 4 of MQGMO
+ { "MH"  , FLD_INT64 , offsetof(MQGMO, MsgHandle)         , sizeof(MQINT64)  },
+ { "?"   , 0         , 0                                  , 0                }
+ } ;
+
+//
+// make_go_from_stem will return a Get Message Options Desc from the
+//                   contents of a Stem Variable:
+//
+//                     .VER   -> Version
+//                     .OPT   -> Options
+//                     .WAIT  -> WaitInterval
+//                     .RQN   -> ResolvedQueueName (output only)
+//                     .MOPT  -> MatchOptions
+//                     .GS    -> GroupStatus (output only)
+//                     .SS    -> SegmentStatus (output only)
+//                     .SEG   -> Segmentation (output only)
+//                     .MT    -> MsgToken
+//                     .RL    -> ReturnedLength (output only)
+//                     .MH    -> MsgHandle
+//
+
+void make_go_from_stem ( MQULONG    traceid      // trace id of caller
+                       , MQGMO    * gmo          // target GMO
+                       , RXSTRING   stem         // name of stem variable
+                       )
+{
+ TRACE(traceid, ("Entering make_go_from_stem\n") ) ;
+
+ memcpy(gmo, &gmo_default, sizeof(MQGMO))      ;
+
+ // All versions of MQGMO, see go_fields
+ stem_to_fields(traceid, NULL, go_fields, gmo, stem, ALLFIELDS) ;
+
+ DUMPCB(traceid,  gmo ) ;
+ TRACE(traceid, ("Leaving make_go_from_stem\n") ) ;
+
+ return ;
+} // End of make_go_from_stem function
+
+//
+// make_stem_from_go will return a Get Message Options Desc as the
+//                   contents of a Stem Variable:
+//
+//                     .VER   -> Version
+//                     .OPT   -> Options
+//                     .WAIT  -> WaitInterval
+//                     .RQN   -> ResolvedQueueName
+//                     .MOPT  -> MatchOptions
+//                     .GS    -> GroupStatus
+//                     .SS    -> SegmentStatus
+//                     .SEG   -> Segmentation
+//                     .MT    -> sgToken
+//                     .RL    -> ReturnedLength
+//                     .MH    -> MsgHandle
+//                     .ZLIST -> 'VER OPT WAIT RQN
+//                                MOPT GS SS SEG
+//                                MT RL MH'
+//
+
+void make_stem_from_go ( MQULONG    traceid      // trace id of caller
+                       , MQGMO    * gmo          // source GMO
+                       , RXSTRING   stem         // name of stem variable
+                       , MQULONG    mask         // fields wanted (ALLFIELDS)
+                       )
+{
+ TRACE(traceid, ("Entering make_stem_from_go\n") ) ;
+ DUMPCB(traceid,  gmo )                            ;
+
+ // All versions of MQGMO, see go_fields
+ stem_from_fields(traceid, go_fields, gmo, stem, mask)   ;
+
+ TRACE(traceid, ("Leaving make_stem_from_go\n") ) ;
+
+ return ;
+} // End of make_stem_from_go function
+
+static RXMQFLD md_fields[] = {
+ // Version 1 of MQMD
+ { "VER"  , FLD_LONG  , offsetof(MQMD2, Version)          , sizeof(MQLONG)   },
+ { "REP"  , FLD_LONG  , offsetof(MQMD2, Report)           , sizeof(MQLONG)   },
+ { "MSG"  , FLD_LONG  , offsetof(MQMD2, MsgType)          , sizeof(MQLONG)   },
+ { "EXP"  , FLD_LONG  , offsetof(MQMD2, Expiry)           , sizeof(MQLONG)   },
+ { "FBK"  , FLD_LONG  , offsetof(MQMD2, Feedback)         , sizeof(MQLONG)   },
+ { "ENC"  , FLD_LONG  , offsetof(MQMD2, Encoding)         , sizeof(MQLONG)   },
+ { "CCSI" , FLD_LONG  , offsetof(MQMD2, CodedCharSetId)   , sizeof(MQLONG)   },
+ { "FORM" , FLD_STRING, offsetof(MQMD2, Format)           , sizeof(MQCHAR8)  },
+ { "PRI"  , FLD_LONG  , offsetof(MQMD2, Priority)         , sizeof(MQLONG)   },
+ { "PER"  , FLD_LONG  , offsetof(MQMD2, Persistence)      , sizeof(MQLONG)   },
+ { "MSGID", FLD_BYTES , offsetof(MQMD2, MsgId)            , sizeof(MQBYTE24) },
+ { "CID"  , FLD_BYTES , offsetof(MQMD2, CorrelId)         , sizeof(MQBYTE24) },
+ { "BC"   , FLD_LONG  , offsetof(MQMD2, BackoutCount)     , sizeof(MQLONG)   },
+ { "RTOQ" , FLD_STRING, offsetof(MQMD2, ReplyToQ)         , sizeof(MQCHAR48) },
+ { "RTOQM", FLD_STRING, offsetof(MQMD2, ReplyToQMgr)      , sizeof(MQCHAR48) },
+ { "UID"  , FLD_STRING, offsetof(MQMD2, UserIdentifier)   , sizeof(MQCHAR12) },
+ { "AT"   , FLD_BYTES , offsetof(MQMD2, AccountingToken)  , sizeof(MQBYTE32) },
+ { "AID"  , FLD_STRING, offsetof(MQMD2, ApplIdentityData) , sizeof(MQCHAR32) },
+ { "PAT"  , FLD_LONG  , offsetof(MQMD2, PutApplType)      , sizeof(MQLONG)   },
+ { "PAN"  , FLD_STRING, offsetof(MQMD2, PutApplName)      , sizeof(MQCHAR28) },
+ { "PD"   , FLD_STRING, offsetof(MQMD2, PutDate)          , sizeof(MQCHAR8)  },
+ { "PT"   , FLD_STRING, offsetof(MQMD2, PutTime)          , sizeof(MQCHAR8)  },
+ { "AOD"  , FLD_STRING, offsetof(MQMD2, ApplOriginData)   , sizeof(MQCHAR4)  },
+ // Version 2 of MQMD
+ { "GID"  , FLD_BYTES , offsetof(MQMD2, GroupId)          , sizeof(MQBYTE24) },
+ { "MSN"  , FLD_LONG  , offsetof(MQMD2, MsgSeqNumber)     , sizeof(MQLONG)   },
+ { "OFF"  , FLD_LONG  , offsetof(MQMD2, Offset)           , sizeof(MQLONG)   },
+ { "MF"   , FLD_LONG  , offsetof(MQMD2, MsgFlags)         , sizeof(MQLONG)   },
+ { "OL"   , FLD_LONG  , offsetof(MQMD2, OriginalLength)   , sizeof(MQLONG)   },
+ { "?"    , 0         , 0                                 , 0                }
+ } ;
+
+//
+// make_md_from_stem will return a Put Message Options Desc from the
+//                   contents of a Stem Variable:
+//
+//                     .VER   -> Version
+//                     .REP   -> Report
+//                     .MSG   -> MsgType
+//                     .EXP   -> Expiry
+//                     .FBK   -> Feedback
+//                     .ENC   -> Encoding
+//                     .CCSI  -> CodedCharSetId
+//                     .FORM  -> Format
+//                     .PRI   -> Priority
+//                     .PER   -> Persistence
+//                     .MSGID -> MsgId
+//                     .CID   -> CorrelId
+//                     .BC    -> BackoutCount
+//                     .RTOQ  -> ReplyToQ
+//                     .RTOQM -> ReplyToQMgr
+//                     .UID   -> UserIdentifier
+//                     .AT    -> AccountingToken
+//                     .AID   -> ApplyIdentityData
+//                     .PAT   -> PutApplType
+//                     .PAN   -> PutApplName
+//                     .PD    -> PutDate
+//                     .PT    -> PutTime
+//                     .AOD   -> ApplOriginData
+//                     .GID   -> GroupId
+//                     .MSN   -> MsgSeqNumber
+//                     .OFF   -> Offset
+//                     .MF    -> MsgFlags
+//                     .OL    -> OriginalLength
+//
+//
+
+void make_md_from_stem ( MQULONG    traceid      // trace id of caller
+                       , MQMD2    * md           // target message descriptor
+                       , RXSTRING   stem         // name of stem variable
+                       )
+{
+ TRACE(traceid, ("Entering make_md_from_stem\n") ) ;
+
+ memcpy(md, &md_default, sizeof(MQMD2))        ;
+ md->Version = MQMD_VERSION_1                  ;
+
+ // All versions of MQMD, see md_fields
+ stem_to_fields(traceid, NULL, md_fields, md, stem, ALLFIELDS) ;
+
+ DUMPCB(traceid,  md ) ;
+ TRACE(traceid, ("Leaving make_md_from_stem\n") ) ;
+
+ return ;
+} // End of make_md_from_stem function
+
+//
+// make_stem_from_md will return a Message Descriptor as the
+//                   contents of a Stem Variable:
+//
+//                     .VER   -> Version
+//                     .REP   -> Report
+//                     .MSG   -> MsgType
+//                     .EXP   -> Expiry
+//                     .FBK   -> Feedback
+//                     .ENC   -> Encoding
+//                     .CCSI  -> CodedCharSetId
+//                     .FORM  -> Format
+//                     .PRI   -> Priority
+//                     .PER   -> Persistence
+//                     .MSGID -> MsgId
+//                     .CID   -> CorrelId
+//                     .BC    -> BackoutCount
+//                     .RTOQ  -> ReplyToQ
+//                     .RTOQM -> ReplyToQMgr
+//                     .UID   -> UserIdentifier
+//                     .AT    -> AccountingToken
+//                     .AID   -> ApplyIdentityData
+//                     .PAT   -> PutApplType
+//                     .PAN   -> PutApplName
+//                     .PD    -> PutDate
+//                     .PT    -> PutTime
+//                     .AOD   -> ApplOriginData
+//                     .GID   -> GroupId
+//                     .MSN   -> MsgSeqNumber
+//                     .OFF   -> Offset
+//                     .MF    -> MsgFlags
+//                     .OL    -> OriginalLength
+//
+//
+//                     .ZLIST -> 'VER REP MSG EXP FBK ENC CCSI FORM PRI PER MSGID CID BC
+//                                RTOQ RTOQM UID AT AID PAT PAN PD PT AOD
+//                                GID MSN OFF MF OL
+//
+//
+
+void make_stem_from_md ( MQULONG    traceid      // trace id of caller
+                       , MQMD2    * md           // source message descriptor
+                       , RXSTRING   stem         // name of stem variable
+                       , MQULONG    mask         // fields wanted (ALLFIELDS)
+                       )
+{
+ TRACE(traceid, ("Entering make_stem_from_md\n") ) ;
+ DUMPCB(traceid,  md )                             ;
+
+ // All versions of MQMD, see md_fields
+ stem_from_fields(traceid, md_fields, md, stem, mask)    ;
+
+ TRACE(traceid, ("Leaving make_stem_from_md\n") ) ;
+
+ return ;
+} // End of make_stem_from_md function
+
+static RXMQFLD sd_fields[] = {
+ // Version 1 of MQSD
+ { "VER" , FLD_LONG  , offsetof(MQSD, Version)             , sizeof(MQLONG)   },
+ { "OPT" , FLD_LONG  , offsetof(MQSD, Options)             , sizeof(MQLONG)   },
+ { "ON"  , FLD_STRING, offsetof(MQSD, ObjectName)          , sizeof(MQCHAR48) },
+ { "AUID", FLD_STRING, offsetof(MQSD, AlternateUserId)     , sizeof(MQCHAR12) },
+ { "ASID", FLD_BYTES , offsetof(MQSD, AlternateSecurityId) , sizeof(MQBYTE40) },
+ { "SE"  , FLD_LONG  , offsetof(MQSD, SubExpiry)           , sizeof(MQLONG)   },
+ { "OS"  , FLD_STRINV, offsetof(MQSD, ObjectString)        , sizeof(MQCHARV)  },
+ { "SN"  , FLD_STRINV, offsetof(MQSD, SubName)             , sizeof(MQCHARV)  },
+ { "SUD" , FLD_STRINV, offsetof(MQSD, SubUserData)         , sizeof(MQCHARV)  },
+ { "SCID", FLD_BYTES , offsetof(MQSD, SubCorrelId)         , sizeof(MQBYTE24) },
+ { "PP"  , FLD_LONG  , offsetof(MQSD, PubPriority)         , sizeof(MQLONG)   },
+ { "PAT" , FLD_BYTES , offsetof(MQSD, PubAccountingToken)  , sizeof(MQBYTE32) },
+ { "PAID", FLD_STRING, offsetof(MQSD, PubApplIdentityData) , sizeof(MQCHAR32) },
+ { "SS"  , FLD_STRINV, offsetof(MQSD, SelectionString)     , sizeof(MQCHARV)  },
+ { "SL"  , FLD_LONG  , offsetof(MQSD, SubLevel)            , sizeof(MQLONG)   },
+ { "ROS" , FLD_STRINV, offsetof(MQSD, ResObjectString)     , sizeof(MQCHARV)  },
+ { "?"   , 0         , 0                                   , 0                }
+ } ;
+
+//
+// make_sd_from_stem will return a Subscription Descriptor from the
+//                   contents of a Stem Variable:
+//
+//                     .VER  -> Version
+//                     .OPT  -> Options
+//                     .ON   -> ObjectName
+//                     .AUID -> AlternateUserId
+//                     .ASID -> AlternateSecurityId
+//                     .SE   -> SubExpiry
+//                     .OS   -> ObjectString
+//                     .SN   -> SubName
+//                     .SUD  -> SubUserData
+//                     .SCID -> SubCorrelId
+//                     .PP   -> PubPriority
+//                     .PAT  -> PubAccountingToken
+//                     .PAID -> PubAppIdentityData
+//                     .SS   -> SelectionString
+//                     .SL   -> SubLevel
+//                     .ROS  -> ResObjectString
+//
+
+void make_sd_from_stem ( MQULONG    traceid      // trace id of caller
+                       , RXMQCB   * anchor       // arena owner (NULL: malloc)
+                       , MQSD     * subdesc      // target MQSD
+                       , RXSTRING   stem         // name of stem variable
+                       )
+{
+ TRACE(traceid, ("Entering make_sd_from_stem") ) ;
+
+ memcpy(subdesc, &sd_default, sizeof(MQSD));
+
+ //The given variable is a stem. variable, so get its contents
+
+ // All versions of MQSD, see sd_fields
+ stem_to_fields(traceid, anchor, sd_fields, subdesc, stem, ALLFIELDS) ;
+
+ DUMPCB(traceid, subdesc) ;
+ TRACE(traceid, ("Leaving make_sd_from_stem\n") ) ;
+
+ return ;
+} // End of make_sd_from_stem function
+
+//
+// make_stem_from_sd will return a Subscription Descriptor as the
+//                   contents of a Stem Variable:
+//
+//                     .VER  -> Version
+//                     .OPT  -> Options
+//                     .ON   -> ObjectName
+//                     .AUID -> AlternateUserId
+//                     .ASID -> AlternateSecurityId
+//                     .SE   -> SubExpiry
+//                     .OS   -> ObjectString
+//                     .SN   -> SubName
+//                     .SUD  -> SubUserData
+//                     .SCID -> SubCorrelId
+//                     .PP   -> PubPriority
+//                     .PAT  -> PubAccountingToken
+//                     .PAID -> PubAppIdentityData
+//                     .SS   -> SelectionString
+//                     .SL   -> SubLevel
+//                     .ROS  -> ResObjectString
+//
+//                     .ZLIST -> 'VER OPT ON AUID ASID
+//                                SE OS. SN. SUD. SCID
+//                                PP PAT PAID
+//                                SS. SL ROS.
+//
+
+void make_stem_from_sd ( MQULONG    traceid      // trace id of caller
+                       , MQSD     * subdesc      // source MQSD
+                       , RXSTRING   stem         // name of stem variable
+                       , MQULONG    mask         // fields wanted (ALLFIELDS)
+                       )
+{
+ TRACE(traceid, ("Entering make_stem_from_sd\n") ) ;
+ DUMPCB(traceid, subdesc)                          ;
+
+ // All versions of MQSD, see sd_fields
+ stem_from_fields(traceid, sd_fields, subdesc, stem, mask) ;
+
+ TRACE(traceid, ("Leaving make_stem_from_sd\n") ) ;
+
+ return ;
+} // End of make_stem_from_sd function
+
+static RXMQFLD cno_fields[] = {
+ // Version 1 of MQCNO
+ { "VER" , FLD_LONG  , offsetof(MQCNO, Version)           , sizeof(MQLONG)   },
+ { "OPT" , FLD_LONG  , offsetof(MQCNO, Options)           , sizeof(MQLONG)   },
+ // Version 3 of MQCNO
+ { "CTAG", FLD_BYTES , offsetof(MQCNO, ConnTag)           , 128              },
+ // Version 5 of MQCNO
+ { "CID" , FLD_BYTES , offsetof(MQCNO, ConnectionId)      , sizeof(MQBYTE24) },
+ // Version 7 of MQCNO
+ { "APPL", FLD_STRING, offsetof(MQCNO, ApplName)          , sizeof(MQCHAR28) },
+ { "?"   , 0         , 0                                  , 0                }
+ } ;
+
+//
+// make_cno_from_stem will return Connect Options from the contents
+//                    of a Stem Variable:
+//
+//                     .VER  -> Version (5 if not given)
+//                     .OPT  -> Options
+//                     .CTAG -> ConnTag (z/OS only)
+//                     .CID  -> ConnectionId (output only)
+//                     .APPL -> ApplName (Version 7)
+//
+
+void make_cno_from_stem ( MQULONG    traceid      // trace id of caller
+                        , RXMQCB   * anchor       // arena owner (NULL: malloc)
+                        , MQCNO    * cno          // target MQCNO
+                        , RXSTRING   stem         // name of stem variable
+                        )
+{
+ TRACE(traceid, ("Entering make_cno_from_stem\n") ) ;
+
+ memcpy(cno, &cno_default, sizeof(MQCNO)) ;
+ cno->Version = MQCNO_VERSION_5           ; // So the ConnectionId is returned
+
+ // All versions of MQCNO, see cno_fields
+ stem_to_fields(traceid, anchor, cno_fields, cno, stem, ALLFIELDS) ;
+
+ DUMPCB(traceid, cno) ;
+ TRACE(traceid, ("Leaving make_cno_from_stem\n") ) ;
+
+ return ;
+} // End of make_cno_from_stem function
+
+//
+// make_stem_from_cno will return Connect Options as the contents
+//                    of a Stem Variable:
+//
+//                     .VER  -> Version
+//                     .OPT  -> Options
+//                     .CTAG -> ConnTag
+//                     .CID  -> ConnectionId
+//                     .APPL -> ApplName
+//
+//                     .ZLIST -> 'VER OPT CTAG CID APPL'
+//
+
+void make_stem_from_cno ( MQULONG    traceid      // trace id of caller
+                        , MQCNO    * cno          // source MQCNO
+                        , RXSTRING   stem         // name of stem variable
+                        , MQULONG    mask         // fields wanted (ALLFIELDS)
+                        )
+{
+ TRACE(traceid, ("Entering make_stem_from_cno\n") ) ;
+
+ // All versions of MQCNO, see cno_fields
+ stem_from_fields(traceid, cno_fields, cno, stem, mask) ;
+
+ TRACE(traceid, ("Leaving make_stem_from_cno\n") ) ;
+
+ return ;
+} // End of make_stem_from_cno function
+
+static RXMQFLD cd_fields[] = {
+ { "VER" , FLD_LONG  , offsetof(MQCD, Version)              , sizeof(MQLONG)    },
+ { "CHL" , FLD_STRING, offsetof(MQCD, ChannelName)          , sizeof(MQCHAR20)  },
+ { "TRAN", FLD_LONG  , offsetof(MQCD, TransportType)        , sizeof(MQLONG)    },
+ { "CONN", FLD_STRING, offsetof(MQCD, ConnectionName)       , sizeof(MQCHAR264) },
+ { "QM"  , FLD_STRING, offsetof(MQCD, QMgrName)             , sizeof(MQCHAR48)  },
+ { "MML" , FLD_LONG  , offsetof(MQCD, MaxMsgLength)         , sizeof(MQLONG)    },
+ { "HB"  , FLD_LONG  , offsetof(MQCD, HeartbeatInterval)    , sizeof(MQLONG)    },
+ { "KA"  , FLD_LONG  , offsetof(MQCD, KeepAliveInterval)    , sizeof(MQLONG)    },
+ { "SSLC", FLD_STRING, offsetof(MQCD, SSLCipherSpec)        , sizeof(MQCHAR32)  },
+ { "SCV" , FLD_LONG  , offsetof(MQCD, SharingConversations) , sizeof(MQLONG)    },
+ { "PC"  , FLD_LONG  , offsetof(MQCD, PropertyControl)      , sizeof(MQLONG)    },
+ { "RCN" , FLD_LONG  , offsetof(MQCD, DefReconnect)         , sizeof(MQLONG)    },
+ { "CERT", FLD_STRING, offsetof(MQCD, CertificateLabel)     , sizeof(MQCHAR64)  },
+ { "?"   , 0         , 0                                    , 0                 }
+ } ;
+
+//
+// make_cd_from_stem will return a client connection Channel
+//                   Definition from the contents of a Stem Variable:
+//
+//                     .VER  -> Version (current if not given)
+//                     .CHL  -> ChannelName
+//                     .TRAN -> TransportType
+//                     .CONN -> ConnectionName
+//                     .QM   -> QMgrName
+//                     .MML  -> MaxMsgLength
+//                     .HB   -> HeartbeatInterval
+//                     .KA   -> KeepAliveInterval
+//                     .SSLC -> SSLCipherSpec
+//                     .SCV  -> SharingConversations
+//                     .PC   -> PropertyControl
+//                     .RCN  -> DefReconnect
+//                     .CERT -> CertificateLabel
+//
+//   The ChannelType is always MQCHT_CLNTCONN. There is no output form.
+//
+
+void make_cd_from_stem ( MQULONG    traceid      // trace id of caller
+                       , RXMQCB   * anchor       // arena owner (NULL: malloc)
+                       , MQCD     * cd           // target MQCD
+                       , RXSTRING   stem         // name of stem variable
+                       )
+{
+ TRACE(traceid, ("Entering make_cd_from_stem\n") ) ;
+
+ memcpy(cd, &cd_default, sizeof(MQCD)) ;
+ cd->Version = MQCD_CURRENT_VERSION    ;
+
+ // All versions of MQCD, see cd_fields
+ stem_to_fields(traceid, anchor, cd_fields, cd, stem, ALLFIELDS) ;
+
+ TRACE(traceid, ("Channel %.20s to %.64s, SharingConversations %"PRId32"\n",
+       cd->ChannelName,cd->ConnectionName,(int32_t)cd->SharingConversations) ) ;
+ TRACE(traceid, ("Leaving make_cd_from_stem\n") ) ;
+
+ return ;
+} // End of make_cd_from_stem function
+
+//
+// Descriptor templates
+//
+//   RXMQDEF compiles a stem into one of the MQ structures below, and
+//   keeps it in the RXMQCB. Its token '&n' can then be given to
+//   RXMQOPEN, RXMQPUT, RXMQPUT1, RXMQGET and RXMQSUB instead of the
+//   name of the input stem, so that no REXX variables are read:
+//
+//        '&n'                    -> the template as is
+//        '&n stem.'              -> overridden by all fields set in stem.
+//        '&n stem. mn mn ...'    -> overridden by only these fields
+//
+//   A template may also carry the list of fields wanted in the output
+//   stem of the same descriptor, used when the call gives no list.
+//
+ #define TMPL_OD   1
+ #define TMPL_MD   2
+ #define TMPL_PMO  3
+ #define TMPL_GMO  4
+ #define TMPL_SD   5
+
+ #define ISTMPL(r) ( ((r).strlength > 0) && ((r).strptr[0] == '&') )
+
+ typedef struct _TMPLTYPE {
+     char     * name     ; // RXMQDEF type
+     PRXMQFLD   fields   ; // Field table
+     size_t     size     ; // Size of the MQ structure
+ } TMPLTYPE              ;
+
+ static TMPLTYPE tmpltypes[] = {
+     { ""   , NULL      , 0             } , // Free slot
+     { "OD" , od_fields , sizeof(MQOD)  } , // TMPL_OD
+     { "MD" , md_fields , sizeof(MQMD2) } , // TMPL_MD
+     { "PMO", po_fields , sizeof(MQPMO) } , // TMPL_PMO
+     { "GMO", go_fields , sizeof(MQGMO) } , // TMPL_GMO
+     { "SD" , sd_fields , sizeof(MQSD)  } , // TMPL_SD
+     { "?"  , NULL      , 0             } } ;
+
+//
+// tmpl_to_cb - build an MQ structure from a template token (see above)
+//              and return the template's output field mask.
+//              Returns 0, or -1 if the token is not a template of this
+//              type or names an unknown field.
+//
+MQLONG tmpl_to_cb ( MQULONG    traceid      // trace id of caller
+                  , RXMQCB   * anchor       // RXMQ Control Block
+                  , MQLONG     type         // TMPL_xx wanted
+                  , RXSTRING   token        // '&n [stem. [mnemonics]]'
+                  , void     * cb           // target structure
+                  , MQULONG  * outmask      // output fields wanted
+                  )
+{
+ TMPLTYPE              * tt = &tmpltypes[type] ; // Template type
+ RXSTRING                stem             ;  // Override stem
+ MQULONG                 mask = ALLFIELDS ;  // Override fields
+ size_t                  i    = 1         ;  // Position in token
+ size_t                  n    = 0         ;  // Template number
+
+ while ( (i < token.strlength) && isdigit((unsigned char)token.strptr[i]) )
+    n = n * 10 + (token.strptr[i++] - '0') ;
+
+ if (    (i == 1) || (n >= MAXTMPL)
+      || (anchor->Tmpl[n].type != type) )
+   {
+    TRACE(traceid, ("Bad %s template %.*s\n", tt->name,
+                    (int)token.strlength, token.strptr) ) ;
+    return -1 ;
+   }
+
+ TRACE(traceid, ("Using %s template %u\n", tt->name, (unsigned int)n) ) ;
+ memcpy(cb, anchor->Tmpl[n].cb, tt->size) ;
+ fields_dup(anchor, tt->fields, cb)       ;
+ *outmask = anchor->Tmpl[n].outmask       ;
+
+ //
+ // Any overrides for this call only ?
+ //
+ while ( (i < token.strlength) && (token.strptr[i] == ' ') ) i++ ;
+ if ( i == token.strlength ) return 0 ;
+
+ stem.strptr = token.strptr + i ;
+ while ( (i < token.strlength) && (token.strptr[i] != ' ') ) i++ ;
+ stem.strlength = token.strptr + i - stem.strptr ;
+
+ if (    (i < token.strlength)
+      && fields_to_mask(tt->fields, token.strptr + i, token.strlength - i, &mask) )
+    return -1 ;
+
+ stem_to_fields(traceid, anchor, tt->fields, cb, stem, mask) ;
+
+ return 0 ;
+} // End of tmpl_to_cb
+
+//
+// tmpl_free - release a template slot
+//
+void tmpl_free ( RXMQCB   * anchor       // RXMQ Control Block
+               , int        n            // Template number
+               )
+{
+ if ( anchor->Tmpl[n].type == 0 ) return ;
+
+ fields_free(tmpltypes[anchor->Tmpl[n].type].fields, anchor->Tmpl[n].cb) ;
+ free(anchor->Tmpl[n].cb) ;
+ anchor->Tmpl[n].cb   = NULL ;
+ anchor->Tmpl[n].type = 0    ;
+
+ return ;
+} // End of tmpl_free
+
+//
+// out_mask - split an output argument 'stem. [mnemonics]' into the stem
+//            name and the field mask. The mask is left as it is when no
+//            mnemonics are given, and an omitted argument stays a null
+//            string (so nothing is set).
+//            Returns 0, or -1 if a mnemonic is unknown.
+//
+MQLONG out_mask ( PRXMQFLD   fields       // field table
+                , PRXSTRING  arg          // output argument
+                , MQULONG  * mask         // output fields wanted
+                )
+{
+ size_t                  i = 0            ;  // End of stem name
+ size_t                  j                ;  // Start of mnemonics
+
+ if ( RXNULLSTRING(*arg) ) return 0 ;
+
+ while ( (i < arg->strlength) && (arg->strptr[i] != ' ') ) i++ ;
+ for ( j = i ; (j < arg->strlength) && (arg->strptr[j] == ' ') ; j++ ) ;
+
+ if ( j < arg->strlength )
+   {
+    if ( fields_to_mask(fields, arg->strptr + j, arg->strlength - j, mask) ) return -1 ;
+   }
+ arg->strlength = i ;
+
+ return 0 ;
+} // End of out_mask
+
+
+//
+// Genuine Internal functions, not concerned with specific things
+//
+
+//
+// setcons - sets up the MQ constants in the Rexx Variable Space
+//           Traced by INIT setting
+//
+
+void setcons (MQULONG traceid)
+ {
+
+//
+// Structure to define MQ literals, to be setup in Variable Space
+//
+
+ struct s_define_mq_ints
+        {
+          char           s_define_mq_ints_name[255] ; // Constant name
+          int32_t        s_define_mq_ints_value     ; // Constant value
+          uint32_t       s_define_mq_ints_type      ; // 0 -> number
+                                                      // 1 -> MQRC_
+                                                      // 2 -> not used
+                                                      // 3 -> MQCC_
+                                                      // 4 -> MQCA_
+        } ;
+
+ typedef struct s_define_mq_ints   t_define_mq_ints ;
+ typedef        t_define_mq_ints * p_define_mq_ints ;
+
+ struct s_define_mq_str
+        {
+          char           s_define_mq_str_name[32]   ;  // 32 seems to be max
+          char           s_define_mq_str_value[9]   ;  // 8 is biggest so far
+          MQULONG        s_define_mq_str_type       ;  // 0 -> char
+        } ;
+
+ typedef struct s_define_mq_str   t_define_mq_str  ;
+ typedef        t_define_mq_str * p_define_mq_str  ;
+
+ struct s_define_mq_byte
+        {
+          char           s_define_mq_byte_name[32]  ;  // 32 seems to be max
+          MQBYTE         s_define_mq_byte_value[33] ;  // 33 is biggest so far
+          MQULONG        s_define_mq_byte_size      ;
+        } ;
+
+ typedef struct s_define_mq_byte   t_define_mq_byte ;
+ typedef        t_define_mq_byte * p_define_mq_byte ;
+
+ struct s_define_mq_char
+        {
+          char           s_define_mq_char_name[32]  ;  // 32 seems to be max
+          char           s_define_mq_char_value     ;  // 1-byte char
+          MQULONG        s_define_mq_char_type      ;  // 0 -> char
+        } ;
+
+ typedef struct s_define_mq_char   t_define_mq_char ;
+ typedef        t_define_mq_char * p_define_mq_char ;
+
+ //
+ //  Usual local variables
+ //
+
+ MQULONG                  i                ;  // Looper
+ p_define_mq_ints         pi               ;  // Table pointer
+ p_define_mq_str          ps               ;  // Table pointer
+ p_define_mq_byte         pb               ;  // Table pointer
+ p_define_mq_char         pc               ;  // Table pointer
+ RXSTRING                 varname          ;  // Variable name
+ RXSTRING                 varname_new      ;  // Variable name
+ RXSTRING                 varname_old      ;  // Variable name
+ char                     varvalc[100]     ;  // Char version of variable
+ SHVCHAIN                 chain            ;  // Variable pool chain
+
+//
+// Array and Structure to define MQ literals, to be setup in Variable Space
+// Constants are placed in separate header file for ease of use
+//
+
+#include <rxmqcons.h>
+
+ TRACE(traceid, ("Entering setcons\n") ) ;
+
+ //
+ // initialize all the constants required.
+ //
+ // This is done by looping through the table of names and
+ //      settings, adding each literal to a chain of variable pool
+ //      requests that is passed to the RexxVariable interface
+ //      whenever it is full, rather than once per literal.
+ //
+ // Additionally, if the constant represents Completion Code (MQCC_)
+ //               then create an number->name entry in the
+ //               RXMQ.CCMAP. stem variable
+ //
+ // Additionally, if the constant represents Reason Code (MQRC_)
+ //               then create an number->name entry in the
+ //               RXMQ.RCMAP. stem variable
+ //
+ // Additionally, if the constant represents Event (MQCA_,...)
+ //               then create an number->name entry in the
+ //               RXMQ.CAMAP. stem variable
+ //
+
+ MAKERXSTRING(varname_new, "RXMQ.", sizeof("RXMQ.")-1)  ;
+ MAKERXSTRING(varname_old, PREFIX,  sizeof(PREFIX)-1)   ;
+ chain.count = 0                                        ;
+
+ for (i=0; ; i++)
+   {
+    pi = &define_mq_ints[i]                           ;
+    if ( pi->s_define_mq_ints_name[0] == '?' )  break ;
+    shv_flush(traceid, &chain, 3)                     ; // Most set for one
+
+    MAKERXSTRING(varname,
+                 &(pi->s_define_mq_ints_name[0]),
+                 strlen(pi->s_define_mq_ints_name))         ; // REXX variable name
+    shv_set_long(&chain, varname, "", NULL, pi->s_define_mq_ints_value) ;
+
+    if ( pi->s_define_mq_ints_type == 1 )    //Only for MQRC_ stuff
+     {
+      sprintf(varvalc, "RCMAP.%"PRId32, pi->s_define_mq_ints_value)   ;
+      shv_set(&chain, varname_new, varvalc, NULL,
+              &(pi->s_define_mq_ints_name[0]),
+              strlen(pi->s_define_mq_ints_name), 0)         ; // like RXMQ.RCMAP.value
+      shv_set(&chain, varname_old, varvalc, NULL,
+              &(pi->s_define_mq_ints_name[0]),
+              strlen(pi->s_define_mq_ints_name), 0)         ; // like RXMQV.RCMAP.value
+      }
+
+    if ( pi->s_define_mq_ints_type == 3 )    //Only for MQCC_ stuff
+     {
+      sprintf(varvalc, "CCMAP.%"PRId32, pi->s_define_mq_ints_value)   ;
+      shv_set(&chain, varname_new, varvalc, NULL,
+              &(pi->s_define_mq_ints_name[0]),
+              strlen(pi->s_define_mq_ints_name), 0)         ; // like RXMQ.CCMAP.value
+     }
+
+    if ( pi->s_define_mq_ints_type == 4 )    //Only for Selector/Event Attributes
+     {
+      sprintf(varvalc, "CAMAP.%"PRId32, pi->s_define_mq_ints_value)   ;
+
+      varname.strptr    = strstr(&(pi->s_define_mq_ints_name[0]), "_") + 1 ;
+      varname.strlength = strlen(varname.strptr)            ;
+
+      shv_set(&chain, varname_new, varvalc, NULL,
+              varname.strptr, varname.strlength, 0)         ; // like RXMQ.CAMAP.value
+     }
+   } // End of Integer initializations Loop
+
+ for (i=0; ; i++)
+   {
+    ps = &define_mq_str[i]                           ;
+    if ( ps->s_define_mq_str_name[0] == '?' ) break  ;
+    shv_flush(traceid, &chain, 1)                    ;
+
+    MAKERXSTRING(varname,
+                 &(ps->s_define_mq_str_name[0]),
+                 strlen(ps->s_define_mq_str_name))         ; // REXX variable name
+    shv_set(&chain, varname, "", NULL,
+            &(ps->s_define_mq_str_value[0]),
+            strlen(ps->s_define_mq_str_value), 0)          ;
+   } // End of String initializations Loop
+
+ for (i=0; ; i++)
+   {
+    pb = &define_mq_byte[i]                           ;
+    if ( pb->s_define_mq_byte_name[0] == '?' ) break  ;
+    shv_flush(traceid, &chain, 1)                     ;
+
+    MAKERXSTRING(varname,
+                 &(pb->s_define_mq_byte_name[0]),
+                 strlen(pb->s_define_mq_byte_name))       ; // REXX variable name
+    shv_set(&chain, varname, "", NULL,
+            &(pb->s_define_mq_byte_value[0]),
+            pb->s_define_mq_byte_size, 1)                 ;
+   } // End of Byte initializations Loop
+
+ for (i=0; ; i++)
+   {
+    pc = &define_mq_char[i]                           ;
+    if ( pc->s_define_mq_char_name[0] == '?' ) break  ;
+    shv_flush(traceid, &chain, 1)                     ;
+
+    MAKERXSTRING(varname,
+                 &(pc->s_define_mq_char_name[0]),
+                 strlen(pc->s_define_mq_char_name))   ; // REXX variable name
+    shv_set(&chain, varname, "", NULL,
+            &(pc->s_define_mq_char_value),
+            sizeof(MQCHAR), 0)                        ;
+   } // End of Character initializations Loop
+
+ shv_flush(traceid, &chain, MAXCHAIN)                 ; // The rest
+
+ TRACE(traceid, ("Leaving setcons\n") ) ;
+
+ return ;
+
+ } // End of setcons function
+
+//
+// Routine geteventname - converts the NUMBER of an Event into
+//                        a name (for use as a Component Variable),
+//                        which is defined event name like MQCA_...
+//                        without MQCA_ prefix itself
+//
+//         If the PCF field number is unknown, then the
+//            component is set to the character version of the
+//            PCF event number. This only works for EVENT PCFs!!!!
+//
+//         Tracing is via the EVENT setting
+//
+//
+
+void geteventname(char * output, const MQLONG pcfnum )
+ {
+  char                    varnamc[100] ;  // Char version of var name
+  char                    varvalc[31]  ;  // Char version of var value
+  SHVBLOCK                sv1          ;  // Var interface CB
+  MQULONG                 sv1rc        ;  // Var interface RC
+
+  // TRACE(EVENT, ("Entering geteventname for %"PRId32"\n",(int32_t)pcfnum) ) ;
+
+  sv1.shvnext     = 0           ; // Fetch only one variable
+  sv1.shvcode     = RXSHV_SYFET ; // Fetch operation
+  sv1.shvret      = 0           ; // Zero out RC
+
+  sprintf(varnamc,"RXMQ.CAMAP.%"PRId32,(int32_t)pcfnum) ; // Construct REXX variable name
+  MAKERXSTRING(sv1.shvname,varnamc,strlen(varnamc))     ; // Construct REXX variable name structure
+  sv1.shvnamelen  = sv1.shvname.strlength               ; // REXX variable name length
+
+  sv1.shvvalue.strptr   = varvalc                     ; // Set pointer to value buffer for REXX
+  sv1.shvvalue.strlength= 30                          ; // Set max value length for REXX
+  sv1.shvvaluelen       = 30                          ; // Set max accepted value length
+
+  sv1rc           = RexxVariablePool(&sv1)            ; // Call REXX variable interface
+
+  varvalc[sv1.shvvalue.strlength] = 0                 ; // Ensure zero terminated
+
+  if (   (sv1rc != RXSHV_OK)
+      || (sv1.shvname.strlength == 0) )
+    sprintf(varvalc,"%"PRId32,(int32_t)pcfnum)        ; // When something goes wrong
+
+  // TRACE(EVENT, ("Converted %"PRId32" into %s\n",(int32_t)pcfnum,varvalc) )  ;
+
+  strcat(output, varvalc)                             ; // Concatenate
+
+  return ;
+
+ } // End of geteventname function
+
+//
+// External Functions, callable from Rexx
+//
+
+//
+// initialize the interface - RXMQINIT
+//
+//    For Windows, AIX, Linux this function installs the other functions of the DLL.
+//    It MUST be called before any of the other Rexx/MQ functions are
+//    available for usage.
+//
+//    This is done by a RxFuncAdd('RXMQINIT','RXMQx',RXMQINIT')
+//         call to let Rexx know about the DLL, and then a
+//         rcc = RXMQINIT() to call the initialization function.
+//
+//    The following things are done:
+//
+//        * Create Rexx variables for ALL known MQ Constants
+//        * Create number->name translation variables for MQ ACs
+//        * initialize the DLL Global variables
+//            (including obtaining the Mutex for Conn/Open/Close processing)
+//        * Make the RXMQ... functions known to Rexx
+//
+//
+//
+FTYPE  RXMQINIT  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0       ;  // RXMQ Control Block
+ int                      i                ;  // Looper
+ int                      rc = 0           ;  // Function Return Code
+ int                      regrc = 0        ;  // Last registration RC
+ MQLONG                   mqrc = 0         ;  // MQ RC
+ MQLONG                   mqac = 0         ;  // MQ AC
+ MQULONG                  traceid = INIT   ;  // This function trace id
+ RXSTRING                 RX_sess          ;  // RXMQ.SESSION. stem
+ MQLONG                   sessions = 0     ;  // Sessions listed in it
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Session preconnect failed"},
+        { -99, "UNKNOWN FAILURE"}} ;
+ //
+ // Prepare Copyright message
+ //
+ char * moremsg = "WMQ Support Pac MA95. Version 2.0 "
+                  "(C) Copyright IBM Corporation. 1997, 2012.\n";
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+ //
+ // Now, initialize all the constants required by calling setcons.
+ //
+ // Additionally, if the constant represents Reason Code (MQRC_)
+ //               then create an number->name entry in the
+ //               RXMQ.RCMAP. stem variable
+ //
+ // Additionally, if the constant represents Completion Code (MQCC_)
+ //               then create an number->name entry in the
+ //               RXMQ.CCMAP. stem variable
+ //
+ // Additionally, if the constant represents Event Name (MQCA_,...)
+ //               then create an number->name entry in the
+ //               RXMQ.CAMAP. stem variable
+ //
+ if ( rc == 0 ) setcons(traceid) ;
+
+#ifndef __MVS__
+ //
+ // Register the DLL functions in Windows/Linux/AIX
+ //
+ if ( rc == 0 )
+   {
+    for (i= 0; i< numfuncs ; i++ )
+      {
+       regrc = RexxRegisterFunctionDll(     funcs[i],
+                                      (PSZ) THISDLL,
+                                            funcs[i]) ;
+       TRACE(traceid, ("Registration of %s, rc = %d\n",funcs[i],regrc) ) ;
+      }
+   }
+#endif
+
+ //
+ // Open the sessions listed in RXMQ.SESSION. (see RXMQSESS). One already
+ // open, by RXMQINIT in another thread say, is left as it is.
+ //
+ if ( rc == 0 )
+   {
+    MAKERXSTRING(RX_sess, "RXMQ.SESSION.", strlen("RXMQ.SESSION.")) ;
+    stem_to_long(traceid, RX_sess, "0", &sessions)                  ;
+    for ( i = 1 ; (rc == 0) && (i <= sessions) ; i++ )
+      {
+       rc = sess_list(traceid, i, &mqrc, &mqac) ;
+       TRACE(traceid, ("Session %d preconnect rc = %d\n",i,rc) ) ;
+       if ( (rc == -1) || (rc == MQCC_WARNING) ) rc =  0 ;
+       else if ( rc != 0 )                       rc = -1 ;
+      }
+   }
+
+//
+// Set the LAST variables, and the function return string (that of the
+// last registration, as before, unless a preconnect failed)
+//
+ if ( rc == 0 ) rc = regrc ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,moremsg) ;
+
+return 0 ;
+ } // End of RXMQINIT function
+
+//
+// RXMQCONS will simply setup the MQ mappings in the Rexx Workspace.
+//
+//           This is useful in a thread based environment where RXMQINIT
+//                has been done elsewhere (so setting the mappings elsewhere)
+//                to act, essentially, as the initialization for the thread
+//
+FTYPE  RXMQCONS  RXMQPARM
+ {
+ RXMQCB                 * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                   rc = 0           ;  // Function Return Code
+ MQLONG                   mqrc = 0         ;  // MQ RC
+ MQLONG                   mqac = 0         ;  // MQ AC
+ MQULONG                  traceid = INIT   ;  // This function trace id
+
+ static const RETMSG ReturnMsg[] = {
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+ //
+ // Just initialize all the constants etc. required by calling setcons.
+ //
+ if ( rc == 0 ) setcons(traceid) ;
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQCONS function
+
+//
+// Terminate the interface - RXMQTERM
+//
+//    For Windows, AIX, Linux only this function removes access to the functions of the DLL.
+//         After calling, no other Rexx/MQ functions are available.
+//
+//    However, all the REXX name bindings are left in the
+//         Workspace; this is done to provide a method of assembling
+//         stem variable with the correct settings.
+//
+//    The work counted on each connection by an auto-commit policy
+//         (RXMQAUTO) is committed, and asynchronous consumers are
+//         stopped. Nothing else is: if other units of work are not
+//         ended, or the Queues Closed, or the QMs Disconnected before
+//         this routine is invoked, then the usual MQ End of Process
+//         action will occur at that time.
+//
+//    If the commit or the stopping of a consumer fails, rc is the worst
+//         CC, with the reason of the first to meet it. Else if a
+//         function could not be deregistered, rc is that of
+//         RexxDeregisterFunction. Else, if messages consumed
+//         asynchronously (RXMQASYN) but not taken by RXMQPOLL were
+//         lost, rc is -1, the reason being how many.
+//
+FTYPE  RXMQTERM  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0       ;  // RXMQ Control Block
+ int                      i                ;  // Looper
+ int                      rc = 0           ;  // Function Return Code
+ MQLONG                   mqrc = 0         ;  // MQ RC
+ MQLONG                   mqac = 0         ;  // MQ AC
+ MQLONG                   cc               ;  // Commit CC
+ MQLONG                   ac               ;  // Commit RC
+ MQLONG                   ascc             ;  // Async end CC
+ MQLONG                   asac             ;  // Async end RC
+ MQLONG                   lost = 0         ;  // Consumed messages lost
+ int                      dereg = 0        ;  // Deregistration RC
+ MQULONG                  traceid = TERM   ;  // This function trace id
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Consumed messages not taken lost, reason is how many"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Stop consuming asynchronously, commit the work counted by auto-commit
+// policies, delete the reply queues of RXMQREQ, end the worker pool,
+// detach from any sessions, and release the descriptor templates and
+// reusable storage. The worst CC met is returned, with the RC of the
+// first to meet it.
+//
+ if (rc == 0)
+   {
+    for (i = 0; i < MAXCONNS ; i++ )
+      if ( anchor->QM[i].Async || (anchor->Rings > 0) )
+        {
+         async_end(traceid, anchor, i, 0, &lost, &ascc, &asac) ;
+         if ( ascc > mqrc ) { mqrc = ascc ; mqac = asac ; }
+        }
+    wake_free(&anchor->Wake)                         ;
+    for (i = 0; i < MAXCONNS ; i++ )
+      if ( anchor->QM[i].Pending > 0 )
+        {
+         uow_commit(traceid, anchor, i, 1, &cc, &ac) ;
+         if ( cc > mqrc ) { mqrc = cc ; mqac = ac ; }
+        }
+    for (i = 0; i < MAXCONNS ; i++ )
+      if ( anchor->QM[i].Rpc != NULL ) req_end(traceid, anchor, i) ;
+    if ( anchor->Pool != NULL ) pool_end(traceid, anchor) ;
+    for (i = 0; i < MAXCONNS ; i++ )
+      if ( anchor->QM[i].Sess != 0 ) sess_detach(traceid, anchor, i) ;
+    for (i = 0; i < MAXTMPL ; i++ ) tmpl_free(anchor, i) ;
+    storage_stats(traceid, anchor)                       ;
+    storage_free(anchor)                                 ;
+    obj_reset(anchor, 0, 1)                              ;
+   }
+
+#ifndef __MVS__
+//
+// Deregister the DLL functions on distributed
+//
+
+ for (i= 0; i< numfuncs ; i++ )
+   {
+    dereg = RexxDeregisterFunction(funcs[i]) ;
+    TRACE(traceid, ("Deregistration of %s, rc = %d\n",funcs[i],dereg) ) ;
+   }
+#endif
+ if ( rc == 0 ) rc = mqrc  ;
+ if ( rc == 0 ) rc = dereg ;
+ if ( (rc == 0) && (lost > 0) )
+   {
+    rc   = -1           ;
+    mqrc = MQCC_WARNING ;
+    mqac = lost         ;
+   }
+
+
+// Return a good return Code
+
+// strcpy((char *)returnc,"0 0 0 RXMQTERM OK Rexx MQ Interface terminated." );
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+#ifdef __MVS__
+ return 4;
+#else
+ return 0;
+#endif
+ } // End of RXMQTERM function
+
+//
+// Set the trace for this thread - RXMQTRAC
+//
+//   Call:   rc = RXMQTRAC( [keywords] )
+//
+//           keywords: trace settings, as for RXMQTRACE ('' for none)
+//
+//   Once set, the RXMQTRACE variables are no longer read by each call
+//   of the thread; with no keywords they are read again.
+//
+FTYPE  RXMQTRAC  RXMQPARM
+ {
+ RXMQCB                 * anchor = 0       ;  // RXMQ Control Block
+ char                     keywords[100]    ;  // Trace keywords
+ MQLONG                   rc = 0           ;  // Function Return Code
+ MQLONG                   mqrc = 0         ;  // MQ RC
+ MQLONG                   mqac = 0         ;  // MQ AC
+ MQULONG                  traceid = INIT   ;  // This function trace id
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Too many parms"},
+        {  -2, "Keywords too long"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+ if ( (rc == 0) && (aargc > 1) )                                   rc = -1 ;
+ if ( (rc == 0) && (aargc == 1) && !RXNULLSTRING(aargv[0])
+               && (aargv[0].strlength >= sizeof(keywords)) )       rc = -2 ;
+
+ if ( (rc == 0) && (aargc == 1) && !RXNULLSTRING(aargv[0]) )
+   {
+    memcpy(keywords, aargv[0].strptr, aargv[0].strlength) ;
+    keywords[aargv[0].strlength] = '\0'                   ;
+    anchor->tracebits = trace_bits(keywords)              ;
+    anchor->traceset  = 1                                 ;
+   }
+ else if ( rc == 0 )
+   {
+    anchor->tracebits = ZERO                              ; // Read the
+    anchor->traceset  = 0                                 ; //   variables
+    memset(anchor->tracevar, 0, sizeof(anchor->tracevar)) ; //   again
+   }
+
+ if ( rc == 0 )
+    TRACE(traceid, ("Trace bits now %"PRIX32"\n",(uint32_t)anchor->tracebits)) ;
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQTRAC function
+
+//
+// Set the return mode for this thread - RXMQRETM
+//
+//   Call:   rc = RXMQRETM( mode )
+//
+//           mode: FULL    - set RXMQ.LASTxx and the old-style LASTxx
+//                           variables (the default)
+//                 NEW     - set only RXMQ.LASTxx
+//                 NUMERIC - set no LASTxx variables, the Return String
+//                           being just 'rc cc ac'
+//
+FTYPE  RXMQRETM  RXMQPARM
+ {
+ RXMQCB                 * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                   rc = 0           ;  // Function Return Code
+ MQLONG                   mqrc = 0         ;  // MQ RC
+ MQLONG                   mqac = 0         ;  // MQ AC
+ MQULONG                  traceid = INIT   ;  // This function trace id
+ char                     mode[8]          ;  // Uppercased mode
+ MQULONG                  i                ;  // Looper
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms"},
+        {  -2, "Bad mode"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+ if ( (rc == 0) && (aargc != 1) )                          rc = -1 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[0]) )              rc = -2 ;
+ if ( (rc == 0) && (aargv[0].strlength >= sizeof(mode)) )  rc = -2 ;
+
+ if ( rc == 0 )
+   {
+    for (i = 0; i < aargv[0].strlength; i++)
+      mode[i] = toupper(aargv[0].strptr[i]) ;
+    mode[i] = '\0'                          ;
+
+    if      ( !strcmp(mode, "FULL")    ) anchor->RetMode = RET_FULL ;
+    else if ( !strcmp(mode, "NEW")     ) anchor->RetMode = RET_NEW  ;
+    else if ( !strcmp(mode, "NUMERIC") ) anchor->RetMode = RET_NUM  ;
+    else                                 rc = -2                    ;
+    TRACE(traceid, ("Return mode now %"PRId32"\n",(int32_t)anchor->RetMode)) ;
+   }
+
+//
+// Set the LAST variables (if still wanted), and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQRETM function
+
+//
+// Do a Connect MQCONN
+//
+//   Call:   rc = RXMQconn(qmname [, conn])
+//
+//      Without conn this makes the default connection. With it another
+//      connection is made, and the variable conn set to its id
+//
+FTYPE  RXMQCONN  RXMQPARM
+ {
+
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = CONN   ;  // This function trace id
+
+ RXSTRING                RX_conn          ;  //      Var Connection id
+ int                     conn      = 0    ;  // Connection to make
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null QM name"},
+        {  -3, "Zero length QM name"},
+        {  -4, "QM name too long"},
+        {  -5, "Zero length connection variable"},
+        {  -6, "No available connections"},
+        { -98, "Already Connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ((aargc < 1) || (aargc > 2)) ) rc = -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )     rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) )  rc =  -3 ;
+ if ( (rc == 0) && ( aargv[0].strlength >
+                     MQ_Q_MGR_NAME_LENGTH ) )   rc =  -4 ;
+ if ( (rc == 0) && (aargc > 1) && RXZEROLENSTRING(aargv[1]) ) rc = -5 ;
+
+//
+// Is this thread already connected ? Or, for another connection,
+// find a free one
+//
+ if ( (rc == 0) && (aargc > 1) && !RXNULLSTRING(aargv[1]) )
+   {
+    memcpy(&RX_conn, &aargv[1], sizeof(RX_conn)) ;
+    for ( conn = 1 ; (conn < MAXCONNS) && (anchor->QM[conn].QMh != 0) ; conn++ ) ;
+    if ( conn == MAXCONNS )                     rc =  -6 ;
+   }
+ if ( (rc == 0) && ( anchor->QM[conn].QMh != 0) ) rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+   {
+    memset(anchor->QM[conn].QMname, 0, sizeof(anchor->QM[conn].QMname)) ;
+    memcpy(anchor->QM[conn].QMname,aargv[0].strptr,aargv[0].strlength) ;
+    TRACE(traceid, ("Requested connection %d with %s\n",conn,anchor->QM[conn].QMname) ) ;
+   }
+
+//
+// Do the MQCONN
+//
+ if (rc == 0)
+   {
+    MQCONN ( anchor->QM[conn].QMname, &anchor->QM[conn].QMh, &mqrc, &mqac ) ;
+    rc = mqrc                                             ;
+    TRACE(traceid, ("MQCONN handle is %"PRIX32", QM is %s\n",
+          (uint32_t)anchor->QM[conn].QMh,anchor->QM[conn].QMname) ) ;
+
+    if ( mqrc == MQCC_FAILED ) anchor->QM[conn].QMh = 0 ;
+    else
+      {
+       anchor->Conns++ ;
+       if ( conn != 0 ) stem_from_long(traceid, NULL, RX_conn, "", conn) ;
+      }
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQCONN function
+
+//
+// Do a Connect with options   MQCONNX
+//
+//   Call:   rc = RXMQconnx(QMname, iMQCNO [, iMQCD [, oMQCNO [, conn]]])
+//
+//      QMname may be a zero length string for the default QM (or the
+//      one a client channel leads to). iMQCNO may be omitted, and is
+//      read as for make_cno_from_stem, with in addition
+//
+//                     .RAH  -> MQOO_READ_AHEAD or MQOO_NO_READ_AHEAD,
+//                              added to each RXMQOPEN for input or
+//                              browse on this connection that gives
+//                              neither, so it need not be coded on
+//                              every open of a client application
+//
+//      iMQCD, if given, makes this a client connection using that
+//      channel definition (see make_cd_from_stem). conn is as for
+//      RXMQCONN.
+//
+//      On z/OS this is RXMQCONX, the name being limited to 8 characters
+//
+FTYPE  RXMQCONX  RXMQPARM
+ {
+
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = CONN   ;  // This function trace id
+
+ RXSTRING                RXi_cno          ;  // Stem Var Conn Opts Input
+ RXSTRING                RXi_cd           ;  // Stem Var Channel Def Input
+ RXSTRING                RXo_cno          ;  // Stem Var Conn Opts Output
+
+ RXSTRING                RX_conn          ;  //      Var Connection id
+ int                     conn      = 0    ;  // Connection to make
+
+ MQULONG                 omask_cno = ALLFIELDS ;  // Output CNO fields wanted
+
+ MQCNO                   cno              ;  // MQ connect options
+ MQCD                    cd               ;  // MQ client channel definition
+ MQLONG                  readahead  =  0  ;  // .RAH of the input CNO
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null QM name"},
+        {  -4, "QM name too long"},
+        {  -5, "Zero length input CNO"},
+        {  -6, "Zero length input CD"},
+        {  -7, "Bad read ahead option"},
+        {  -9, "Zero length output CNO"},
+        { -10, "Zero length connection variable"},
+        { -11, "No available connections"},
+        { -96, "Bad output field list"},
+        { -98, "Already Connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+ MAKERXSTRING(RXi_cno, NULL, 0) ;
+ MAKERXSTRING(RXi_cd,  NULL, 0) ;
+ MAKERXSTRING(RXo_cno, NULL, 0) ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ((aargc < 1) || (aargc > 5)) )     rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )           rc =  -2 ;
+ if ( (rc == 0) && ( aargv[0].strlength >
+                     MQ_Q_MGR_NAME_LENGTH ) )         rc =  -4 ;
+ if ( (rc == 0) && (aargc > 1) && RXZEROLENSTRING(aargv[1]) ) rc = -5 ;
+ if ( (rc == 0) && (aargc > 2) && RXZEROLENSTRING(aargv[2]) ) rc = -6 ;
+ if ( (rc == 0) && (aargc > 3) && RXZEROLENSTRING(aargv[3]) ) rc = -9 ;
+if ( (rc == 0) && (aargc > 4) && RXZEROLENSTRING(aargv[4]) ) rc = -10 ;
+
+//
+// Is this thread already connected ? Or, for another connection,
+// find a free one
+//
+ if ( (rc == 0) && (aargc > 4) && !RXNULLSTRING(aargv[4]) )
+   {
+    memcpy(&RX_conn, &aargv[4], sizeof(RX_conn)) ;
+    for ( conn = 1 ; (conn < MAXCONNS) && (anchor->QM[conn].QMh != 0) ; conn++ ) ;
+    if ( conn == MAXCONNS )                           rc = -11 ;
+   }
+ if ( (rc == 0) && ( anchor->QM[conn].QMh != 0) )     rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+   {
+    TRACE(traceid, ("Requested connection with %.*s\n",(int)aargv[0].strlength,aargv[0].strptr) ) ;
+
+    if ( aargc > 1 ) memcpy(&RXi_cno, &aargv[1], sizeof(RXi_cno)) ;
+    if ( aargc > 2 ) memcpy(&RXi_cd,  &aargv[2], sizeof(RXi_cd))  ;
+    if ( aargc > 3 ) memcpy(&RXo_cno, &aargv[3], sizeof(RXo_cno)) ;
+
+    memcpy(&cno, &cno_default, sizeof(MQCNO)) ;
+    cno.Version = MQCNO_VERSION_5             ;
+    if ( !RXNULLSTRING(RXi_cno) )
+      {
+       TRACE(traceid, ("RXi_cno = %.*s\n",(int)RXi_cno.strlength,RXi_cno.strptr) ) ;
+       make_cno_from_stem(traceid, anchor, &cno, RXi_cno) ;
+       stem_to_long(traceid, RXi_cno, "RAH", &readahead)  ;
+       if ( (readahead != 0) && (readahead != MQOO_READ_AHEAD)
+                             && (readahead != MQOO_NO_READ_AHEAD) ) rc = -7 ;
+      }
+
+    if ( !RXNULLSTRING(RXi_cd) )
+      {
+       TRACE(traceid, ("RXi_cd = %.*s\n",(int)RXi_cd.strlength,RXi_cd.strptr) ) ;
+       make_cd_from_stem(traceid, anchor, &cd, RXi_cd)  ;
+       cno.ClientConnPtr = &cd                          ;
+       if ( cno.Version < MQCNO_VERSION_2 ) cno.Version = MQCNO_VERSION_2 ;
+      }
+
+    if ( (rc == 0) && out_mask(cno_fields, &RXo_cno, &omask_cno) ) rc = -96 ;
+   }
+
+//
+// Do the MQCONNX
+//
+ if (rc == 0)
+   {
+    memset(anchor->QM[conn].QMname, 0, sizeof(anchor->QM[conn].QMname)) ;
+    memcpy(anchor->QM[conn].QMname,aargv[0].strptr,aargv[0].strlength) ;
+    DUMPCB(traceid, &cno) ;
+    MQCONNX ( anchor->QM[conn].QMname, &cno, &anchor->QM[conn].QMh, &mqrc, &mqac ) ;
+    rc = mqrc                                                    ;
+    TRACE(traceid, ("MQCONNX handle is %"PRIX32", QM is %.48s, connection %d\n",
+          (uint32_t)anchor->QM[conn].QMh,anchor->QM[conn].QMname,conn) ) ;
+
+    if ( mqrc == MQCC_FAILED ) anchor->QM[conn].QMh = 0 ;
+    else
+      {
+       anchor->QM[conn].ReadAhead = readahead ;
+       anchor->Conns++                        ;
+       if ( conn != 0 ) stem_from_long(traceid, NULL, RX_conn, "", conn) ;
+      }
+    make_stem_from_cno(traceid, &cno, RXo_cno, omask_cno)    ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQCONX function
+
+//
+// Do a Disconnect   MQDISC
+//
+//   Call:   rc = RXMQdisc([conn])
+//
+//      A connection attached to a session (RXMQSESS) is not disconnected,
+//      only this thread's use of it ending
+//
+//      Puts made with MQPMO_ASYNC_RESPONSE are checked first, as by
+//      RXMQCMIT
+//
+//      Messages consumed asynchronously (RXMQASYN) but not taken by
+//      RXMQPOLL are lost, and if there were any rc is -2, the reason
+//      being how many
+//
+FTYPE  RXMQDISC  RXMQPARM
+ {
+
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQLONG                  cc = 0           ;  // Commit CC
+ MQLONG                  ac = 0           ;  // Commit RC
+ MQLONG                  ascc = 0         ;  // Async end CC
+ MQLONG                  asac = 0         ;  // Async end RC
+ MQLONG                  lost = 0         ;  // Consumed messages lost
+ MQLONG                  stcc = 0         ;  // MQSTAT CC
+ MQLONG                  stac = 0         ;  // MQSTAT RC
+ RXSTRING                stem             ;  // RXMQ.STAT.
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = DISC   ;  // This function trace id
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Consumed messages not taken lost, reason is how many"},
+        { -95, "Bad connection id"},
+        { -98, "Not Connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ( aargc > 1 ) )         rc =  -1 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 0, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
+
+//
+// Stop consuming asynchronously, then commit the work counted by an
+// auto-commit policy, and report. The disconnect is done even if either
+// fails, the worse (or, as bad, the first) then being returned.
+//
+ if ( (rc == 0) && (anchor->QM[conn].Async || (anchor->Rings > 0)) )
+    async_end(traceid, anchor, conn, 0, &lost, &ascc, &asac) ;
+ if ( (rc == 0) && (anchor->QM[conn].Pending > 0) )
+    uow_commit(traceid, anchor, conn, 1, &cc, &ac) ;
+ if ( ascc >= cc ) { cc = ascc ; ac = asac ; }
+ if ( (rc == 0) && UOW_AUTO(&anchor->QM[conn]) )
+    uow_stats(traceid, anchor, conn) ;
+
+//
+// Check the asynchronous puts, as RXMQCMIT does
+//
+ if ( (rc == 0) && (anchor->QM[conn].AsyncPuts > 0) )
+   {
+    MAKERXSTRING(stem, "RXMQ.STAT.", sizeof("RXMQ.STAT.")-1) ;
+    put_stat(traceid, anchor, conn, stem, &stcc, &stac) ;
+   }
+
+//
+// Delete the reply queues of RXMQREQ, then detach from a session, or do
+// the MQDISC
+//
+ if ( (rc == 0) && (anchor->QM[conn].Rpc != NULL) )
+    req_end(traceid, anchor, conn) ;
+ if ( (rc == 0) && (anchor->QM[conn].Sess != 0) )
+   {
+    TRACE(traceid, ("Detaching connection %d from session %d\n",conn,(int)anchor->QM[conn].Sess) ) ;
+    sess_detach(traceid, anchor, conn) ;
+    storage_stats(traceid, anchor)     ;
+   }
+ else if (rc == 0)
+   {
+    TRACE(traceid, ("Disconnecting connection %d from QM %s\n",conn,anchor->QM[conn].QMname) ) ;
+    MQDISC ( &anchor->QM[conn].QMh, &mqrc, &mqac ) ;
+    rc = mqrc                             ;
+    obj_reset(anchor, conn, 0)                         ; // Handles are gone
+    memset (&anchor->QM[conn], 0, sizeof(RXMQQM))      ; // Templates are kept
+    anchor->Conns--                                    ;
+    storage_stats(traceid, anchor)                     ;
+   }
+ if ( (rc == 0) && (cc == MQCC_FAILED) )
+   {
+    rc   = cc ;
+    mqrc = cc ;
+    mqac = ac ;
+   }
+ else if ( (rc == 0) && (lost > 0) )
+   {
+    rc   = -2           ;
+    mqrc = MQCC_WARNING ;
+    mqac = lost         ;
+   }
+ else if ( (rc == 0) && (stcc != MQCC_OK) )
+   {
+    rc   = MQCC_WARNING ;
+    mqrc = MQCC_WARNING ;
+    mqac = stac         ;
+   }
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQDISC function
+
+
+//
+// Do an Open   MQOPEN
+//
+//   Call:   rc = RXMQopen(iMQOD,opts,handle,oMQOD [,conn])
+//
+//      iMQOD may name a distribution list, see Distribution lists
+//
+FTYPE  RXMQOPEN  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = OPEN   ;  // This function trace id
+
+ RXSTRING                RXi_od           ;  // Stem Var Obj Desc Input
+ RXSTRING                RXo_od           ;  // Stem Var Obj Desc Output
+ RXSTRING                RX_opt           ;  // Open     Options
+ RXSTRING                RX_handle        ;  //      Var Obj Handle
+
+ MQULONG                 omask_od = ALLFIELDS ;  // Output OD fields wanted
+
+ MQOD                    od               ;  //MQ object desc
+ MQLONG                  options    =  0  ;  //MQ open options
+ int                     theobj     =  0  ;  //gmqo object to use
+ MQLONG                  key        =  0  ;  //Cache key (0 not cacheable)
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null Input OD/Qname"},
+        {  -3, "Zero length input OD/Qname"},
+        {  -4, "Null options"},
+        {  -5, "Zero length options"},
+        {  -6, "Null handle name"},
+        {  -7, "Zero length handle name"},
+        {  -9, "Zero length output OD"},
+        { -10, "No available Q objects"},
+        { -95, "Bad connection id"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ((aargc < 4) || (aargc > 5)) ) rc = -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 4, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+    {
+      memcpy(&RXi_od    ,&aargv[0],sizeof(RXi_od))    ;
+      memcpy(&RX_opt    ,&aargv[1],sizeof(RX_opt  ))  ;
+      memcpy(&RX_handle ,&aargv[2],sizeof(RX_handle)) ;
+      memcpy(&RXo_od    ,&aargv[3],sizeof(RXo_od))    ;
+
+      TRACE(traceid, ("RXi_od = %.*s\n",   (int)RXi_od.strlength,   RXi_od.strptr) )     ;
+      TRACE(traceid, ("RX_opt = %.*s\n",   (int)RX_opt.strlength,   RX_opt.strptr) )     ;
+      TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) )  ;
+      TRACE(traceid, ("RXo_od = %.*s\n",   (int)RXo_od.strlength,   RXo_od.strptr) )     ;
+
+      if ( !ISTMPL(RXi_od) )                                     make_od_from_stem(traceid,anchor,&od,RXi_od) ;
+      else if ( tmpl_to_cb(traceid,anchor,TMPL_OD,RXi_od,&od, &omask_od) ) rc = -97 ;
+      if ( (rc == 0) && out_mask(od_fields, &RXo_od,  &omask_od  ) ) rc = -96 ;
+      parm_to_ulong(RX_opt, &options)          ;
+
+      if (  (options & ( MQOO_INPUT_AS_Q_DEF | MQOO_INPUT_SHARED
+                       | MQOO_INPUT_EXCLUSIVE | MQOO_BROWSE ))
+        && !(options & ( MQOO_READ_AHEAD | MQOO_NO_READ_AHEAD )) )
+         options |= anchor->QM[conn].ReadAhead ; // Connection's default (RXMQCONNX)
+    }
+
+
+//
+// Reuse a cached handle, else take a slot in the object table
+//
+ if (rc == 0)
+   {
+    key    = cache_key(&od, options)                          ;
+    theobj = cache_find(traceid, anchor, conn, &od, options, key) ;
+    if ( theobj == 0 ) theobj = obj_new(traceid, anchor, conn)    ;
+    TRACE(traceid, ("Selected Object [%d]\n",theobj) ) ;
+    if ( theobj == 0 ) rc = -10 ;
+   }
+
+//
+// A cached handle is already open, else do the MQOPEN on the obtained
+// Queue object
+//
+ if ( (rc == 0) && (anchor->Obj[theobj].Qh != 0) )
+   {
+    stem_from_long(traceid, NULL, RX_handle, ""  , OBJHANDLE(anchor,theobj)) ;
+    make_stem_from_od(traceid,&od,RXo_od, omask_od) ;
+   }
+ else if (rc == 0)
+   {
+    TRACE(traceid, ("Calling MQOPEN with options = %"PRId32"\n",(int32_t)options) ) ;
+    MQOPEN ( anchor->QM[conn].QMh, &od, options, &anchor->Obj[theobj].Qh, &mqrc, &mqac ) ;
+    rc = mqrc ;
+
+    if ( anchor->Obj[theobj].Qh != 0 )   //If the Open worked,
+      {                                  //then .....
+       obj_opened(traceid, anchor, theobj, options, od.ObjectName) ;
+       anchor->Obj[theobj].dests = OD_DESTS(&od)                   ;
+       cache_keep(anchor, theobj, key, &od)                        ;
+       stem_from_long(traceid, NULL, RX_handle, ""  , OBJHANDLE(anchor,theobj)) ;
+       make_stem_from_od(traceid,&od,RXo_od, omask_od) ; //and update the OD
+      }
+    else obj_drop(anchor, theobj) ;
+
+    if ( OD_DESTS(&od) > 0 )
+       rr_to_stem(traceid, od.ResponseRecPtr, od.RecsPresent, mqrc, mqac, RXo_od) ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQOPEN function
+
+//
+// Do a Close   MQCLOSE
+//
+//   Call:   rc = RXMQclos(handle,opts)
+//
+//      Messages of the queue consumed asynchronously (RXMQASYN) but not
+//      taken by RXMQPOLL are lost, and if there were any (and the close
+//      worked) rc is -8, the reason being how many
+//
+FTYPE  RXMQCLOS  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQLONG                  lost = 0         ;  // Consumed messages lost
+ MQULONG                 traceid = CLOSE  ;  // This function trace id
+
+ RXSTRING                RX_opts          ;  // Data     Options
+ RXSTRING                RX_handle        ;  // Data     Obj Handle
+
+ MQLONG                  options  = 0     ;  //MQ close options
+ MQLONG                  handle   = 0     ;  //MQ object number
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null handle"},
+        {  -3, "Zero length handle"},
+        {  -4, "Null options"},
+        {  -5, "Zero length options"},
+        {  -6, "Handle out of range"},
+        {  -7, "Invalid handle"},
+        {  -8, "Consumed messages not taken lost, reason is how many"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && (aargc != 2 ) )             rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+   {
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle))   ;
+    memcpy(&RX_opts  ,&aargv[1],sizeof(RX_opts  ))   ;
+
+    TRACE(traceid, ("RX_opts = %.*s\n",  (int)RX_opts.strlength,  RX_opts.strptr) )   ;
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+
+    parm_to_ulong(RX_opts,   &options)                 ;
+    parm_to_ulong(RX_handle, &handle)                  ;
+   }
+
+//
+// See if the handle is valid (ie: the gmqo to use)
+//
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -6 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -7 ;
+
+//
+// Stop consuming the queue asynchronously
+//
+ if ( (rc == 0) && (OBJ(anchor,handle)->ring != NULL) )
+   {
+    async_end(traceid, anchor, OBJ(anchor,handle)->conn, handle & OBJSLOTMASK, &lost, &mqrc, &mqac) ;
+    if ( mqrc == MQCC_FAILED ) rc = mqrc ;
+   }
+
+//
+// Commit the work counted by an auto-commit policy first, the close
+// not being done if that fails
+//
+ if ( (rc == 0) && (anchor->QM[OBJ(anchor,handle)->conn].Pending > 0) )
+   {
+    uow_commit(traceid, anchor, OBJ(anchor,handle)->conn, 1, &mqrc, &mqac) ;
+    if ( mqrc == MQCC_FAILED ) rc = mqrc ;
+   }
+
+//
+// A session's queue is left open for the other threads using it
+//
+ if ( (rc == 0) && OBJ(anchor,handle)->shared )
+   {
+    TRACE(traceid, ("Dropping session object handle [%"PRIu32"]\n",(uint32_t)handle) ) ;
+    obj_drop(anchor, handle & OBJSLOTMASK) ;
+   }
+
+//
+// Keep the handle in the cache if that is on (and it may be kept)
+//
+ else if ( (rc == 0) && (options == MQCO_NONE)
+   && (anchor->Cache.max > 0) && (OBJ(anchor,handle)->key != 0) )
+   {
+    TRACE(traceid, ("Keeping object handle [%"PRIu32"] in the cache\n",(uint32_t)handle) ) ;
+    cache_idle(traceid, anchor, handle & OBJSLOTMASK) ;
+   }
+
+//
+// Otherwise close the object
+//
+ else if (rc == 0)
+   {
+    TRACE(traceid, ("Closing object handle [%"PRIu32"]\n",(uint32_t)handle) ) ;
+    MQCLOSE ( OBJHCONN(anchor,handle), &OBJ(anchor,handle)->Qh, options, &mqrc, &mqac )  ;
+    rc = mqrc ;
+    if ( mqac == 0 )                  //If the Close worked,
+      {                               //then .....
+       obj_drop(anchor, handle & OBJSLOTMASK) ; //free the slot
+      }
+   }
+ if ( (rc == 0) && (lost > 0) )
+   {
+    rc   = -8           ;
+    mqrc = MQCC_WARNING ;
+    mqac = lost         ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQCLOS function
+
+//
+// Do a Syncpoint    MQCMIT
+//
+//   Call:   rc = RXMQcmit([conn])
+//
+//      If puts were made with MQPMO_ASYNC_RESPONSE since they were last
+//      checked, they are checked as by RXMQSTAT into RXMQ.STAT.xxx, a
+//      failure making a commit that worked a warning
+//
+FTYPE  RXMQCMIT  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQLONG                  cc               ;  // MQSTAT CC
+ MQLONG                  ac               ;  // MQSTAT RC
+ RXSTRING                stem             ;  // RXMQ.STAT.
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = CMIT   ;  // This function trace id
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        { -95, "Bad connection id"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && (aargc > 1 ) )              rc =  -1 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 0, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
+
+//
+// Do the Actual Syncpoint on the required Queue Manager
+//        This also forces it for all others on the thread
+//
+ if (rc == 0)
+   {
+    uow_commit(traceid, anchor, conn, 0, &mqrc, &mqac) ;
+    rc   = mqrc                          ;
+   }
+
+//
+// Check the asynchronous puts
+//
+ if ( (rc == 0) && (anchor->QM[conn].AsyncPuts > 0) )
+   {
+    MAKERXSTRING(stem, "RXMQ.STAT.", sizeof("RXMQ.STAT.")-1) ;
+    put_stat(traceid, anchor, conn, stem, &cc, &ac) ;
+    if ( cc != MQCC_OK )
+      {
+       rc   = MQCC_WARNING ;
+       mqrc = MQCC_WARNING ;
+       mqac = ac           ;
+      }
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQCMIT function
+
+//
+// Do a Rollback     MQBACK
+//
+//   Call:   rc = RXMQback([conn])
+//
+FTYPE  RXMQBACK  RXMQPARM
+ {
+
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = BACK   ;  // This function trace id
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        { -95, "Bad connection id"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && (aargc > 1 ) )              rc =  -1 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 0, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
+
+//
+// Do the Actual Backout on the required Queue Manager
+//        This also forces it for all others on the thread
+//
+ if (rc == 0)
+   {
+    MQBACK ( anchor->QM[conn].QMh, &mqrc, &mqac ) ;
+    rc   = mqrc                          ;
+    anchor->QM[conn].Uow.backouts++      ;
+    anchor->QM[conn].Pending   = 0       ; // A new batch
+    anchor->QM[conn].PendBytes = 0       ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+ return 0;
+ } // End of RXMQBACK function
+
+//
+// Check asynchronous puts   MQSTAT
+//
+//   Call:   rc = RXMQstat(status, [conn])
+//
+//      Does an MQSTAT (MQSTAT_TYPE_ASYNC_ERROR) for the puts made with
+//      MQPMO_ASYNC_RESPONSE on the connection since they were last
+//      checked, setting:
+//
+//                     status.PUTS    -> async puts made since the last check
+//                     status.SUCCESS -> PutSuccessCount
+//                     status.WARNING -> PutWarningCount
+//                     status.FAILURE -> PutFailureCount
+//                     status.CC      -> CompCode of the first failure (or warning)
+//                     status.RC      -> Reason of the first failure (or warning)
+//                     status.OBJNAME -> ObjectName it was put to
+//                     status.QMNAME  -> ObjectQMgrName it was put to
+//
+//      The CompCode and Reason of the first failure are returned (0 0 if
+//      none), or those of the MQSTAT if that fails.
+//
+FTYPE  RXMQSTAT  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = PUT    ;  // This function trace id
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null status stem"},
+        {  -3, "Zero length status stem"},
+        { -95, "Bad connection id"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ((aargc < 1) || (aargc > 2)) ) rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 1, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
+
+//
+// Do the MQSTAT, and set the stem
+//
+ if (rc == 0)
+   {
+    TRACE(traceid, ("status = %.*s\n",(int)aargv[0].strlength,aargv[0].strptr) ) ;
+    put_stat(traceid, anchor, conn, aargv[0], &mqrc, &mqac) ;
+    rc = mqrc ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQSTAT function
+
+//
+// Do a Put     MQPUT
+//
+//   Call:   rc = RXMQput(handle, data,
+//                        input_msgdesc, output_msgdesc,
+//                        input_pmo, output_pmo)
+//
+//           For a distribution list the input PMO stem may give put
+//           message records, and the responses are set in the output
+//           PMO stem, see Distribution lists.
+//
+FTYPE  RXMQPUT  RXMQPARM
+ {
+
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc   = 0         ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = PUT    ;  // This function trace id
+
+ RXSTRING                RX_handle        ;  // Obj Handle
+ RXSTRING                RX_data          ;  // Variable Data
+ RXSTRING                RXi_md           ;  // Variable Input  Msg Desc
+ RXSTRING                RXo_md           ;  // Variable Output Msg Desc
+ RXSTRING                RXi_pmo          ;  // Variable Input  PMO
+ RXSTRING                RXo_pmo          ;  // Variable Output PMO
+
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+ MQULONG                 omask_pmo = ALLFIELDS;  // Output PMO fields wanted
+
+ MQLONG                  handle           ;  //MQ object number
+ MQMD2                   od               ;  //MQ Message descriptor
+ MQPMO                   pmo              ;  //MQ Put Message options
+ MQLONG                  data0 = 0        ;  // Variable Data len
+ void                 *  data  = 0        ;  //-> Data buffer
+ int                     datalen          ;  //   Data length
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null handle"},
+        {  -3, "Zero data handle"},
+        {  -4, "Null data stem var"},
+        {  -5, "Zero data stem var"},
+        {  -6, "Null input MsgDesc"},
+        {  -7, "Zero length input MsgDesc"},
+        {  -9, "Zero length output MsgDesc"},
+        { -10, "Null input PMO"},
+        { -11, "Zero length input PMO"},
+        { -13, "Zero length output PMO"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Zero length input data buffer"},
+        { -18, "Data length is not equal to specified value"},
+        { -19, "Context handle out of range"},
+        { -20, "Invalid Context handle"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && (aargc != 6 ) )             rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[4]) )    rc = -10 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc = -11 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[5]) ) rc = -13 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+   {
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
+    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))   ;
+    memcpy(&RXi_md,   &aargv[2],sizeof(RXi_md))    ;
+    memcpy(&RXo_md,   &aargv[3],sizeof(RXo_md))    ;
+    memcpy(&RXi_pmo,  &aargv[4],sizeof(RXi_pmo))   ;
+    memcpy(&RXo_pmo,  &aargv[5],sizeof(RXo_pmo))   ;
+
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("RX_data = %.*s\n",  (int)RX_data.strlength,  RX_data.strptr)   ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n",   (int)RXi_md.strlength,   RXi_md.strptr)    ) ;
+    TRACE(traceid, ("RXo_md = %.*s\n",   (int)RXo_md.strlength,   RXo_md.strptr)    ) ;
+    TRACE(traceid, ("RXi_pmo = %.*s\n",  (int)RXi_pmo.strlength,  RXi_pmo.strptr)   ) ;
+    TRACE(traceid, ("RXo_pmo = %.*s\n",  (int)RXo_pmo.strlength,  RXo_pmo.strptr)   ) ;
+
+    if ( !ISTMPL(RXi_md) )                                        make_md_from_stem(traceid,&od, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &od, &omask_md) ) rc = -97 ;
+    if ( !ISTMPL(RXi_pmo) )                                       make_po_from_stem(traceid,&pmo , RXi_pmo ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_PMO,RXi_pmo,&pmo, &omask_pmo) ) rc = -97 ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md,  &omask_md  ) ) rc = -96 ;
+    if ( (rc == 0) && out_mask(po_fields, &RXo_pmo, &omask_pmo ) ) rc = -96 ;
+
+    parm_to_ulong(RX_handle, &handle)                ;
+    stem_to_long(traceid, RX_data, "0" , &data0)     ;
+   }
+
+//
+// Now check the input Stem variable to see that there is
+//     some valid data to obtain
+//
+ if ( (rc == 0) && ( data0 <= 0 ) ) rc = -17    ;
+
+//
+// Allocate data buffer to store stem.1 variable data.
+//
+ if ( rc == 0 )
+   {
+    TRACE(traceid, ("Getting buffer for %"PRId32" bytes\n",(int32_t)data0) ) ;
+    data = buf_get(anchor, BUF_DATA, data0)                                ;
+    if ( data == NULL )
+      {
+       mqac = errno                                                        ;
+       TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)mqac) )          ;
+       rc = -16                                                            ;
+      }
+    else
+    {
+     datalen = stem_to_data(traceid, RX_data, "1", (MQBYTE *)data, data0)  ;
+     TRACE(traceid, ("Length of data received = %d\n",datalen) )           ;
+    }
+   }
+
+//
+// Now check if stem.0 specifies the same value as stem.1 length.
+// If not, don't know what to do.
+//
+ if ( (rc == 0) && ( datalen != data0 ) ) rc = -18;
+
+//
+// See if the output queue handle is valid
+//
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -14 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -15 ;
+
+
+//
+// If Context is specified (for MQPMO_PASS_ALL_CONTEXT)
+// see if the input queue handle is valid
+//
+ if ( (rc == 0) && ( pmo.Context != 0 ) )
+   {
+    if ( !OBJINRANGE(anchor,pmo.Context) )                 rc = -19 ;
+    if ( (rc == 0) && !OBJOPEN(anchor,pmo.Context) )       rc = -20 ;
+    if ( (rc == 0) && (OBJ(anchor,pmo.Context)->conn != OBJ(anchor,handle)->conn) ) rc = -20 ;
+    if   (rc == 0) pmo.Context = OBJ(anchor,pmo.Context)->Qh;
+    }
+
+//
+// A put to a distribution list has the records of each queue
+//
+ if ( (rc == 0) && (OBJ(anchor,handle)->dests > 0)
+   && pmo_dests(traceid, anchor, &pmo, RXi_pmo, !ISTMPL(RXi_pmo), OBJ(anchor,handle)->dests, NULL) )
+   {
+    mqac = errno ;
+    rc   = -16   ;
+   }
+
+//
+// Now put the data to the queue
+//
+ if (rc == 0)
+   {
+    TRACE(traceid, ("PUT Maxdatalen = %"PRId32"\n",(int32_t)data0) )                ;
+    MQPUT ( OBJHCONN(anchor,handle), OBJ(anchor,handle)->Qh, &od, &pmo, data0, data, &mqrc, &mqac ) ;
+    TRACE(traceid, ("PUT rc = %"PRId32", ac = %"PRId32"\n",(int32_t)mqrc, (int32_t)mqac) ) ;
+    PUT_ASYNC(&anchor->QM[OBJ(anchor,handle)->conn], pmo, mqrc) ;
+    if ( (pmo.Version >= MQPMO_VERSION_2) && (pmo.RecsPresent > 0) )
+       rr_to_stem(traceid, pmo.ResponseRecPtr, pmo.RecsPresent, mqrc, mqac, RXo_pmo) ;
+    uow_count(traceid, anchor, OBJ(anchor,handle)->conn, (pmo.Options & MQPMO_SYNCPOINT) != 0,
+              data0, &mqrc, &mqac) ;
+    rc = mqrc ;
+
+    make_stem_from_md(traceid,&od, RXo_md, omask_md)    ;   //Set the return Variables
+    make_stem_from_po(traceid,&pmo , RXo_pmo, omask_pmo) ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+ return 0;
+ } // End of RXMQPUT function
+
+//
+// Put several messages in one call
+//
+//   Call:   rc = RXMQputn(handle, data, input_msgdesc, input_pmo,
+//                         [commit], [reasons], [msgdesc])
+//
+//           data.1 to data.n (n being data.0) are put in turn, each with
+//           the input MD and PMO (stems or RXMQDEF templates). A message
+//           may differ from the input MD in the fields set in msgdesc.i.xxx
+//           (the fields to look at may follow the stem name, as for the
+//           output stems of RXMQPUT, so saving the fetch of the others).
+//
+//           With MQPMO_LOGICAL_ORDER in the PMO the messages are put as
+//           one logical group, the last one flagged MQMF_LAST_MSG_IN_GROUP.
+//
+//           With commit = k (> 0) the messages are put under syncpoint,
+//           and committed every k messages and at the end. The puts since
+//           the last commit are left uncommitted if the call stops early.
+//           Puts under syncpoint count toward the auto-commit policy of
+//           the connection (RXMQAUTO), and each commit starts a new batch.
+//
+//           reasons.i is set to the reason code of message i, and
+//           reasons.0 to the number of messages tried. A failed message
+//           does not stop the others, unless it is part of a group or the
+//           connection or queue handle is no longer usable. The return
+//           code is the worst completion code, with the first reason that
+//           was not MQRC_NONE.
+//
+ #define PUTNCHUNK  1048576 // Data fetched by one pool call (about)
+ #define PUTNSLOT   256     // Smallest fetch buffer per message
+
+FTYPE  RXMQPUTN  RXMQPARM
+ {
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc   = 0         ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = PUT    ;  // This function trace id
+
+ RXSTRING                RX_handle        ;  // Obj Handle
+ RXSTRING                RX_data          ;  // Variable Data
+ RXSTRING                RXi_md           ;  // Variable Input  Msg Desc
+ RXSTRING                RXi_pmo          ;  // Variable Input  PMO
+ RXSTRING                RX_out           ;  // Variable Reason codes
+ RXSTRING                RXm_md           ;  // Variable Msg Desc overrides
+ RXSTRING                RX_item          ;  // Msg Desc stem of one message
+
+ MQULONG                 omask_md  = ALLFIELDS ;  // (templates' masks, unused)
+ MQULONG                 omask_pmo = ALLFIELDS ;
+ MQULONG                 mmask_md  = ALLFIELDS ;  // Override MD fields wanted
+
+ MQLONG                  handle    = 0    ;  // MQ object number
+ RXMQOBJ               * obj       = 0    ;  //   its entry
+ MQLONG                  commit    = 0    ;  // Commit every (0 never)
+ MQMD2                   md_in            ;  // MQ Message descriptor
+ MQMD2                   md               ;  //   of this message
+ MQPMO                   pmo_in           ;  // MQ Put Message options
+ MQPMO                   pmo              ;  //   of this message
+ int                     group     = 0    ;  // Put as a logical group
+ MQLONG                  data0     = 0    ;  // Messages to put
+ char                 *  slots     = 0    ;  //-> Fetched data, slot each
+ char                 *  data             ;  //-> Data of this message
+ MQLONG                  slot             ;  //   Slot size
+ MQLONG                  size             ;  //   Buffer size of a refetch
+ MQLONG                  datalen          ;  //   Data length
+ MQLONG                  m         = 0    ;  // Messages fetched together
+ MQLONG                  j                ;  //   this one of them
+ MQLONG                  n         = 0    ;  // Messages tried
+ MQLONG                  done      = 0    ;  //   put since the last commit
+ MQLONG                  worstcc   = 0    ;  // Outcome of the call
+ MQLONG                  firstac   = 0    ;
+ int                     stop      = 0    ;  // Failure ending the call
+ int                     started   = 0    ;  // Putting begun
+ char                    tail[24]         ;  // Message number
+ char                    itemnam[VARNAMLEN] ; // Msg Desc stem name
+ SHVCHAIN                chain            ;  // Data fetches
+ SHVCHAIN                outs             ;  // Reason code sets
+ SHVBLOCK              * sv               ;  // Block of a refetch
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null handle"},
+        {  -3, "Zero data handle"},
+        {  -4, "Null data stem var"},
+        {  -5, "Zero data stem var"},
+        {  -6, "Null input MsgDesc"},
+        {  -7, "Zero length input MsgDesc"},
+        {  -8, "Zero length commit count"},
+        {  -9, "Zero length reasons stem"},
+        { -10, "Null input PMO"},
+        { -11, "Zero length input PMO"},
+        { -12, "Zero length MsgDesc overrides"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Bad number of messages"},
+        { -18, "Message data not set"},
+        { -19, "Context handle out of range"},
+        { -20, "Invalid Context handle"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ((aargc < 4) || (aargc > 7)) ) rc = -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[3]) )    rc = -10 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc = -11 ;
+ if ( (rc == 0) && (aargc > 4) && RXZEROLENSTRING(aargv[4]) ) rc =  -8 ;
+ if ( (rc == 0) && (aargc > 5) && RXZEROLENSTRING(aargv[5]) ) rc =  -9 ;
+ if ( (rc == 0) && (aargc > 6) && RXZEROLENSTRING(aargv[6]) ) rc = -12 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+   {
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
+    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))   ;
+    memcpy(&RXi_md,   &aargv[2],sizeof(RXi_md))    ;
+    memcpy(&RXi_pmo,  &aargv[3],sizeof(RXi_pmo))   ;
+    RX_out.strptr = NULL ; RX_out.strlength = 0    ;
+    RXm_md.strptr = NULL ; RXm_md.strlength = 0    ;
+    if ( aargc > 4 ) parm_to_ulong(aargv[4], &commit) ;
+    if ( aargc > 5 ) memcpy(&RX_out,&aargv[5],sizeof(RX_out)) ;
+    if ( aargc > 6 ) memcpy(&RXm_md,&aargv[6],sizeof(RXm_md)) ;
+
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("RX_data = %.*s\n",  (int)RX_data.strlength,  RX_data.strptr)   ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n",   (int)RXi_md.strlength,   RXi_md.strptr)    ) ;
+    TRACE(traceid, ("RXi_pmo = %.*s\n",  (int)RXi_pmo.strlength,  RXi_pmo.strptr)   ) ;
+    TRACE(traceid, ("commit = %"PRId32"\n",(int32_t)commit)                         ) ;
+    TRACE(traceid, ("RX_out = %.*s\n",   (int)RX_out.strlength,   RX_out.strptr)    ) ;
+    TRACE(traceid, ("RXm_md = %.*s\n",   (int)RXm_md.strlength,   RXm_md.strptr)    ) ;
+
+    if ( !ISTMPL(RXi_md) )                                        make_md_from_stem(traceid,&md_in, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &md_in, &omask_md) ) rc = -97 ;
+    if ( !ISTMPL(RXi_pmo) )                                       make_po_from_stem(traceid,&pmo_in, RXi_pmo ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_PMO,RXi_pmo,&pmo_in,&omask_pmo) ) rc = -97 ;
+    if ( (rc == 0) && out_mask(md_fields, &RXm_md, &mmask_md) ) rc = -96 ;
+    mmask_md &= ~FLD_ZLIST ;
+
+    parm_to_ulong(RX_handle, &handle)              ;
+    stem_to_long(traceid, RX_data, "0" , &data0)   ;
+   }
+
+ if ( (rc == 0) && ( data0 < 0 ) ) rc = -17     ;
+
+//
+// See if the output queue handle is valid
+//
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -14 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -15 ;
+
+//
+// If Context is specified (for MQPMO_PASS_ALL_CONTEXT)
+// see if the input queue handle is valid
+//
+ if ( (rc == 0) && ( pmo_in.Context != 0 ) )
+   {
+    if ( !OBJINRANGE(anchor,pmo_in.Context) )              rc = -19 ;
+    if ( (rc == 0) && !OBJOPEN(anchor,pmo_in.Context) )    rc = -20 ;
+    if ( (rc == 0) && (OBJ(anchor,pmo_in.Context)->conn != OBJ(anchor,handle)->conn) ) rc = -20 ;
+    if   (rc == 0) pmo_in.Context = OBJ(anchor,pmo_in.Context)->Qh;
+   }
+
+//
+// A group needs the version 2 MD, and committing the syncpoint
+//
+ if (rc == 0)
+   {
+    obj     = OBJ(anchor,handle)                                 ;
+    started = 1                                                  ;
+    group   = ( (pmo_in.Options & MQPMO_LOGICAL_ORDER) != 0 )    ;
+    if ( group )
+      {
+       md_in.Version   = MQMD_VERSION_2                          ;
+       md_in.MsgFlags |= MQMF_MSG_IN_GROUP                       ;
+      }
+    if ( commit > 0 )
+       pmo_in.Options = (pmo_in.Options & ~MQPMO_NO_SYNCPOINT) | MQPMO_SYNCPOINT ;
+    chain.count = 0                                              ;
+    outs.count  = 0                                              ;
+   }
+
+//
+// Fetch the data of up to MAXCHAIN messages at a time, each into a slot
+// the size of the recent messages, and put them in turn. A message too
+// big for its slot is fetched again on its own, into a buffer that is
+// doubled until it fits.
+//
+ while ( (rc == 0) && !stop && (n < data0) )
+   {
+    slot = obj->est + obj->est / 4                                 ; // Some room to grow
+    if ( slot < PUTNSLOT )           slot = PUTNSLOT               ;
+    m    = data0 - n                                               ;
+    if ( m > MAXCHAIN )              m = MAXCHAIN                  ;
+    if ( m > PUTNCHUNK / slot )      m = PUTNCHUNK / slot          ;
+    if ( m < 1 )                     m = 1                         ;
+
+    slots = (char *) buf_get(anchor, BUF_WORK, m * slot)           ;
+    if ( slots == NULL ) { mqac = errno ; rc = -16 ; break ; }
+
+    chain.count = 0                                                ;
+    for ( j = 0 ; j < m ; j++ )
+      {
+       num_to_str(tail, (uint64_t)(n + j + 1), 0)                  ;
+       shv_fetch(&chain, RX_data, tail, NULL, slots + j * slot, slot) ;
+      }
+    shv_run(traceid, &chain)                                       ;
+
+    for ( j = 0 ; (j < m) && (rc == 0) && !stop ; j++ )
+      {
+       sv      = &chain.sv[j]                                      ;
+       data    = sv->shvvalue.strptr                               ;
+       datalen = (MQLONG) sv->shvvalue.strlength                   ;
+       if ( sv->shvret & RXSHV_NEWV ) { rc = -18 ; break ; }
+
+       for ( size = slot ; sv->shvret & RXSHV_TRUNC ; )
+         {
+          if ( size >= 0x40000000 ) break                          ;
+          data = (char *) buf_get(anchor, BUF_DATA, size * 2)      ;
+          if ( data == NULL ) { mqac = errno ; rc = -16 ; break ; }
+          size = anchor->Buf[BUF_DATA].size                        ;
+          TRACE(traceid, ("Message is bigger, fetching %"PRId32" bytes\n",(int32_t)size) ) ;
+          sv->shvnext     = NULL                                   ; // This block alone
+          sv->shvret      = 0                                      ;
+          MAKERXSTRING(sv->shvvalue, data, size)                   ;
+          sv->shvvaluelen = size                                   ;
+          RexxVariablePool(sv)                                     ;
+          datalen = (MQLONG) sv->shvvalue.strlength                ;
+         }
+       if ( rc != 0 ) break                                        ;
+
+       if ( datalen >= obj->est ) obj->est  = datalen              ;
+       else                       obj->est -= (obj->est - datalen) / 8 ;
+
+       memcpy(&md , &md_in , sizeof(MQMD2))                        ;
+       memcpy(&pmo, &pmo_in, sizeof(MQPMO))                        ;
+       num_to_str(tail, (uint64_t)(n + 1), 0)                      ;
+       if ( !RXNULLSTRING(RXm_md) )
+         {
+          MAKERXSTRING(RX_item, itemnam, make_varname(itemnam, RXm_md, tail, ".")) ;
+          stem_to_fields(traceid, anchor, md_fields, &md, RX_item, mmask_md) ;
+         }
+       if ( group && (n + 1 == data0) ) md.MsgFlags |= MQMF_LAST_MSG_IN_GROUP ;
+
+       MQPUT ( OBJHCONN(anchor,handle), obj->Qh, &md, &pmo, datalen, data, &mqrc, &mqac ) ;
+       TRACE(traceid, ("PUT %s rc = %"PRId32", ac = %"PRId32"\n",tail,(int32_t)mqrc,(int32_t)mqac) ) ;
+       PUT_ASYNC(&anchor->QM[obj->conn], pmo, mqrc)                ;
+       uow_count(traceid, anchor, obj->conn, (pmo.Options & MQPMO_SYNCPOINT) != 0,
+                 datalen, &mqrc, &mqac)                            ;
+
+       n++                                                         ;
+       if ( mqrc != MQCC_FAILED ) done++                           ;
+       if ( UOW_AUTO(&anchor->QM[obj->conn]) && (anchor->QM[obj->conn].Pending == 0) )
+          done = 0                                                 ; // Committed by the policy
+       if ( mqrc > worstcc )                    worstcc = mqrc     ;
+       if ( (mqac != MQRC_NONE) && (firstac == MQRC_NONE) ) firstac = mqac ;
+       if ( !RXNULLSTRING(RX_out) )
+         {
+          shv_flush(traceid, &outs, 1)                             ;
+          shv_set_long(&outs, RX_out, tail, NULL, mqac)            ;
+         }
+
+       if ( mqrc == MQCC_FAILED )
+         {
+          if (    group
+               || (mqac == MQRC_CONNECTION_BROKEN)
+               || (mqac == MQRC_CONNECTION_QUIESCING)
+               || (mqac == MQRC_CONNECTION_STOPPING)
+               || (mqac == MQRC_Q_MGR_STOPPING)
+               || (mqac == MQRC_Q_MGR_NOT_AVAILABLE)
+               || (mqac == MQRC_HCONN_ERROR)
+               || (mqac == MQRC_HOBJ_ERROR) ) stop = 1            ;
+         }
+
+       if ( !stop && (commit > 0) && ((n % commit == 0) || (n == data0)) && (done > 0) )
+         {
+          uow_commit(traceid, anchor, obj->conn, 0, &mqrc, &mqac)  ;
+          done = 0                                                 ;
+          if ( mqrc > worstcc )                    worstcc = mqrc  ;
+          if ( (mqac != MQRC_NONE) && (firstac == MQRC_NONE) ) firstac = mqac ;
+          if ( mqrc == MQCC_FAILED ) stop = 1                      ;
+         }
+      }
+   }
+
+ if ( (rc == 0) && started )
+   {
+    mqrc = worstcc ;
+    mqac = firstac ;
+    rc   = mqrc    ;
+   }
+ TRACE(traceid, ("%"PRId32" messages put of %"PRId32"\n",(int32_t)n,(int32_t)data0) ) ;
+
+ if ( started && !RXNULLSTRING(RX_out) )
+   {
+    shv_flush(traceid, &outs, 1)                ;
+    shv_set_long(&outs, RX_out, "0", NULL, n)   ;
+    shv_run(traceid, &outs)                     ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+ return 0;
+ } // End of RXMQPUTN function
+
+//
+// Do a put    MQPUT1
+//
+//   Call:   rc = RXMQPUT1(input1_objdesc, output1_objdesc, data,
+//                         input1_msgdesc,output1_msgdesc,
+//                         input1_pmo,output1_pmo [,conn])
+//        or
+//           rc = RXMQPUT1(queue_name, output1_objdesc, data,
+//                         input1_msgdesc,output1_msgdesc,
+//                         input1_pmo,output1_pmo [,conn])
+//
+//           A distribution list is put to as for RXMQPUT, with the
+//           list itself named by input1_objdesc.
+//
+FTYPE RXMQPUT1  RXMQPARM
+ {
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = PUT1   ;  // This function trace id
+
+ RXSTRING                RXi_od           ;  // Stem Var Obj Desc Input
+ RXSTRING                RXo_od           ;  // Stem Var Obj Desc Output
+ RXSTRING                RX_data          ;  // Variable Data
+ RXSTRING                RXi_md           ;  // Variable Input1  Msg Desc
+ RXSTRING                RXo_md           ;  // Variable Output1 Msg Desc
+ RXSTRING                RXi_pmo          ;  // Variable Input1  PMO
+ RXSTRING                RXo_pmo          ;  // Variable Output1 PMO
+
+ MQULONG                 omask_od = ALLFIELDS ;  // Output OD fields wanted
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+ MQULONG                 omask_pmo = ALLFIELDS;  // Output PMO fields wanted
+
+ MQOD                    od               ;  // MQ object descriptor
+ MQMD2                   md               ;  // MQ Message descriptor
+ MQPMO                   pmo              ;  // MQ put1 Message options
+ void                 *  data  = 0        ;  //-> Data buffer
+ MQLONG                  data0 = 0        ;  // Variable Data len
+ int                     datalen          ;  //   Data length
+ MQLONG                  oopts            ;  // Open options to cache
+ int                     theobj    = 0    ;  //   cached object to use
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null input OD/Qname"},
+        {  -3, "Zero length input OD/Qname"},
+        {  -5, "Zero length output OD"},
+        {  -6, "Null data stem var"},
+        {  -7, "Zero data stem var"},
+        {  -8, "Null input MsgDesc"},
+        {  -9, "Zero length input MsgDesc"},
+        { -11, "Zero length output MsgDesc"},
+        { -12, "Null input PMO"},
+        { -13, "Zero length input PMO"},
+        { -15, "Zero length output PMO"},
+        { -17, "malloc failure, check reason code"},
+        { -18, "Zero length input data buffer"},
+        { -19, "Data length is not equal to specified value"},
+        { -20, "Context handle out of range"},
+        { -21, "Invalid context handle"},
+        { -95, "Bad connection id"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ((aargc < 7) || (aargc > 8)) ) rc = -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[3]) )    rc =  -8 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc = -11 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[5]) )    rc = -12 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[5]) ) rc = -13 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[6]) ) rc = -15 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 7, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+   {
+    memcpy(&RXi_od, &aargv[0],sizeof(RXi_od))  ;
+    memcpy(&RXo_od, &aargv[1],sizeof(RXo_od))  ;
+    memcpy(&RX_data,&aargv[2],sizeof(RX_data)) ;
+    memcpy(&RXi_md, &aargv[3],sizeof(RXi_md))  ;
+    memcpy(&RXo_md, &aargv[4],sizeof(RXo_md))  ;
+    memcpy(&RXi_pmo,&aargv[5],sizeof(RXi_pmo)) ;
+    memcpy(&RXo_pmo,&aargv[6],sizeof(RXo_pmo)) ;
+
+    TRACE(traceid, ("RXi_od = %.*s\n", (int)RXi_od.strlength, RXi_od.strptr)  ) ;
+    TRACE(traceid, ("RXo_od = %.*s\n", (int)RXo_od.strlength, RXo_od.strptr)  ) ;
+    TRACE(traceid, ("RX_data = %.*s\n",(int)RX_data.strlength,RX_data.strptr) ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n", (int)RXi_md.strlength, RXi_md.strptr)  ) ;
+    TRACE(traceid, ("RXo_md = %.*s\n", (int)RXo_md.strlength, RXo_md.strptr)  ) ;
+    TRACE(traceid, ("RXi_pmo = %.*s\n",(int)RXi_pmo.strlength,RXi_pmo.strptr) ) ;
+    TRACE(traceid, ("RXo_pmo = %.*s\n",(int)RXo_pmo.strlength,RXo_pmo.strptr) ) ;
+
+    if ( !ISTMPL(RXi_od) )                                        make_od_from_stem(traceid,anchor,&od, RXi_od ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_OD, RXi_od, &od, &omask_od) ) rc = -97 ;
+    if ( !ISTMPL(RXi_md) )                                        make_md_from_stem(traceid,&md, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &md, &omask_md) ) rc = -97 ;
+    if ( !ISTMPL(RXi_pmo) )                                       make_po_from_stem(traceid,&pmo,RXi_pmo) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_PMO,RXi_pmo,&pmo, &omask_pmo) ) rc = -97 ;
+    if ( (rc == 0) && out_mask(od_fields, &RXo_od,  &omask_od  ) ) rc = -96 ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md,  &omask_md  ) ) rc = -96 ;
+    if ( (rc == 0) && out_mask(po_fields, &RXo_pmo, &omask_pmo ) ) rc = -96 ;
+    stem_to_long     (traceid,RX_data, "0" , &data0  ) ;
+   }
+
+//
+// Now check the input Stem variable to see that there is
+//     some valid data to obtain
+//
+ if ( (rc == 0) && ( data0 <= 0 ) )  rc = -18 ;
+
+//
+// Allocate data buffer to store stem.1 variable data.
+//
+ if ( rc == 0 )
+   {
+    TRACE(traceid, ("Getting buffer for %"PRId32" bytes\n",(int32_t)data0) )  ;
+    data = buf_get(anchor, BUF_DATA, data0)                                 ;
+    if ( data == NULL )
+      {
+       mqac = errno                                                         ;
+       TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)mqac) )           ;
+       rc = -17                                                             ;
+      }
+    else
+      {
+       datalen = stem_to_data(traceid, RX_data, "1", (MQBYTE *)data, data0) ;
+       TRACE(traceid, ("Length of data received = %d\n",datalen) )          ;
+      }
+   }
+
+//
+// Now check if stem.0 specifies the same value as stem.1 length.
+// If not, don't know what to do.
+//
+ if ( (rc == 0) && ( datalen != data0 ) ) rc = -19 ;
+
+ //
+ // If Context is specified (for MQPMO_PASS_ALL_CONTEXT)
+ // see if the input queue handle is valid (ie: the gmqo to use)
+ //
+  if ( (rc == 0) && ( pmo.Context != 0 ) )
+    {
+     if ( !OBJINRANGE(anchor,pmo.Context) )                rc = -20 ;
+     if ( (rc == 0) && !OBJOPEN(anchor,pmo.Context) )      rc = -21 ;
+     if ( (rc == 0) && (OBJ(anchor,pmo.Context)->conn != conn) ) rc = -21 ;
+     if (rc == 0) pmo.Context = OBJ(anchor,pmo.Context)->Qh          ;
+    }
+
+//
+// A put to a distribution list has the records of each queue
+//
+ if ( (rc == 0) && (OD_DESTS(&od) > 0)
+   && pmo_dests(traceid, anchor, &pmo, RXi_pmo, !ISTMPL(RXi_pmo), od.RecsPresent, od.ResponseRecPtr) )
+   {
+    mqac = errno ;
+    rc   = -17   ;
+   }
+
+//
+// With the cache on, and no context or alternate user wanted, use a
+// cached handle for the queue, or open one to be cached after the put
+//
+ if ( (rc == 0) && (anchor->Cache.max > 0)
+   && !(pmo.Options & ( MQPMO_PASS_IDENTITY_CONTEXT | MQPMO_PASS_ALL_CONTEXT
+                      | MQPMO_SET_IDENTITY_CONTEXT  | MQPMO_SET_ALL_CONTEXT
+                      | MQPMO_ALTERNATE_USER_AUTHORITY )) )
+   {
+    oopts  = MQOO_OUTPUT
+           | ( (pmo.Options & MQPMO_FAIL_IF_QUIESCING) ? MQOO_FAIL_IF_QUIESCING : 0 ) ;
+    theobj = cache_open(traceid, anchor, conn, &od, oopts)    ;
+   }
+
+//
+// Now execute PUT1 (or the PUT on the cached handle)
+//
+ if ( (rc == 0) && (theobj != 0) )
+   {
+    TRACE(traceid, ("PUT Maxdatalen is %"PRId32"\n",(int32_t)data0) ) ;
+    MQPUT ( anchor->QM[conn].QMh, anchor->Obj[theobj].Qh, &md, &pmo, data0, data, &mqrc, &mqac ) ;
+    TRACE(traceid, ("PUT rc = %"PRId32", ac = %"PRId32"\n",
+          (int32_t)mqrc,(int32_t)mqac) )                               ;
+    PUT_ASYNC(&anchor->QM[conn], pmo, mqrc)                            ;
+    uow_count(traceid, anchor, conn, (pmo.Options & MQPMO_SYNCPOINT) != 0, data0, &mqrc, &mqac) ;
+    rc   = mqrc ;
+
+    cache_done(traceid, anchor, theobj) ;
+
+    make_stem_from_md(traceid,&md,  RXo_md, omask_md) ;   //Set the return Variables
+    make_stem_from_po(traceid,&pmo, RXo_pmo, omask_pmo) ;
+    make_stem_from_od(traceid,&od,  RXo_od, omask_od) ;
+   }
+ else if (rc == 0)
+   {
+    TRACE(traceid, ("PUT1 Maxdatalen is %"PRId32"\n",(int32_t)data0) ) ;
+    MQPUT1 ( anchor->QM[conn].QMh, &od, &md, &pmo, data0, data, &mqrc, &mqac )  ;
+    TRACE(traceid, ("PUT1 rc = %"PRId32", ac = %"PRId32"\n",
+          (int32_t)mqrc,(int32_t)mqac) )                               ;
+    PUT_ASYNC(&anchor->QM[conn], pmo, mqrc)                            ;
+    if ( OD_DESTS(&od) > 0 )
+       rr_to_stem(traceid, od.ResponseRecPtr, od.RecsPresent, mqrc, mqac, RXo_pmo) ;
+    uow_count(traceid, anchor, conn, (pmo.Options & MQPMO_SYNCPOINT) != 0, data0, &mqrc, &mqac) ;
+    rc   = mqrc ;
+
+    make_stem_from_md(traceid,&md,  RXo_md, omask_md) ;
+    make_stem_from_po(traceid,&pmo, RXo_pmo, omask_pmo) ;
+    make_stem_from_od(traceid,&od,  RXo_od, omask_od) ;
+   }
+
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+} // End of RXMQPUT1 function
+
+//
+// Do a Get     MQGET
+//
+//   Call:   rc = RXMQget(handle, data,
+//                        input_msgdesc,output_msgdesc,
+//                        input_gmo,output_gmo)
+//
+FTYPE  RXMQGET  RXMQPARM
+ {
+
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = GET    ;  // This function trace id
+
+ RXSTRING                RX_handle        ;  // Obj Handle
+ RXSTRING                RX_data          ;  // Variable Data
+ RXSTRING                RXi_md           ;  // Variable Input  Msg Desc
+ RXSTRING                RXo_md           ;  // Variable Output Msg Desc
+ RXSTRING                RXi_gmo          ;  // Variable Input  GMO
+ RXSTRING                RXo_gmo          ;  // Variable Output GMO
+
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+ MQULONG                 omask_gmo = ALLFIELDS;  // Output GMO fields wanted
+
+ MQLONG                  handle    = 0    ;  // MQ object number
+ MQMD2                   md               ;  // MQ Message descriptor
+ MQGMO                   gmo              ;  // MQ Get Message options
+ void                 *  data      = 0    ;  //-> Data buffer
+ MQLONG                  data0     = 0    ;  //   Data length max
+ SHVCHAIN                chain            ;  // data.0 and data.1 sets
+ MQLONG                  datalen   = 0    ;  //   Data length actual
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null handle"},
+        {  -3, "Zero data handle"},
+        {  -4, "Null data stem var"},
+        {  -5, "Zero data stem var"},
+        {  -6, "Null input MsgDesc"},
+        {  -7, "Zero length input MsgDesc"},
+        {  -9, "Zero length output MsgDesc"},
+        { -10, "Null input GMO"},
+        { -11, "Zero length input GMO"},
+        { -13, "Zero length output GMO"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Negative input data length"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+
+ if ( (rc == 0) && (aargc != 6 ) )             rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[4]) )    rc = -10 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc = -11 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[5]) ) rc = -13 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+
+ if (rc == 0)
+   {
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
+    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))   ;
+    memcpy(&RXi_md,   &aargv[2],sizeof(RXi_md))    ;
+    memcpy(&RXo_md,   &aargv[3],sizeof(RXo_md))    ;
+    memcpy(&RXi_gmo,  &aargv[4],sizeof(RXi_gmo))   ;
+    memcpy(&RXo_gmo,  &aargv[5],sizeof(RXo_gmo))   ;
+
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("RX_data = %.*s\n",  (int)RX_data.strlength,  RX_data.strptr)   ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n",   (int)RXi_md.strlength,   RXi_md.strptr)    ) ;
+    TRACE(traceid, ("RXo_md = %.*s\n",   (int)RXo_md.strlength,   RXo_md.strptr)    ) ;
+    TRACE(traceid, ("RXi_gmo = %.*s\n",  (int)RXi_gmo.strlength,  RXi_gmo.strptr)   ) ;
+    TRACE(traceid, ("RXo_gmo = %.*s\n",  (int)RXo_gmo.strlength,  RXo_gmo.strptr)   ) ;
+
+
+    if ( !ISTMPL(RXi_md) )                                        make_md_from_stem(traceid,&md, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &md, &omask_md) ) rc = -97 ;
+    if ( !ISTMPL(RXi_gmo) )                                       make_go_from_stem(traceid,&gmo , RXi_gmo ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_GMO,RXi_gmo,&gmo, &omask_gmo) ) rc = -97 ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md,  &omask_md  ) ) rc = -96 ;
+    if ( (rc == 0) && out_mask(go_fields, &RXo_gmo, &omask_gmo ) ) rc = -96 ;
+    parm_to_ulong(RX_handle, &handle)            ;
+    stem_to_long(traceid, RX_data, "0" , &data0) ;
+   }
+
+//
+// Now check the input Stem variable for the length wanted
+//     (0 -> let get_msg size the buffer)
+//
+  if ( (rc == 0) && ( data0 < 0 ) ) rc = -17 ;
+
+//
+// See if the handle is valid
+//
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -14 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -15 ;
+
+//
+// Now get the data from the queue
+//
+ if (rc == 0)
+   {
+    data = get_msg(traceid, anchor, OBJ(anchor,handle), &md, &gmo, &data0, &datalen, &mqrc, &mqac) ;
+    if ( data != NULL )
+       uow_count(traceid, anchor, OBJ(anchor,handle)->conn, GMO_IN_UOW(gmo,md), datalen, &mqrc, &mqac) ;
+    rc   = ( data == NULL ) ? -16 : mqrc                                               ;
+   }
+
+ if (data != NULL)
+   {
+    make_stem_from_md(traceid,&md,  RXo_md, omask_md) ;  //Set the return Variables
+    make_stem_from_go(traceid,&gmo, RXo_gmo, omask_gmo) ;
+
+    chain.count = 0                                                        ;
+    shv_set_long(&chain, RX_data, "0", NULL, datalen)                      ;
+    if (datalen > data0) datalen = data0                                   ;
+    shv_set     (&chain, RX_data, "1", NULL, data, datalen, 1)             ;
+    shv_run(traceid, &chain)                                               ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQGET function
+
+//
+// Do an inquire MQINQ
+//
+//   Call:   rc = RXMQinq(handle, attribute, attrsetting )
+//
+//           NB: only 1 attribute at a time!
+//
+//
+FTYPE  RXMQINQ  RXMQPARM
+ {
+
+ RXMQCB         * anchor = 0           ;  // RXMQ Control Block
+ MQLONG           rc = 0               ;  // Function Return Code
+ MQLONG           mqrc = 0             ;  // MQ RC
+ MQLONG           mqac = 0             ;  // MQ AC
+ MQULONG          traceid = INQ        ;  // This function trace id
+
+ RXSTRING         RX_handle            ;  // Data     Obj Handle
+ RXSTRING         RX_attr              ;  // Variable Input  Attr
+ RXSTRING         RX_value             ;  // Variable Output Attr
+
+ MQLONG           handle       = 0     ;  // MQ object number
+ MQLONG           attrib       = 0     ;  // object attribute
+
+ MQLONG           inqselcount  = 1     ;  //INQ - number of sels
+ MQLONG           inqselicount = 1     ;  //INQ - number of int sels
+ MQLONG           inqints      = 0     ;  //INQ - integer return
+ MQLONG           inqcharlen   = 600   ;  //INQ - char return length
+ char             inqchars[601]        ;  //INQ - char return
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null handle"},
+        {  -3, "Zero data handle"},
+        {  -4, "Null data input attr"},
+        {  -5, "Zero data input attr"},
+        {  -6, "Null output attr"},
+        {  -7, "Zero length output attr"},
+        {  -8, "No attribute supplied"},
+        {  -9, "Attribute out of valid range"},
+        { -10, "Handle out of range"},
+        { -11, "Invalid handle"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && (aargc != 3 ) )             rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+   {
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
+    memcpy(&RX_attr,  &aargv[1],sizeof(RX_attr))   ;
+    memcpy(&RX_value, &aargv[2],sizeof(RX_value))  ;
+
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("RX_attr = %.*s\n",  (int)RX_attr.strlength,  RX_attr.strptr)   ) ;
+    TRACE(traceid, ("RX_value = %.*s\n", (int)RX_value.strlength, RX_value.strptr)  ) ;
+
+    parm_to_ulong(RX_handle, &handle) ;
+    parm_to_ulong(RX_attr,   &attrib) ;
+
+    if (attrib == 0) rc = -8          ;
+
+    if ( !( ( (attrib >= MQIA_FIRST) && (attrib <= MQIA_LAST  ) )
+         || ( (attrib >= MQCA_FIRST) && (attrib <= MQCA_LAST  ) ) ) ) rc = -9;
+   }
+//
+// See if the handle is valid
+//
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -10 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -11 ;
+
+//
+// Format up either a character or an integer area
+//
+ if (rc == 0)
+   {
+    memset(inqchars,0,sizeof(inqchars)) ;
+    if ( (attrib >= MQCA_FIRST  ) && (attrib <= MQCA_LAST  ) )
+      inqselicount = 0 ;
+    else
+      inqcharlen   = 0 ;
+   } //End of Attribute setup
+
+//
+// Now do the Inquiry and return the setting
+//
+ if (rc == 0)
+   {
+    TRACE(traceid, ("Attr = %"PRId32", IntSelNum = %"PRId32", CharAttrLen = %"PRId32"\n",
+                    (int32_t)attrib,(int32_t)inqselicount,(int32_t)inqcharlen) );
+    MQINQ ( OBJHCONN(anchor,handle) , OBJ(anchor,handle)->Qh,
+            inqselcount , &attrib  ,
+            inqselicount, &inqints ,
+            inqcharlen  , inqchars ,
+            &mqrc, &mqac ) ;
+    rc   = mqrc ;
+    TRACE(traceid, ("INQ rc = %"PRId32", ac = %"PRId32", Intval = %"PRId32", Charval = %s\n",
+          (int32_t)mqrc,(int32_t)mqac,(int32_t)inqints,inqchars) ) ;
+
+    if ( (attrib >= MQCA_FIRST  ) && (attrib <= MQCA_LAST) )
+      stem_from_string(traceid, NULL, RX_value, "", inqchars, inqcharlen) ;
+    else
+      stem_from_long  (traceid, NULL, RX_value, "", inqints) ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQINQ function
+
+//
+// Do a set      MQSET
+//
+//   Call:   rc = RXMQset(handle, attribute, atttrsetting )
+//
+//           NB: only 1 attribute at a time!
+//
+//
+FTYPE  RXMQSET  RXMQPARM
+ {
+
+ RXMQCB         * anchor = 0           ;  // RXMQ Control Block
+ MQLONG           rc = 0               ;  // Function Return Code
+ MQLONG           mqrc = 0             ;  // MQ RC
+ MQLONG           mqac = 0             ;  // MQ AC
+ MQULONG          traceid = SET        ;  // This function trace id
+
+ RXSTRING         RX_handle            ;  // Data     Obj Handle
+ RXSTRING         RX_attr              ;  // Variable Input  Attr
+ RXSTRING         RX_value             ;  // Variable Set    Attr
+
+ MQLONG           handle       = 0     ;  //MQ object number
+ MQLONG           attrib       = 0     ;  // object attribute
+
+ MQLONG           setselcount  = 1     ;  //SET - number of sels
+ MQLONG           setselicount = 1     ;  //SET - number of int sels
+ MQLONG           setints      = 0     ;  //SET - integer return
+ MQLONG           setcharlen   = 600   ;  //SET - char return length
+ char             setchars[601]        ;  //SET - char return
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null handle"},
+        {  -3, "Zero data handle"},
+        {  -4, "Null data attribute"},
+        {  -5, "Zero data attribute"},
+        {  -6, "Null setting"},
+        {  -7, "Zero length setting"},
+        {  -8, "No attribute supplied"},
+        {  -9, "Attribute out of valid range"},
+        { -10, "Handle out of range"},
+        { -11, "Invalid handle"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+
+ if ( (rc == 0) && (aargc != 3 ) )             rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
+
+//
+// Now the parms are correct, get them
+//
+ if (rc == 0)
+   {
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
+    memcpy(&RX_attr,  &aargv[1],sizeof(RX_attr))   ;
+    memcpy(&RX_value, &aargv[2],sizeof(RX_value))  ;
+
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("RX_attr = %.*s\n",  (int)RX_attr.strlength,  RX_attr.strptr)   ) ;
+    TRACE(traceid, ("RX_value = %.*s\n", (int)RX_value.strlength, RX_value.strptr)  ) ;
+
+    parm_to_ulong(RX_handle, &handle) ;
+    parm_to_ulong(RX_attr,   &attrib) ;
+
+    if (attrib == 0) rc = -8 ;
+
+    if ( !( ( (attrib >= MQIA_FIRST) && (attrib <= MQIA_LAST  ) )
+         || ( (attrib >= MQCA_FIRST) && (attrib <= MQCA_LAST  ) ) ) ) rc = -9;
+   }
+
+//
+// See if the handle is valid (ie: the gmqo to use)
+//
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -10 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -11 ;
+
+//
+//
+// Format up either a character or an integer area
+//
+ if (rc == 0)
+   {
+    memset(setchars,' ',sizeof(setchars))                     ;
+    if ( (attrib >= MQCA_FIRST  ) && (attrib <= MQCA_LAST  ) )
+      {
+       setselicount = 0                                       ;
+       memcpy(setchars,RX_value.strptr,RX_value.strlength)    ;
+
+      }      //End of Char Attr processing
+    else      //Int attr processing
+      {
+       setcharlen   = 0                                       ;
+       parm_to_ulong(RX_value,  &setints)                     ;
+      }      //End of Int Attr processing
+
+   } //End of Attribute building
+
+//
+// Now do the Setting
+//
+ if (rc == 0)
+   {
+    TRACE(traceid, ("Attr = %"PRId32", IntSelNum = %"PRId32", IntSelVal = %"PRId32", CharAtrLen = %"PRId32", CharSetVal = %s\n",
+          (int32_t)attrib,(int32_t)setselicount,(int32_t)setints,(int32_t)setcharlen,setchars) ) ;
+    MQSET ( OBJHCONN(anchor,handle) , OBJ(anchor,handle)->Qh,
+            setselcount , &attrib   ,
+            setselicount, &setints  ,
+            setcharlen  , setchars  ,
+            &mqrc, &mqac ) ;
+    rc   = mqrc ;
+    TRACE(traceid, ("MQSET rc = %"PRId32", ac = %"PRId32"\n",(int32_t)mqrc,(int32_t)mqac) ) ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQSET function
+
+//
+// Do a Subscribe MQSUB
+//
+//   Call:   rc = RXMQsub(isdesc,handle,osdesc [,conn])
+//
+FTYPE  RXMQSUB  RXMQPARM
+ {
 
-  varvalc[sv1.shvvalue.strlength] = 0                 ; // Ensure zero terminated
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = SUB    ;  // This function trace id
 
-  if (   (sv1rc != RXSHV_OK)
-      || (sv1.shvname.strlength == 0) )
-    sprintf(varvalc,"%"PRId32,(int32_t)pcfnum)        ; // When something goes wrong
+ RXSTRING                RX_handle        ;  //      Var Obj Handle
+ RXSTRING                RXi_sd           ;  // Stem Var Sub Desc Input
+ RXSTRING                RXo_sd           ;  // Stem Var Sub Desc Output
 
-  // TRACE(EVENT, ("Converted %"PRId32" into %s\n",(int32_t)pcfnum,varvalc) )  ;
+ MQULONG                 omask_sd = ALLFIELDS ;  // Output SD fields wanted
 
-  strcat(output, varvalc)                             ; // Concatenate
+ MQSD                    sd               ;  // MQ subscription desc
+ int                     theobj     =  0  ;  // gmqo object to use
+ MQHOBJ                  sh               ;  // Subscription handle
 
-  return ;
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null input SD"},
+        {  -3, "Zero length input SD"},
+        {  -6, "Null handle name"},
+        {  -7, "Zero length handle name"},
+        {  -9, "Zero length Output SD"},
+        { -10, "No available objects"},
+        { -95, "Bad connection id"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
 
- } // End of geteventname function
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
 
 //
-// External Functions, callable from Rexx
+// Check the parms
 //
+ if ( (rc == 0) && ((aargc < 3) || (aargc > 4)) ) rc = -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -7 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -9 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 3, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
 
 //
-// initialize the interface - RXMQINIT
-//
-//    For Windows, AIX, Linux this function installs the other functions of the DLL.
-//    It MUST be called before any of the other Rexx/MQ functions are
-//    available for usage.
-//
-//    This is done by a RxFuncAdd('RXMQINIT','RXMQx',RXMQINIT')
-//         call to let Rexx know about the DLL, and then a
-//         rcc = RXMQINIT() to call the initialization function.
-//
-//    The following things are done:
-//
-//        * Create Rexx variables for ALL known MQ Constants
-//        * Create number->name translation variables for MQ ACs
-//        * initialize the DLL Global variables
-//            (including obtaining the Mutex for Conn/Open/Close processing)
-//        * Make the RXMQ... functions known to Rexx
-//
-//
+// Now the parms are correct, get them
 //
-FTYPE  RXMQINIT  RXMQPARM
- {
-
- RXMQCB                 * anchor = 0       ;  // RXMQ Control Block
- int                      i                ;  // Looper
- int                      rc = 0           ;  // Function Return Code
- MQLONG                   mqrc = 0         ;  // MQ RC
- MQLONG                   mqac = 0         ;  // MQ AC
- MQULONG                  traceid = INIT   ;  // This function trace id
+ if (rc == 0)
+    {
+      memcpy(&RXi_sd ,   &aargv[0],sizeof(RXi_sd))    ;
+      memcpy(&RX_handle ,&aargv[1],sizeof(RX_handle)) ;
+      memcpy(&RXo_sd ,   &aargv[2],sizeof(RXo_sd))    ;
 
- RETMSG ReturnMsg[] = {
-        { -99, "UNKNOWN FAILURE"}} ;
- //
- // Prepare Copyright message
- //
- char * moremsg = "WMQ Support Pac MA95. Version 2.0 "
-                  "(C) Copyright IBM Corporation. 1997, 2012.\n";
+      TRACE(traceid, ("RXi_sd = %.*s\n",   (int)RXi_sd.strlength,   RXi_sd.strptr)    )  ;
+      TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) )  ;
+      TRACE(traceid, ("RXo_sd = %.*s\n",   (int)RXo_sd.strlength,   RXo_sd.strptr)    )  ;
 
- rc = set_envir (afuncname, &traceid, &anchor)    ;
+      if ( !ISTMPL(RXi_sd) )                                     make_sd_from_stem(traceid,anchor,&sd,RXi_sd) ;
+      else if ( tmpl_to_cb(traceid,anchor,TMPL_SD,RXi_sd,&sd, &omask_sd) ) rc = -97 ;
+      if ( (rc == 0) && out_mask(sd_fields, &RXo_sd,  &omask_sd  ) ) rc = -96 ;
+    }
 
- //
- // Now, initialize all the constants required by calling setcons.
- //
- // Additionally, if the constant represents Reason Code (MQRC_)
- //               then create an number->name entry in the
- //               RXMQ.RCMAP. stem variable
- //
- // Additionally, if the constant represents Completion Code (MQCC_)
- //               then create an number->name entry in the
- //               RXMQ.CCMAP. stem variable
- //
- // Additionally, if the constant represents Event Name (MQCA_,...)
- //               then create an number->name entry in the
- //               RXMQ.CAMAP. stem variable
- //
- if ( rc == 0 ) setcons(traceid) ;
+//
+// Take a slot in the object table
+//
+ if (rc == 0)
+   {
+    theobj = obj_new(traceid, anchor, conn) ;
+    TRACE(traceid, ("Selected Object [%d]\n",theobj) ) ;
+    if ( theobj == 0 ) rc = -10 ;
+   }
 
-#ifndef __MVS__
- //
- // Register the DLL functions in Windows/Linux/AIX
- //
- if ( rc == 0 )
+//
+// Do the MQSUB on the obtained Subscription object
+//
+ if (rc == 0)
    {
-    for (i= 0; i< numfuncs ; i++ )
-      {
-       rc = RexxRegisterFunctionDll(        funcs[i],
-                                      (PSZ) THISDLL,
-                                            funcs[i]) ;
-       TRACE(traceid, ("Registration of %s, rc = %d\n",funcs[i],rc) ) ;
+    TRACE(traceid, ("Calling MQSUB\n") )                               ;
+    MQSUB ( anchor->QM[conn].QMh, &sd, &anchor->Obj[theobj].Qh, &sh, &mqrc, &mqac ) ;
+    rc   = mqrc                                                            ;
+
+    if ( anchor->Obj[theobj].Qh != 0 )   //If the Subscribe worked,
+      {                                  //then .....
+       obj_opened(traceid, anchor, theobj, 0, sd.ObjectName) ;
+       stem_from_long(traceid, NULL, RX_handle, ""  , OBJHANDLE(anchor,theobj)) ;
+       make_stem_from_sd(traceid,&sd,RXo_sd, omask_sd)                  ; //and update the SD
       }
+    else obj_drop(anchor, theobj) ;
    }
-#endif
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,moremsg) ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
-return 0 ;
- } // End of RXMQINIT function
+return 0;
+ } // End of RXMQSUB function
 
 //
-// RXMQCONS will simply setup the MQ mappings in the Rexx Workspace.
+// Extension functions
 //
-//           This is useful in a thread based environment where RXMQINIT
-//                has been done elsewhere (so setting the mappings elsewhere)
-//                to act, essentially, as the initialization for the thread
+
 //
-FTYPE  RXMQCONS  RXMQPARM
+// Do a Browse
+//
+//   Call:   rc = RXMQbrws(handle, data)
+//
+//           This function issues a browse on the Queue, and
+//                returns the next message (if available). If you
+//                need the Message descriptor as well, then use the
+//                native Get interface.
+//
+//
+FTYPE  RXMQBRWS  RXMQPARM
  {
- RXMQCB                 * anchor = 0       ;  // RXMQ Control Block
- MQLONG                   rc = 0           ;  // Function Return Code
- MQLONG                   mqrc = 0         ;  // MQ RC
- MQLONG                   mqac = 0         ;  // MQ AC
- MQULONG                  traceid = INIT   ;  // This function trace id
 
- RETMSG ReturnMsg[] = {
-        { -99, "UNKNOWN FAILURE"}} ;
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = BRO    ;  // This function trace id
 
- rc = set_envir (afuncname, &traceid, &anchor)    ;
+ RXSTRING                RX_handle        ;  // Data     Obj Handle
+ RXSTRING                RX_data          ;  // Variable Data
 
- //
- // Just initialize all the constants etc. required by calling setcons.
- //
- if ( rc == 0 ) setcons(traceid) ;
+ MQMD2                   md               ;  // Browse MD
+ MQGMO                   gmo              ;  // Browase GMO
 
-//
-// Set the LAST variables, and the function return string
-//
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ MQLONG                  handle    = 0    ;  //MQ object number
+ void                 *  data      = 0    ;  //-> Data buffer
+ MQLONG                  data0     = 0    ;  //   Data length max
+ MQLONG                  datalen   = 0    ;  //   Data length actual
 
-return 0;
- } // End of RXMQCONS function
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null handle"},
+        {  -3, "Zero data handle"},
+        {  -4, "Null data stem var"},
+        {  -5, "Zero data stem var"},
+        {  -6, "Handle out of range"},
+        {  -7, "Invalid handle"},
+        {  -8, "malloc failure, check reason code"},
+        {  -9, "Zero length input data buffer"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
 
 //
-// Terminate the interface - RXMQTERM
-//
-//    For Windows, AIX, Linux only this function removes access to the functions of the DLL.
-//         After calling, no other Rexx/MQ functions are available.
-//
-//    However, all the REXX name bindings are left in the
-//         Workspace; this is done to provide a method of assembling
-//         stem variable with the correct settings.
+// Check the parms
 //
-//    NO end of process actions are taken. If a prior Syncpoint is
-//         not taken, or the Queue Closed, or the QM Disconnected
-//         before this routine is invoked, then the usual MQ
-//         End of Process action will occur at that time.
+ if ( (rc == 0) && (aargc != 2 ) )             rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
+
 //
+// Now the parms are correct, get them
 //
-FTYPE  RXMQTERM  RXMQPARM
- {
+ if (rc == 0)
+   {
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
+    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))   ;
 
- RXMQCB                 * anchor = 0       ;  // RXMQ Control Block
- int                      i                ;  // Looper
- int                      rc = 0           ;  // Function Return Code
- MQLONG                   mqrc = 0         ;  // MQ RC
- MQLONG                   mqac = 0         ;  // MQ AC
- MQULONG                  traceid = TERM   ;  // This function trace id
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("RX_data   = %.*s\n",(int)RX_data.strlength,  RX_data.strptr)   ) ;
 
- RETMSG ReturnMsg[] = {
-        { -99, "UNKNOWN FAILURE"}} ;
+    parm_to_ulong(RX_handle, &handle)            ;
+    stem_to_long(traceid, RX_data, "0" , &data0) ;
+   }
 
- rc = set_envir (afuncname, &traceid, &anchor)    ;
+//
+// Now check the input Stem variable to see that there is
+//     some valid data to obtain
+//
+ if ( (rc == 0) && ( data0 <= 0 ) ) rc = -9 ;
 
-#ifndef __MVS__
 //
-// Deregister the DLL functions on distributed
+// See if the handle is valid
 //
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -6 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -7 ;
 
- for (i= 0; i< numfuncs ; i++ )
+//
+// Now GETMAIN the buffer to receive the data records
+//
+ if (( rc == 0) && ( data0 != 0 ) )
    {
-    rc = RexxDeregisterFunction(funcs[i]) ;
-    TRACE(traceid, ("Deregistration of %s, rc = %d\n",funcs[i],rc) ) ;
+    TRACE(traceid, ("Getting buffer for %"PRId32" bytes\n",(int32_t)data0) ) ;
+    data = buf_get(anchor, BUF_DATA, data0)                                ;
+    if ( data == NULL )
+      {
+       mqac = errno                                                        ;
+       TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)mqac) )          ;
+       rc = -8                                                             ;
+      }
    }
-#endif
 
+//
+// Now get the data from the queue
+//
+ if (rc == 0)
+   {
+    TRACE(traceid, ("BROWSE Maxdatalen = %"PRId32"\n",(int32_t)data0) )       ;
+    memcpy(&md , &md_default , sizeof(MQMD2))                  ;
+    memcpy(&gmo, &gmo_default, sizeof(MQGMO))                  ;
+    gmo.Options        = MQGMO_NO_WAIT+MQGMO_BROWSE_NEXT
+                       + MQGMO_ACCEPT_TRUNCATED_MSG
+                       + MQGMO_FAIL_IF_QUIESCING               ;
+    gmo.WaitInterval   = MQWI_UNLIMITED                        ;
+    MQGET ( OBJHCONN(anchor,handle), OBJ(anchor,handle)->Qh, &md, &gmo, data0, data, &datalen, &mqrc, &mqac ) ;
+    rc   = mqrc ;
+    TRACE(traceid, ("MQGET rc = %"PRId32", ac = %"PRId32", Datalen = %"PRId32"\n",
+                    (int32_t)mqrc,(int32_t)mqac,(int32_t)datalen) ) ;
 
-// Return a good return Code
+    stem_from_long  (traceid, NULL, RX_data, "0" , datalen)                 ;
+    if (datalen > data0) datalen = data0                                    ;
+    stem_from_bytes (traceid, NULL, RX_data, "1" , (MQBYTE *)data, datalen) ;
+   }
 
-// strcpy((char *)returnc,"0 0 0 RXMQTERM OK Rexx MQ Interface terminated." );
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
-#ifdef __MVS__
- return 4;
-#else
- return 0;
-#endif
- } // End of RXMQTERM function
+return 0;
+ } // End of RXMQBRWS function
 
 //
-// Do a Connect MQCONN
+// Get (or browse) several messages in one call
 //
-//   Call:   rc = RXMQconn(qmname)
+//   Call:   rc = RXMQgetn(handle, maxmsgs, maxbytes, wait,
+//                         data, [output_msgdesc], [input_gmo])
+//           rc = RXMQbrwn(handle, maxmsgs, maxbytes, wait,
+//                         data, [output_msgdesc])
 //
-FTYPE  RXMQCONN  RXMQPARM
- {
-
+//           Up to maxmsgs messages are got into data.1 to data.n, with
+//           data.0 set to n. Given as 'data. PACK', the messages are
+//           instead put end to end in data.PACK, message i being
+//           substr(data.PACK, data.i.OFF, data.i.LEN).
+//
+//           The output MD fields of message i go to msgdesc.i.xxx (the
+//           fields wanted may follow the stem name, as for RXMQGET, but
+//           no .ZLIST is set), and msgdesc.0 is set to n.
+//
+//           Getting stops once maxbytes of data have been got (0 for no
+//           limit), when no message comes within wait milliseconds of
+//           the start of the call (0 not to wait), or at the first
+//           failure. An empty queue after one or more messages is not a
+//           failure. The wait replaces any wait option in input_gmo.
+//
+//           RXMQbrwn browses the queue as RXMQbrws does, from the
+//           browse cursor onwards. Gets under syncpoint count toward the
+//           auto-commit policy of the connection (RXMQAUTO).
+//
+int get_many ( PSZ        afuncname    // Rexx Func name
+             , MQLONG     aargc        // Number of parms
+             , PRXSTRING  aargv        // Parms
+             , PRXSTRING  aretstr      // Return String
+             , int        browse       // Browse (RXMQBRWN)
+             )
+{
  RXMQCB                * anchor = 0       ;  // RXMQ Control Block
  MQLONG                  rc = 0           ;  // Function Return Code
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = CONN   ;  // This function trace id
+ MQULONG                 traceid = browse ? BRO : GET ;  // This function trace id
+
+ RXSTRING                RX_handle        ;  // Obj Handle
+ RXSTRING                RX_data          ;  // Variable Data
+ RXSTRING                RXo_md           ;  // Variable Output Msg Desc
+ RXSTRING                RXi_gmo          ;  // Variable Input  GMO
+ RXSTRING                RX_item          ;  // Msg Desc stem of one message
+
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+ MQULONG                 omask_gmo = ALLFIELDS;  // (GMO template's, unused)
 
- RETMSG ReturnMsg[] = {
+ MQLONG                  handle    = 0    ;  // MQ object number
+ MQLONG                  maxmsgs   = 0    ;  // Messages wanted
+ MQLONG                  maxbytes  = 0    ;  // Data wanted (0 no limit)
+ MQLONG                  wait      = 0    ;  // Wait in ms (0 none)
+ uint64_t                number    = 0    ;  // Limit as given
+ uint64_t                deadline  = 0    ;  //   as a time
+ uint64_t                now              ;
+ MQMD2                   md_in            ;  // MQ Message descriptor
+ MQMD2                   md               ;  //   of this message
+ MQMD2                 * mdcopy           ;  //   kept for the chain
+ MQGMO                   gmo_in           ;  // MQ Get Message options
+ MQGMO                   gmo              ;  //   of this message
+ char                 *  data      = 0    ;  //-> Data buffer
+ char                 *  copy             ;  //-> Data kept for the chain
+ char                 *  hold      = 0    ;  //-> Copies the chain points to
+ size_t                  holdlen   = 0    ;  // their length
+ size_t                  holdsize  = 0    ;  // and size
+ MQLONG                  size             ;  //   Buffer size used
+ MQLONG                  datalen   = 0    ;  //   Data length actual
+ int                     packed    = 0    ;  // 'data. PACK' given
+ char                 *  pack      = 0    ;  //-> Packed data
+ size_t                  packlen   = 0    ;  //   its length
+ size_t                  packsize  = 0    ;  //   and size
+ size_t                  want             ;  //   size needed
+ size_t                  i                ;  // Position in data arg
+ MQLONG                  n         = 0    ;  // Messages got
+ MQLONG                  total     = 0    ;  // Data got
+ MQLONG                  warncc    = 0    ;  // A warning on the way
+ MQLONG                  warnac    = 0    ;
+ int                     started   = 0    ;  // Getting begun
+ int                     blocks           ;  // Chain blocks per message
+ char                    tail[24]         ;  // Message number
+ char                    itemnam[VARNAMLEN] ; // Msg Desc stem name
+ SHVCHAIN                chain            ;  // Variable sets
+
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        {  -2, "Null QM name"},
-        {  -3, "Zero length QM name"},
-        {  -4, "QM name too long"},
-        { -98, "Already Connected to a QM"},
+        {  -2, "Null handle"},
+        {  -3, "Zero data handle"},
+        {  -4, "Bad maximum messages"},
+        {  -5, "Bad maximum bytes"},
+        {  -6, "Bad wait time"},
+        {  -7, "Null data stem var"},
+        {  -8, "Zero data stem var"},
+        {  -9, "Bad data stem option"},
+        { -10, "Zero length output MsgDesc"},
+        { -11, "Zero length input GMO"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -16, "malloc failure, check reason code"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
         { -99, "UNKNOWN FAILURE"}} ;
 
  rc = set_envir (afuncname, &traceid, &anchor)    ;
@@ -2740,61 +9992,368 @@ FTYPE  RXMQCONN  RXMQPARM
 //
 // Check the parms
 //
- if ( (rc == 0) && (aargc != 1 ) )              rc =  -1 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[0]) )     rc =  -2 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) )  rc =  -3 ;
- if ( (rc == 0) && ( aargv[0].strlength >
-                     MQ_Q_MGR_NAME_LENGTH ) )   rc =  -4 ;
-//
-// Is this thread already connected ?
-//
- if ( (rc == 0) && ( anchor->QMh != 0) )        rc = -98 ;
+ if ( (rc == 0) && ((aargc < 5) || (aargc > (browse ? 6 : 7))) ) rc = -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[1]) )  rc =  -4 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[2]) )  rc =  -5 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[3]) )  rc =  -6 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[4]) )    rc =  -7 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc =  -8 ;
+ if ( (rc == 0) && (aargc > 5) && RXZEROLENSTRING(aargv[5]) ) rc = -10 ;
+ if ( (rc == 0) && (aargc > 6) && RXZEROLENSTRING(aargv[6]) ) rc = -11 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
 
 //
 // Now the parms are correct, get them
 //
  if (rc == 0)
    {
-    memcpy(anchor->QMname,aargv[0].strptr,aargv[0].strlength)        ;
-    TRACE(traceid, ("Requested connection with %s\n",anchor->QMname) ) ;
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
+    memcpy(&RX_data,  &aargv[4],sizeof(RX_data))   ;
+    RXo_md.strptr  = NULL ; RXo_md.strlength  = 0  ;
+    RXi_gmo.strptr = NULL ; RXi_gmo.strlength = 0  ;
+    if ( aargc > 5 ) memcpy(&RXo_md, &aargv[5],sizeof(RXo_md))  ;
+    if ( aargc > 6 ) memcpy(&RXi_gmo,&aargv[6],sizeof(RXi_gmo)) ;
+
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("maxmsgs = %.*s\n",  (int)aargv[1].strlength, aargv[1].strptr)  ) ;
+    TRACE(traceid, ("maxbytes = %.*s\n", (int)aargv[2].strlength, aargv[2].strptr)  ) ;
+    TRACE(traceid, ("wait = %.*s\n",     (int)aargv[3].strlength, aargv[3].strptr)  ) ;
+    TRACE(traceid, ("RX_data = %.*s\n",  (int)RX_data.strlength,  RX_data.strptr)   ) ;
+
+    parm_to_ulong(RX_handle, &handle)     ;
+    parm_to_ulong(aargv[1],  &maxmsgs)    ;
+    if (              maxmsgs <= 0  ) rc = -4 ;
+    if (    (rc == 0)
+         && (    !str_to_num(aargv[2].strptr, aargv[2].strlength, &number)
+              || ((int64_t)number < 0) || (number > 0x7FFFFFFF) ) ) rc = -5 ;
+    maxbytes = (MQLONG)number             ;
+    number   = 0                          ;
+    if (    (rc == 0)
+         && (    !str_to_num(aargv[3].strptr, aargv[3].strlength, &number)
+              || ((int64_t)number < 0) || (number > 0x7FFFFFFF) ) ) rc = -6 ;
+    wait     = (MQLONG)number             ;
+
+    // 'data. PACK' -> packed data
+    for ( i = 0 ; (i < RX_data.strlength) && (RX_data.strptr[i] != ' ') ; i++ ) ;
+    if ( i < RX_data.strlength )
+      {
+       packed = 1                     ;
+       for ( want = i ; (want < RX_data.strlength) && (RX_data.strptr[want] == ' ') ; want++ ) ;
+       if (    (rc == 0)
+            && (    (RX_data.strlength - want != 4)
+                 || (toupper(RX_data.strptr[want  ]) != 'P')
+                 || (toupper(RX_data.strptr[want+1]) != 'A')
+                 || (toupper(RX_data.strptr[want+2]) != 'C')
+                 || (toupper(RX_data.strptr[want+3]) != 'K') ) ) rc = -9 ;
+       RX_data.strlength = i          ;
+      }
+
+    memcpy(&md_in , &md_default , sizeof(MQMD2)) ;
+    memcpy(&gmo_in, &gmo_default, sizeof(MQGMO)) ;
+    if ( browse )
+       gmo_in.Options = MQGMO_BROWSE_NEXT + MQGMO_FAIL_IF_QUIESCING ;
+    else if ( RXNULLSTRING(RXi_gmo) )
+       gmo_in.Options = MQGMO_FAIL_IF_QUIESCING                     ;
+    else if ( !ISTMPL(RXi_gmo) )
+       make_go_from_stem(traceid,&gmo_in, RXi_gmo)                  ;
+    else if ( (rc == 0) && tmpl_to_cb(traceid,anchor,TMPL_GMO,RXi_gmo,&gmo_in,&omask_gmo) )
+       rc = -97                                                     ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md, &omask_md) ) rc = -96 ;
+    omask_md &= ~FLD_ZLIST ;
    }
 
 //
-// Do the MQCONN
+// See if the handle is valid
+//
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -14 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -15 ;
+
+//
+// Now get the messages, setting the variables of each a chain at a time.
+// The buffer is reused by the next MQGET, so the data (and MD) set are
+// copies, held in a malloc'd buffer until the chain pointing to them has
+// been run, and the packed data in one grown as it goes. Both are freed
+// at the end (the arena would keep their high-water mark).
 //
  if (rc == 0)
    {
-    MQCONN ( anchor->QMname, &anchor->QMh, &mqrc, &mqac ) ;
-    rc = mqrc                                             ;
-    TRACE(traceid, ("MQCONN handle is %"PRIX32", QM is %s\n",
-          (uint32_t)anchor->QMh,anchor->QMname) ) ;
+    started     = 1                                         ;
+    chain.count = 0                                         ;
+    blocks      = ( packed ? 2 : 1 )
+                + ( RXNULLSTRING(RXo_md) ? 0 : fields_blocks(md_fields, omask_md) ) ;
+    if ( wait > 0 ) deadline = now_ms() + wait              ;
    }
 
+ while ( (rc == 0) && (n < maxmsgs) )
+   {
+    memcpy(&md , &md_in , sizeof(MQMD2))                    ;
+    memcpy(&gmo, &gmo_in, sizeof(MQGMO))                    ;
+    gmo.Options &= ~MQGMO_WAIT                              ;
+    if ( wait > 0 )
+      {
+       now = now_ms()                                       ;
+       if ( now < deadline )
+         {
+          gmo.Options     |= MQGMO_WAIT                     ;
+          gmo.WaitInterval = (MQLONG)(deadline - now)       ;
+         }
+      }
+
+    size = 0                                                ; // Adaptive buffer
+    data = get_msg(traceid, anchor, OBJ(anchor,handle), &md, &gmo, &size, &datalen, &mqrc, &mqac) ;
+    if ( data == NULL )          { rc = -16 ; break ; }
+    uow_count(traceid, anchor, OBJ(anchor,handle)->conn, GMO_IN_UOW(gmo,md), datalen, &mqrc, &mqac) ;
+    if ( mqrc == MQCC_FAILED )   break                      ;
+    if ( mqrc == MQCC_WARNING )  { warncc = mqrc ; warnac = mqac ; }
+    if ( datalen > size ) datalen = size                    ;
+
+    n++                                                     ;
+    total += datalen                                        ;
+    num_to_str(tail, (uint64_t)n, 0)                        ;
+    shv_flush(traceid, &chain, blocks)                      ;
+    if ( chain.count == 0 ) holdlen = 0                     ; // Copies done with
+
+    want = ( packed ? 0 : (datalen + 8) & ~(size_t)7 )
+         + ( RXNULLSTRING(RXo_md) ? 0 : sizeof(MQMD2) )     ;
+    if ( holdlen + want > holdsize )
+      {
+       shv_run(traceid, &chain)                             ; // Let go of the copies
+       chain.count = 0                                      ;
+       holdlen     = 0                                      ;
+      }
+    if ( want > holdsize )
+      {
+       for ( holdsize = holdsize ? holdsize : BUFMIN ; holdsize < want ; holdsize <<= 1 ) ;
+       free(hold)                                           ;
+       hold = (char *) malloc(holdsize)                     ;
+       if ( hold == NULL ) { mqac = errno ; rc = -16 ; break ; }
+      }
+
+    if ( packed )
+      {
+       if ( packlen + datalen > packsize )
+         {
+          for ( want = packsize ? packsize : BUFMIN ; want < packlen + datalen ; want <<= 1 ) ;
+          copy = (char *) realloc(pack, want)               ;
+          if ( copy == NULL ) { mqac = errno ; rc = -16 ; break ; }
+          pack     = copy                                   ;
+          packsize = want                                   ;
+         }
+       memcpy(pack + packlen, data, datalen)                ;
+       shv_set_long(&chain, RX_data, tail, ".OFF", (int32_t)(packlen + 1)) ;
+       shv_set_long(&chain, RX_data, tail, ".LEN", datalen) ;
+       packlen += datalen                                   ;
+      }
+    else
+      {
+       copy     = hold + holdlen                            ;
+       holdlen += (datalen + 8) & ~(size_t)7                ;
+       memcpy(copy, data, datalen)                          ;
+       shv_set(&chain, RX_data, tail, NULL, copy, datalen, 1) ;
+      }
+
+    if ( !RXNULLSTRING(RXo_md) )
+      {
+       mdcopy   = (MQMD2 *) (hold + holdlen)                ;
+       holdlen += sizeof(MQMD2)                             ;
+       memcpy(mdcopy, &md, sizeof(MQMD2))                   ;
+       MAKERXSTRING(RX_item, itemnam, make_varname(itemnam, RXo_md, tail, ".")) ;
+       fields_to_chain(&chain, md_fields, mdcopy, RX_item, omask_md) ;
+      }
+
+    if ( gmo_in.Options & MQGMO_BROWSE_FIRST )
+       gmo_in.Options = (gmo_in.Options & ~MQGMO_BROWSE_FIRST) | MQGMO_BROWSE_NEXT ;
+
+    if ( (maxbytes > 0) && (total >= maxbytes) )    break   ;
+    if ( (wait > 0) && (now_ms() >= deadline) )     break   ;
+   }
+
+//
+// An empty queue only ends the messages (unless there were none), and
+// a warning on the way is kept
+//
+ if ( (rc == 0) && started )
+   {
+    if ( (n > 0) && (mqrc == MQCC_FAILED) && (mqac == MQRC_NO_MSG_AVAILABLE) )
+      {
+       mqrc = MQCC_OK ;
+       mqac = MQRC_NONE ;
+      }
+    if ( (mqrc == MQCC_OK) && (warncc != 0) )
+      {
+       mqrc = warncc ;
+       mqac = warnac ;
+      }
+    rc = mqrc ;
+   }
+ TRACE(traceid, ("%"PRId32" messages, %"PRId32" bytes\n",(int32_t)n,(int32_t)total) ) ;
+
+ if ( started )
+   {
+    shv_flush(traceid, &chain, 3)                                   ;
+    shv_set_long(&chain, RX_data, "0", NULL, n)                     ;
+    if ( packed )
+       shv_set(&chain, RX_data, "PACK", NULL, (pack != NULL) ? pack : "", packlen, 1) ;
+    if ( !RXNULLSTRING(RXo_md) )
+       shv_set_long(&chain, RXo_md, "0", NULL, n)                   ;
+    shv_run(traceid, &chain)                                        ;
+   }
+ free(hold) ;
+ free(pack) ;
+
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
 return 0;
- } // End of RXMQCONN function
+ } // End of get_many
+
+FTYPE  RXMQGETN  RXMQPARM
+ {
+  return get_many(afuncname,aargc,aargv,aretstr,0) ;
+ }
+
+FTYPE  RXMQBRWN  RXMQPARM
+ {
+  return get_many(afuncname,aargc,aargv,aretstr,1) ;
+ }
 
 //
-// Do a Disconnect   MQDISC
-//
-//   Call:   rc = RXMQdisc()
+// copy_commit - commit a batch of RXMQCOPY, on the target connection
+//               and then on the source if that is another
 //
-FTYPE  RXMQDISC  RXMQPARM
- {
+void copy_commit ( MQULONG    traceid      // trace id of caller
+                 , RXMQCB   * anchor       // RXMQ Control Block
+                 , RXMQOBJ  * sobj         // Source object
+                 , RXMQOBJ  * dobj         // Target object
+                 , MQLONG   * mqrc         // MQ CC
+                 , MQLONG   * mqac         // MQ RC
+                 )
+{
+ uow_commit(traceid, anchor, dobj->conn, 0, mqrc, mqac) ;
+ if ( (*mqrc != MQCC_FAILED) && (sobj->conn != dobj->conn) )
+    uow_commit(traceid, anchor, sobj->conn, 0, mqrc, mqac) ;
 
+ return ;
+} // End of copy_commit
+
+//
+// Copy or move messages between queues
+//
+//   Call:   rc = RXMQcopy(source_handle, target_handle, [options], [filter])
+//
+//           Messages are got from the source queue and put to the target
+//           queue in C, the data never reaching REXX variables. The
+//           handles may be on different connections. options are words
+//           from:
+//
+//              COPY      browse the source, from its browse cursor on
+//                        (the default)
+//              MOVE      get the messages (under syncpoint)
+//              BATCH=n   commit every n messages (default 50; 0, for a
+//                        copy only, puts outside syncpoint)
+//              MAX=n     stop after n messages
+//              BYTES=n   stop once n bytes have been copied
+//              RATE=n    copy at most n messages a second
+//              WAIT=n    wait up to n ms for each message (default 0)
+//
+//           Only messages whose MD fields named after the filter stem
+//           are as set in it ('flt. PRI FORM') are copied. The MSGID,
+//           CID, GID, MSN and OFF fields are matched by the queue
+//           manager; the others are looked at by browsing each message
+//           first, for which a source to be moved from must be open for
+//           browse too.
+//
+//           A message moved on one connection keeps its context with
+//           MQPMO_PASS_ALL_CONTEXT (source open with
+//           MQOO_SAVE_ALL_CONTEXT, target with MQOO_PASS_ALL_CONTEXT);
+//           otherwise it is put with MQPMO_SET_ALL_CONTEXT (target open
+//           with MQOO_SET_ALL_CONTEXT). Across two connections a batch is
+//           committed on the target first, so a failure between the two
+//           commits leaves messages copied but not removed.
+//
+//           Copying ends without error when the source has no more
+//           messages. A failed put backs the batch out and ends it.
+//
+//           RXMQ.COPY.COUNT, .BYTES and .SKIPPED (by the filter) are set
+//           to the messages copied, .COMMITS to the batches committed,
+//           .TIME to the milliseconds taken, and .RATE and .BYTERATE to
+//           the messages and bytes copied a second.
+//
+FTYPE  RXMQCOPY  RXMQPARM
+ {
  RXMQCB                * anchor = 0       ;  // RXMQ Control Block
- MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  rc   = 0         ;  // Function Return Code
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = DISC   ;  // This function trace id
+ MQLONG                  cc               ;  // Commit or backout CC
+ MQLONG                  ac               ;  // Commit or backout RC
+ MQULONG                 traceid = GET    ;  // This function trace id
 
- RETMSG ReturnMsg[] = {
+ RXSTRING                RX_filter        ;  // Variable Filter Msg Desc
+ RXSTRING                stem             ;  // RXMQ.COPY.
+ MQULONG                 fmask = 0        ;  // Filter fields
+ MQULONG                 qmask = 0        ;  //   matched by the QM
+ MQULONG                 bit              ;  //   one of those
+
+ MQLONG                  src  = 0         ;  // Source object number
+ MQLONG                  dst  = 0         ;  // Target object number
+ RXMQOBJ               * sobj = 0         ;  //   their entries
+ RXMQOBJ               * dobj = 0         ;
+ int                     move  = 0        ;  // MOVE given
+ MQLONG                  batch = 50       ;  // Commit every (0 never)
+ MQLONG                  max   = 0        ;  // Messages wanted (0 all)
+ MQLONG                  maxbytes = 0     ;  // Data wanted (0 all)
+ MQLONG                  rate  = 0        ;  // Messages a second (0 any)
+ MQLONG                  wait  = 0        ;  // Wait for each message
+ MQLONG                * value            ;  // Option value to set
+ char                    word[10]         ;  // Option keyword
+ size_t                  i                ;  // Position in options
+ size_t                  j                ;  //   end of word
+ size_t                  k                ;  //   end of keyword
+
+ MQMD2                   fmd              ;  // Filter values
+ MQMD2                   md_in            ;  // MQ Message descriptor
+ MQMD2                   md               ;  //   of this message
+ MQGMO                   gmo_in           ;  // MQ Get Message options
+ MQGMO                   gmo              ;  //   of this message
+ MQPMO                   pmo_in           ;  // MQ Put Message options
+ MQPMO                   pmo              ;  //   of this message
+ MQBYTE                  none[1]          ;  // Buffer for an MD only browse
+ void                  * data             ;  //-> Data buffer
+ MQLONG                  size             ;  //   Buffer size used
+ MQLONG                  datalen = 0      ;  //   Data length
+ MQLONG                  n       = 0      ;  // Messages copied
+ MQLONG                  pending = 0      ;  //   since the last commit
+ MQLONG                  skipped = 0      ;  // Filtered out
+ MQLONG                  commits = 0      ;  // Batches committed
+ uint64_t                total   = 0      ;  // Data copied
+ uint64_t                pendbytes = 0    ;  //   since the last commit
+ uint64_t                start   = 0      ;  // Time started (us)
+ uint64_t                took             ;  //   taken
+ uint64_t                due              ;  // Time of the next message (us)
+ int                     started = 0      ;  // Copying begun
+ SHVCHAIN                chain            ;  // Variable sets
+
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        { -98, "Not Connected to a QM"},
+        {  -2, "Null source handle"},
+        {  -3, "Zero length source handle"},
+        {  -4, "Null target handle"},
+        {  -5, "Zero length target handle"},
+        {  -6, "Bad option"},
+        {  -7, "Zero length filter MsgDesc"},
+        {  -8, "Source and target are the same"},
+        { -14, "Source handle out of range"},
+        { -15, "Invalid source handle"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Target handle out of range"},
+        { -18, "Invalid target handle"},
+        { -96, "Bad filter field list"},
+        { -98, "Not connected to a QM"},
         { -99, "UNKNOWN FAILURE"}} ;
 
  rc = set_envir (afuncname, &traceid, &anchor)    ;
@@ -2802,174 +10361,561 @@ FTYPE  RXMQDISC  RXMQPARM
 //
 // Check the parms
 //
- if ( (rc == 0) && ( aargc != 0 ) )        rc =  -1 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )  rc = -98 ;
+ if ( (rc == 0) && ((aargc < 2) || (aargc > 4)) ) rc = -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && (aargc > 3) && RXZEROLENSTRING(aargv[3]) ) rc = -7 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
 
 //
-// Do the MQDISC
+// Now the parms are correct, get them
 //
  if (rc == 0)
    {
-    TRACE(traceid, ("Disconnecting from QM %s\n",anchor->QMname) ) ;
-    MQDISC ( &anchor->QMh, &mqrc, &mqac ) ;
-    rc = mqrc                             ;
-    memset (anchor, 0, sizeof(RXMQCB))   ;
-    memcpy (&anchor->StrucId, RXMQeyecatcher, sizeof(MQCHAR4)) ;
+    TRACE(traceid, ("Source = %.*s\n",(int)aargv[0].strlength,aargv[0].strptr) ) ;
+    TRACE(traceid, ("Target = %.*s\n",(int)aargv[1].strlength,aargv[1].strptr) ) ;
+    parm_to_ulong(aargv[0], &src) ;
+    parm_to_ulong(aargv[1], &dst) ;
+
+    // Options: COPY MOVE BATCH=n MAX=n BYTES=n RATE=n WAIT=n
+    for ( i = 0 ; (rc == 0) && (aargc > 2) && !RXNULLSTRING(aargv[2]) && (i < aargv[2].strlength) ; i = j )
+      {
+       if ( aargv[2].strptr[i] == ' ' ) { j = i + 1 ; continue ; }
+       for ( j = i ; (j < aargv[2].strlength) && (aargv[2].strptr[j] != ' ') ; j++ ) ;
+       TRACE(traceid, ("Option %.*s\n",(int)(j-i),aargv[2].strptr+i) ) ;
+
+       memset(word, 0, sizeof(word)) ;
+       for ( k = i ; (k < j) && (aargv[2].strptr[k] != '=') ; k++ )
+          if ( k - i < sizeof(word) - 1 ) word[k-i] = toupper((unsigned char)aargv[2].strptr[k]) ;
+
+       value = NULL ;
+       if      ( !strcmp(word, "COPY")  ) move  = 0         ;
+       else if ( !strcmp(word, "MOVE")  ) move  = 1         ;
+       else if ( !strcmp(word, "BATCH") ) value = &batch    ;
+       else if ( !strcmp(word, "MAX")   ) value = &max      ;
+       else if ( !strcmp(word, "BYTES") ) value = &maxbytes ;
+       else if ( !strcmp(word, "RATE")  ) value = &rate     ;
+       else if ( !strcmp(word, "WAIT")  ) value = &wait     ;
+       else                               rc    = -6        ;
+
+       if ( (rc == 0) && ((value != NULL) != (k < j)) ) rc = -6 ; // n given if wanted
+       if ( (rc == 0) && (value != NULL) )
+         {
+          if ( (j - k < 2) || (j - k > 10) ) rc = -6 ;
+          for ( *value = 0, k++ ; (rc == 0) && (k < j) ; k++ )
+            {
+             if ( !isdigit((unsigned char)aargv[2].strptr[k]) ) rc = -6 ;
+             else *value = *value * 10 + (aargv[2].strptr[k] - '0') ;
+            }
+         }
+      }
+    if ( move && (batch == 0) ) batch = 1 ;          // A moved message is never lost
+
+    if ( (aargc > 3) && !RXNULLSTRING(aargv[3]) )
+      {
+       memcpy(&RX_filter, &aargv[3], sizeof(RX_filter)) ;
+       TRACE(traceid, ("RX_filter = %.*s\n",(int)RX_filter.strlength,RX_filter.strptr) ) ;
+       if ( (rc == 0) && out_mask(md_fields, &RX_filter, &fmask) ) rc = -96 ;
+       fmask &= ~FLD_ZLIST ;
+       if ( (rc == 0) && (fmask == 0) ) rc = -96 ;     // Fields must be named
+      }
+    else
+      {
+       RX_filter.strptr = NULL ; RX_filter.strlength = 0 ;
+      }
    }
+
 //
-// Set the LAST variables, and the function return string
+// See if the handles are valid
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ if ( (rc == 0) && !OBJINRANGE(anchor,src) ) rc = -14 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,src) )    rc = -15 ;
+ if ( (rc == 0) && !OBJINRANGE(anchor,dst) ) rc = -17 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,dst) )    rc = -18 ;
+ if ( (rc == 0) && (OBJ(anchor,src) == OBJ(anchor,dst)) ) rc = -8 ;
 
-return 0;
- } // End of RXMQDISC function
+//
+// Build the descriptors, the MSGID, CID, GID, MSN and OFF filter
+// fields being given to MQGET to match and the rest left for here
+//
+ if (rc == 0)
+   {
+    sobj = OBJ(anchor,src)                                        ;
+    dobj = OBJ(anchor,dst)                                        ;
+
+    memcpy(&md_in , &md_default , sizeof(MQMD2))                  ;
+    md_in.Version       = MQMD_VERSION_2                          ;
+    memcpy(&gmo_in, &gmo_default, sizeof(MQGMO))                  ;
+    memcpy(&pmo_in, &pmo_default, sizeof(MQPMO))                  ;
+    gmo_in.Version      = MQGMO_VERSION_2                         ;
+    gmo_in.MatchOptions = MQMO_NONE                               ;
+    gmo_in.Options      = MQGMO_FAIL_IF_QUIESCING                 ;
+    if ( wait > 0 )
+      {
+       gmo_in.Options     |= MQGMO_WAIT                           ;
+       gmo_in.WaitInterval = wait                                 ;
+      }
+
+    if ( !RXNULLSTRING(RX_filter) )
+      {
+       memcpy(&fmd, &md_default, sizeof(MQMD2))                   ;
+       stem_to_fields(traceid, anchor, md_fields, &fmd, RX_filter, fmask) ;
+       if ( !fields_to_mask(md_fields, "MSGID", 5, &bit) && (fmask & bit) )
+         {
+          memcpy(md_in.MsgId, fmd.MsgId, sizeof(md_in.MsgId))     ;
+          gmo_in.MatchOptions |= MQMO_MATCH_MSG_ID ; qmask |= bit ;
+         }
+       if ( !fields_to_mask(md_fields, "CID", 3, &bit) && (fmask & bit) )
+         {
+          memcpy(md_in.CorrelId, fmd.CorrelId, sizeof(md_in.CorrelId)) ;
+          gmo_in.MatchOptions |= MQMO_MATCH_CORREL_ID ; qmask |= bit ;
+         }
+       if ( !fields_to_mask(md_fields, "GID", 3, &bit) && (fmask & bit) )
+         {
+          memcpy(md_in.GroupId, fmd.GroupId, sizeof(md_in.GroupId)) ;
+          gmo_in.MatchOptions |= MQMO_MATCH_GROUP_ID ; qmask |= bit ;
+         }
+       if ( !fields_to_mask(md_fields, "MSN", 3, &bit) && (fmask & bit) )
+         {
+          md_in.MsgSeqNumber = fmd.MsgSeqNumber                   ;
+          gmo_in.MatchOptions |= MQMO_MATCH_MSG_SEQ_NUMBER ; qmask |= bit ;
+         }
+       if ( !fields_to_mask(md_fields, "OFF", 3, &bit) && (fmask & bit) )
+         {
+          md_in.Offset = fmd.Offset                               ;
+          gmo_in.MatchOptions |= MQMO_MATCH_OFFSET ; qmask |= bit ;
+         }
+       fmask &= ~qmask                                            ;
+      }
+
+    pmo_in.Options = MQPMO_FAIL_IF_QUIESCING
+                   | ( (batch > 0) ? MQPMO_SYNCPOINT : MQPMO_NO_SYNCPOINT ) ;
+    if ( move && (sobj->conn == dobj->conn) )
+      {
+       pmo_in.Options |= MQPMO_PASS_ALL_CONTEXT                   ;
+       pmo_in.Context  = sobj->Qh                                 ;
+      }
+    else pmo_in.Options |= MQPMO_SET_ALL_CONTEXT                  ;
 
+    TRACE(traceid, ("%s batch %"PRId32" max %"PRId32" bytes %"PRId32" rate %"PRId32" wait %"PRId32" match %"PRId32" filter %08"PRIX32"\n",
+          move ? "MOVE" : "COPY",(int32_t)batch,(int32_t)max,(int32_t)maxbytes,
+          (int32_t)rate,(int32_t)wait,(int32_t)gmo_in.MatchOptions,(uint32_t)fmask) ) ;
+
+    started = 1                                                   ;
+    start   = now_us()                                            ;
+   }
 
 //
-// Do an Open   MQOPEN
-//
-//   Call:   rc = RXMQopen(iMQOD,opts,handle,oMQOD)
+// Copy the messages, each got into the payload buffer and put from it
 //
-FTYPE  RXMQOPEN  RXMQPARM
- {
+ while ( (rc == 0) && ((max == 0) || (n < max)) && ((maxbytes == 0) || (total < (uint64_t)maxbytes)) )
+   {
+    if ( rate > 0 )                                    // Keep to the rate
+      {
+       due = start + (uint64_t)n * 1000000 / rate                 ;
+       took = now_us()                                            ;
+       if ( took < due ) sleep_ms((MQLONG)((due - took + 999) / 1000)) ;
+      }
 
- RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
- int                     i                ;  // Looper
- MQLONG                  rc = 0           ;  // Function Return Code
- MQLONG                  mqrc = 0         ;  // MQ RC
- MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = OPEN   ;  // This function trace id
+    memcpy(&md , &md_in , sizeof(MQMD2))                          ;
+    memcpy(&gmo, &gmo_in, sizeof(MQGMO))                          ;
 
- RXSTRING                RXi_od           ;  // Stem Var Obj Desc Input
- RXSTRING                RXo_od           ;  // Stem Var Obj Desc Output
- RXSTRING                RX_opt           ;  // Open     Options
- RXSTRING                RX_handle        ;  //      Var Obj Handle
+    if ( fmask != 0 )                                  // Filter on a browse
+      {
+       gmo.Options |= MQGMO_BROWSE_NEXT | MQGMO_ACCEPT_TRUNCATED_MSG ;
+       MQGET ( OBJHCONN(anchor,src), sobj->Qh, &md, &gmo, 0, none, &datalen, &mqrc, &mqac ) ;
+       TRACE(traceid, ("Browse rc = %"PRId32", ac = %"PRId32", datalen = %"PRId32"\n",
+             (int32_t)mqrc,(int32_t)mqac,(int32_t)datalen) ) ;
+       if ( mqrc == MQCC_FAILED ) break                           ;
+       if ( !fields_match(md_fields, &md, &fmd, fmask) )
+         {
+          skipped++                                               ;
+          continue                                                ;
+         }
+       memcpy(&md , &md_in , sizeof(MQMD2))                       ;
+       memcpy(&gmo, &gmo_in, sizeof(MQGMO))                       ;
+       gmo.Options &= ~MQGMO_WAIT                                 ;
+       gmo.MatchOptions = MQMO_NONE                               ;
+       gmo.Options |= move ? (MQGMO_MSG_UNDER_CURSOR | MQGMO_SYNCPOINT)
+                           : MQGMO_BROWSE_MSG_UNDER_CURSOR        ;
+      }
+    else gmo.Options |= move ? MQGMO_SYNCPOINT : MQGMO_BROWSE_NEXT ;
 
- MQOD                    od               ;  //MQ object desc
- MQLONG                  options    =  0  ;  //MQ open options
- int                     theobj     = -1  ;  //gmqo object to use
+    size = 0                                                      ; // Adaptive buffer
+    data = get_msg(traceid, anchor, sobj, &md, &gmo, &size, &datalen, &mqrc, &mqac) ;
+    if ( data == NULL )        { rc = -16 ; break ; }
+    if ( mqrc == MQCC_FAILED ) break                              ;
 
- RETMSG ReturnMsg[] = {
-        {  -1, "Bad number of parms" },
-        {  -2, "Null Input OD/Qname"},
-        {  -3, "Zero length input OD/Qname"},
-        {  -4, "Null options"},
-        {  -5, "Zero length options"},
-        {  -6, "Null handle name"},
-        {  -7, "Zero length handle name"},
-        {  -8, "Null Output OD"},
-        {  -9, "Zero length output OD"},
-        { -10, "No available Q objects"},
-        { -98, "Not connected to a QM"},
-        { -99, "UNKNOWN FAILURE"}} ;
+    memcpy(&pmo, &pmo_in, sizeof(MQPMO))                          ;
+    MQPUT ( OBJHCONN(anchor,dst), dobj->Qh, &md, &pmo, datalen, data, &mqrc, &mqac ) ;
+    TRACE(traceid, ("PUT rc = %"PRId32", ac = %"PRId32"\n",(int32_t)mqrc,(int32_t)mqac) ) ;
+    if ( mqrc == MQCC_FAILED )
+      {
+       if ( batch > 0 )                                // Back the batch out
+         {
+          MQBACK ( anchor->QM[dobj->conn].QMh, &cc, &ac )         ;
+          if ( sobj->conn != dobj->conn ) MQBACK ( anchor->QM[sobj->conn].QMh, &cc, &ac ) ;
+          anchor->QM[dobj->conn].Pending = 0                      ;
+          anchor->QM[sobj->conn].Pending = 0                      ;
+          n      -= pending                                       ; // Not copied after all
+          total  -= pendbytes                                     ;
+          pending = 0                                             ;
+         }
+       break                                                      ;
+      }
 
- rc = set_envir (afuncname, &traceid, &anchor)    ;
+    n++                                                           ;
+    pending++                                                     ;
+    total     += datalen                                          ;
+    pendbytes += datalen                                          ;
+
+    if ( (batch > 0) && (pending >= batch) )
+      {
+       copy_commit(traceid, anchor, sobj, dobj, &mqrc, &mqac)     ;
+       if ( mqrc == MQCC_FAILED ) break                           ;
+       commits++                                                  ;
+       pending   = 0                                              ;
+       pendbytes = 0                                              ;
+      }
+   }
 
 //
-// Check the parms
+// No more messages is the normal end; commit what is left
 //
- if ( (rc == 0) && (aargc != 4 ) )             rc =  -1 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[3]) )    rc =  -8 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && started )
+   {
+    if ( (mqrc == MQCC_FAILED) && (mqac == MQRC_NO_MSG_AVAILABLE) )
+      {
+       mqrc = MQCC_OK   ;
+       mqac = MQRC_NONE ;
+      }
+    if ( (mqrc != MQCC_FAILED) && (pending > 0) )
+      {
+       copy_commit(traceid, anchor, sobj, dobj, &cc, &ac)         ;
+       if ( cc == MQCC_FAILED ) { mqrc = cc ; mqac = ac ; }
+       else                       commits++             ;
+      }
+    rc = mqrc ;
+   }
+
+ if ( started )
+   {
+    took = now_us() - start                                       ;
+    if ( took == 0 ) took = 1                                     ;
+    TRACE(traceid, ("%"PRId32" messages copied, %"PRId32" skipped, %"PRIu32" us\n",
+          (int32_t)n,(int32_t)skipped,(uint32_t)took) )            ;
+    MAKERXSTRING(stem, "RXMQ.COPY.", sizeof("RXMQ.COPY.")-1)      ;
+    chain.count = 0                                               ;
+    shv_set_long (&chain, stem, "COUNT",    NULL, n)              ;
+    shv_set_int64(&chain, stem, "BYTES",    NULL, (MQINT64)total) ;
+    shv_set_long (&chain, stem, "SKIPPED",  NULL, skipped)        ;
+    shv_set_long (&chain, stem, "COMMITS",  NULL, commits)        ;
+    shv_set_int64(&chain, stem, "TIME",     NULL, (MQINT64)(took / 1000)) ;
+    shv_set_int64(&chain, stem, "RATE",     NULL, (MQINT64)((uint64_t)n * 1000000 / took)) ;
+    shv_set_int64(&chain, stem, "BYTERATE", NULL, (MQINT64)(total * 1000000 / took)) ;
+    shv_run(traceid, &chain)                                      ;
+   }
 
 //
-// Now the parms are correct, get them
+// Set the LAST variables, and the function return string
 //
- if (rc == 0)
-    {
-      memcpy(&RXi_od    ,&aargv[0],sizeof(RXi_od))    ;
-      memcpy(&RX_opt    ,&aargv[1],sizeof(RX_opt  ))  ;
-      memcpy(&RX_handle ,&aargv[2],sizeof(RX_handle)) ;
-      memcpy(&RXo_od    ,&aargv[3],sizeof(RXo_od))    ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
-      TRACE(traceid, ("RXi_od = %.*s\n",   (int)RXi_od.strlength,   RXi_od.strptr) )     ;
-      TRACE(traceid, ("RX_opt = %.*s\n",   (int)RX_opt.strlength,   RX_opt.strptr) )     ;
-      TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) )  ;
-      TRACE(traceid, ("RXo_od = %.*s\n",   (int)RXo_od.strlength,   RXo_od.strptr) )     ;
+ return 0;
+ } // End of RXMQCOPY function
+
+//
+// Consume queues asynchronously
+//
+//   Call:   rc = RXMQasyn('START', handles, [input_gmo], [slots])
+//        or
+//           rc = RXMQasyn('STOP', [handles])
+//
+//           START registers a message consumer (MQCB) for each of the
+//           handles (a blank separated list), and starts the connections
+//           they are on (MQCTL), MQ then getting their messages on a
+//           thread of its own until RXMQPOLL takes them. The messages of
+//           each queue are held in a ring of slots messages (default 64,
+//           rounded up to a power of two), the consumer being suspended
+//           while that is full. A queue already being consumed is left
+//           as it is.
+//
+//           input_gmo (a stem or an RXMQDEF template) gives the get
+//           options, by default MQGMO_WAIT with no wait limit. Messages
+//           are always got outside syncpoint, there being no thread to
+//           commit them on. The consumer browses the queue, and only
+//           removes a message once it has a slot in the ring, so one
+//           that comes while the ring is full or consuming is being
+//           stopped stays on the queue. With browse options given the
+//           queue is only browsed, such a message then being passed
+//           over.
+//
+//           STOP stops consuming the handles given, or all queues. The
+//           messages already in their rings but not yet taken by
+//           RXMQPOLL are lost, and if there were any rc is -18, the
+//           reason being how many. RXMQCLOS, RXMQDISC and RXMQTERM stop
+//           consuming what they close, and report lost messages with
+//           an rc of their own (-8, -2 and -1, see them).
+//
+//           While a connection is consuming, MQ calls on it other than
+//           these (RXMQGET, RXMQPUT, RXMQCMIT ...) fail with
+//           MQRC_HCONN_ASYNC_ACTIVE: a queue for replies or for other
+//           work should be opened on another connection.
+//
+FTYPE  RXMQASYN  RXMQPARM
+ {
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQLONG                  cc               ;  // MQCTL CC
+ MQLONG                  ac               ;  // MQCTL RC
+ MQLONG                  lost = 0         ;  // Consumed messages lost
+ MQULONG                 traceid = ASYNC  ;  // This function trace id
+
+ RXSTRING                RXi_gmo          ;  // Variable Input  GMO
+ RXSTRING                RX_word          ;  // One handle of the list
 
-      make_od_from_stem(traceid,&od,RXi_od)    ;
-      parm_to_ulong(RX_opt, &options)          ;
-    }
+ MQULONG                 omask_gmo = ALLFIELDS;  // (GMO template's, unused)
+ MQGMO                   gmo              ;  // MQ Get Message options
+ MQLONG                  handle           ;  // MQ object number
+ MQLONG                  slots = ASYNSLOTS ; // Ring size
+ MQLONG                  want             ;  //   as given
+ char                    reqc[8]          ;  // Request (upper case)
+ int                     start = 0        ;  // START (else STOP)
+ int                     ctl[MAXCONNS]    ;  // Connections to start
+ int                     i                ;  // Looper
+ int                     conn             ;  // Connection
+ int                     len              ;  // Length of a handle
+ char                  * p                ;  //-> a handle
+ char                  * e                ;  //-> end of the list
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null request"},
+        {  -3, "Bad request"},
+        {  -4, "Null handles"},
+        {  -5, "Bad handle list"},
+        {  -6, "Zero length input GMO"},
+        {  -7, "Bad ring size"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -16, "A session's queue may not be consumed"},
+        { -17, "Wake up event not made"},
+        { -18, "Consumed messages not taken lost, reason is how many"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
 
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
 
 //
-// Select the handle slot
+// Check the parms
 //
+ if ( (rc == 0) && ((aargc < 1) || (aargc > 4)) ) rc = -1 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[0]) )    rc = -2 ;
+
  if (rc == 0)
    {
-    for ( i=MINQS ; i <= MAXQS ; i++ )
+    memset(reqc, 0, sizeof(reqc)) ;
+    for ( i = 0 ; (i < (int)aargv[0].strlength) && (i < (int)sizeof(reqc)-1) ; i++ )
+       reqc[i] = toupper((unsigned char)aargv[0].strptr[i]) ;
+    if ( aargv[0].strlength >= sizeof(reqc) ) reqc[0] = 0 ;
+    TRACE(traceid, ("Request %s\n",reqc) ) ;
+
+    if      ( !strcmp(reqc, "START") ) { start = 1 ; if ( aargc < 2 ) rc = -1 ; }
+    else if ( !strcmp(reqc, "STOP") )  { if ( aargc > 2 ) rc = -1 ; }
+    else                                              rc = -3 ;
+   }
+ if ( (rc == 0) && start && !RXVALIDSTRING(aargv[1]) )              rc = -4 ;
+ if ( (rc == 0) && (aargc > 2) && RXZEROLENSTRING(aargv[2]) )       rc = -6 ;
+ if ( (rc == 0) && (aargc > 3) && !RXNULLSTRING(aargv[3]) )
+   {
+    parm_to_ulong(aargv[3], &want)                                     ;
+    if ( (want <= 0) || (want > ASYNMAX) )                          rc = -7 ;
+    else for ( slots = 1 ; slots < want ; slots <<= 1 ) ;
+   }
+ if ( (rc == 0) && anchor->Conns == 0 )                             rc = -98 ;
+
+//
+// Get the get options, never under syncpoint
+//
+ if ( (rc == 0) && start )
+   {
+    memcpy(&gmo, &gmo_default, sizeof(MQGMO))                ;
+    memset(&RXi_gmo, 0, sizeof(RXi_gmo))                     ;
+    if ( aargc > 2 ) memcpy(&RXi_gmo, &aargv[2], sizeof(RXi_gmo)) ;
+    if ( RXNULLSTRING(RXi_gmo) )
       {
-       if ( anchor->Qh[i] == 0 )
-         {
-          theobj = i ;
-          TRACE(traceid, ("Selected Qh Object [%d]\n",theobj) ) ;
-          break      ;
-         }
+       gmo.Options      = MQGMO_WAIT + MQGMO_FAIL_IF_QUIESCING ;
+       gmo.WaitInterval = MQWI_UNLIMITED                     ;
       }
-
-    if ( (theobj == -1) ) rc = -10 ;
+    else if ( !ISTMPL(RXi_gmo) )
+       make_go_from_stem(traceid, &gmo, RXi_gmo)             ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_GMO,RXi_gmo,&gmo,&omask_gmo) )
+       rc = -97                                              ;
+    gmo.Options = ( gmo.Options & ~(MQGMO_SYNCPOINT | MQGMO_SYNCPOINT_IF_PERSISTENT) )
+                | MQGMO_NO_SYNCPOINT                         ;
+    if ( (rc == 0) && wake_make(&anchor->Wake) ) rc = -17 ;
    }
 
 //
-// Do the MQOPEN on the obtained Queue object
+// STOP with no handles stops every connection consuming
 //
- if (rc == 0)
+ if ( (rc == 0) && !start && ((aargc < 2) || RXNULLSTRING(aargv[1])) )
    {
-    TRACE(traceid, ("Calling MQOPEN with options = %"PRId32"\n",(int32_t)options) ) ;
-    MQOPEN ( anchor->QMh, &od, options, &anchor->Qh[theobj], &mqrc, &mqac ) ;
+    for ( conn = 0 ; conn < MAXCONNS ; conn++ )
+      if ( anchor->QM[conn].Async || (anchor->Rings > 0) )
+        {
+         async_end(traceid, anchor, conn, 0, &lost, &cc, &ac) ;
+         if ( cc > mqrc ) { mqrc = cc ; mqac = ac ; }
+        }
     rc = mqrc ;
+   }
+
+//
+// Otherwise take the handles in turn, a connection being stopped while
+// a consumer is registered (or deregistered) and started again after
+//
+ else if (rc == 0)
+   {
+    memset(ctl, 0, sizeof(ctl))                         ;
+    e = aargv[1].strptr + aargv[1].strlength            ;
+    for ( p = aargv[1].strptr ; (rc == 0) && (p < e) ; p += len )
+      {
+       for ( len = 0 ; (p + len < e) && (p[len] != ' ') ; len++ )
+          if ( !isdigit((unsigned char)p[len]) ) rc = -5 ;
+       if ( len == 0 ) { len = 1 ; continue ; }        // A blank
+       if ( rc != 0 ) break                            ;
+
+       MAKERXSTRING(RX_word, p, len)                   ;
+       parm_to_ulong(RX_word, &handle)                 ;
+       TRACE(traceid, ("Handle %"PRIu32"\n",(uint32_t)handle) ) ;
+       if      ( !OBJINRANGE(anchor,handle) )  rc = -14 ;
+       else if ( !OBJOPEN(anchor,handle) )     rc = -15 ;
+       else if ( OBJ(anchor,handle)->shared )  rc = -16 ;
+       if ( rc != 0 ) break                            ;
+
+       if ( (OBJ(anchor,handle)->ring != NULL) == start ) continue ;
+       conn = OBJ(anchor,handle)->conn                 ;
+       if ( anchor->QM[conn].Async )
+         {
+          async_ctl(traceid, anchor, conn, MQOP_STOP, &mqrc, &mqac) ;
+          if ( mqrc == MQCC_FAILED ) { rc = mqrc ; break ; }
+          ctl[conn] = 1                                ;
+         }
+       if ( start )
+         {
+          async_add(traceid, anchor, handle & OBJSLOTMASK, &gmo, slots, &mqrc, &mqac) ;
+          if ( mqrc == MQCC_FAILED ) { rc = mqrc ; break ; }
+          ctl[conn] = 1                                ;
+         }
+       else
+          lost += async_drop(traceid, anchor, handle & OBJSLOTMASK) ;
+      }
 
-    if ( anchor->Qh[theobj] != 0 )   //If the Open worked,
-      {                              //then .....
-       stem_from_long(traceid, NULL, RX_handle, ""  , theobj) ;
-       make_stem_from_od(traceid,&od,RXo_od) ; //and update the OD
+    for ( conn = 0 ; conn < MAXCONNS ; conn++ )
+      {
+       if ( ctl[conn] == 0 ) continue                  ;
+       for ( i = 1 ; i < anchor->Objsize ; i++ )
+         if ( (anchor->Obj[i].ring != NULL) && (anchor->Obj[i].conn == conn) ) break ;
+       if ( i == anchor->Objsize ) continue            ; // None left
+       async_ctl(traceid, anchor, conn, MQOP_START, &cc, &ac) ;
+       if ( (cc == MQCC_FAILED) && (rc == 0) )
+         {
+          rc   = cc ;
+          mqrc = cc ;
+          mqac = ac ;
+         }
       }
    }
 
+ if ( (rc == 0) && (lost > 0) )
+   {
+    rc   = -18          ;
+    mqrc = MQCC_WARNING ;
+    mqac = lost         ;
+   }
+
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
 return 0;
- } // End of RXMQOPEN function
+ } // End of RXMQASYN function
 
 //
-// Do a Close   MQCLOSE
+// Take messages consumed asynchronously
 //
-//   Call:   rc = RXMQclos(handle,opts)
+//   Call:   rc = RXMQpoll(maxmsgs, wait, data, [output_msgdesc], [handle])
 //
-FTYPE  RXMQCLOS  RXMQPARM
+//           Up to maxmsgs messages held by RXMQASYN are taken into
+//           data.1 to data.n, with data.0 set to n and data.i.HANDLE to
+//           the handle of the queue message i came from. The queues are
+//           taken from in turn, a message each, or only the queue of
+//           handle. If there are none, the call waits up to wait
+//           milliseconds (0 not to wait) for the first, returning
+//           MQRC_NO_MSG_AVAILABLE if none came.
+//
+//           The MD fields of message i go to msgdesc.i.xxx (the fields
+//           wanted may follow the stem name, as for RXMQGET, but no
+//           .ZLIST is set), and msgdesc.0 is set to n.
+//
+//           A failure reported by MQ for a queue is returned once the
+//           messages before it have been taken.
+//
+FTYPE  RXMQPOLL  RXMQPARM
  {
-
- RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
  MQLONG                  rc = 0           ;  // Function Return Code
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = CLOSE  ;  // This function trace id
-
- RXSTRING                RX_opts          ;  // Data     Options
- RXSTRING                RX_handle        ;  // Data     Obj Handle
+ MQLONG                  warncc    = 0    ;  // A resume failure
+ MQLONG                  warnac    = 0    ;
+ MQULONG                 traceid = ASYNC  ;  // This function trace id
 
- MQLONG                  options  = 0     ;  //MQ close options
- MQLONG                  handle   = 0     ;  //MQ object number
+ RXSTRING                RX_data          ;  // Variable Data
+ RXSTRING                RXo_md           ;  // Variable Output Msg Desc
 
- RETMSG ReturnMsg[] = {
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+
+ MQLONG                  handle    = 0    ;  // MQ object number (0 any)
+ int                     one       = 0    ;  //   its slot
+ MQLONG                  maxmsgs   = 0    ;  // Messages wanted
+ MQLONG                  wait      = 0    ;  // Wait in ms (0 none)
+ uint64_t                number    = 0    ;  //   as given
+ uint64_t                deadline  = 0    ;  //   as a time
+ uint64_t                now              ;
+ RXMQRING              * ring             ;  // A queue's ring
+ MQULONG                 head             ;  //   its head
+ MQLONG                  n         = 0    ;  // Messages taken
+ int                     took             ;  // Any taken this pass
+ int                     started   = 0    ;  // Taking begun
+ int                     blocks           ;  // Chain blocks per message
+ int                     k                ;  // Looper
+ int                     s                ;  // Slot number
+ char                  * hold      = 0    ;  //-> Copies the chain points to
+ size_t                  holdlen   = 0    ;  //   their length
+ size_t                  holdsize  = 0    ;  //   and size
+ SHVCHAIN                chain            ;  // Variable sets
+
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        {  -2, "Null handle"},
-        {  -3, "Zero length handle"},
-        {  -4, "Null options"},
-        {  -5, "Zero length options"},
-        {  -6, "Handle out of range"},
-        {  -7, "Invalid handle"},
-        { -98, "Not connected to a QM"},
+        {  -2, "Bad maximum messages"},
+        {  -3, "Bad wait time"},
+        {  -4, "Null data stem var"},
+        {  -5, "Zero data stem var"},
+        {  -6, "Zero length output MsgDesc"},
+        {  -7, "Zero length handle"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Queue not being consumed"},
+        { -96, "Bad output field list"},
+        { -98, "No queues being consumed"},
         { -99, "UNKNOWN FAILURE"}} ;
 
  rc = set_envir (afuncname, &traceid, &anchor)    ;
@@ -2977,73 +10923,216 @@ FTYPE  RXMQCLOS  RXMQPARM
 //
 // Check the parms
 //
- if ( (rc == 0) && (aargc != 2 ) )             rc =  -1 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && ((aargc < 3) || (aargc > 5)) ) rc = -1 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[0]) )  rc =  -2 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[1]) )  rc =  -3 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -5 ;
+ if ( (rc == 0) && (aargc > 3) && RXZEROLENSTRING(aargv[3]) ) rc = -6 ;
+ if ( (rc == 0) && (aargc > 4) && RXZEROLENSTRING(aargv[4]) ) rc = -7 ;
+ if ( (rc == 0) && anchor->Rings == 0 )        rc = -98 ;
 
 //
 // Now the parms are correct, get them
 //
  if (rc == 0)
    {
-    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle))   ;
-    memcpy(&RX_opts  ,&aargv[1],sizeof(RX_opts  ))   ;
+    memcpy(&RX_data,  &aargv[2],sizeof(RX_data))   ;
+    RXo_md.strptr  = NULL ; RXo_md.strlength  = 0  ;
+    if ( aargc > 3 ) memcpy(&RXo_md, &aargv[3],sizeof(RXo_md))  ;
 
-    TRACE(traceid, ("RX_opts = %.*s\n",  (int)RX_opts.strlength,  RX_opts.strptr) )   ;
-    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("maxmsgs = %.*s\n",  (int)aargv[0].strlength, aargv[0].strptr)  ) ;
+    TRACE(traceid, ("wait = %.*s\n",     (int)aargv[1].strlength, aargv[1].strptr)  ) ;
+    TRACE(traceid, ("RX_data = %.*s\n",  (int)RX_data.strlength,  RX_data.strptr)   ) ;
 
-    parm_to_ulong(RX_opts,   &options)                 ;
-    parm_to_ulong(RX_handle, &handle)                  ;
+    parm_to_ulong(aargv[0],  &maxmsgs)    ;
+    if (              maxmsgs <= 0  ) rc = -2 ;
+    if (    (rc == 0)
+         && (    !str_to_num(aargv[1].strptr, aargv[1].strlength, &number)
+              || ((int64_t)number < 0) || (number > 0x7FFFFFFF) ) ) rc = -3 ;
+    wait = (MQLONG)number                 ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md, &omask_md) ) rc = -96 ;
+    omask_md &= ~FLD_ZLIST ;
+
+    if ( (rc == 0) && (aargc > 4) && !RXNULLSTRING(aargv[4]) )
+      {
+       parm_to_ulong(aargv[4], &handle)                         ;
+       if      ( !OBJINRANGE(anchor,handle) )      rc = -14      ;
+       else if ( !OBJOPEN(anchor,handle) )         rc = -15      ;
+       else if ( OBJ(anchor,handle)->ring == NULL ) rc = -17     ;
+       one = handle & OBJSLOTMASK                               ;
+      }
    }
 
 //
-// See if the handle is valid (ie: the gmqo to use)
+// Take the messages, a queue at a time, waiting only for the first
 //
- if ( (rc == 0) && ( ( handle > MAXQS ) || ( handle <= 0 ) ) ) rc = -6 ;
- if ( (rc == 0) && ( anchor->Qh[handle] == 0 ) )               rc = -7 ;
+ if (rc == 0)
+   {
+    started     = 1                                         ;
+    chain.count = 0                                         ;
+    blocks      = 2 + ( RXNULLSTRING(RXo_md) ? 0 : fields_blocks(md_fields, omask_md) ) ;
+    if ( wait > 0 ) deadline = now_ms() + wait              ;
+   }
+
+ while (rc == 0)
+   {
+    took = 0 ;
+    for ( k = 0 ; (k < anchor->Objsize) && (n < maxmsgs) && (rc == 0) ; k++ )
+      {
+       s    = (anchor->PollNext + k) % anchor->Objsize        ;
+       ring = anchor->Obj[s].ring                             ;
+       if ( (ring == NULL) || ((one != 0) && (s != one)) ) continue ;
+
+       head = ring->head                                      ;
+       if ( head == RING_GET(ring->tail) )
+         {
+          if ( (n == 0) && (mqac == 0) && (RING_GET(ring->reason) != 0) )
+            {
+             mqrc = MQCC_FAILED                               ;
+             mqac = (MQLONG) RING_GET(ring->reason)           ;
+             RING_SET(ring->reason, 0)                        ;
+             break                                            ;
+            }
+          continue                                            ;
+         }
+
+       rc = async_take(traceid, anchor, s, &chain, RX_data, md_fields, RXo_md,
+                       omask_md, blocks, n + 1, &hold, &holdlen, &holdsize,
+                       &warncc, &warnac) ;
+       if ( rc != 0 ) { mqac = errno ; break ; }
+       n++                                                    ;
+       took = 1                                               ;
+       anchor->PollNext = s + 1                               ;
+      }
+
+    if ( (rc != 0) || (n >= maxmsgs) || (mqac != 0) ) break  ;
+    if ( took ) continue                                      ; // Another pass
+    if ( (n > 0) || (wait == 0) ) break                       ;
+    now = now_ms()                                            ;
+    if ( now >= deadline ) break                              ;
+    wake_wait(anchor, one, (MQLONG)(deadline - now))          ;
+   }
 
 //
-// Now close the object
+// None taken is MQRC_NO_MSG_AVAILABLE, unless MQ reported a failure; a
+// consumer that could not be resumed is a warning
 //
- if (rc == 0)
+ if ( (rc == 0) && started )
    {
-    TRACE(traceid, ("Closing object handle [%"PRIu32"]\n",(uint32_t)handle) ) ;
-    MQCLOSE ( anchor->QMh, &anchor->Qh[handle], options, &mqrc, &mqac )       ;
-    rc = mqrc ;
-    if ( mqac == 0 )                  //If the Close worked,
-      {                               //then .....
-       anchor->Qh[handle] = 0 ;       //loose the MQ object
+    if ( (n == 0) && (mqac == 0) )
+      {
+       mqrc = MQCC_FAILED            ;
+       mqac = MQRC_NO_MSG_AVAILABLE  ;
+      }
+    if ( (mqrc == MQCC_OK) && (warncc != 0) )
+      {
+       mqrc = warncc ;
+       mqac = warnac ;
       }
+    rc = mqrc ;
    }
+ TRACE(traceid, ("%"PRId32" messages taken\n",(int32_t)n) ) ;
+
+ if ( started )
+   {
+    shv_flush(traceid, &chain, 2)                                   ;
+    shv_set_long(&chain, RX_data, "0", NULL, n)                     ;
+    if ( !RXNULLSTRING(RXo_md) )
+       shv_set_long(&chain, RXo_md, "0", NULL, n)                   ;
+    shv_run(traceid, &chain)                                        ;
+   }
+ free(hold) ;
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
 return 0;
- } // End of RXMQCLOS function
+ } // End of RXMQPOLL function
 
 //
-// Do a Syncpoint    MQCMIT
+// Wait for a message on any of a list of queues
 //
-//   Call:   rc = RXMQcmit()
+//   Call:   rc = RXMQwany(handles, wait, data, [output_msgdesc], [maxmsgs])
 //
-FTYPE  RXMQCMIT  RXMQPARM
+//           handles is a blank separated list of handles being consumed
+//           (RXMQASYN), each optionally followed by ':' and a weight (1
+//           to 1000, default 1). Up to maxmsgs messages (default 1) are
+//           taken from those queues into data.1 to data.n as by
+//           RXMQPOLL, data.i.HANDLE being the handle message i came
+//           from and msgdesc.i.xxx its MD fields. If none of them has a
+//           message the call waits up to wait milliseconds (0 not to
+//           wait) for one on any of them, woken by the consumer rather
+//           than polling, and returns MQRC_NO_MSG_AVAILABLE if none came.
+//
+//           Each message is taken from the queue, of those that have
+//           one, furthest behind its share (smooth weighted round
+//           robin), the shares being kept from call to call: queues of
+//           the same weight take turns, and one of weight 3 gives three
+//           messages to each one of weight 1 while both have messages.
+//           A queue with none does not hold up the others.
+//
+//           A failure reported by MQ for one of the queues is returned
+//           when none of them has a message.
+//
+FTYPE  RXMQWANY  RXMQPARM
  {
-
- RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
  MQLONG                  rc = 0           ;  // Function Return Code
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = CMIT   ;  // This function trace id
+ MQLONG                  warncc    = 0    ;  // A resume failure
+ MQLONG                  warnac    = 0    ;
+ MQULONG                 traceid = ASYNC  ;  // This function trace id
 
- RETMSG ReturnMsg[] = {
+ RXSTRING                RX_data          ;  // Variable Data
+ RXSTRING                RXo_md           ;  // Variable Output Msg Desc
+ RXSTRING                RX_word          ;  // One handle (or weight) of the list
+
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+
+ MQLONG                  handle           ;  // MQ object number
+ MQLONG                  weight           ;  //   its weight
+ MQLONG                  maxmsgs   = 1    ;  // Messages wanted
+ MQLONG                  wait      = 0    ;  // Wait in ms (0 none)
+ uint64_t                number    = 0    ;  //   as given
+ uint64_t                deadline  = 0    ;  //   as a time
+ uint64_t                now              ;
+ RXMQRING              * ring             ;  // A queue's ring
+ MQLONG                  total            ;  // Weight of those with messages
+ MQLONG                  n         = 0    ;  // Messages taken
+ int                     best             ;  // Slot taken from
+ int                     failed           ;  // Slot with a failure
+ int                     started   = 0    ;  // Taking begun
+ int                     blocks           ;  // Chain blocks per message
+ int                     len              ;  // Length of a handle
+ int                     wlen             ;  //   and of its weight
+ int                     s                ;  // Slot number
+ char                  * p                ;  //-> a handle
+ char                  * e                ;  //-> end of the list
+ char                  * hold      = 0    ;  //-> Copies the chain points to
+ size_t                  holdlen   = 0    ;  //   their length
+ size_t                  holdsize  = 0    ;  //   and size
+ SHVCHAIN                chain            ;  // Variable sets
+
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        { -98, "Not connected to a QM"},
+        {  -2, "Null handles"},
+        {  -3, "Bad handle list"},
+        {  -4, "Bad weight"},
+        {  -5, "Bad wait time"},
+        {  -6, "Null data stem var"},
+        {  -7, "Zero data stem var"},
+        {  -8, "Zero length output MsgDesc"},
+        {  -9, "Bad maximum messages"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Queue not being consumed"},
+        { -96, "Bad output field list"},
+        { -98, "No queues being consumed"},
         { -99, "UNKNOWN FAILURE"}} ;
 
  rc = set_envir (afuncname, &traceid, &anchor)    ;
@@ -3051,123 +11140,248 @@ FTYPE  RXMQCMIT  RXMQPARM
 //
 // Check the parms
 //
- if ( (rc == 0) && (aargc != 0 ) )             rc =  -1 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && ((aargc < 3) || (aargc > 5)) ) rc = -1 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[0]) )  rc =  -2 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[1]) )  rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && (aargc > 3) && RXZEROLENSTRING(aargv[3]) ) rc = -8 ;
+ if ( (rc == 0) && (aargc > 4) && RXZEROLENSTRING(aargv[4]) ) rc = -9 ;
+ if ( (rc == 0) && anchor->Rings == 0 )        rc = -98 ;
 
 //
-// Do the Actual Syncpoint on the required Queue Manager
-//        This also forces it for all others on the thread
+// Now the parms are correct, get them
 //
  if (rc == 0)
    {
-    MQCMIT ( anchor->QMh, &mqrc, &mqac ) ;
-    rc   = mqrc                          ;
+    memcpy(&RX_data,  &aargv[2],sizeof(RX_data))   ;
+    RXo_md.strptr  = NULL ; RXo_md.strlength  = 0  ;
+    if ( aargc > 3 ) memcpy(&RXo_md, &aargv[3],sizeof(RXo_md))  ;
+
+    TRACE(traceid, ("handles = %.*s\n",  (int)aargv[0].strlength, aargv[0].strptr)  ) ;
+    TRACE(traceid, ("wait = %.*s\n",     (int)aargv[1].strlength, aargv[1].strptr)  ) ;
+    TRACE(traceid, ("RX_data = %.*s\n",  (int)RX_data.strlength,  RX_data.strptr)   ) ;
+
+    if ( (aargc > 4) && !RXNULLSTRING(aargv[4]) )
+      {
+       parm_to_ulong(aargv[4], &maxmsgs)                ;
+       if ( maxmsgs <= 0 )                  rc = -9     ;
+      }
+    if (    (rc == 0)
+         && (    !str_to_num(aargv[1].strptr, aargv[1].strlength, &number)
+              || ((int64_t)number < 0) || (number > 0x7FFFFFFF) ) ) rc = -5 ;
+    wait = (MQLONG)number                               ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md, &omask_md) ) rc = -96 ;
+    omask_md &= ~FLD_ZLIST ;
    }
 
 //
-// Set the LAST variables, and the function return string
+// Weight the queues listed, the rest having none for this call
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ if (rc == 0)
+   {
+    e = aargv[0].strptr + aargv[0].strlength            ;
+    for ( p = aargv[0].strptr ; (rc == 0) && (p < e) ; p += len )
+      {
+       for ( len = 0 ; (p + len < e) && (p[len] != ' ') && (p[len] != ':') ; len++ )
+          if ( !isdigit((unsigned char)p[len]) ) rc = -3 ;
+       if ( (len == 0) && (*p == ' ') ) { len = 1 ; continue ; }  // A blank
+       if ( (rc != 0) || (len == 0) ) { rc = -3 ; break ; }
+
+       MAKERXSTRING(RX_word, p, len)                   ;
+       parm_to_ulong(RX_word, &handle)                 ;
+       weight = 1                                      ;
+       if ( (p + len < e) && (p[len] == ':') )
+         {
+          for ( wlen = 0 ; (p + len + 1 + wlen < e) && (p[len + 1 + wlen] != ' ') ; wlen++ )
+             if ( !isdigit((unsigned char)p[len + 1 + wlen]) ) rc = -4 ;
+          MAKERXSTRING(RX_word, p + len + 1, wlen)     ;
+          parm_to_ulong(RX_word, &weight)              ;
+          if ( (wlen == 0) || (weight <= 0) || (weight > WANYMAX) ) rc = -4 ;
+          len += 1 + wlen                              ;
+         }
+       TRACE(traceid, ("Handle %"PRIu32" weight %"PRId32"\n",(uint32_t)handle,(int32_t)weight) ) ;
+       if ( rc != 0 ) break                            ;
 
-return 0;
- } // End of RXMQCMIT function
+       if      ( !OBJINRANGE(anchor,handle) )       rc = -14 ;
+       else if ( !OBJOPEN(anchor,handle) )          rc = -15 ;
+       else if ( OBJ(anchor,handle)->ring == NULL ) rc = -17 ;
+       else OBJ(anchor,handle)->ring->weight = weight ;
+      }
+   }
 
 //
-// Do a Rollback     MQBACK
-//
-//   Call:   rc = RXMQback()
+// Take from whichever queue with a message has most credit, each with a
+// message gaining its weight and the one taken from losing what they
+// gained between them; wait (only for the first) when none has one
 //
-FTYPE  RXMQBACK  RXMQPARM
- {
+ if (rc == 0)
+   {
+    started     = 1                                         ;
+    chain.count = 0                                         ;
+    blocks      = 2 + ( RXNULLSTRING(RXo_md) ? 0 : fields_blocks(md_fields, omask_md) ) ;
+    if ( wait > 0 ) deadline = now_ms() + wait              ;
+   }
 
- RXMQCB                * anchor = 0       ;  // RXMQ Control Block
- MQLONG                  rc = 0           ;  // Function Return Code
- MQLONG                  mqrc = 0         ;  // MQ RC
- MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = BACK   ;  // This function trace id
+ while (rc == 0)
+   {
+    best   = 0 ;
+    failed = 0 ;
+    total  = 0 ;
+    for ( s = 1 ; s < anchor->Objsize ; s++ )
+      {
+       ring = anchor->Obj[s].ring                             ;
+       if ( (ring == NULL) || (ring->weight == 0) ) continue  ;
+       if ( ring->head == RING_GET(ring->tail) )
+         {
+          if ( (failed == 0) && (RING_GET(ring->reason) != 0) ) failed = s ;
+          continue                                            ;
+         }
+       ring->credit += ring->weight                           ;
+       total        += ring->weight                           ;
+       if ( (best == 0) || (ring->credit > anchor->Obj[best].ring->credit) ) best = s ;
+      }
 
- RETMSG ReturnMsg[] = {
-        {  -1, "Bad number of parms" },
-        { -98, "Not connected to a QM"},
-        { -99, "UNKNOWN FAILURE"}} ;
+    if ( best != 0 )
+      {
+       anchor->Obj[best].ring->credit -= total                ;
+       rc = async_take(traceid, anchor, best, &chain, RX_data, md_fields, RXo_md,
+                       omask_md, blocks, n + 1, &hold, &holdlen, &holdsize,
+                       &warncc, &warnac) ;
+       if ( rc != 0 ) { mqac = errno ; break ; }
+       n++                                                    ;
+       if ( n >= maxmsgs ) break                              ;
+       continue                                               ;
+      }
 
- rc = set_envir (afuncname, &traceid, &anchor)    ;
+    if ( n > 0 ) break                                        ;
+    if ( failed != 0 )
+      {
+       ring = anchor->Obj[failed].ring                        ;
+       mqrc = MQCC_FAILED                                     ;
+       mqac = (MQLONG) RING_GET(ring->reason)                 ;
+       RING_SET(ring->reason, 0)                              ;
+       break                                                  ;
+      }
+    if ( wait == 0 ) break                                    ;
+    now = now_ms()                                            ;
+    if ( now >= deadline ) break                              ;
+    wake_wait(anchor, -1, (MQLONG)(deadline - now))           ;
+   }
 
-//
-// Check the parms
-//
- if ( (rc == 0) && (aargc != 0 ) )             rc =  -1 ;
- if ( (rc == 0) && (anchor->QMh == 0 ) )       rc = -98 ;
+ for ( s = 1 ; s < anchor->Objsize ; s++ )
+   if ( anchor->Obj[s].ring != NULL ) anchor->Obj[s].ring->weight = 0 ;
 
 //
-// Do the Actual Backout on the required Queue Manager
-//        This also forces it for all others on the thread
+// None taken is MQRC_NO_MSG_AVAILABLE, unless MQ reported a failure; a
+// consumer that could not be resumed is a warning
 //
- if (rc == 0)
+ if ( (rc == 0) && started )
    {
-    MQBACK ( anchor->QMh, &mqrc, &mqac ) ;
-    rc   = mqrc                          ;
+    if ( (n == 0) && (mqac == 0) )
+      {
+       mqrc = MQCC_FAILED            ;
+       mqac = MQRC_NO_MSG_AVAILABLE  ;
+      }
+    if ( (mqrc == MQCC_OK) && (warncc != 0) )
+      {
+       mqrc = warncc ;
+       mqac = warnac ;
+      }
+    rc = mqrc ;
    }
+ TRACE(traceid, ("%"PRId32" messages taken\n",(int32_t)n) ) ;
+
+ if ( started )
+   {
+    shv_flush(traceid, &chain, 2)                                   ;
+    shv_set_long(&chain, RX_data, "0", NULL, n)                     ;
+    if ( !RXNULLSTRING(RXo_md) )
+       shv_set_long(&chain, RXo_md, "0", NULL, n)                   ;
+    shv_run(traceid, &chain)                                        ;
+   }
+ free(hold) ;
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
- return 0;
- } // End of RXMQBACK function
+return 0;
+ } // End of RXMQWANY function
 
 //
-// Do a Put     MQPUT
+// Send a request, and wait for its reply
 //
-//   Call:   rc = RXMQput(handle, data,
-//                        input_msgdesc, output_msgdesc,
-//                        input_pmo, output_pmo)
+//   Call:   rc = RXMQreq(queue, request, reply, [timeout],
+//                        [input_msgdesc], [conn])
 //
-FTYPE  RXMQPUT  RXMQPARM
+//           request (a string) is put to queue as an MQMT_REQUEST message
+//           whose ReplyToQ is a reply queue of the connection, see
+//           Request/reply, and reply.ID is set to its request number.
+//           input_msgdesc (a stem or an RXMQDEF template) may give other
+//           MD fields: a ReplyToQ in it names the model queue the reply
+//           queues are made from when first needed (by default
+//           SYSTEM.DEFAULT.MODEL.QUEUE), and MQRO_PASS_CORREL_ID in its
+//           Report has the reply matched by the CorrelId given rather
+//           than by the new MsgId.
+//
+//           With timeout (milliseconds, 0 or more) the reply is waited
+//           for, and set in reply.1 with reply.0 = 1, reply.1.ID the
+//           request number and reply.1.TIME the microseconds from put to
+//           reply. If none comes in time MQRC_NO_MSG_AVAILABLE is
+//           returned (reply.0 = 0), and a reply that comes later is
+//           discarded.
+//
+//           With no timeout the request is left in flight (reply.0 = 0),
+//           for RXMQRPLY to take its reply.
+//
+FTYPE  RXMQREQ  RXMQPARM
  {
-
  RXMQCB                * anchor = 0       ;  // RXMQ Control Block
- MQLONG                  rc   = 0         ;  // Function Return Code
+ MQLONG                  rc = 0           ;  // Function Return Code
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = PUT    ;  // This function trace id
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = REQ    ;  // This function trace id
 
- RXSTRING                RX_handle        ;  // Obj Handle
- RXSTRING                RX_data          ;  // Variable Data
- RXSTRING                RXi_md           ;  // Variable Input  Msg Desc
- RXSTRING                RXo_md           ;  // Variable Output Msg Desc
- RXSTRING                RXi_pmo          ;  // Variable Input  PMO
- RXSTRING                RXo_pmo          ;  // Variable Output PMO
+ RXSTRING                RX_queue         ;  // Request queue name
+ RXSTRING                RX_data          ;  // Request data
+ RXSTRING                RX_reply         ;  // Stem Var Reply
+ RXSTRING                RXi_md           ;  // Variable Input Msg Desc
 
- MQLONG                  handle           ;  //MQ object number
- MQMD2                   od               ;  //MQ Message descriptor
- MQPMO                   pmo              ;  //MQ Put Message options
- MQLONG                  data0 = 0        ;  // Variable Data len
- void                 *  data  = 0        ;  //-> Data buffer
- int                     datalen          ;  //   Data length
+ MQULONG                 omask_md = ALLFIELDS ;  // (no output MD)
 
- RETMSG ReturnMsg[] = {
+ MQOD                    od               ;  // MQ object descriptor
+ MQMD2                   md               ;  // MQ Message descriptor
+ MQPMO                   pmo              ;  // MQ Put Message options
+ MQCHAR48                model            ;  // Reply queue model
+ RXMQRPC               * rpc              ;  // Reply queues
+ int                     which = REQ_LEFT ;  //   the one for this request
+ int                     theobj = 0       ;  // Cached queue object to use
+ MQLONG                  timeout = 0      ;  // Wait in ms (REQ_WAIT only)
+ uint64_t                number = 0       ;  //   as given
+ MQLONG                  id = 0           ;  // Request number
+ MQBYTE24                key              ;  // CorrelId of the reply
+ uint64_t                sent             ;  // Time put
+ void                  * data = NULL      ;  //-> Reply data
+ MQLONG                  datalen = 0      ;  //   its length
+ SHVCHAIN                chain            ;  // Variable sets
+
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        {  -2, "Null handle"},
-        {  -3, "Zero data handle"},
-        {  -4, "Null data stem var"},
-        {  -5, "Zero data stem var"},
-        {  -6, "Null input MsgDesc"},
-        {  -7, "Zero length input MsgDesc"},
-        {  -8, "Null output MsgDesc"},
-        {  -9, "Zero length output MsgDesc"},
-        { -10, "Null input PMO"},
-        { -11, "Zero length input PMO"},
-        { -12, "Null output PMO"},
-        { -13, "Zero length output PMO"},
-        { -14, "Handle out of range"},
-        { -15, "Invalid handle"},
+        {  -2, "Null queue name"},
+        {  -3, "Zero length queue name"},
+        {  -4, "Queue name too long"},
+        {  -5, "Null request data"},
+        {  -6, "Null reply stem var"},
+        {  -7, "Zero length reply stem var"},
+        {  -8, "Bad timeout"},
+        {  -9, "Zero length input MsgDesc"},
         { -16, "malloc failure, check reason code"},
-        { -17, "Zero length input data buffer"},
-        { -18, "Data length is not equal to specified value"},
-        { -19, "Context handle out of range"},
-        { -20, "Invalid Context handle"},
+        { -17, "Reply queue not made, check rc/rsn"},
+        { -95, "Bad connection id"},
+        { -97, "Bad RXMQDEF template token"},
         { -98, "Not connected to a QM"},
         { -99, "UNKNOWN FAILURE"}} ;
 
@@ -3176,183 +11390,221 @@ FTYPE  RXMQPUT  RXMQPARM
 //
 // Check the parms
 //
- if ( (rc == 0) && (aargc != 6 ) )             rc =  -1 ;
+ if ( (rc == 0) && ((aargc < 3) || (aargc > 6)) ) rc = -1 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[3]) )    rc =  -8 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[4]) )    rc = -10 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc = -11 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[5]) )    rc = -12 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[5]) ) rc = -13 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && (aargv[0].strlength > MQ_Q_NAME_LENGTH) ) rc = -4 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && (aargc > 3) && RXZEROLENSTRING(aargv[3]) ) rc = -8 ;
+ if ( (rc == 0) && (aargc > 4) && RXZEROLENSTRING(aargv[4]) ) rc = -9 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 5, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
 
 //
 // Now the parms are correct, get them
 //
  if (rc == 0)
    {
-    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
-    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))   ;
-    memcpy(&RXi_md,   &aargv[2],sizeof(RXi_md))    ;
-    memcpy(&RXo_md,   &aargv[3],sizeof(RXo_md))    ;
-    memcpy(&RXi_pmo,  &aargv[4],sizeof(RXi_pmo))   ;
-    memcpy(&RXo_pmo,  &aargv[5],sizeof(RXo_pmo))   ;
-
-    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
-    TRACE(traceid, ("RX_data = %.*s\n",  (int)RX_data.strlength,  RX_data.strptr)   ) ;
-    TRACE(traceid, ("RXi_md = %.*s\n",   (int)RXi_md.strlength,   RXi_md.strptr)    ) ;
-    TRACE(traceid, ("RXo_md = %.*s\n",   (int)RXo_md.strlength,   RXo_md.strptr)    ) ;
-    TRACE(traceid, ("RXi_pmo = %.*s\n",  (int)RXi_pmo.strlength,  RXi_pmo.strptr)   ) ;
-    TRACE(traceid, ("RXo_pmo = %.*s\n",  (int)RXo_pmo.strlength,  RXo_pmo.strptr)   ) ;
-
-    make_md_from_stem(traceid,&od, RXi_md )          ;
-    make_po_from_stem(traceid,&pmo , RXi_pmo )       ;
+    memcpy(&RX_queue, &aargv[0],sizeof(RX_queue)) ;
+    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))  ;
+    memcpy(&RX_reply, &aargv[2],sizeof(RX_reply)) ;
+    RXi_md.strptr = NULL ; RXi_md.strlength = 0   ;
+    if ( aargc > 4 ) memcpy(&RXi_md, &aargv[4],sizeof(RXi_md)) ;
+
+    TRACE(traceid, ("RX_queue = %.*s\n",(int)RX_queue.strlength,RX_queue.strptr) ) ;
+    TRACE(traceid, ("RX_data length = %u\n",(uint32_t)RX_data.strlength)        ) ;
+    TRACE(traceid, ("RX_reply = %.*s\n",(int)RX_reply.strlength,RX_reply.strptr) ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n",  (int)RXi_md.strlength,  RXi_md.strptr)   ) ;
+
+    if ( RXNULLSTRING(RXi_md) )
+      {
+       memcpy(&md, &md_default, sizeof(MQMD2))          ;
+       memcpy(md.Format, MQFMT_STRING, sizeof(MQCHAR8)) ;
+      }
+    else if ( !ISTMPL(RXi_md) )                                   make_md_from_stem(traceid,&md, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &md, &omask_md) ) rc = -97 ;
 
-    parm_to_ulong(RX_handle, &handle)                ;
-    stem_to_long(traceid, RX_data, "0" , &data0)     ;
+    if ( (aargc > 3) && !RXNULLSTRING(aargv[3]) )
+      {
+       if (    (rc == 0)
+            && (    !str_to_num(aargv[3].strptr, aargv[3].strlength, &number)
+                 || ((int64_t)number < 0) || (number > 0x7FFFFFFF) ) ) rc = -8 ;
+       timeout = (MQLONG)number ;
+       which   = REQ_WAIT       ;
+      }
    }
 
 //
-// Now check the input Stem variable to see that there is
-//     some valid data to obtain
-//
- if ( (rc == 0) && ( data0 <= 0 ) ) rc = -17    ;
-
-//
-// Allocate data buffer to store stem.1 variable data.
+// Make the reply queue if this is its first use
 //
- if ( rc == 0 )
+ if (rc == 0)
    {
-    TRACE(traceid, ("Doing malloc for %"PRId32" bytes\n",(int32_t)data0) ) ;
-    data = malloc(data0)                                                   ;
-    if ( data == NULL )
+    memset(model, 0, sizeof(MQCHAR48))                         ;
+    if ( (md.ReplyToQ[0] == ' ') || (md.ReplyToQ[0] == '\0') )
+       memcpy(model, REQMODEL, sizeof(REQMODEL)-1)             ;
+    else
+       memcpy(model, md.ReplyToQ, sizeof(MQCHAR48))            ;
+
+    rpc = req_pool(anchor, conn, model)                        ;
+    if ( rpc == NULL )
       {
-       mqac = errno                                                        ;
-       TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)mqac) )          ;
-       rc = -16                                                            ;
+       mqac = errno                                            ;
+       rc   = -16                                              ;
       }
     else
-    {
-     datalen = stem_to_data(traceid, RX_data, "1", (MQBYTE *)data, data0)  ;
-     TRACE(traceid, ("Length of data received = %d\n",datalen) )           ;
-    }
+      {
+       req_queue(traceid, anchor, rpc, which, &mqrc, &mqac)    ;
+       if ( rpc->q[which].Qh == 0 ) rc = -17                   ;
+      }
    }
 
 //
-// Now check if stem.0 specifies the same value as stem.1 length.
-// If not, don't know what to do.
-//
- if ( (rc == 0) && ( datalen != data0 ) ) rc = -18;
-
-//
-// See if the output queue handle is valid
+// Put the request, on a cached handle for the queue if the cache is on
 //
- if ( (rc == 0) && ( ( handle > MAXQS ) || ( handle <= 0 ) ) )   rc = -14 ;
- if ( (rc == 0) && ( anchor->Qh[handle] == 0 ) )                 rc = -15 ;
+ if (rc == 0)
+   {
+    md.MsgType = MQMT_REQUEST                                  ;
+    memcpy(md.ReplyToQ, rpc->q[which].name, sizeof(MQCHAR48))  ;
+    memset(md.ReplyToQMgr, ' ', sizeof(MQCHAR48))              ;
 
+    memcpy(&pmo, &pmo_default, sizeof(MQPMO))                  ;
+    pmo.Options = MQPMO_NO_SYNCPOINT | MQPMO_NEW_MSG_ID
+                | MQPMO_FAIL_IF_QUIESCING                      ;
 
-//
-// If Context is specified (for MQPMO_PASS_ALL_CONTEXT)
-// see if the input queue handle is valid
-//
- if ( (rc == 0) && ( pmo.Context != 0 ) )
-   {
-    if ( ( pmo.Context > MAXQS ) || ( pmo.Context < 0 ) )  rc = -19 ;
-    if ( (rc == 0) && (anchor->Qh[pmo.Context] == 0 ) )    rc = -20 ;
-    if   (rc == 0) pmo.Context = anchor->Qh[pmo.Context];
-    }
+    memcpy(&od, &od_default, sizeof(MQOD))                     ;
+    memcpy(od.ObjectName, RX_queue.strptr, RX_queue.strlength) ;
 
-//
-// Now put the data to the queue
-//
- if (rc == 0)
-   {
-    TRACE(traceid, ("PUT Maxdatalen = %"PRId32"\n",(int32_t)data0) )                ;
-    MQPUT ( anchor->QMh, anchor->Qh[handle], &od, &pmo, data0, data, &mqrc, &mqac ) ;
+    theobj = cache_open(traceid, anchor, conn, &od, MQOO_OUTPUT | MQOO_FAIL_IF_QUIESCING) ;
+    sent   = now_us()                                          ;
+    if ( theobj != 0 )
+      {
+       MQPUT ( anchor->QM[conn].QMh, anchor->Obj[theobj].Qh, &md, &pmo,
+               (MQLONG)RX_data.strlength, RX_data.strptr, &mqrc, &mqac ) ;
+       cache_done(traceid, anchor, theobj)                     ;
+      }
+    else
+       MQPUT1 ( anchor->QM[conn].QMh, &od, &md, &pmo,
+                (MQLONG)RX_data.strlength, RX_data.strptr, &mqrc, &mqac ) ;
+    TRACE(traceid, ("PUT rc = %"PRId32", ac = %"PRId32"\n",(int32_t)mqrc,(int32_t)mqac) ) ;
     rc = mqrc ;
-    TRACE(traceid, ("PUT rc = %"PRId32", ac = %"PRId32"\n",(int32_t)mqrc, (int32_t)mqac) ) ;
 
-    make_stem_from_md(traceid,&od, RXo_md )    ;   //Set the return Variables
-    make_stem_from_po(traceid,&pmo , RXo_pmo ) ;
+    if ( mqrc != MQCC_FAILED )
+      {
+       id = ++rpc->lastid                                      ;
+       memcpy(key, (md.Report & MQRO_PASS_CORREL_ID) ? md.CorrelId : md.MsgId, sizeof(MQBYTE24)) ;
+       TRACE(traceid, ("Request %"PRId32" reply CorrelId:\n",(int32_t)id) ) ;
+       TRACX(traceid, (key, sizeof(MQBYTE24)) )                ;
+      }
    }
 
 //
-// Free data buffer for stem.1 variable data, if allocated.
+// Leave it in flight, or wait for the reply
 //
- if ( data != 0 )
+ if ( (id != 0) && (which == REQ_LEFT) && (req_add(rpc, id, key, sent) != 0) )
+   {
+    mqac = errno ;
+    rc   = -16   ;
+   }
+ if ( (id != 0) && (which == REQ_WAIT) )
+   {
+    if ( req_get(traceid, anchor, rpc, REQ_WAIT, key, now_ms() + timeout,
+                 &data, &datalen, &mqrc, &mqac) == 0 )
+      {
+       TRACE(traceid, ("Request %"PRId32" replied in %"PRIu64" us\n",
+                       (int32_t)id,(uint64_t)(now_us() - sent)) ) ;
+       rc = mqrc ;
+      }
+    else if ( data == NULL )
+      {
+       mqac = errno ;
+       rc   = -16   ;
+      }
+    else rc = mqrc  ;
+   }
+
+ if ( id != 0 )
    {
-    TRACE(traceid, ("Free area\n") ) ;
-    free(data) ;
+    chain.count = 0                                                 ;
+    shv_set_long(&chain, RX_reply, "ID", NULL, id)                  ;
+    if ( (which == REQ_WAIT) && (rc >= 0) && (rc != MQCC_FAILED) )
+      {
+       shv_set_long (&chain, RX_reply, "0", NULL, 1)                ;
+       shv_set      (&chain, RX_reply, "1", NULL, data, datalen, 1) ;
+       shv_set_long (&chain, RX_reply, "1", ".ID", id)              ;
+       shv_set_int64(&chain, RX_reply, "1", ".TIME", (MQINT64)(now_us() - sent)) ;
+      }
+    else shv_set_long(&chain, RX_reply, "0", NULL, 0)               ;
+    shv_run(traceid, &chain)                                        ;
    }
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
- return 0;
- } // End of RXMQPUT function
+return 0;
+ } // End of RXMQREQ function
 
 //
-// Do a put    MQPUT1
+// Take the replies to requests in flight
 //
-//   Call:   rc = RXMQPUT1(input1_objdesc, output1_objdesc, data,
-//                         input1_msgdesc,output1_msgdesc,
-//                         input1_pmo,output1_pmo)
-//        or
-//           rc = RXMQPUT1(queue_name, output1_objdesc, data,
-//                         input1_msgdesc,output1_msgdesc,
-//                         input1_pmo,output1_pmo)
+//   Call:   rc = RXMQrply(replies, timeout, [drop], [conn])
 //
-FTYPE RXMQPUT1  RXMQPARM
+//           The replies to the requests left in flight by RXMQREQ are
+//           taken as they come into replies.1 to replies.n, with
+//           replies.0 set to n, replies.i.ID to the request number,
+//           replies.i.TIME to the microseconds from put to reply and
+//           replies.i.RC to 0. The call waits up to timeout milliseconds
+//           (0 not to wait) for them all, returning MQRC_NO_MSG_AVAILABLE
+//           if none came, and sets replies.LEFT to the number still in
+//           flight.
+//
+//           With drop = 1 the requests still in flight at the end are
+//           given up, each listed with a null replies.i, its time so far
+//           and replies.i.RC = 2033 (MQRC_NO_MSG_AVAILABLE), the call
+//           returning a warning if there were any. Replies to them that
+//           come later are discarded.
+//
+FTYPE  RXMQRPLY  RXMQPARM
  {
  RXMQCB                * anchor = 0       ;  // RXMQ Control Block
  MQLONG                  rc = 0           ;  // Function Return Code
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = PUT1   ;  // This function trace id
-
- RXSTRING                RXi_od           ;  // Stem Var Obj Desc Input
- RXSTRING                RXo_od           ;  // Stem Var Obj Desc Output
- RXSTRING                RX_data          ;  // Variable Data
- RXSTRING                RXi_md           ;  // Variable Input1  Msg Desc
- RXSTRING                RXo_md           ;  // Variable Output1 Msg Desc
- RXSTRING                RXi_pmo          ;  // Variable Input1  PMO
- RXSTRING                RXo_pmo          ;  // Variable Output1 PMO
-
- MQOD                    od               ;  // MQ object descriptor
- MQMD2                   md               ;  // MQ Message descriptor
- MQPMO                   pmo              ;  // MQ put1 Message options
- void                 *  data  = 0        ;  //-> Data buffer
- MQLONG                  data0 = 0        ;  // Variable Data len
- int                     datalen          ;  //   Data length
-
- RETMSG ReturnMsg[] = {
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = REQ    ;  // This function trace id
+
+ RXSTRING                RX_replies       ;  // Stem Var Replies
+
+ RXMQRPC               * rpc = NULL       ;  // Reply queues
+ RXMQFLIGHT            * fl               ;  // A request in flight
+ MQLONG                  timeout = 0      ;  // Wait in ms (0 none)
+ uint64_t                number = 0       ;  //   as given
+ MQLONG                  drop = 0         ;  // Give up those left
+ uint64_t                deadline = 0     ;  //   as a time
+ void                  * data             ;  //-> Reply data
+ MQLONG                  datalen          ;  //   its length
+ char                  * copy             ;  // Data kept for the chain
+ char                  * hold = 0         ;  //-> Copies the chain points to
+ size_t                  holdlen = 0      ;  //   their length
+ size_t                  holdsize = 0     ;  //   and size
+ size_t                  want             ;  //   size needed
+ MQLONG                  n = 0            ;  // Replies taken
+ int                     i                ;  // Request in flight
+ int                     started = 0      ;  // Taking begun
+ char                    tail[24]         ;  // Reply number
+ SHVCHAIN                chain            ;  // Variable sets
+
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        {  -2, "Null input OD/Qname"},
-        {  -3, "Zero length input OD/Qname"},
-        {  -4, "Null output OD"},
-        {  -5, "Zero length output OD"},
-        {  -6, "Null data stem var"},
-        {  -7, "Zero data stem var"},
-        {  -8, "Null input MsgDesc"},
-        {  -9, "Zero length input MsgDesc"},
-        { -10, "Null output MsgDesc"},
-        { -11, "Zero length output MsgDesc"},
-        { -12, "Null input PMO"},
-        { -13, "Zero length input PMO"},
-        { -14, "Null output PMO"},
-        { -15, "Zero length output PMO"},
-        { -17, "malloc failure, check reason code"},
-        { -18, "Zero length input data buffer"},
-        { -19, "Data length is not equal to specified value"},
-        { -20, "Context handle out of range"},
-        { -21, "Invalid context handle"},
+        {  -2, "Null replies stem var"},
+        {  -3, "Zero length replies stem var"},
+        {  -4, "Bad timeout"},
+        {  -5, "Bad drop, not 0 or 1"},
+        { -16, "malloc failure, check reason code"},
+        { -95, "Bad connection id"},
         { -98, "Not connected to a QM"},
         { -99, "UNKNOWN FAILURE"}} ;
 
@@ -3361,176 +11613,408 @@ FTYPE RXMQPUT1  RXMQPARM
 //
 // Check the parms
 //
- if ( (rc == 0) && (aargc != 7 ) )             rc =  -1 ;
+ if ( (rc == 0) && ((aargc < 2) || (aargc > 4)) ) rc = -1 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[3]) )    rc =  -8 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[4]) )    rc = -10 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc = -11 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[5]) )    rc = -12 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[5]) ) rc = -13 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[6]) )    rc = -14 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[6]) ) rc = -15 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[1]) )  rc =  -4 ;
+ if ( (rc == 0)
+   && (    !str_to_num(aargv[1].strptr, aargv[1].strlength, &number)
+        || ((int64_t)number < 0) || (number > 0x7FFFFFFF) ) ) rc = -4 ;
+ if ( (rc == 0) && (aargc > 2) && !RXNULLSTRING(aargv[2])
+   && ( (aargv[2].strlength != 1) || ((aargv[2].strptr[0] != '0') && (aargv[2].strptr[0] != '1')) ) ) rc = -5 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 3, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
 
 //
 // Now the parms are correct, get them
 //
  if (rc == 0)
    {
-    memcpy(&RXi_od, &aargv[0],sizeof(RXi_od))  ;
-    memcpy(&RXo_od, &aargv[1],sizeof(RXo_od))  ;
-    memcpy(&RX_data,&aargv[2],sizeof(RX_data)) ;
-    memcpy(&RXi_md, &aargv[3],sizeof(RXi_md))  ;
-    memcpy(&RXo_md, &aargv[4],sizeof(RXo_md))  ;
-    memcpy(&RXi_pmo,&aargv[5],sizeof(RXi_pmo)) ;
-    memcpy(&RXo_pmo,&aargv[6],sizeof(RXo_pmo)) ;
+    memcpy(&RX_replies, &aargv[0],sizeof(RX_replies)) ;
+    TRACE(traceid, ("RX_replies = %.*s\n",(int)RX_replies.strlength,RX_replies.strptr) ) ;
+    TRACE(traceid, ("timeout = %.*s\n",   (int)aargv[1].strlength,   aargv[1].strptr)    ) ;
 
-    TRACE(traceid, ("RXi_od = %.*s\n", (int)RXi_od.strlength, RXi_od.strptr)  ) ;
-    TRACE(traceid, ("RXo_od = %.*s\n", (int)RXo_od.strlength, RXo_od.strptr)  ) ;
-    TRACE(traceid, ("RX_data = %.*s\n",(int)RX_data.strlength,RX_data.strptr) ) ;
-    TRACE(traceid, ("RXi_md = %.*s\n", (int)RXi_md.strlength, RXi_md.strptr)  ) ;
-    TRACE(traceid, ("RXo_md = %.*s\n", (int)RXo_md.strlength, RXo_md.strptr)  ) ;
-    TRACE(traceid, ("RXi_pmo = %.*s\n",(int)RXi_pmo.strlength,RXi_pmo.strptr) ) ;
-    TRACE(traceid, ("RXo_pmo = %.*s\n",(int)RXo_pmo.strlength,RXo_pmo.strptr) ) ;
+    timeout = (MQLONG)number                                          ;
+    if ( (aargc > 2) && !RXNULLSTRING(aargv[2]) ) drop = aargv[2].strptr[0] - '0' ;
 
-    make_od_from_stem(traceid,&od, RXi_od            ) ;
-    make_md_from_stem(traceid,&md, RXi_md            ) ;
-    make_po_from_stem(traceid,&pmo,RXi_pmo           ) ;
-    stem_to_long     (traceid,RX_data, "0" , &data0  ) ;
+    rpc         = anchor->QM[conn].Rpc                                ;
+    deadline    = now_ms() + timeout                                  ;
+    chain.count = 0                                                   ;
+    started     = 1                                                   ;
    }
 
 //
-// Now check the input Stem variable to see that there is
-//     some valid data to obtain
+// Take the replies, until there are none in flight or the time is up.
+// The data buffer is reused by the next MQGET, so the data set is a
+// copy, held in a malloc'd buffer until the chain pointing to it has
+// been run, and freed at the end.
 //
- if ( (rc == 0) && ( data0 <= 0 ) )  rc = -18 ;
+ while ( (rc == 0) && (rpc != NULL) && (rpc->count > 0) )
+   {
+    i = req_get(traceid, anchor, rpc, REQ_LEFT, NULL, deadline, &data, &datalen, &mqrc, &mqac) ;
+    if ( (i < 0) && (data == NULL) ) { mqac = errno ; rc = -16 ; break ; }
+    if ( i < 0 ) break                                          ;
+
+    shv_flush(traceid, &chain, 4)                               ;
+    if ( chain.count == 0 ) holdlen = 0                         ; // Copies done with
+    want = (datalen + 8) & ~(size_t)7                           ;
+    if ( holdlen + want > holdsize )
+      {
+       shv_run(traceid, &chain)                                 ; // Let go of the copies
+       chain.count = 0                                          ;
+       holdlen     = 0                                          ;
+      }
+    if ( want > holdsize )
+      {
+       for ( holdsize = holdsize ? holdsize : BUFMIN ; holdsize < want ; holdsize <<= 1 ) ;
+       free(hold)                                               ;
+       hold = (char *) malloc(holdsize)                         ;
+       if ( hold == NULL ) { mqac = errno ; rc = -16 ; break ; }
+      }
+    copy     = hold + holdlen                                   ;
+    holdlen += want                                             ;
+    memcpy(copy, data, datalen)                                 ;
+
+    fl = &rpc->flight[i]                                        ;
+    num_to_str(tail, (uint64_t)(++n), 0)                        ;
+    shv_set      (&chain, RX_replies, tail, NULL, copy, datalen, 1) ;
+    shv_set_long (&chain, RX_replies, tail, ".ID", fl->id)      ;
+    shv_set_int64(&chain, RX_replies, tail, ".TIME", (MQINT64)(now_us() - fl->sent)) ;
+    shv_set_long (&chain, RX_replies, tail, ".RC", MQRC_NONE)   ;
+    TRACE(traceid, ("Request %"PRId32" replied\n",(int32_t)fl->id) ) ;
+
+    *fl = rpc->flight[--rpc->count]                             ; // Keep them together
+   }
 
 //
-// Allocate data buffer to store stem.1 variable data.
+// Running out of time is not a failure unless nothing came; with drop
+// the requests left are given up
 //
- if ( rc == 0 )
+ if ( (rc == 0) && started )
    {
-    TRACE(traceid, ("Doing malloc for %"PRId32" bytes\n",(int32_t)data0) )  ;
-    data = malloc(data0)                                                    ;
-    if ( data == NULL )
+    if ( (mqrc == MQCC_FAILED) && (mqac != MQRC_NO_MSG_AVAILABLE) )
       {
-       mqac = errno                                                         ;
-       TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)mqac) )           ;
-       rc = -17                                                             ;
+       TRACE(traceid, ("Replies stopped by MQ failure\n") )    ;
+      }
+    else if ( drop && (rpc != NULL) && (rpc->count > 0) )
+      {
+       for ( i = 0 ; i < rpc->count ; i++ )
+         {
+          fl = &rpc->flight[i]                                 ;
+          num_to_str(tail, (uint64_t)(++n), 0)                 ;
+          shv_flush(traceid, &chain, 4)                        ;
+          shv_set      (&chain, RX_replies, tail, NULL, (void *)"", 0, 0) ;
+          shv_set_long (&chain, RX_replies, tail, ".ID", fl->id) ;
+          shv_set_int64(&chain, RX_replies, tail, ".TIME", (MQINT64)(now_us() - fl->sent)) ;
+          shv_set_long (&chain, RX_replies, tail, ".RC", MQRC_NO_MSG_AVAILABLE) ;
+         }
+       TRACE(traceid, ("%"PRId32" requests given up\n",(int32_t)rpc->count) ) ;
+       rpc->count = 0                                          ;
+       mqrc       = MQCC_WARNING                               ;
+       mqac       = MQRC_NO_MSG_AVAILABLE                      ;
+      }
+    else if ( (n == 0) && (rpc != NULL) && (rpc->count > 0) )
+      {
+       mqrc = MQCC_FAILED                                      ;
+       mqac = MQRC_NO_MSG_AVAILABLE                            ;
       }
     else
       {
-       datalen = stem_to_data(traceid, RX_data, "1", (MQBYTE *)data, data0) ;
-       TRACE(traceid, ("Length of data received = %d\n",datalen) )          ;
+       mqrc = MQCC_OK                                          ;
+       mqac = MQRC_NONE                                        ;
       }
+    rc = mqrc ;
+   }
+
+ if ( started )
+   {
+    shv_flush(traceid, &chain, 2)                                     ;
+    shv_set_long(&chain, RX_replies, "0", NULL, n)                    ;
+    shv_set_long(&chain, RX_replies, "LEFT", NULL, (rpc == NULL) ? 0 : rpc->count) ;
+    shv_run(traceid, &chain)                                          ;
    }
+ free(hold) ;
 
 //
-// Now check if stem.0 specifies the same value as stem.1 length.
-// If not, don't know what to do.
+// Set the LAST variables, and the function return string
 //
- if ( (rc == 0) && ( datalen != data0 ) ) rc = -19 ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
- //
- // If Context is specified (for MQPMO_PASS_ALL_CONTEXT)
- // see if the input queue handle is valid (ie: the gmqo to use)
- //
-  if ( (rc == 0) && ( pmo.Context != 0 ) )
-    {
-     if ( ( pmo.Context > MAXQS ) || ( pmo.Context < 0 ) ) rc = -20 ;
-     if ( (rc == 0) & (anchor->Qh[pmo.Context] == 0 ) )    rc = -21 ;
-     if (rc == 0) pmo.Context = anchor->Qh[pmo.Context]             ;
-    }
+return 0;
+ } // End of RXMQRPLY function
+
+//
+// Give a task to the worker pool
+//
+//   Call:   rc = RXMQsubm(op, queue, data, ticket, [wait], [input_msgdesc],
+//                         [key], [conn])
+//
+//           op is PUT (data is put to queue), GET (a message is got from
+//           queue, data being ignored) or REQ (data is put to queue as a
+//           request and its reply got, as for RXMQREQ). The task is done
+//           by a worker thread, on a connection of its own to the QM of
+//           conn (by MQCONN, so for a client as MQSERVER or the channel
+//           table give) and outside syncpoint, while the script goes on;
+//           the variable ticket is set to the ticket that RXMQWAIT takes
+//           for its result.
+//
+//           wait is how long (ms) a GET waits for a message, or a REQ for
+//           its reply (default 0, not to wait). input_msgdesc (a stem or
+//           an RXMQDEF template) gives the MD of a PUT or REQ, or the
+//           MsgId and CorrelId a GET is to match.
+//
+//           Tasks with the same key are done one after the other in the
+//           order given. The key of a PUT is by default its queue name,
+//           so puts to a queue are done in order; GETs and REQs have none
+//           unless given, going to whichever worker has least to do.
+//
+//           RXMQTERM ends the workers once the tasks they are doing are
+//           done, dropping those not begun.
+//
+FTYPE  RXMQSUBM  RXMQPARM
+ {
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = WORK   ;  // This function trace id
+
+ RXSTRING                RX_queue         ;  // Queue name
+ RXSTRING                RX_data          ;  // Data to put
+ RXSTRING                RX_ticket        ;  // Variable Ticket
+ RXSTRING                RXi_md           ;  // Variable Input Msg Desc
+ RXSTRING                RX_key           ;  // Ordering key
+
+ MQULONG                 omask_md = ALLFIELDS ;  // (no output MD)
+
+ RXMQPOOL              * pool = NULL      ;  // The pool
+ RXMQTASK              * task = NULL      ;  // The task
+ MQLONG                  op = 0           ;  // WORK_xx
+ MQLONG                  wait = 0         ;  // Wait in ms (0 none)
+ uint64_t                number = 0       ;  //   as given
+ char                    opc[4]           ;  // op (upper case)
+ int                     i                ;  // Looper
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null op"},
+        {  -3, "Bad op, not PUT, GET or REQ"},
+        {  -4, "Null queue name"},
+        {  -5, "Zero length queue name"},
+        {  -6, "Queue name too long"},
+        {  -7, "Null data"},
+        {  -8, "Null ticket var"},
+        {  -9, "Zero length ticket var"},
+        { -10, "Bad wait time"},
+        { -11, "Zero length input MsgDesc"},
+        { -12, "Zero length key"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Worker not started, check reason code"},
+        { -95, "Bad connection id"},
+        { -97, "Bad RXMQDEF template token"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
 
 //
-// Now execute PUT1
+// Check the parms
 //
+ if ( (rc == 0) && ((aargc < 4) || (aargc > 8)) ) rc = -1 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[0]) )  rc =  -2 ;
  if (rc == 0)
    {
-    TRACE(traceid, ("PUT1 Maxdatalen is %"PRId32"\n",(int32_t)data0) ) ;
-    MQPUT1 ( anchor->QMh, &od, &md, &pmo, data0, data, &mqrc, &mqac )  ;
-    rc   = mqrc ;
-    TRACE(traceid, ("PUT1 rc = %"PRId32", ac = %"PRId32"\n",
-          (int32_t)mqrc,(int32_t)mqac) )                               ;
+    memset(opc, 0, sizeof(opc)) ;
+    for ( i = 0 ; (i < (int)aargv[0].strlength) && (i < (int)sizeof(opc)-1) ; i++ )
+       opc[i] = toupper((unsigned char)aargv[0].strptr[i]) ;
+    if ( aargv[0].strlength >= sizeof(opc) ) opc[0] = 0 ;
+    if      ( !strcmp(opc, "PUT") ) op = WORK_PUT ;
+    else if ( !strcmp(opc, "GET") ) op = WORK_GET ;
+    else if ( !strcmp(opc, "REQ") ) op = WORK_REQ ;
+    else                            rc = -3       ;
+   }
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && (aargv[1].strlength > MQ_Q_NAME_LENGTH) ) rc = -6 ;
+ if ( (rc == 0) && (op != WORK_GET) && RXNULLSTRING(aargv[2]) ) rc = -7 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[3]) )    rc =  -8 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
+ if ( (rc == 0) && (aargc > 4) && RXZEROLENSTRING(aargv[4]) ) rc = -10 ;
+ if (    (rc == 0) && (aargc > 4) && !RXNULLSTRING(aargv[4])
+      && (    !str_to_num(aargv[4].strptr, aargv[4].strlength, &number)
+           || ((int64_t)number < 0) || (number > 0x7FFFFFFF) ) ) rc = -10 ;
+ wait = (MQLONG)number ;
+ if ( (rc == 0) && (aargc > 5) && RXZEROLENSTRING(aargv[5]) ) rc = -11 ;
+ if ( (rc == 0) && (aargc > 6) && RXZEROLENSTRING(aargv[6]) ) rc = -12 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 7, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
 
-    make_stem_from_md(traceid,&md,  RXo_md  ) ;   //Set the return Variables
-    make_stem_from_po(traceid,&pmo, RXo_pmo ) ;
-    make_stem_from_od(traceid,&od,  RXo_od  ) ;
+//
+// Now the parms are correct, make the task
+//
+ if (rc == 0)
+   {
+    memcpy(&RX_queue,  &aargv[1],sizeof(RX_queue))  ;
+    memcpy(&RX_data,   &aargv[2],sizeof(RX_data))   ;
+    memcpy(&RX_ticket, &aargv[3],sizeof(RX_ticket)) ;
+    RXi_md.strptr = NULL ; RXi_md.strlength = 0     ;
+    if ( aargc > 5 ) memcpy(&RXi_md, &aargv[5],sizeof(RXi_md)) ;
+    RX_key.strptr = NULL ; RX_key.strlength = 0     ;
+    if ( aargc > 6 ) memcpy(&RX_key, &aargv[6],sizeof(RX_key)) ;
+    if ( (op == WORK_PUT) && RXNULLSTRING(RX_key) ) memcpy(&RX_key, &RX_queue, sizeof(RX_key)) ;
+
+    TRACE(traceid, ("op = %s\n",opc) ) ;
+    TRACE(traceid, ("RX_queue = %.*s\n",(int)RX_queue.strlength,RX_queue.strptr) ) ;
+    TRACE(traceid, ("RX_key = %.*s\n",  (int)RX_key.strlength,  RX_key.strptr)   ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n",  (int)RXi_md.strlength,  RXi_md.strptr)   ) ;
+
+    task = (RXMQTASK *) calloc(1, sizeof(RXMQTASK))     ;
+    if ( (task != NULL) && (op != WORK_GET) && (RX_data.strlength > 0) )
+      {
+       task->data = (char *) malloc(RX_data.strlength)  ;
+       if ( task->data == NULL ) { free(task) ; task = NULL ; }
+      }
+    if ( task == NULL )
+      {
+       mqac = errno ;
+       rc   = -16   ;
+      }
    }
 
+ if (rc == 0)
+   {
+    task->op      = op                                     ;
+    task->traceid = traceid                                ;
+    memcpy(task->QMname, anchor->QM[conn].QMname, MQ_Q_MGR_NAME_LENGTH) ;
+    memcpy(task->qname, RX_queue.strptr, RX_queue.strlength) ;
+    if ( op != WORK_GET )
+      {
+       if ( RX_data.strlength > 0 ) memcpy(task->data, RX_data.strptr, RX_data.strlength) ;
+       task->datalen = (MQLONG) RX_data.strlength          ;
+      }
+    task->wait    = wait                                   ;
+
+    if ( RXNULLSTRING(RXi_md) )
+      {
+       memcpy(&task->md, &md_default, sizeof(MQMD2))       ;
+       if ( op != WORK_GET ) memcpy(task->md.Format, MQFMT_STRING, sizeof(MQCHAR8)) ;
+      }
+    else if ( !ISTMPL(RXi_md) )                                   make_md_from_stem(traceid,&task->md, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &task->md, &omask_md) ) rc = -97 ;
+   }
 
 //
-// Free data buffer for stem.1 variable data, if allocated.
+// Give it to a worker, the pool being made if this is the first
 //
- if ( data != 0 )
+ if (rc == 0)
+   {
+    pool = pool_make(anchor)       ;
+    if ( pool == NULL )
+      {
+       mqac = errno ;
+       rc   = -16   ;
+      }
+   }
+ if (rc == 0)
+   {
+    task->ticket = ++pool->tickets ;
+    if ( pool_give(traceid, pool, task, RX_key) )
+      {
+       mqac = errno ;
+       rc   = -17   ;
+      }
+    else
+      {
+       task->all   = pool->tasks   ;
+       pool->tasks = task          ;
+       stem_from_long(traceid, NULL, RX_ticket, "", (MQLONG)task->ticket) ;
+       task = NULL                 ;
+      }
+   }
+ if ( task != NULL )
    {
-    TRACE(traceid, ("Free area\n") ) ;
-    free(data) ;
+    free(task->data) ;
+    free(task)       ;
    }
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
-return 0;
-} // End of RXMQPUT1 function
+ return 0;
+ } // End of RXMQSUBM function
 
 //
-// Do a Get     MQGET
+// Wait for tasks given to the worker pool
 //
-//   Call:   rc = RXMQget(handle, data,
-//                        input_msgdesc,output_msgdesc,
-//                        input_gmo,output_gmo)
+//   Call:   rc = RXMQwait(tickets, wait, results, [output_msgdesc])
 //
-FTYPE  RXMQGET  RXMQPARM
+//           tickets is a blank separated list of tickets from RXMQSUBM
+//           (or '*' for every task not yet waited for). The call waits
+//           up to wait milliseconds (0 not to wait) for all of them to
+//           be done, then sets results.0 to how many were listed and,
+//           for each, results.i.TICKET and results.i.DONE (1 or 0). For
+//           a task done, results.i is the message got (empty for a PUT),
+//           results.i.CC and .RC its MQ completion and reason codes,
+//           results.i.TIME the time it took in microseconds, and
+//           msgdesc.i.xxx the fields of the MD put or got; its ticket is
+//           then finished with. A task not done may be waited for again.
+//
+//           The return is OK once all are done (whatever their own codes),
+//           else MQRC_NO_MSG_AVAILABLE, as a warning if some were done.
+//
+FTYPE  RXMQWAIT  RXMQPARM
  {
-
  RXMQCB                * anchor = 0       ;  // RXMQ Control Block
  MQLONG                  rc = 0           ;  // Function Return Code
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = GET    ;  // This function trace id
+ MQULONG                 traceid = WORK   ;  // This function trace id
 
- RXSTRING                RX_handle        ;  // Obj Handle
- RXSTRING                RX_data          ;  // Variable Data
- RXSTRING                RXi_md           ;  // Variable Input  Msg Desc
+ RXSTRING                RX_results       ;  // Stem Var Results
  RXSTRING                RXo_md           ;  // Variable Output Msg Desc
- RXSTRING                RXi_gmo          ;  // Variable Input  GMO
- RXSTRING                RXo_gmo          ;  // Variable Output GMO
-
- MQLONG                  handle    = 0    ;  // MQ object number
- MQMD2                   md               ;  // MQ Message descriptor
- MQGMO                   gmo              ;  // MQ Get Message options
- void                 *  data      = 0    ;  //-> Data buffer
- MQLONG                  data0     = 0    ;  //   Data length max
- MQLONG                  datalen   = 0    ;  //   Data length actual
+ RXSTRING                RX_item          ;  // Msg Desc stem of one task
+ RXSTRING                RX_word          ;  // One ticket of the list
+
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+
+ RXMQPOOL              * pool             ;  // The pool
+ RXMQTASK             ** list = NULL      ;  // Tasks listed
+ RXMQTASK             ** prev             ;  //-> link to a task
+ RXMQTASK              * task             ;  // A task
+ MQLONG                * fin = NULL       ;  // Whether each is done
+ MQLONG                  ticket           ;  // A ticket
+ MQLONG                  wait      = 0    ;  // Wait in ms (0 none)
+ uint64_t                number    = 0    ;  //   as given
+ uint64_t                deadline  = 0    ;  //   as a time
+ uint64_t                now              ;
+ int                     all       = 0    ;  // '*' given
+ int                     waited    = 0    ;  // Waiting done
+ int                     count     = 0    ;  // Tasks listed
+ int                     left             ;  //   not yet done
+ int                     blocks           ;  // Chain blocks per task
+ int                     len              ;  // Length of a ticket
+ int                     i                ;  // Looper
+ char                  * p                ;  //-> a ticket
+ char                  * e                ;  //-> end of the list
+ char                    tail[24]         ;  // Task number
+ char                    itemnam[VARNAMLEN] ; // Msg Desc stem name
+ SHVCHAIN                chain            ;  // Variable sets
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        {  -2, "Null handle"},
-        {  -3, "Zero data handle"},
-        {  -4, "Null data stem var"},
-        {  -5, "Zero data stem var"},
-        {  -6, "Null input MsgDesc"},
-        {  -7, "Zero length input MsgDesc"},
-        {  -8, "Null output MsgDesc"},
-        {  -9, "Zero length output MsgDesc"},
-        { -10, "Null input GMO"},
-        { -11, "Zero length input GMO"},
-        { -12, "Null output GMO"},
-        { -13, "Zero length output GMO"},
-        { -14, "Handle out of range"},
-        { -15, "Invalid handle"},
+        {  -2, "Null tickets"},
+        {  -3, "Bad ticket list"},
+        {  -4, "Unknown ticket"},
+        {  -5, "Bad wait time"},
+        {  -6, "Null results stem var"},
+        {  -7, "Zero length results stem var"},
+        {  -8, "Zero length output MsgDesc"},
         { -16, "malloc failure, check reason code"},
-        { -17, "Zero length input data buffer"},
-        { -98, "Not connected to a QM"},
+        { -96, "Bad output field list"},
+        { -98, "No tasks given (RXMQSUBM)"},
         { -99, "UNKNOWN FAILURE"}} ;
 
  rc = set_envir (afuncname, &traceid, &anchor)    ;
@@ -3538,154 +12022,224 @@ FTYPE  RXMQGET  RXMQPARM
 //
 // Check the parms
 //
-
- if ( (rc == 0) && (aargc != 6 ) )             rc =  -1 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && ((aargc < 3) || (aargc > 4)) ) rc = -1 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[0]) )  rc =  -2 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[1]) )  rc =  -5 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[3]) )    rc =  -8 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[4]) )    rc = -10 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc = -11 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[5]) )    rc = -12 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[5]) ) rc = -13 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && (aargc > 3) && RXZEROLENSTRING(aargv[3]) ) rc = -8 ;
+ if ( (rc == 0) && anchor->Pool == NULL )      rc = -98 ;
 
 //
 // Now the parms are correct, get them
 //
-
  if (rc == 0)
    {
-    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
-    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))   ;
-    memcpy(&RXi_md,   &aargv[2],sizeof(RXi_md))    ;
-    memcpy(&RXo_md,   &aargv[3],sizeof(RXo_md))    ;
-    memcpy(&RXi_gmo,  &aargv[4],sizeof(RXi_gmo))   ;
-    memcpy(&RXo_gmo,  &aargv[5],sizeof(RXo_gmo))   ;
-
-    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
-    TRACE(traceid, ("RX_data = %.*s\n",  (int)RX_data.strlength,  RX_data.strptr)   ) ;
-    TRACE(traceid, ("RXi_md = %.*s\n",   (int)RXi_md.strlength,   RXi_md.strptr)    ) ;
-    TRACE(traceid, ("RXo_md = %.*s\n",   (int)RXo_md.strlength,   RXo_md.strptr)    ) ;
-    TRACE(traceid, ("RXi_gmo = %.*s\n",  (int)RXi_gmo.strlength,  RXi_gmo.strptr)   ) ;
-    TRACE(traceid, ("RXo_gmo = %.*s\n",  (int)RXo_gmo.strlength,  RXo_gmo.strptr)   ) ;
-
-
-    make_md_from_stem(traceid,&md, RXi_md )      ;
-    make_go_from_stem(traceid,&gmo , RXi_gmo )   ;
-    parm_to_ulong(RX_handle, &handle)            ;
-    stem_to_long(traceid, RX_data, "0" , &data0) ;
+    pool = anchor->Pool                             ;
+    memcpy(&RX_results, &aargv[2],sizeof(RX_results)) ;
+    RXo_md.strptr  = NULL ; RXo_md.strlength  = 0  ;
+    if ( aargc > 3 ) memcpy(&RXo_md, &aargv[3],sizeof(RXo_md))  ;
+
+    TRACE(traceid, ("tickets = %.*s\n",  (int)aargv[0].strlength, aargv[0].strptr)  ) ;
+    TRACE(traceid, ("wait = %.*s\n",     (int)aargv[1].strlength, aargv[1].strptr)  ) ;
+
+    if (    !str_to_num(aargv[1].strptr, aargv[1].strlength, &number)
+         || ((int64_t)number < 0) || (number > 0x7FFFFFFF) )   rc = -5  ;
+    wait = (MQLONG)number                           ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md, &omask_md) ) rc = -96 ;
+    omask_md &= ~FLD_ZLIST ;
    }
 
 //
-// Now check the input Stem variable to see that there is
-//     some valid data to obtain
-//
-  if ( (rc == 0) && ( data0 <= 0 ) ) rc = -17 ;
-
-//
-// See if the handle is valid
-//
- if ( (rc == 0) && ( ( handle > MAXQS ) || ( handle <= 0 ) ) ) rc = -14 ;
- if ( (rc == 0) && ( anchor->Qh[handle] == 0 ) )               rc = -15 ;
-
-//
-// Now GETMAIN the buffer to receive the data records
+// Find the tasks listed (at most one per two characters of the list, or
+// all of them for '*')
 //
- if (( rc == 0) && ( data0 != 0 ) )
+ if (rc == 0)
    {
-    TRACE(traceid, ("Doing malloc for %"PRId32" bytes\n",(int32_t)data0) ) ;
-    data = malloc(data0)                                                   ;
-    if ( data == NULL )
-    {
-     mqac = errno                                                          ;
-     TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)mqac) )            ;
-     rc = -16                                                              ;
-    }
+    e   = aargv[0].strptr + aargv[0].strlength          ;
+    all = ( (aargv[0].strlength == 1) && (aargv[0].strptr[0] == '*') ) ;
+    if ( all ) for ( task = pool->tasks ; task != NULL ; task = task->all ) count++ ;
+    else       count = ( (int)aargv[0].strlength + 1 ) / 2 ;
+    list = (RXMQTASK **) arena_get(anchor, (count + 1) * sizeof(RXMQTASK *)) ;
+    fin  = (MQLONG *)    arena_get(anchor, (count + 1) * sizeof(MQLONG))     ;
+    if ( (list == NULL) || (fin == NULL) ) { mqac = errno ; rc = -16 ; }
+   }
+ if ( (rc == 0) && all )
+   {
+    for ( i = count - 1, task = pool->tasks ; task != NULL ; task = task->all, i-- )
+       list[i] = task ;                                  // Oldest first
+   }
+ else if (rc == 0)
+   {
+    count = 0                                           ;
+    for ( p = aargv[0].strptr ; (rc == 0) && (p < e) ; p += len )
+      {
+       for ( len = 0 ; (p + len < e) && (p[len] != ' ') ; len++ )
+          if ( !isdigit((unsigned char)p[len]) ) rc = -3 ;
+       if ( len == 0 ) { len = 1 ; continue ; }        // A blank
+       if ( rc != 0 ) break                            ;
+
+       MAKERXSTRING(RX_word, p, len)                   ;
+       parm_to_ulong(RX_word, &ticket)                 ;
+       for ( task = pool->tasks ; task != NULL ; task = task->all )
+         if ( task->ticket == (MQULONG)ticket ) break ;
+       TRACE(traceid, ("Ticket %"PRId32" %s\n",(int32_t)ticket,(task != NULL) ? "found" : "not known") ) ;
+       if ( task == NULL ) rc = -4                     ;
+       else list[count++] = task                       ;
+      }
    }
 
 //
-// Now get the data from the queue
+// Wait for them, noting which are done
 //
  if (rc == 0)
    {
-    TRACE(traceid, ("GET Maxdatalen = %"PRId32"\n",(int32_t)data0) )                          ;
-    MQGET ( anchor->QMh, anchor->Qh[handle], &md, &gmo, data0, data, &datalen, &mqrc, &mqac ) ;
-    rc = mqrc                                                                                 ;
-    TRACE(traceid, ("GET rc = %"PRId32", ac = %"PRId32", datalen = %"PRId32"\n",
-          (int32_t)mqrc,(int32_t)mqac,(int32_t)datalen) )                                     ;
-
-    make_stem_from_md(traceid,&md,  RXo_md  ) ;  //Set the return Variables
-    make_stem_from_go(traceid,&gmo, RXo_gmo ) ;
+    waited = 1                                 ;
+    if ( wait > 0 ) deadline = now_ms() + wait ;
+    POOL_LOCK(pool) ;
+    for (;;)
+      {
+       for ( i = 0, left = 0 ; i < count ; i++ ) left += ( list[i]->done == 0 ) ;
+       if ( (left == 0) || (wait == 0) ) break ;
+       now = now_ms()                          ;
+       if ( now >= deadline ) break            ;
+       pool_wait(pool, (MQLONG)(deadline - now)) ;
+      }
+    for ( i = 0 ; i < count ; i++ ) fin[i] = list[i]->done ;
+    POOL_UNLOCK(pool) ;
+    TRACE(traceid, ("%d of %d tasks done\n",count - left,count) ) ;
 
-    stem_from_long (traceid, NULL, RX_data, "0" , datalen)                 ;
-    if (datalen > data0) datalen = data0                                   ;
-    stem_from_bytes(traceid, NULL, RX_data, "1" , (MQBYTE *)data, datalen) ;
+    mqrc = MQCC_OK   ;
+    if ( left > 0 )
+      {
+       mqrc = ( left == count ) ? MQCC_FAILED : MQCC_WARNING ;
+       mqac = MQRC_NO_MSG_AVAILABLE                         ;
+      }
+    rc = mqrc ;
    }
 
 //
-// Free data buffer for stem.1 variable data, if allocated.
+// Set the results. The data and MDs are the tasks' own, so those done
+// are only freed once the chain has been run.
 //
- if ( data != 0 )
+ if ( waited )
    {
-    TRACE(traceid, ("Free area\n") ) ;
-    free(data) ;
+    chain.count = 0                                                  ;
+    blocks      = 6 + ( RXNULLSTRING(RXo_md) ? 0 : fields_blocks(md_fields, omask_md) ) ;
+    for ( i = 0 ; i < count ; i++ )
+      {
+       task = list[i]                                                ;
+       num_to_str(tail, (uint64_t)(i + 1), 0)                        ;
+       shv_flush(traceid, &chain, blocks)                            ;
+       shv_set_long(&chain, RX_results, tail, ".TICKET", (MQLONG)task->ticket) ;
+       shv_set_long(&chain, RX_results, tail, ".DONE", fin[i] ? 1 : 0) ;
+       if ( !fin[i] ) continue                                       ;
+
+       shv_set(&chain, RX_results, tail, NULL, (task->data != NULL) ? task->data : "",
+               task->datalen, 1)                                     ;
+       shv_set_long(&chain, RX_results, tail, ".CC", task->mqrc)     ;
+       shv_set_long(&chain, RX_results, tail, ".RC", task->mqac)     ;
+       shv_set_int64(&chain, RX_results, tail, ".TIME", (MQINT64)task->took) ;
+       if ( !RXNULLSTRING(RXo_md) )
+         {
+          MAKERXSTRING(RX_item, itemnam, make_varname(itemnam, RXo_md, tail, ".")) ;
+          fields_to_chain(&chain, md_fields, &task->md, RX_item, omask_md) ;
+         }
+       task->done = 2                                                ; // Finished with
+      }
+    shv_flush(traceid, &chain, 2)                                    ;
+    shv_set_long(&chain, RX_results, "0", NULL, count)               ;
+    if ( !RXNULLSTRING(RXo_md) )
+       shv_set_long(&chain, RXo_md, "0", NULL, count)                ;
+    shv_run(traceid, &chain)                                         ;
+
+    for ( prev = &pool->tasks ; (task = *prev) != NULL ; )
+      {
+       if ( task->done != 2 ) { prev = &task->all ; continue ; }
+       *prev = task->all ;
+       free(task->data)  ;
+       free(task)        ;
+      }
    }
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
-return 0;
- } // End of RXMQGET function
+ return 0;
+ } // End of RXMQWAIT function
 
 //
-// Do an inquire MQINQ
+// Put a message to queues on several queue managers at once
 //
-//   Call:   rc = RXMQinq(handle, attribute, attrsetting )
+//   Call:   rc = RXMQfan(targets, data, [input_msgdesc], [conn])
 //
-//           NB: only 1 attribute at a time!
+//           data is put to each queue of the stem targets: targets.0 is
+//           how many, targets.i.Q the name of the i'th queue and
+//           targets.i.QM the QM it is on (by default that of conn). The
+//           puts are done by the worker pool (see RXMQSUBM) outside
+//           syncpoint, those to a QM one after the other in the order
+//           listed, on a worker's connection to it, and those to
+//           different QMs at the same time, so the call takes about as
+//           long as the slowest QM. input_msgdesc (a stem or an RXMQDEF
+//           template) gives the MD of every message.
 //
+//           When all are done targets.i.CC and .RC are set to each
+//           put's MQ completion and reason codes, targets.i.TIME to the
+//           time it took (microseconds, with any MQCONN the worker made
+//           for it), and targets.TIME to that of the whole call.
 //
-FTYPE  RXMQINQ  RXMQPARM
+//           The return is OK if all were put, else the reason of those
+//           that failed (MQRC_MULTIPLE_REASONS if not all the same), as
+//           a warning if some were put.
+//
+FTYPE  RXMQFAN  RXMQPARM
  {
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = WORK   ;  // This function trace id
+
+ RXSTRING                RX_targets       ;  // Stem Var Targets
+ RXSTRING                RX_data          ;  // Data to put
+ RXSTRING                RXi_md           ;  // Variable Input Msg Desc
+ RXSTRING                RX_key           ;  // Ordering key (the QM)
+
+ MQULONG                 omask_md = ALLFIELDS ;  // (no output MD)
+
+ RXMQPOOL              * pool = NULL      ;  // The pool
+ RXMQTASK              * tasks = NULL     ;  // A task per target
+ RXMQTASK              * task             ;  // One of them
+ MQMD2                   md               ;  // MD of every message
+ MQLONG                  count = 0        ;  // Targets
+ MQLONG                  given = 0        ;  //   given to workers
+ MQLONG                  left             ;  //   not yet done
+ MQLONG                  put = 0          ;  //   put
+ MQLONG                  reason = 0       ;  // Reason of those that failed
+ uint64_t                start = now_us() ;  // Time called
+ int                     n                ;  // Targets fetched
+ int                     i                ;  // Looper
+ int                     j                ;  // Looper
+ SHVBLOCK              * sv               ;  //-> a fetch
+ char                    tail[24]         ;  // Target number
+ SHVCHAIN                chain            ;  // Variable fetches and sets
 
- RXMQCB         * anchor = 0           ;  // RXMQ Control Block
- MQLONG           rc = 0               ;  // Function Return Code
- MQLONG           mqrc = 0             ;  // MQ RC
- MQLONG           mqac = 0             ;  // MQ AC
- MQULONG          traceid = INQ        ;  // This function trace id
-
- RXSTRING         RX_handle            ;  // Data     Obj Handle
- RXSTRING         RX_attr              ;  // Variable Input  Attr
- RXSTRING         RX_value             ;  // Variable Output Attr
-
- MQLONG           handle       = 0     ;  // MQ object number
- MQLONG           attrib       = 0     ;  // object attribute
-
- MQLONG           inqselcount  = 1     ;  //INQ - number of sels
- MQLONG           inqselicount = 1     ;  //INQ - number of int sels
- MQLONG           inqints      = 0     ;  //INQ - integer return
- MQLONG           inqcharlen   = 600   ;  //INQ - char return length
- char             inqchars[601]        ;  //INQ - char return
-
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        {  -2, "Null handle"},
-        {  -3, "Zero data handle"},
-        {  -4, "Null data input attr"},
-        {  -5, "Zero data input attr"},
-        {  -6, "Null output attr"},
-        {  -7, "Zero length output attr"},
-        {  -8, "No attribute supplied"},
-        {  -9, "Attribute out of valid range"},
-        { -10, "Handle out of range"},
-        { -11, "Invalid handle"},
+        {  -2, "Null targets stem var"},
+        {  -3, "Zero length targets stem var"},
+        {  -4, "Null data"},
+        {  -5, "Zero length input MsgDesc"},
+        {  -6, "No targets (targets.0)"},
+        {  -7, "Missing target queue name (targets.i.Q)"},
+        {  -8, "Target queue or QM name too long"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Worker not started, check reason code"},
+        { -95, "Bad connection id"},
+        { -97, "Bad RXMQDEF template token"},
         { -98, "Not connected to a QM"},
         { -99, "UNKNOWN FAILURE"}} ;
 
@@ -3694,126 +12248,225 @@ FTYPE  RXMQINQ  RXMQPARM
 //
 // Check the parms
 //
- if ( (rc == 0) && (aargc != 3 ) )             rc =  -1 ;
+ if ( (rc == 0) && ((aargc < 2) || (aargc > 4)) ) rc = -1 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && (aargc > 2) && RXZEROLENSTRING(aargv[2]) ) rc = -5 ;
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 3, &conn) ) rc = -95 ;
 
 //
-// Now the parms are correct, get them
+// Now the parms are correct, get them and the MD
 //
  if (rc == 0)
    {
-    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
-    memcpy(&RX_attr,  &aargv[1],sizeof(RX_attr))   ;
-    memcpy(&RX_value, &aargv[2],sizeof(RX_value))  ;
-
-    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
-    TRACE(traceid, ("RX_attr = %.*s\n",  (int)RX_attr.strlength,  RX_attr.strptr)   ) ;
-    TRACE(traceid, ("RX_value = %.*s\n", (int)RX_value.strlength, RX_value.strptr)  ) ;
-
-    parm_to_ulong(RX_handle, &handle) ;
-    parm_to_ulong(RX_attr,   &attrib) ;
+    memcpy(&RX_targets, &aargv[0],sizeof(RX_targets)) ;
+    memcpy(&RX_data,    &aargv[1],sizeof(RX_data))    ;
+    RXi_md.strptr = NULL ; RXi_md.strlength = 0      ;
+    if ( aargc > 2 ) memcpy(&RXi_md, &aargv[2],sizeof(RXi_md)) ;
 
-    if (attrib == 0) rc = -8          ;
+    TRACE(traceid, ("RX_targets = %.*s\n",(int)RX_targets.strlength,RX_targets.strptr) ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n",    (int)RXi_md.strlength,    RXi_md.strptr)     ) ;
 
-    if ( !( ( (attrib >= MQIA_FIRST) && (attrib <= MQIA_LAST  ) )
-         || ( (attrib >= MQCA_FIRST) && (attrib <= MQCA_LAST  ) ) ) ) rc = -9;
+    if ( RXNULLSTRING(RXi_md) )
+      {
+       memcpy(&md, &md_default, sizeof(MQMD2))              ;
+       memcpy(md.Format, MQFMT_STRING, sizeof(MQCHAR8))     ;
+      }
+    else if ( !ISTMPL(RXi_md) )                                   make_md_from_stem(traceid,&md, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &md, &omask_md) ) rc = -97 ;
+   }
+ if (rc == 0)
+   {
+    stem_to_long(traceid, RX_targets, "0", &count) ;
+    if ( count <= 0 ) rc = -6                      ;
    }
+ if (rc == 0)
+   {
+    tasks = (RXMQTASK *) arena_get(anchor, count * sizeof(RXMQTASK)) ;
+    if ( tasks == NULL ) { mqac = errno ; rc = -16 ; }
+    else memset(tasks, 0, count * sizeof(RXMQTASK))                ;
+   }
+
 //
-// See if the handle is valid
+// Make a task of each target, fetching their queue and QM names up to
+// MAXCHAIN at a time straight into the tasks. The data is the caller's,
+// which stays put until the tasks are done.
 //
- if ( (rc == 0) && ( ( handle > MAXQS ) || ( handle <= 0 ) ) ) rc = -10 ;
- if ( (rc == 0) && ( anchor->Qh[handle] == 0 ) )               rc = -11 ;
+ for ( i = 0 ; (rc == 0) && (i < count) ; i += n )
+   {
+    n = count - i                                               ;
+    if ( n > MAXCHAIN / 2 ) n = MAXCHAIN / 2                    ;
+    chain.count = 0                                             ;
+    for ( j = 0 ; j < n ; j++ )
+      {
+       num_to_str(tail, (uint64_t)(i + j + 1), 0)               ;
+       shv_fetch(&chain, RX_targets, tail, ".Q",  tasks[i+j].qname,  sizeof(MQCHAR48)) ;
+       shv_fetch(&chain, RX_targets, tail, ".QM", tasks[i+j].QMname, MQ_Q_MGR_NAME_LENGTH) ;
+      }
+    shv_run(traceid, &chain)                                    ;
+
+    for ( j = 0 ; (j < n) && (rc == 0) ; j++ )
+      {
+       task = &tasks[i+j]                                       ;
+       sv   = &chain.sv[2*j]                                    ;
+       if ( sv->shvret & RXSHV_NEWV )                 rc = -7   ;
+       else if ( sv->shvvalue.strlength == 0 )        rc = -7   ;
+       if ( (sv->shvret | sv[1].shvret) & RXSHV_TRUNC ) rc = -8 ;
+       if ( (sv[1].shvret & RXSHV_NEWV) || (sv[1].shvvalue.strlength == 0) )
+         {
+          if ( (rc == 0) && (anchor->QM[conn].QMh == 0) ) rc = -98 ;
+          memcpy(task->QMname, anchor->QM[conn].QMname, MQ_Q_MGR_NAME_LENGTH) ;
+         }
+       if ( rc != 0 )
+         {
+          TRACE(traceid, ("Target %d has no queue or a bad name\n",i + j + 1) ) ;
+          break ;
+         }
+       task->op      = WORK_PUT                                 ;
+       task->traceid = traceid                                  ;
+       task->ticket  = (MQULONG)(i + j + 1)                     ;
+       task->data    = RX_data.strptr                           ;
+       task->datalen = (MQLONG) RX_data.strlength               ;
+       memcpy(&task->md, &md, sizeof(MQMD2))                    ;
+      }
+   }
 
 //
-// Format up either a character or an integer area
+// Give them to the workers, keyed by QM, and wait for those given
 //
  if (rc == 0)
    {
-    memset(inqchars,0,sizeof(inqchars)) ;
-    if ( (attrib >= MQCA_FIRST  ) && (attrib <= MQCA_LAST  ) )
-      inqselicount = 0 ;
-    else
-      inqcharlen   = 0 ;
-   } //End of Attribute setup
+    pool = pool_make(anchor) ;
+    if ( pool == NULL ) { mqac = errno ; rc = -16 ; }
+   }
+ for ( ; (rc == 0) && (given < count) ; given++ )
+   {
+    task = &tasks[given]                                        ;
+    for ( j = 0 ; (j < MQ_Q_MGR_NAME_LENGTH) && (task->QMname[j] != '\0')
+                                             && (task->QMname[j] != ' ') ; j++ ) ;
+    MAKERXSTRING(RX_key, task->QMname, j)                       ;
+    TRACE(traceid, ("Target %"PRId32" is %.48s on %.48s\n",
+                    (int32_t)(given + 1),task->qname,task->QMname) ) ;
+    if ( pool_give(traceid, pool, task, RX_key) ) { mqac = errno ; rc = -17 ; }
+   }
+ if ( given > 0 )
+   {
+    if ( rc != 0 ) given-- ;                             // That one was not
+    POOL_LOCK(pool) ;
+    for (;;)
+      {
+       for ( i = 0, left = 0 ; i < given ; i++ ) left += ( tasks[i].done == 0 ) ;
+       if ( left == 0 ) break ;
+       pool_wait(pool, 1000)  ;
+      }
+    POOL_UNLOCK(pool) ;
+    TRACE(traceid, ("%"PRId32" puts done in %"PRIu64" microseconds\n",
+                    (int32_t)given,(uint64_t)(now_us() - start)) ) ;
+   }
 
 //
-// Now do the Inquiry and return the setting
+// Set the results, and the overall codes from those of the puts
 //
  if (rc == 0)
    {
-    TRACE(traceid, ("Attr = %"PRId32", IntSelNum = %"PRId32", CharAttrLen = %"PRId32"\n",
-                    (int32_t)attrib,(int32_t)inqselicount,(int32_t)inqcharlen) );
-    MQINQ ( anchor->QMh , anchor->Qh[handle],
-            inqselcount , &attrib  ,
-            inqselicount, &inqints ,
-            inqcharlen  , inqchars ,
-            &mqrc, &mqac ) ;
-    rc   = mqrc ;
-    TRACE(traceid, ("INQ rc = %"PRId32", ac = %"PRId32", Intval = %"PRId32", Charval = %s\n",
-          (int32_t)mqrc,(int32_t)mqac,(int32_t)inqints,inqchars) ) ;
+    chain.count = 0                                             ;
+    for ( i = 0 ; i < count ; i++ )
+      {
+       task = &tasks[i]                                         ;
+       num_to_str(tail, (uint64_t)(i + 1), 0)                   ;
+       shv_flush(traceid, &chain, 3)                            ;
+       shv_set_long(&chain, RX_targets, tail, ".CC", task->mqrc) ;
+       shv_set_long(&chain, RX_targets, tail, ".RC", task->mqac) ;
+       shv_set_int64(&chain, RX_targets, tail, ".TIME", (MQINT64)task->took) ;
+       if ( task->mqrc != MQCC_FAILED )   put++                 ;
+       else if ( reason == 0 )            reason = task->mqac   ;
+       else if ( reason != task->mqac )   reason = MQRC_MULTIPLE_REASONS ;
+      }
+    shv_flush(traceid, &chain, 1)                               ;
+    shv_set_int64(&chain, RX_targets, "TIME", NULL, (MQINT64)(now_us() - start)) ;
+    shv_run(traceid, &chain)                                    ;
 
-    if ( (attrib >= MQCA_FIRST  ) && (attrib <= MQCA_LAST) )
-      stem_from_string(traceid, NULL, RX_value, "", inqchars, inqcharlen) ;
-    else
-      stem_from_long  (traceid, NULL, RX_value, "", inqints) ;
+    mqrc = MQCC_OK                                              ;
+    if ( put < count )
+      {
+       mqrc = ( put == 0 ) ? MQCC_FAILED : MQCC_WARNING         ;
+       mqac = reason                                            ;
+      }
+    rc = mqrc                                                   ;
    }
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
-return 0;
- } // End of RXMQINQ function
+ return 0;
+ } // End of RXMQFAN function
 
 //
-// Do a set      MQSET
+// Stem-free payload functions
 //
-//   Call:   rc = RXMQset(handle, attribute, atttrsetting )
+//   These take the message data directly as a REXX string, and give
+//   the received message data back as the function's return value,
+//   so saving the stem.0/stem.1 variable pool work and a copy of the
+//   payload per message. The outcome is in RXMQ.LASTRC, .LASTCC,
+//   .LASTAC and .LASTMSG as for every other function (a failed get
+//   returns a null string).
 //
-//           NB: only 1 attribute at a time!
+//   On MVS the data is returned in the EVALBLOCK provided by REXX,
+//   so the maximum length asked for is limited to its size.
 //
+
 //
-FTYPE  RXMQSET  RXMQPARM
+// Do a Put of string data   MQPUT
+//
+//   Call:   rc = RXMQputd(handle, data,
+//                         input_msgdesc, output_msgdesc,
+//                         input_pmo, output_pmo)
+//
+//           data is the message itself (which may be a null string)
+//
+FTYPE  RXMQPUTD  RXMQPARM
  {
 
- RXMQCB         * anchor = 0           ;  // RXMQ Control Block
- MQLONG           rc = 0               ;  // Function Return Code
- MQLONG           mqrc = 0             ;  // MQ RC
- MQLONG           mqac = 0             ;  // MQ AC
- MQULONG          traceid = SET        ;  // This function trace id
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
+ MQLONG                  rc   = 0         ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = PUT    ;  // This function trace id
 
- RXSTRING         RX_handle            ;  // Data     Obj Handle
- RXSTRING         RX_attr              ;  // Variable Input  Attr
- RXSTRING         RX_value             ;  // Variable Set    Attr
+ RXSTRING                RX_handle        ;  // Obj Handle
+ RXSTRING                RX_data          ;  // Message data
+ RXSTRING                RXi_md           ;  // Variable Input  Msg Desc
+ RXSTRING                RXo_md           ;  // Variable Output Msg Desc
+ RXSTRING                RXi_pmo          ;  // Variable Input  PMO
+ RXSTRING                RXo_pmo          ;  // Variable Output PMO
 
- MQLONG           handle       = 0     ;  //MQ object number
- MQLONG           attrib       = 0     ;  // object attribute
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+ MQULONG                 omask_pmo = ALLFIELDS;  // Output PMO fields wanted
 
- MQLONG           setselcount  = 1     ;  //SET - number of sels
- MQLONG           setselicount = 1     ;  //SET - number of int sels
- MQLONG           setints      = 0     ;  //SET - integer return
- MQLONG           setcharlen   = 600   ;  //SET - char return length
- char             setchars[601]        ;  //SET - char return
+ MQLONG                  handle           ;  //MQ object number
+ MQMD2                   md               ;  //MQ Message descriptor
+ MQPMO                   pmo              ;  //MQ Put Message options
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null handle"},
         {  -3, "Zero data handle"},
-        {  -4, "Null data attribute"},
-        {  -5, "Zero data attribute"},
-        {  -6, "Null setting"},
-        {  -7, "Zero length setting"},
-        {  -8, "No attribute supplied"},
-        {  -9, "Attribute out of valid range"},
-        { -10, "Handle out of range"},
-        { -11, "Invalid handle"},
+        {  -4, "Null data"},
+        {  -6, "Null input MsgDesc"},
+        {  -7, "Zero length input MsgDesc"},
+        {  -9, "Zero length output MsgDesc"},
+        { -10, "Null input PMO"},
+        { -11, "Zero length input PMO"},
+        { -13, "Zero length output PMO"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -19, "Context handle out of range"},
+        { -20, "Invalid Context handle"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
         { -98, "Not connected to a QM"},
         { -99, "UNKNOWN FAILURE"}} ;
 
@@ -3822,15 +12475,17 @@ FTYPE  RXMQSET  RXMQPARM
 //
 // Check the parms
 //
-
- if ( (rc == 0) && (aargc != 3 ) )             rc =  -1 ;
+ if ( (rc == 0) && (aargc != 6 ) )             rc =  -1 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[4]) )    rc = -10 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc = -11 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[5]) ) rc = -13 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
 
 //
 // Now the parms are correct, get them
@@ -3838,105 +12493,132 @@ FTYPE  RXMQSET  RXMQPARM
  if (rc == 0)
    {
     memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
-    memcpy(&RX_attr,  &aargv[1],sizeof(RX_attr))   ;
-    memcpy(&RX_value, &aargv[2],sizeof(RX_value))  ;
+    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))   ;
+    memcpy(&RXi_md,   &aargv[2],sizeof(RXi_md))    ;
+    memcpy(&RXo_md,   &aargv[3],sizeof(RXo_md))    ;
+    memcpy(&RXi_pmo,  &aargv[4],sizeof(RXi_pmo))   ;
+    memcpy(&RXo_pmo,  &aargv[5],sizeof(RXo_pmo))   ;
 
     TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
-    TRACE(traceid, ("RX_attr = %.*s\n",  (int)RX_attr.strlength,  RX_attr.strptr)   ) ;
-    TRACE(traceid, ("RX_value = %.*s\n", (int)RX_value.strlength, RX_value.strptr)  ) ;
-
-    parm_to_ulong(RX_handle, &handle) ;
-    parm_to_ulong(RX_attr,   &attrib) ;
+    TRACE(traceid, ("RX_data length = %u\n",(uint32_t)RX_data.strlength)           ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n",   (int)RXi_md.strlength,   RXi_md.strptr)    ) ;
+    TRACE(traceid, ("RXo_md = %.*s\n",   (int)RXo_md.strlength,   RXo_md.strptr)    ) ;
+    TRACE(traceid, ("RXi_pmo = %.*s\n",  (int)RXi_pmo.strlength,  RXi_pmo.strptr)   ) ;
+    TRACE(traceid, ("RXo_pmo = %.*s\n",  (int)RXo_pmo.strlength,  RXo_pmo.strptr)   ) ;
 
-    if (attrib == 0) rc = -8 ;
+    if ( !ISTMPL(RXi_md) )                                        make_md_from_stem(traceid,&md, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &md, &omask_md) ) rc = -97 ;
+    if ( !ISTMPL(RXi_pmo) )                                       make_po_from_stem(traceid,&pmo , RXi_pmo ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_PMO,RXi_pmo,&pmo, &omask_pmo) ) rc = -97 ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md,  &omask_md  ) ) rc = -96 ;
+    if ( (rc == 0) && out_mask(po_fields, &RXo_pmo, &omask_pmo ) ) rc = -96 ;
 
-    if ( !( ( (attrib >= MQIA_FIRST) && (attrib <= MQIA_LAST  ) )
-         || ( (attrib >= MQCA_FIRST) && (attrib <= MQCA_LAST  ) ) ) ) rc = -9;
+    parm_to_ulong(RX_handle, &handle)                ;
    }
 
 //
-// See if the handle is valid (ie: the gmqo to use)
+// See if the output queue handle is valid
 //
- if ( (rc == 0) && ( ( handle > MAXQS ) || ( handle <= 0 ) ) ) rc = -10 ;
- if ( (rc == 0) && ( anchor->Qh[handle] == 0 ) )               rc = -11 ;
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -14 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -15 ;
 
 //
+// If Context is specified (for MQPMO_PASS_ALL_CONTEXT)
+// see if the input queue handle is valid
 //
-// Format up either a character or an integer area
-//
- if (rc == 0)
+ if ( (rc == 0) && ( pmo.Context != 0 ) )
    {
-    memset(setchars,' ',sizeof(setchars))                     ;
-    if ( (attrib >= MQCA_FIRST  ) && (attrib <= MQCA_LAST  ) )
-      {
-       setselicount = 0                                       ;
-       memcpy(setchars,RX_value.strptr,RX_value.strlength)    ;
-
-      }      //End of Char Attr processing
-    else      //Int attr processing
-      {
-       setcharlen   = 0                                       ;
-       parm_to_ulong(RX_value,  &setints)                     ;
-      }      //End of Int Attr processing
-
-   } //End of Attribute building
+    if ( !OBJINRANGE(anchor,pmo.Context) )                 rc = -19 ;
+    if ( (rc == 0) && !OBJOPEN(anchor,pmo.Context) )       rc = -20 ;
+    if ( (rc == 0) && (OBJ(anchor,pmo.Context)->conn != OBJ(anchor,handle)->conn) ) rc = -20 ;
+    if   (rc == 0) pmo.Context = OBJ(anchor,pmo.Context)->Qh;
+    }
 
 //
-// Now do the Setting
+// Now put the data, straight from the argument, to the queue
 //
  if (rc == 0)
    {
-    TRACE(traceid, ("Attr = %"PRId32", IntSelNum = %"PRId32", IntSelVal = %"PRId32", CharAtrLen = %"PRId32", CharSetVal = %s\n",
-          (int32_t)attrib,(int32_t)setselicount,(int32_t)setints,(int32_t)setcharlen,setchars) ) ;
-    MQSET ( anchor->QMh , anchor->Qh[handle],
-            setselcount , &attrib   ,
-            setselicount, &setints  ,
-            setcharlen  , setchars  ,
-            &mqrc, &mqac ) ;
-    rc   = mqrc ;
-    TRACE(traceid, ("MQSET rc = %"PRId32", ac = %"PRId32"\n",(int32_t)mqrc,(int32_t)mqac) ) ;
+    TRACE(traceid, ("PUT Datalen = %u\n",(uint32_t)RX_data.strlength) ) ;
+    MQPUT ( OBJHCONN(anchor,handle), OBJ(anchor,handle)->Qh, &md, &pmo,
+            (MQLONG)RX_data.strlength, RX_data.strptr, &mqrc, &mqac ) ;
+    TRACE(traceid, ("PUT rc = %"PRId32", ac = %"PRId32"\n",(int32_t)mqrc, (int32_t)mqac) ) ;
+    PUT_ASYNC(&anchor->QM[OBJ(anchor,handle)->conn], pmo, mqrc) ;
+    uow_count(traceid, anchor, OBJ(anchor,handle)->conn, (pmo.Options & MQPMO_SYNCPOINT) != 0,
+              (MQLONG)RX_data.strlength, &mqrc, &mqac) ;
+    rc = mqrc ;
+
+    make_stem_from_md(traceid,&md,  RXo_md, omask_md)   ;   //Set the return Variables
+    make_stem_from_po(traceid,&pmo, RXo_pmo, omask_pmo) ;
    }
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
-return 0;
- } // End of RXMQSET function
+ return 0;
+ } // End of RXMQPUTD function
 
 //
-// Do a Subscribe MQSUB
+// Do a Get of string data   MQGET
 //
-//   Call:   rc = RXMQsub(isdesc,handle,osdesc)
+//   Call:   data = RXMQgetd(handle, maxlength,
+//                           input_msgdesc,output_msgdesc,
+//                           input_gmo,output_gmo)
 //
-FTYPE  RXMQSUB  RXMQPARM
+//           maxlength is the largest message wanted (0 to have
+//           the buffer sized as for RXMQget, or on z/OS to take as
+//           much as the return string holds), and the message (or a
+//           null string) is the function result
+//
+FTYPE  RXMQGETD  RXMQPARM
  {
 
  RXMQCB                * anchor = 0       ;  // RXMQ Control Block
- MQULONG                 i                ;  // Looper
  MQLONG                  rc = 0           ;  // Function Return Code
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
- MQULONG                 traceid = SUB    ;  // This function trace id
+ MQULONG                 traceid = GET    ;  // This function trace id
 
- RXSTRING                RX_handle        ;  //      Var Obj Handle
- RXSTRING                RXi_sd           ;  // Stem Var Sub Desc Input
- RXSTRING                RXo_sd           ;  // Stem Var Sub Desc Output
+ RXSTRING                RX_handle        ;  // Obj Handle
+ RXSTRING                RX_maxlen        ;  // Maximum data length
+ RXSTRING                RXi_md           ;  // Variable Input  Msg Desc
+ RXSTRING                RXo_md           ;  // Variable Output Msg Desc
+ RXSTRING                RXi_gmo          ;  // Variable Input  GMO
+ RXSTRING                RXo_gmo          ;  // Variable Output GMO
+ RXSTRING                RX_status        ;  // Return string for LASTMSG
+ char                    status[256]      ;  //   and its buffer
 
- MQSD                    sd               ;  // MQ subscription desc
- int                     theobj     = -1  ;  // gmqo object to use
- MQHOBJ                  sh               ;  // Subscription handle
+ MQULONG                 omask_md = ALLFIELDS ;  // Output MD fields wanted
+ MQULONG                 omask_gmo = ALLFIELDS;  // Output GMO fields wanted
+
+ MQLONG                  handle    = 0    ;  // MQ object number
+ MQMD2                   md               ;  // MQ Message descriptor
+ MQGMO                   gmo              ;  // MQ Get Message options
+ char                 *  data      = 0    ;  //-> Data buffer
+ char                 *  buf       = 0    ;  //-> Adaptive size buffer
+ MQLONG                  data0     = 0    ;  //   Data length max
+ MQLONG                  datalen   = 0    ;  //   Data length actual
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
-        {  -2, "Null input SD"},
-        {  -3, "Zero length input SD"},
-        {  -6, "Null handle name"},
-        {  -7, "Zero length handle name"},
-        {  -8, "Null Output SD"},
-        {  -9, "Zero length Output SD"},
-        { -10, "No available objects"},
+        {  -2, "Null handle"},
+        {  -3, "Zero data handle"},
+        {  -4, "Null maximum length"},
+        {  -5, "Zero length maximum length"},
+        {  -6, "Null input MsgDesc"},
+        {  -7, "Zero length input MsgDesc"},
+        {  -9, "Zero length output MsgDesc"},
+        { -10, "Null input GMO"},
+        { -11, "Zero length input GMO"},
+        { -13, "Zero length output GMO"},
+        { -14, "Handle out of range"},
+        { -15, "Invalid handle"},
+        { -16, "malloc failure, check reason code"},
+        { -17, "Bad maximum length"},
+        { -96, "Bad output field list"},
+        { -97, "Bad RXMQDEF template token"},
         { -98, "Not connected to a QM"},
         { -99, "UNKNOWN FAILURE"}} ;
 
@@ -3945,88 +12627,173 @@ FTYPE  RXMQSUB  RXMQPARM
 //
 // Check the parms
 //
- if ( (rc == 0) && (aargc != 3 ) )             rc =  -1 ;
+ if ( (rc == 0) && (aargc != 6 ) )             rc =  -1 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc =  -2 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -6 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -7 ;
- if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -8 ;
- if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -9 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[2]) )    rc =  -6 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) ) rc =  -7 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[3]) ) rc =  -9 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[4]) )    rc = -10 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[4]) ) rc = -11 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[5]) ) rc = -13 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
 
 //
 // Now the parms are correct, get them
 //
  if (rc == 0)
-    {
-      memcpy(&RXi_sd ,   &aargv[0],sizeof(RXi_sd))    ;
-      memcpy(&RX_handle ,&aargv[1],sizeof(RX_handle)) ;
-      memcpy(&RXo_sd ,   &aargv[2],sizeof(RXo_sd))    ;
+   {
+    memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
+    memcpy(&RX_maxlen,&aargv[1],sizeof(RX_maxlen)) ;
+    memcpy(&RXi_md,   &aargv[2],sizeof(RXi_md))    ;
+    memcpy(&RXo_md,   &aargv[3],sizeof(RXo_md))    ;
+    memcpy(&RXi_gmo,  &aargv[4],sizeof(RXi_gmo))   ;
+    memcpy(&RXo_gmo,  &aargv[5],sizeof(RXo_gmo))   ;
 
-      TRACE(traceid, ("RXi_sd = %.*s\n",   (int)RXi_sd.strlength,   RXi_sd.strptr)    )  ;
-      TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) )  ;
-      TRACE(traceid, ("RXo_sd = %.*s\n",   (int)RXo_sd.strlength,   RXo_sd.strptr)    )  ;
+    TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
+    TRACE(traceid, ("RX_maxlen = %.*s\n",(int)RX_maxlen.strlength,RX_maxlen.strptr) ) ;
+    TRACE(traceid, ("RXi_md = %.*s\n",   (int)RXi_md.strlength,   RXi_md.strptr)    ) ;
+    TRACE(traceid, ("RXo_md = %.*s\n",   (int)RXo_md.strlength,   RXo_md.strptr)    ) ;
+    TRACE(traceid, ("RXi_gmo = %.*s\n",  (int)RXi_gmo.strlength,  RXi_gmo.strptr)   ) ;
+    TRACE(traceid, ("RXo_gmo = %.*s\n",  (int)RXo_gmo.strlength,  RXo_gmo.strptr)   ) ;
 
-      make_sd_from_stem(traceid,&sd,RXi_sd)           ;
-    }
+    if ( !ISTMPL(RXi_md) )                                        make_md_from_stem(traceid,&md, RXi_md ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_MD, RXi_md, &md, &omask_md) ) rc = -97 ;
+    if ( !ISTMPL(RXi_gmo) )                                       make_go_from_stem(traceid,&gmo , RXi_gmo ) ;
+    else if ( tmpl_to_cb(traceid,anchor,TMPL_GMO,RXi_gmo,&gmo, &omask_gmo) ) rc = -97 ;
+    if ( (rc == 0) && out_mask(md_fields, &RXo_md,  &omask_md  ) ) rc = -96 ;
+    if ( (rc == 0) && out_mask(go_fields, &RXo_gmo, &omask_gmo ) ) rc = -96 ;
+    parm_to_ulong(RX_handle, &handle)            ;
+    parm_to_ulong(RX_maxlen, &data0)             ;
+   }
+
+ if ( (rc == 0) && ( data0 < 0 ) ) rc = -17 ;
 
 //
-// Select the handle
+// See if the handle is valid
 //
- if (rc == 0)
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -14 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -15 ;
+
+//
+// Receive straight into the return string when it is big enough,
+// else into REXX storage that then becomes the return string
+//
+#ifdef __MVS__
+ if ( (rc == 0) && (data0 == 0) ) data0 = aretstr->strlength ;     // No adaptive sizing
+#endif
+ if ( (rc == 0) && (data0 != 0) )
    {
-    for ( i=MINQS ; i <= MAXQS ; i++ )
+#ifdef __MVS__
+    if ( data0 > (MQLONG)aretstr->strlength ) data0 = aretstr->strlength ;
+#endif
+    if ( data0 <= (MQLONG)aretstr->strlength ) data = aretstr->strptr    ;
+#ifndef __MVS__
+    else
       {
-       if ( anchor->Qh[i] == 0 )
+       TRACE(traceid, ("Doing RexxAllocateMemory for %"PRId32" bytes\n",(int32_t)data0) ) ;
+       data = (char *)RexxAllocateMemory(data0)                            ;
+       if ( data == NULL )
          {
-          theobj = i ;
-          TRACE(traceid, ("Selected Object [%d]\n",theobj) ) ;
-          break      ;
+          mqac = errno                                                     ;
+          TRACE(traceid, ("RexxAllocateMemory rc = %"PRId32"\n",(int32_t)mqac) ) ;
+          rc = -16                                                         ;
          }
       }
-    if ( (theobj == -1) ) rc = -10;
+#endif
    }
 
 //
-// Do the MQSUB on the obtained Subscription object
+// Now get the data from the queue
 //
- if (rc == 0)
+ if ( (rc == 0) && (data0 != 0) )
    {
-    TRACE(traceid, ("Calling MQSUB\n") )                               ;
-    MQSUB ( anchor->QMh, &sd, &anchor->Qh[theobj], &sh, &mqrc, &mqac ) ;
-    rc   = mqrc                                                        ;
+    TRACE(traceid, ("GET Maxdatalen = %"PRId32"\n",(int32_t)data0) )                          ;
+    MQGET ( OBJHCONN(anchor,handle), OBJ(anchor,handle)->Qh, &md, &gmo, data0, data, &datalen, &mqrc, &mqac ) ;
+    TRACE(traceid, ("GET rc = %"PRId32", ac = %"PRId32", datalen = %"PRId32"\n",
+          (int32_t)mqrc,(int32_t)mqac,(int32_t)datalen) )                                     ;
+    uow_count(traceid, anchor, OBJ(anchor,handle)->conn, GMO_IN_UOW(gmo,md), datalen, &mqrc, &mqac) ;
+    rc = mqrc                                                                                 ;
 
-    if ( anchor->Qh[theobj] != 0 )   //If the Subscribe worked,
-      {                              //then .....
-       stem_from_long(traceid, NULL, RX_handle, ""  , theobj) ;
-       make_stem_from_sd(traceid,&sd,RXo_sd)                  ; //and update the SD
-      }
+    make_stem_from_md(traceid,&md,  RXo_md, omask_md) ;  //Set the return Variables
+    make_stem_from_go(traceid,&gmo, RXo_gmo, omask_gmo) ;
    }
 
 //
-// Set the LAST variables, and the function return string
+// or, with no maximum length, into a buffer sized by get_msg and
+// then copied to the return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
-
-return 0;
- } // End of RXMQSUB function
+#ifndef __MVS__
+ if ( (rc == 0) && (data0 == 0) )
+   {
+    buf = (char *) get_msg(traceid, anchor, OBJ(anchor,handle), &md, &gmo, &data0, &datalen, &mqrc, &mqac) ;
+    if ( buf != NULL )
+       uow_count(traceid, anchor, OBJ(anchor,handle)->conn, GMO_IN_UOW(gmo,md), datalen, &mqrc, &mqac) ;
+    rc  = ( buf == NULL ) ? -16 : mqrc                                     ;
+    if ( (buf != NULL) && (mqrc != MQCC_FAILED) )
+      {
+       if ( datalen > data0 ) datalen = data0                              ;
+       if ( datalen <= (MQLONG)aretstr->strlength ) data = aretstr->strptr ;
+       else
+         {
+          TRACE(traceid, ("Doing RexxAllocateMemory for %"PRId32" bytes\n",(int32_t)datalen) ) ;
+          data = (char *)RexxAllocateMemory(datalen)                       ;
+          if ( data == NULL )
+            {
+             mqac = errno                                                  ;
+             rc   = -16                                                    ;
+            }
+         }
+       if ( data != NULL ) memcpy(data, buf, datalen)                      ;
+      }
+    if ( buf != NULL )
+      {
+       make_stem_from_md(traceid,&md,  RXo_md, omask_md) ;
+       make_stem_from_go(traceid,&gmo, RXo_gmo, omask_gmo) ;
+      }
+   }
+#endif
 
 //
-// Extension functions
+// Set the LAST variables; the status string only goes to LASTMSG, so
+// they are still set under RET_NUM (there being no other status)
 //
+ MAKERXSTRING(RX_status, status, sizeof(status))                    ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,&RX_status,
+            (RETMODE(anchor) == RET_NUM) ? RET_NEW : RETMODE(anchor),
+            traceid,"") ;
 
 //
-// Do a Browse
+// and return the message data (if any) as the function result
 //
-//   Call:   rc = RXMQbrws(handle, data)
+ if ( (rc >= 0) && (rc != MQCC_FAILED) )
+   {
+    if (datalen > data0) datalen = data0 ;
+    aretstr->strptr    = data            ;
+    aretstr->strlength = datalen         ;
+   }
+ else
+   {
+#ifndef __MVS__
+    if ( (data != 0) && (data != aretstr->strptr) ) RexxFreeMemory(data) ;
+#endif
+    aretstr->strlength = 0 ;
+   }
+
+ return 0;
+ } // End of RXMQGETD function
+
 //
-//           This function issues a browse on the Queue, and
-//                returns the next message (if available). If you
-//                need the Message descriptor as well, then use the
-//                native Get interface.
+// Do a Browse of string data
 //
+//   Call:   data = RXMQbrwd(handle, maxlength)
 //
-FTYPE  RXMQBRWS  RXMQPARM
+//           As RXMQbrws, but the next message (or a null string) is
+//           the function result
+//
+FTYPE  RXMQBRWD  RXMQPARM
  {
 
  RXMQCB                * anchor = 0       ;  // RXMQ Control Block
@@ -4036,26 +12803,28 @@ FTYPE  RXMQBRWS  RXMQPARM
  MQULONG                 traceid = BRO    ;  // This function trace id
 
  RXSTRING                RX_handle        ;  // Data     Obj Handle
- RXSTRING                RX_data          ;  // Variable Data
+ RXSTRING                RX_maxlen        ;  // Maximum data length
+ RXSTRING                RX_status        ;  // Return string for LASTMSG
+ char                    status[256]      ;  //   and its buffer
 
  MQMD2                   md               ;  // Browse MD
- MQGMO                   gmo              ;  // Browase GMO
+ MQGMO                   gmo              ;  // Browse GMO
 
  MQLONG                  handle    = 0    ;  //MQ object number
- void                 *  data      = 0    ;  //-> Data buffer
+ char                 *  data      = 0    ;  //-> Data buffer
  MQLONG                  data0     = 0    ;  //   Data length max
  MQLONG                  datalen   = 0    ;  //   Data length actual
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null handle"},
         {  -3, "Zero data handle"},
-        {  -4, "Null data stem var"},
-        {  -5, "Zero data stem var"},
+        {  -4, "Null maximum length"},
+        {  -5, "Zero length maximum length"},
         {  -6, "Handle out of range"},
         {  -7, "Invalid handle"},
         {  -8, "malloc failure, check reason code"},
-        {  -9, "Zero length input data buffer"},
+        {  -9, "Bad maximum length"},
         { -98, "Not connected to a QM"},
         { -99, "UNKNOWN FAILURE"}} ;
 
@@ -4069,7 +12838,7 @@ FTYPE  RXMQBRWS  RXMQPARM
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && anchor->Conns == 0 )      rc = -98 ;
 
 //
 // Now the parms are correct, get them
@@ -4077,40 +12846,46 @@ FTYPE  RXMQBRWS  RXMQPARM
  if (rc == 0)
    {
     memcpy(&RX_handle,&aargv[0],sizeof(RX_handle)) ;
-    memcpy(&RX_data,  &aargv[1],sizeof(RX_data))   ;
+    memcpy(&RX_maxlen,&aargv[1],sizeof(RX_maxlen)) ;
 
     TRACE(traceid, ("RX_handle = %.*s\n",(int)RX_handle.strlength,RX_handle.strptr) ) ;
-    TRACE(traceid, ("RX_data   = %.*s\n",(int)RX_data.strlength,  RX_data.strptr)   ) ;
+    TRACE(traceid, ("RX_maxlen = %.*s\n",(int)RX_maxlen.strlength,RX_maxlen.strptr) ) ;
 
     parm_to_ulong(RX_handle, &handle)            ;
-    stem_to_long(traceid, RX_data, "0" , &data0) ;
+    parm_to_ulong(RX_maxlen, &data0)             ;
    }
 
-//
-// Now check the input Stem variable to see that there is
-//     some valid data to obtain
-//
  if ( (rc == 0) && ( data0 <= 0 ) ) rc = -9 ;
 
 //
 // See if the handle is valid
 //
- if ( (rc == 0) && ( ( handle > MAXQS ) || ( handle <= 0 ) ) ) rc = -6 ;
- if ( (rc == 0) && ( anchor->Qh[handle] == 0 ) )               rc = -7 ;
+ if ( (rc == 0) && !OBJINRANGE(anchor,handle) ) rc = -6 ;
+ if ( (rc == 0) && !OBJOPEN(anchor,handle) )    rc = -7 ;
 
 //
-// Now GETMAIN the buffer to receive the data records
+// Receive straight into the return string when it is big enough,
+// else into REXX storage that then becomes the return string
 //
- if (( rc == 0) && ( data0 != 0 ) )
+ if ( rc == 0 )
    {
-    TRACE(traceid, ("Doing malloc for %"PRId32" bytes\n",(int32_t)data0) ) ;
-    data = malloc(data0)                                                   ;
-    if ( data == NULL )
+#ifdef __MVS__
+    if ( data0 > (MQLONG)aretstr->strlength ) data0 = aretstr->strlength ;
+#endif
+    if ( data0 <= (MQLONG)aretstr->strlength ) data = aretstr->strptr    ;
+#ifndef __MVS__
+    else
       {
-       mqac = errno                                                        ;
-       TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)mqac) )          ;
-       rc = -8                                                             ;
+       TRACE(traceid, ("Doing RexxAllocateMemory for %"PRId32" bytes\n",(int32_t)data0) ) ;
+       data = (char *)RexxAllocateMemory(data0)                            ;
+       if ( data == NULL )
+         {
+          mqac = errno                                                     ;
+          TRACE(traceid, ("RexxAllocateMemory rc = %"PRId32"\n",(int32_t)mqac) ) ;
+          rc = -8                                                          ;
+         }
       }
+#endif
    }
 
 //
@@ -4125,32 +12900,40 @@ FTYPE  RXMQBRWS  RXMQPARM
                        + MQGMO_ACCEPT_TRUNCATED_MSG
                        + MQGMO_FAIL_IF_QUIESCING               ;
     gmo.WaitInterval   = MQWI_UNLIMITED                        ;
-    MQGET ( anchor->QMh, anchor->Qh[handle], &md, &gmo, data0, data, &datalen, &mqrc, &mqac ) ;
+    MQGET ( OBJHCONN(anchor,handle), OBJ(anchor,handle)->Qh, &md, &gmo, data0, data, &datalen, &mqrc, &mqac ) ;
     rc   = mqrc ;
     TRACE(traceid, ("MQGET rc = %"PRId32", ac = %"PRId32", Datalen = %"PRId32"\n",
                     (int32_t)mqrc,(int32_t)mqac,(int32_t)datalen) ) ;
-
-    stem_from_long  (traceid, NULL, RX_data, "0" , datalen)                 ;
-    if (datalen > data0) datalen = data0                                    ;
-    stem_from_bytes (traceid, NULL, RX_data, "1" , (MQBYTE *)data, datalen) ;
    }
 
 //
-// Free data buffer for stem.1 variable data, if allocated.
+// Set the LAST variables; the status string only goes to LASTMSG, so
+// they are still set under RET_NUM (there being no other status)
 //
-  if ( data != 0 )
-    {
-     TRACE(traceid, ("Free area\n") ) ;
-     free(data) ;
-    }
+ MAKERXSTRING(RX_status, status, sizeof(status))                    ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,&RX_status,
+            (RETMODE(anchor) == RET_NUM) ? RET_NEW : RETMODE(anchor),
+            traceid,"") ;
 
 //
-// Set the LAST variables, and the function return string
+// and return the message data (if any) as the function result
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ if ( (rc >= 0) && (rc != MQCC_FAILED) )
+   {
+    if (datalen > data0) datalen = data0 ;
+    aretstr->strptr    = data            ;
+    aretstr->strlength = datalen         ;
+   }
+ else
+   {
+#ifndef __MVS__
+    if ( (data != 0) && (data != aretstr->strptr) ) RexxFreeMemory(data) ;
+#endif
+    aretstr->strlength = 0 ;
+   }
 
-return 0;
- } // End of RXMQBRWS function
+ return 0;
+ } // End of RXMQBRWD function
 
 //
 // Do a Header extract  MQHXT
@@ -4238,7 +13021,7 @@ FTYPE  RXMQHXT  RXMQPARM
  char                    zlist[200]       ;  // Char version of .ZLIST
 
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null input stem var"},
         {  -3, "Zero input stem var"},
@@ -4287,8 +13070,8 @@ FTYPE  RXMQHXT  RXMQPARM
 //
  if ( rc == 0 )
    {
-    TRACE(traceid, ("Doing malloc for %"PRId32" bytes\n",(int32_t)data0) ) ;
-    data = malloc(data0)                                                   ;
+    TRACE(traceid, ("Getting buffer for %"PRId32" bytes\n",(int32_t)data0) ) ;
+    data = buf_get(anchor, BUF_DATA, data0)                                ;
     if ( data == NULL )
       {
        mqac = errno                                               ;
@@ -4419,19 +13202,10 @@ FTYPE  RXMQHXT  RXMQPARM
       }
    }
 
-//
-// Free data buffer for stem.1 variable data, if allocated.
-//
- if ( data != 0 )
-   {
-    TRACE(traceid, ("Free area\n") ) ;
-    free(data) ;
-   }
-
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
 return 0;
  } // End of RXMQHXT function
@@ -4505,6 +13279,7 @@ FTYPE  RXMQEVNT  RXMQPARM
 
  char                    comp[62]         ;  //Component name
  char                 *  zvars = 0        ;  //List of components
+ char                 *  znew  = 0        ;  //  and a bigger one
  MQULONG                 zvarlen = 4096U  ;  //Current length of list
 
  RXSTRING                varname          ;  // REXX string of varnamc
@@ -4512,7 +13287,7 @@ FTYPE  RXMQEVNT  RXMQPARM
  char                    varnamc[100]     ;  // Char version of variable name
  char                    varvalc[100]     ;  // Char version of variable value
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null input stem var"},
         {  -3, "Zero input stem var"},
@@ -4562,8 +13337,8 @@ FTYPE  RXMQEVNT  RXMQPARM
 //
  if ( rc == 0 )
    {
-    TRACE(traceid, ("Doing malloc for %"PRId32" bytes\n",(int32_t)data0) ) ;
-    data = (char *) malloc(data0)                                          ;
+    TRACE(traceid, ("Getting buffer for %"PRId32" bytes\n",(int32_t)data0) ) ;
+    data = (char *) buf_get(anchor, BUF_DATA, data0)                       ;
     if ( data == NULL )
       {
        mqac = errno                                               ;
@@ -4663,8 +13438,8 @@ if ( rc == 0 )
 //
  if ( rc == 0 )
    {
-    TRACE(traceid, ("Doing malloc for zvars %"PRId32" bytes\n",(int32_t)zvarlen) ) ;
-    zvars = (char *) malloc(zvarlen)                                               ;
+    TRACE(traceid, ("Getting zvars of %"PRId32" bytes\n",(int32_t)zvarlen) )       ;
+    zvars = (char *) arena_get(anchor, zvarlen)                                    ;
     if ( zvars == NULL )
       {
       mqac = errno                                           ;
@@ -4705,15 +13480,17 @@ if ( rc == 0 )
        if ( ( strlen(zvars) + RX_output.strlength + sizeof(comp) ) > zvarlen )
          {                           // If zvars is potentially too small
           zvarlen = 2 * zvarlen                                                           ;
-          TRACE(traceid, ("Doing realloc for zvars %"PRId32" bytes\n",(int32_t)zvarlen) ) ;
-          zvars = (char *) realloc(zvars, zvarlen)                                        ;
-          if ( zvars == NULL )
+          TRACE(traceid, ("Growing zvars to %"PRId32" bytes\n",(int32_t)zvarlen) )        ;
+          znew = (char *) arena_get(anchor, zvarlen)                                      ;
+          if ( znew == NULL )
             {
              mqac = errno ;
              TRACE(traceid, ("malloc rc = %"PRId32"\n",(int32_t)mqac) ) ;
              rc = -15     ;
              break        ;
             }
+          strcpy(znew, zvars) ;          // The old list stays in the arena
+          zvars = znew        ;
          }
        grpparms = 0 ;                    // Force pseudo group for 1 shot
        comp[0]  = 0 ;                    // Clear component name
@@ -4816,28 +13593,10 @@ if ( rc == 0 )
     TRACE(traceid, ("All Event fields extracted\n") ) ;
    } // End of Event Processing Block
 
-//
-// Free ZLIST buffer, if allocated.
-//
- if ( zvars != 0 )
-   {
-    TRACE(traceid, ("Free zlist\n") ) ;
-    free(zvars) ;
-   }
-
-//
-// Free data buffer for stem.1 variable data, if allocated.
-//
- if ( data != 0 )
-   {
-    TRACE(traceid, ("Free area\n") )  ;
-    free(data) ;
-   }
-
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
 return 0;
  } // End of RXMQEVNT function
@@ -4904,7 +13663,7 @@ FTYPE  RXMQTM  RXMQPARM
 
  char                    zlist[200]       ;  // Char version of .ZLIST
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null input stem var"},
         {  -3, "Zero input stem var"},
@@ -4942,7 +13701,7 @@ FTYPE  RXMQTM  RXMQPARM
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc =  -3 ;
  if ( (rc == 0) && RXNULLSTRING(aargv[1]) )    rc =  -4 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) ) rc =  -5 ;
- if ( (rc == 0) && ( anchor->QMh == 0 ) )      rc = -98 ;
+ if ( (rc == 0) && ( anchor->QM[0].QMh == 0 ) )      rc = -98 ;
 
 //
 // The input parms are OK, so obtain them, and obtain the resolutions
@@ -4964,8 +13723,8 @@ FTYPE  RXMQTM  RXMQPARM
 //
        if (( data0 > 0 ) )
          {
-          TRACE(traceid, ("Doing malloc for %"PRId32" bytes\n",(int32_t)data0) ) ;
-          data = malloc(data0)                                                   ;
+          TRACE(traceid, ("Getting buffer for %"PRId32" bytes\n",(int32_t)data0) ) ;
+          data = buf_get(anchor, BUF_DATA, data0)                                ;
           if ( data == NULL )
             {
              mqac = errno                                                        ;
@@ -5055,7 +13814,7 @@ FTYPE  RXMQTM  RXMQPARM
 if ( ( rc == 0 ) && ( action == 1 ) )
   {
    TRACE(traceid, ("Unravelling a TM message\n")       ) ;
-   TRACE(traceid, ("QM name is /%s/\n",anchor->QMname) ) ;
+   TRACE(traceid, ("QM name is /%s/\n",anchor->QM[0].QMname) ) ;
    TRACE(traceid, ("Now starting the unpacking\n")     ) ;
    thetm = (MQTM *) data; // Set Header pointer
 
@@ -5069,62 +13828,657 @@ if ( ( rc == 0 ) && ( action == 1 ) )
    memcpy(&newtm2.ApplId,      thetm->ApplId,      sizeof(MQCHAR256)) ;
    memcpy(&newtm2.EnvData,     thetm->EnvData,     sizeof(MQCHAR128)) ;
    memcpy(&newtm2.UserData,    thetm->UserData,    sizeof(MQCHAR128)) ;
-   memcpy(&newtm2.QMgrName,    anchor->QMname,     sizeof(MQCHAR48) ) ;
+   memcpy(&newtm2.QMgrName,    anchor->QM[0].QMname,     sizeof(MQCHAR48) ) ;
 
                          //Build the components
 
-   stem_from_string(traceid, zlist, RX_output, "QN"  , thetm->QName,                sizeof(MQCHAR48)) ;
-   stem_from_string(traceid, zlist, RX_output, "PN"  , thetm->ProcessName,          sizeof(MQCHAR48)) ;
-   stem_from_string(traceid, zlist, RX_output, "TD"  , thetm->TriggerData,          sizeof(MQCHAR64)) ;
-   stem_from_long  (traceid, zlist, RX_output, "AT"  , thetm->ApplType)                               ;
-   stem_from_string(traceid, zlist, RX_output, "AID" , thetm->ApplId,              sizeof(MQCHAR256)) ;
-   stem_from_string(traceid, zlist, RX_output, "ED"  , thetm->EnvData,             sizeof(MQCHAR128)) ;
-   stem_from_string(traceid, zlist, RX_output, "UD"  , thetm->UserData,            sizeof(MQCHAR128)) ;
-   stem_from_string(traceid, zlist, RX_output, "ZLIST", zlist, strlen(zlist))                         ;
-   stem_from_string(traceid, zlist, RX_output, "PL"  , (MQCHAR *)&newtm2,sizeof(MQTMC2))              ;
+   stem_from_string(traceid, zlist, RX_output, "QN"  , thetm->QName,                sizeof(MQCHAR48)) ;
+   stem_from_string(traceid, zlist, RX_output, "PN"  , thetm->ProcessName,          sizeof(MQCHAR48)) ;
+   stem_from_string(traceid, zlist, RX_output, "TD"  , thetm->TriggerData,          sizeof(MQCHAR64)) ;
+   stem_from_long  (traceid, zlist, RX_output, "AT"  , thetm->ApplType)                               ;
+   stem_from_string(traceid, zlist, RX_output, "AID" , thetm->ApplId,              sizeof(MQCHAR256)) ;
+   stem_from_string(traceid, zlist, RX_output, "ED"  , thetm->EnvData,             sizeof(MQCHAR128)) ;
+   stem_from_string(traceid, zlist, RX_output, "UD"  , thetm->UserData,            sizeof(MQCHAR128)) ;
+   stem_from_string(traceid, zlist, RX_output, "ZLIST", zlist, strlen(zlist))                         ;
+   stem_from_string(traceid, zlist, RX_output, "PL"  , (MQCHAR *)&newtm2,sizeof(MQTMC2))              ;
+
+   TRACE(traceid, ("Unravelled the TM\n") ) ;
+  }
+
+//
+// Now we have got valid Trigger Data, split it up
+//
+if ( ( rc == 0 ) && ( action == 2 ) )
+  {
+   TRACE(traceid, ("Unravelling Trigger Data\n") ) ;
+
+   thetm2 = (MQTMC2 *)oldtm2.strptr   ; // Set Header pointer
+
+//Build the components
+
+   stem_from_string(traceid, zlist, RX_output, "QN"  , thetm2->QName,          sizeof(MQCHAR48)) ;
+   stem_from_string(traceid, zlist, RX_output, "PN"  , (char*)thetm2->ProcessName, sizeof(MQCHAR48)) ;
+   stem_from_string(traceid, zlist, RX_output, "TD"  , thetm2->TriggerData,          sizeof(MQCHAR64)) ;
+   stem_from_string(traceid, zlist, RX_output, "AID" , thetm2->ApplId,              sizeof(MQCHAR256)) ;
+   stem_from_string(traceid, zlist, RX_output, "ED"  , thetm2->EnvData,             sizeof(MQCHAR128)) ;
+   stem_from_string(traceid, zlist, RX_output, "UD"  , thetm2->UserData,            sizeof(MQCHAR128)) ;
+   stem_from_string(traceid, zlist, RX_output, "QM"  , thetm2->QMgrName,             sizeof(MQCHAR48)) ;
+   stem_from_string(traceid, zlist, RX_output, "ZLIST", zlist, strlen(zlist))                         ;
+
+   TRACE(traceid, ("Unravelled the Trigger Data\n") ) ;
+  }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQTM function
+
+//
+// Compile a descriptor template  RXMQDEF
+//
+//   Call:   rc = RXMQdef(type, input_stem, token [, output_fields])
+//        or
+//           rc = RXMQdef('DROP', token)
+//
+//      type is one of OD, MD, PMO, GMO or SD. The stem is read as for
+//      the input descriptor of the RXMQ function concerned, and the
+//      variable token is set to '&n' to be used in its place.
+//      output_fields lists the mnemonics (and ZLIST) to be set in the
+//      output stem, when the call does not give its own list.
+//
+FTYPE  RXMQDEF  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ int                     i                ;  // Looper
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = DEF    ;  // This function trace id
+
+ RXSTRING                RX_type          ;  // Template type
+ char                    typec[5]         ;  // Uppercased type
+ RXSTRING                RXi_stem         ;  // Stem Var Input
+ RXSTRING                RX_token         ;  //      Var Token
+ char                    token[12]        ;  // Char version of token
+
+ MQLONG                  type   = 0       ;  // TMPL_xx
+ int                     theslot = -1     ;  // Template slot to use
+ void                  * cb     = 0       ;  // Compiled structure
+ MQULONG                 outmask = ALLFIELDS ; // Output fields wanted
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null template type"},
+        {  -3, "Zero length template type"},
+        {  -4, "Unknown template type"},
+        {  -5, "Null input stem"},
+        {  -6, "Zero length input stem"},
+        {  -7, "Null token name"},
+        {  -8, "Zero length token name"},
+        {  -9, "No available template slots"},
+        { -10, "Bad template token"},
+        { -11, "Unable to obtain template storage"},
+        { -12, "Bad output field list"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ((aargc < 2) || (aargc > 4)) )  rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )        rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) )     rc =  -3 ;
+
+ if (rc == 0)
+   {
+    memcpy(&RX_type, &aargv[0], sizeof(RX_type)) ;
+    TRACE(traceid, ("RX_type = %.*s\n",(int)RX_type.strlength,RX_type.strptr) ) ;
+
+    memset(typec, 0, sizeof(typec)) ;
+    for ( i = 0 ; (i < (int)RX_type.strlength) && (i < (int)sizeof(typec)-1) ; i++ )
+       typec[i] = toupper((unsigned char)RX_type.strptr[i]) ;
+
+    for ( i = 1 ; tmpltypes[i].name[0] != '?' ; i++ )
+       if ( !strcmp(tmpltypes[i].name, typec) ) type = i ;
+
+    if ( RX_type.strlength >= sizeof(typec) ) type = 0 ;
+    if ( (type == 0) && strcmp(typec, "DROP") )  rc = -4 ;
+    if ( RX_type.strlength >= sizeof(typec) )    rc = -4 ;
+   }
+
+ if ( (rc == 0) && (type == 0) && (aargc != 2) )   rc =  -1 ;
+ if ( (rc == 0) && (type != 0) && (aargc <  3) )   rc =  -1 ;
+
+//
+// DROP a template
+//
+ if ( (rc == 0) && (type == 0) )
+   {
+    memcpy(&RX_token, &aargv[1], sizeof(RX_token)) ;
+    TRACE(traceid, ("RX_token = %.*s\n",(int)RX_token.strlength,RX_token.strptr) ) ;
+
+    if ( ISTMPL(RX_token) )
+      {
+       theslot = 0 ;
+       for ( i = 1 ; (i < (int)RX_token.strlength) && isdigit((unsigned char)RX_token.strptr[i]) ; i++ )
+          theslot = theslot * 10 + (RX_token.strptr[i] - '0') ;
+       if ( (i == 1) || (i != (int)RX_token.strlength) ) theslot = -1 ;
+      }
+
+    if (    (theslot < 0) || (theslot >= MAXTMPL)
+         || (anchor->Tmpl[theslot].type == 0) ) rc = -10 ;
+    else
+      {
+       TRACE(traceid, ("Dropping template %d\n",theslot) ) ;
+       tmpl_free(anchor, theslot) ;
+      }
+   }
+
+//
+// Compile a template
+//
+ if ( (rc == 0) && (type != 0) )
+   {
+    if ( (rc == 0) && RXNULLSTRING(aargv[1]) )     rc =  -5 ;
+    if ( (rc == 0) && RXZEROLENSTRING(aargv[1]) )  rc =  -6 ;
+    if ( (rc == 0) && RXNULLSTRING(aargv[2]) )     rc =  -7 ;
+    if ( (rc == 0) && RXZEROLENSTRING(aargv[2]) )  rc =  -8 ;
+   }
+
+ if ( (rc == 0) && (type != 0) )
+   {
+    memcpy(&RXi_stem, &aargv[1], sizeof(RXi_stem)) ;
+    memcpy(&RX_token, &aargv[2], sizeof(RX_token)) ;
+    TRACE(traceid, ("RXi_stem = %.*s\n",(int)RXi_stem.strlength,RXi_stem.strptr) ) ;
+    TRACE(traceid, ("RX_token = %.*s\n",(int)RX_token.strlength,RX_token.strptr) ) ;
+
+    for ( i = 0 ; i < MAXTMPL ; i++ )
+      {
+       if ( anchor->Tmpl[i].type == 0 )
+         {
+          theslot = i ;
+          TRACE(traceid, ("Selected template slot [%d]\n",theslot) ) ;
+          break       ;
+         }
+      }
+    if ( theslot == -1 ) rc = -9 ;
+
+    if ( (rc == 0) && (aargc == 4) && RXVALIDSTRING(aargv[3]) )
+      {
+       TRACE(traceid, ("Output fields = %.*s\n",(int)aargv[3].strlength,aargv[3].strptr) ) ;
+       if ( fields_to_mask(tmpltypes[type].fields, aargv[3].strptr,
+                           aargv[3].strlength, &outmask) ) rc = -12 ;
+      }
+   }
+
+ if ( (rc == 0) && (type != 0) )
+   {
+    TRACE(traceid, ("Doing malloc for %u bytes\n",(uint32_t)tmpltypes[type].size)) ;
+    cb = malloc(tmpltypes[type].size) ;
+    if ( cb == NULL )
+      {
+       TRACE(traceid, ("malloc rc = %d\n",errno) ) ;
+       rc = -11                                    ;
+      }
+   }
+
+ if ( (rc == 0) && (type != 0) )
+   {
+    switch ( type )
+      {
+       case TMPL_OD  : make_od_from_stem(traceid, NULL, (MQOD  *)cb, RXi_stem) ; break ;
+       case TMPL_MD  : make_md_from_stem(traceid, (MQMD2 *)cb, RXi_stem) ; break ;
+       case TMPL_PMO : make_po_from_stem(traceid, (MQPMO *)cb, RXi_stem) ; break ;
+       case TMPL_GMO : make_go_from_stem(traceid, (MQGMO *)cb, RXi_stem) ; break ;
+       case TMPL_SD  : make_sd_from_stem(traceid, NULL, (MQSD  *)cb, RXi_stem) ; break ;
+      }
+
+    anchor->Tmpl[theslot].type    = type    ;
+    anchor->Tmpl[theslot].cb      = cb      ;
+    anchor->Tmpl[theslot].outmask = outmask ;
+
+    sprintf(token, "&%d", theslot)    ;
+    stem_from_string(traceid, NULL, RX_token, "", token, strlen(token)) ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQDEF function
+
+//
+// Size or flush the open handle cache  RXMQCACH
+//
+//   Call:   rc = RXMQcach(size)
+//        or
+//           rc = RXMQcach('FLUSH')
+//
+//      size is the most queue handles RXMQCLOS and RXMQPUT1 may leave
+//      open for reuse; 0 (the default) turns the cache off. FLUSH closes
+//      the idle handles but leaves the size as it is. Either way the
+//      cache size, idle count and hit/miss counts are then put in
+//      RXMQ.CACHE.SIZE, .IDLE, .HITS and .MISSES
+//
+FTYPE  RXMQCACH  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ int                     i                ;  // Looper
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = CACHE  ;  // This function trace id
+
+ RXSTRING                RX_size          ;  // Cache size or FLUSH
+ char                    sizec[6]         ;  // Uppercased FLUSH
+ MQLONG                  size   = 0       ;  // New cache size
+ int                     flush  = 0       ;  // FLUSH given
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null cache size"},
+        {  -3, "Zero length cache size"},
+        {  -4, "Bad cache size"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && (aargc != 1) )                  rc =  -1 ;
+ if ( (rc == 0) && RXNULLSTRING(aargv[0]) )        rc =  -2 ;
+ if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) )     rc =  -3 ;
+
+ if (rc == 0)
+   {
+    memcpy(&RX_size, &aargv[0], sizeof(RX_size)) ;
+    TRACE(traceid, ("RX_size = %.*s\n",(int)RX_size.strlength,RX_size.strptr) ) ;
+
+    memset(sizec, 0, sizeof(sizec)) ;
+    for ( i = 0 ; (i < (int)RX_size.strlength) && (i < (int)sizeof(sizec)-1) ; i++ )
+       sizec[i] = toupper((unsigned char)RX_size.strptr[i]) ;
+
+    if ( (RX_size.strlength == 5) && !strcmp(sizec, "FLUSH") ) flush = 1 ;
+    else
+      {
+       for ( i = 0 ; i < (int)RX_size.strlength ; i++ )
+          if ( !isdigit((unsigned char)RX_size.strptr[i]) ) rc = -4 ;
+       if ( RX_size.strlength > 5 )                         rc = -4 ;
+       if ( rc == 0 ) parm_to_ulong(RX_size, &size)              ;
+       if ( size > OBJSLOTMASK )                            rc = -4 ;
+      }
+   }
+
+//
+// Close what is no longer to be kept, and report
+//
+ if (rc == 0)
+   {
+    if ( !flush ) anchor->Cache.max = size ;
+    cache_trim(traceid, anchor, flush ? 0 : anchor->Cache.max) ;
+    TRACE(traceid, ("Cache size %"PRId32", idle %"PRId32"\n",
+          (int32_t)anchor->Cache.max,(int32_t)anchor->Cache.idle) ) ;
+    cache_stats(traceid, anchor) ;
+   }
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQCACH function
+
+//
+// Set the auto-commit policy of a connection  RXMQAUTO
+//
+//   Call:   rc = RXMQauto([ops], [bytes], [ms] [,conn])
+//
+//      Under the policy the MQPUTs and MQGETs done under syncpoint by
+//      RXMQPUT, RXMQPUT1, RXMQPUTD, RXMQPUTN, RXMQGET, RXMQGETD and
+//      RXMQGETN on the connection are committed by MA95 once ops of them, or bytes of
+//      message data, have been done, or ms milliseconds have passed
+//      since the first of them (seen at the next one). 0 turns a limit
+//      off, and all three 0 the policy; with none of them given the
+//      policy is left as it is. The work counted is also committed by
+//      RXMQCLOS of a queue on the connection, RXMQDISC, RXMQTERM and a
+//      change of policy. RXMQCMIT and RXMQBACK may still be used, each
+//      starting a new batch, as do the commits of RXMQPUTN.
+//
+//      An operation failing with MQRC_SYNCPOINT_LIMIT_REACHED is not
+//      retried, but the work before it is committed and the batch size
+//      lowered for a while.
+//
+//      The commit counters of the connection are then put in
+//      RXMQ.COMMIT.COUNT, .AUTO, .BACK, .LIMITHIT, .TIME and .MAXTIME
+//      (the times in microseconds), with the batch size now in .LIMIT
+//      and the operations not yet committed in .PENDING. RXMQDISC sets
+//      them too, for a connection with a policy.
+//
+FTYPE  RXMQAUTO  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ int                     i                ;  // Looper
+ int                     j                ;
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ int                     conn = 0         ;  // Connection (RXMQCONN id)
+ MQULONG                 traceid = CMIT   ;  // This function trace id
+
+ MQLONG                  limit[3] = {0,0,0} ; // Ops, bytes and ms
+ int                     given = 0        ;  // Any of them given
+ RXMQQM                * qm               ;  // The connection
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Bad operation count"},
+        {  -3, "Bad byte count"},
+        {  -4, "Bad time"},
+        { -95, "Bad connection id"},
+        { -98, "Not connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && (aargc > 4) )                   rc =  -1 ;
+ for ( i = 0 ; (rc == 0) && (i < 3) && (i < aargc) ; i++ )
+   {
+    if ( RXNULLSTRING(aargv[i]) ) continue                    ;
+    TRACE(traceid, ("Limit %d = %.*s\n",i,(int)aargv[i].strlength,aargv[i].strptr) ) ;
+    if ( (aargv[i].strlength == 0) || (aargv[i].strlength > 9) ) rc = -2 - i ;
+    for ( j = 0 ; j < (int)aargv[i].strlength ; j++ )
+       if ( !isdigit((unsigned char)aargv[i].strptr[j]) )      rc = -2 - i ;
+    if ( rc == 0 ) parm_to_ulong(aargv[i], &limit[i])          ;
+    given = 1                                                  ;
+   }
+ if ( (rc == 0) && parm_to_conn(aargc, aargv, 3, &conn) ) rc = -95 ;
+ if ( (rc == 0) && ( anchor->QM[conn].QMh == 0 ) ) rc = -98 ;
+
+//
+// Commit what was counted under the old policy, and set the new one
+//
+ if ( (rc == 0) && given )
+   {
+    qm = &anchor->QM[conn]                                     ;
+    if ( qm->Pending > 0 )
+      {
+       uow_commit(traceid, anchor, conn, 1, &mqrc, &mqac)      ;
+       rc = mqrc                                               ;
+      }
+    qm->AutoMsgs  = limit[0]                                   ;
+    qm->AutoBytes = limit[1]                                   ;
+    qm->AutoMs    = limit[2]                                   ;
+    qm->AutoLimit = limit[0]                                   ;
+    qm->AutoCap   = limit[0]                                   ;
+    TRACE(traceid, ("Connection %d auto-commit %"PRId32" ops %"PRId32" bytes %"PRId32" ms\n",
+          conn,(int32_t)limit[0],(int32_t)limit[1],(int32_t)limit[2]) ) ;
+   }
+
+ if ( (rc == 0) || (rc == MQCC_FAILED) ) uow_stats(traceid, anchor, conn) ;
+
+//
+// Set the LAST variables, and the function return string
+//
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
+
+return 0;
+ } // End of RXMQAUTO function
+
+//
+// Shared sessions  RXMQSESS
+//
+//   Call:   rc = RXMQsess('OPEN', name, qmname [, queues [, opts]])
+//        or
+//           rc = RXMQsess('ATTACH', name [, handles [, conn]])
+//        or
+//           rc = RXMQsess('CLOSE', name)
+//
+//      OPEN connects to qmname with MQCNO_HANDLE_SHARE_BLOCK, and opens
+//      the queues (a blank separated list of at most 16) with opts, by
+//      default MQOO_OUTPUT + MQOO_FAIL_IF_QUIESCING. These are held for
+//      the whole process, under the name given. RXMQINIT also opens any
+//      sessions listed in these variables:
+//
+//                     RXMQ.SESSION.0       -> number of sessions
+//                     RXMQ.SESSION.n       -> session name
+//                     RXMQ.SESSION.n.QM    -> QM name
+//                     RXMQ.SESSION.n.OPTS  -> open options
+//                     RXMQ.SESSION.n.Q.0   -> number of queues
+//                     RXMQ.SESSION.n.Q.m   -> queue name
+//
+//      ATTACH, in any thread, makes the session one of the thread's
+//      connections (conn as for RXMQCONN), and sets handles.0 to the
+//      number of queues and handles.1 ... to their object handles, in
+//      the order given when it was opened. RXMQCLOS of these leaves the
+//      queue open, and RXMQDISC only detaches. Other queues may be opened
+//      on the connection as usual. Note a syncpoint on it is that of all
+//      the threads attached.
+//
+//      CLOSE closes the queues and disconnects, once no thread is attached
+//
+FTYPE  RXMQSESS  RXMQPARM
+ {
+
+ RXMQCB                 * anchor = 0      ;  // RXMQ Control Block
+ int                     i                ;  // Looper
+ MQLONG                  rc = 0           ;  // Function Return Code
+ MQLONG                  mqrc = 0         ;  // MQ RC
+ MQLONG                  mqac = 0         ;  // MQ AC
+ MQULONG                 traceid = SESS   ;  // This function trace id
+
+ RXSTRING                RX_handles       ;  // Stem Var Object handles
+ RXSTRING                RX_conn          ;  //      Var Connection id
+ int                     conn      = 0    ;  // Connection to attach as
+ char                    reqc[7]          ;  // Uppercased request
+ MQCHAR48                name             ;  // Session name
+ char                    qmname[MQ_Q_MGR_NAME_LENGTH] ; // QM name
+ MQCHAR48                qname[MAXSESSQ]  ;  // Queues to open
+ int                     qs        = 0    ;  //   how many
+ MQLONG                  options   = MQOO_OUTPUT | MQOO_FAIL_IF_QUIESCING ; // Their open options
+ char                  * p                ;  // Queue list scan
+ char                  * e                ;  //   its end
+ int                     len       = 0    ;  //   word length
+ int                     s         = -1   ;  // Session index
+ int                     n                ;  // Object slot
+ char                    tail[12]         ;  // Handles stem tail
+
+ static const RETMSG ReturnMsg[] = {
+        {  -1, "Bad number of parms" },
+        {  -2, "Null or zero length request"},
+        {  -3, "Bad request"},
+        {  -4, "Null or zero length session name"},
+        {  -5, "Session name too long"},
+        {  -6, "Null QM name or QM name too long"},
+        {  -7, "Zero length options"},
+        {  -8, "Too many queues"},
+        {  -9, "Queue name too long"},
+        { -10, "Session already open"},
+        { -11, "Session not open"},
+        { -12, "No available sessions"},
+        { -13, "Session in use"},
+        { -14, "Zero length handles stem"},
+        { -15, "Zero length connection variable"},
+        { -16, "No available connections"},
+        { -17, "Object table full"},
+        { -98, "Already Connected to a QM"},
+        { -99, "UNKNOWN FAILURE"}} ;
+
+ rc = set_envir (afuncname, &traceid, &anchor)    ;
+
+ MAKERXSTRING(RX_handles, NULL, 0) ;
+
+//
+// Check the parms
+//
+ if ( (rc == 0) && ((aargc < 2) || (aargc > 5)) )      rc =  -1 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[0]) )          rc =  -2 ;
+ if ( (rc == 0) && !RXVALIDSTRING(aargv[1]) )          rc =  -4 ;
+ if ( (rc == 0) && ( aargv[1].strlength >
+                     sizeof(MQCHAR48) ) )              rc =  -5 ;
+
+ if (rc == 0)
+   {
+    memset(reqc, 0, sizeof(reqc)) ;
+    for ( i = 0 ; (i < (int)aargv[0].strlength) && (i < (int)sizeof(reqc)-1) ; i++ )
+       reqc[i] = toupper((unsigned char)aargv[0].strptr[i]) ;
+    if ( aargv[0].strlength >= sizeof(reqc) ) reqc[0] = 0 ;
+
+    if      ( !strcmp(reqc, "OPEN") )   { if ( aargc < 3 ) rc = -1 ; }
+    else if ( !strcmp(reqc, "ATTACH") ) { if ( aargc > 4 ) rc = -1 ; }
+    else if ( !strcmp(reqc, "CLOSE") )  { if ( aargc > 2 ) rc = -1 ; }
+    else                                               rc =  -3 ;
+
+    memset(name, 0, sizeof(name))                       ;
+    memcpy(name, aargv[1].strptr, aargv[1].strlength)   ;
+    TRACE(traceid, ("Request %s for session %.48s\n",reqc,name) ) ;
+   }
+
+//
+// For OPEN get the QM name, queues and options
+//
+ if ( (rc == 0) && !strcmp(reqc, "OPEN") )
+   {
+    if ( RXNULLSTRING(aargv[2]) || (aargv[2].strlength >
+                                    MQ_Q_MGR_NAME_LENGTH) ) rc = -6 ;
+    if ( (rc == 0) && (aargc > 4) && RXZEROLENSTRING(aargv[4]) ) rc = -7 ;
+
+    if (rc == 0)
+      {
+       memset(qmname, 0, sizeof(qmname))                   ;
+       memcpy(qmname, aargv[2].strptr, aargv[2].strlength) ;
+       if ( (aargc > 4) && !RXNULLSTRING(aargv[4]) ) parm_to_ulong(aargv[4], &options) ;
+      }
 
-   TRACE(traceid, ("Unravelled the TM\n") ) ;
-  }
+    if ( (rc == 0) && (aargc > 3) && !RXNULLSTRING(aargv[3]) )
+      {
+       e = aargv[3].strptr + aargv[3].strlength ;
+       for ( p = aargv[3].strptr ; (rc == 0) && (p < e) ; p += len )
+         {
+          for ( len = 0 ; (p + len < e) && (p[len] != ' ') ; len++ ) ;
+          if      ( len == 0 )                       len =  1 ; // A blank
+          else if ( qs == MAXSESSQ )                 rc  = -8 ;
+          else if ( len > (int)sizeof(MQCHAR48) )    rc  = -9 ;
+          else
+            {
+             memset(qname[qs], 0, sizeof(MQCHAR48)) ;
+             memcpy(qname[qs++], p, len)            ;
+            }
+         }
+      }
+   }
 
 //
-// Now we have got valid Trigger Data, split it up
+// For ATTACH check the stem and, for another connection, find a free one
 //
-if ( ( rc == 0 ) && ( action == 2 ) )
-  {
-   TRACE(traceid, ("Unravelling Trigger Data\n") ) ;
+ if ( (rc == 0) && !strcmp(reqc, "ATTACH") )
+   {
+    if ( (aargc > 2) && RXZEROLENSTRING(aargv[2]) )              rc = -14 ;
+    if ( (rc == 0) && (aargc > 3) && RXZEROLENSTRING(aargv[3]) ) rc = -15 ;
+    if ( (rc == 0) && (aargc > 2) ) memcpy(&RX_handles, &aargv[2], sizeof(RX_handles)) ;
 
-   thetm2 = (MQTMC2 *)oldtm2.strptr   ; // Set Header pointer
+    if ( (rc == 0) && (aargc > 3) && !RXNULLSTRING(aargv[3]) )
+      {
+       memcpy(&RX_conn, &aargv[3], sizeof(RX_conn)) ;
+       for ( conn = 1 ; (conn < MAXCONNS) && (anchor->QM[conn].QMh != 0) ; conn++ ) ;
+       if ( conn == MAXCONNS )                                   rc = -16 ;
+      }
+    if ( (rc == 0) && (anchor->QM[conn].QMh != 0) )              rc = -98 ;
+   }
 
-//Build the components
+//
+// Open the session
+//
+ if ( (rc == 0) && !strcmp(reqc, "OPEN") )
+   {
+    rc = sess_open(traceid, name, qmname, qname, qs, options, &mqrc, &mqac) ;
+    if ( rc == -1 ) rc = -10 ;
+    if ( rc == -2 ) rc = -12 ;
+   }
 
-   stem_from_string(traceid, zlist, RX_output, "QN"  , thetm2->QName,          sizeof(MQCHAR48)) ;
-   stem_from_string(traceid, zlist, RX_output, "PN"  , (char*)thetm2->ProcessName, sizeof(MQCHAR48)) ;
-   stem_from_string(traceid, zlist, RX_output, "TD"  , thetm2->TriggerData,          sizeof(MQCHAR64)) ;
-   stem_from_string(traceid, zlist, RX_output, "AID" , thetm2->ApplId,              sizeof(MQCHAR256)) ;
-   stem_from_string(traceid, zlist, RX_output, "ED"  , thetm2->EnvData,             sizeof(MQCHAR128)) ;
-   stem_from_string(traceid, zlist, RX_output, "UD"  , thetm2->UserData,            sizeof(MQCHAR128)) ;
-   stem_from_string(traceid, zlist, RX_output, "QM"  , thetm2->QMgrName,             sizeof(MQCHAR48)) ;
-   stem_from_string(traceid, zlist, RX_output, "ZLIST", zlist, strlen(zlist))                         ;
+//
+// Attach to it. Being counted as a user, it cannot be closed meanwhile.
+//
+ if ( (rc == 0) && !strcmp(reqc, "ATTACH") )
+   {
+    SESS_LOCK() ;
+    s = sess_find(name) ;
+    if ( (s < 0) || (Sess[s].state != SESS_READY) ) rc = -11 ;
+    else Sess[s].users++ ;
+    SESS_UNLOCK() ;
 
-   TRACE(traceid, ("Unravelled the Trigger Data\n") ) ;
-  }
+    if (rc == 0)
+      {
+       memcpy(anchor->QM[conn].QMname, Sess[s].QMname, sizeof(anchor->QM[conn].QMname)) ;
+       anchor->QM[conn].QMh  = Sess[s].QMh ;
+       anchor->QM[conn].Sess = s + 1       ;
+       anchor->Conns++                     ;
+       TRACE(traceid, ("Attached connection %d, handle %"PRIX32", QM %.48s\n",
+             conn,(uint32_t)anchor->QM[conn].QMh,anchor->QM[conn].QMname) ) ;
+
+       for ( i = 0 ; (rc == 0) && (i < Sess[s].Qs) ; i++ )
+         {
+          n = obj_new(traceid, anchor, conn) ;
+          if ( n == 0 ) rc = -17 ;
+          else
+            {
+             anchor->Obj[n].Qh     = Sess[s].Qh[i] ;
+             anchor->Obj[n].shared = 1             ;
+             obj_opened(traceid, anchor, n, Sess[s].options, Sess[s].Qname[i]) ;
+             sprintf(tail, "%d", i + 1) ;
+             if ( !RXNULLSTRING(RX_handles) )
+                stem_from_long(traceid, NULL, RX_handles, tail, OBJHANDLE(anchor,n)) ;
+            }
+         }
+
+       if ( rc != 0 ) sess_detach(traceid, anchor, conn) ;
+       else
+         {
+          if ( !RXNULLSTRING(RX_handles) ) stem_from_long(traceid, NULL, RX_handles, "0", Sess[s].Qs) ;
+          if ( conn != 0 ) stem_from_long(traceid, NULL, RX_conn, "", conn) ;
+         }
+      }
+   }
 
 //
-// Free data buffer for stem.1 variable data, if allocated.
+// Close it, if no thread is attached
 //
- if ( data != 0 )
+ if ( (rc == 0) && !strcmp(reqc, "CLOSE") )
    {
-    TRACE(traceid, ("Free area\n") ) ;
-    free(data) ;
+    SESS_LOCK() ;
+    s = sess_find(name) ;
+    if ( (s < 0) || (Sess[s].state != SESS_READY) ) rc = -11 ;
+    else if ( Sess[s].users > 0 )                   rc = -13 ;
+    else Sess[s].state = SESS_BUSY ;
+    SESS_UNLOCK() ;
+
+    if (rc == 0)
+      {
+       sess_shut(traceid, &Sess[s], &mqrc, &mqac) ;
+       rc = mqrc                                  ;
+      }
    }
 
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
 return 0;
- } // End of RXMQTM function
+ } // End of RXMQSESS function
 
 
 #ifdef __MVS__
@@ -5171,7 +14525,7 @@ FTYPE RXMQC  RXMQPARM
  char        var  [10]                     ;
  MQLONG      to   = 5000                   ; //Timeout for MQ Get in msec
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null parms"},
         {  -3, "Zero parms"},
@@ -5248,7 +14602,7 @@ FTYPE RXMQC  RXMQPARM
 // 1) Connect to queue manager, if not yet connected
 
  if (rc == 0)
-   if ( (anchor->QMh == 0) || strcmp(anchor->QMname, qm) )   // Is it connected to correct QM ?
+   if ( (qmh = conn_qm(anchor, qm)) == 0 )                   // Is it connected to correct QM ?
      {                                                       // No
       DisconnectFinally = 1                         ;
       TRACE(traceid, ("Connecting to QM %s\n",qm) ) ;
@@ -5256,7 +14610,6 @@ FTYPE RXMQC  RXMQPARM
       TRACE(traceid, ("MQCONN rc = %ld\n",mqrc ) )  ;
       if ( mqrc != 0 )  rc = -11                    ;
      }
-   else qmh = anchor->QMh                           ;
 
 
 // 2) Open the command queue for PUT access
@@ -5316,8 +14669,8 @@ FTYPE RXMQC  RXMQPARM
 //
  if ( rc == 0 )
    {
-    TRACE(traceid, ("Doing malloc for %ld bytes\n",bufflen) )  ;
-    buffer = (char *) malloc(bufflen)                          ;
+    TRACE(traceid, ("Getting buffer for %ld bytes\n",bufflen) ) ;
+    buffer = (char *) buf_get(anchor, BUF_WORK, bufflen)       ;
     if ( buffer == NULL )
       {
        mqac = errno                                ;
@@ -5352,7 +14705,7 @@ FTYPE RXMQC  RXMQPARM
           bufflen = bufflen * 2              ;         // double the size of buffer
           TRACE(traceid, ("Reallocating buffer with double size = %s\n",bufflen) ) ;
           rc = 0                                      ;
-          buffer = (char *) realloc(buffer,bufflen)   ;
+          buffer = (char *) buf_get(anchor, BUF_WORK, bufflen) ;
           if ( buffer == NULL )
             {
              mqac = errno                                ;
@@ -5390,15 +14743,6 @@ FTYPE RXMQC  RXMQPARM
       }
    }
 
-//
-// Free data buffer, if allocated.
-//
- if ( buffer != 0 )
-   {
-   TRACE(traceid, ("Free buffer\n") ) ;
-    free(buffer) ;
-   }
-
  if (rQh) MQCLOSE ( qmh, &rQh, MQCO_DELETE_PURGE, &dummy, &dummy ) ;
 
  if( DisconnectFinally ) MQDISC ( &qmh, &dummy, &dummy ) ;
@@ -5406,7 +14750,7 @@ FTYPE RXMQC  RXMQPARM
 //
 // Set the LAST variables, and the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
 return 0;
 }
@@ -5472,7 +14816,7 @@ FTYPE RXMQC RXMQPARM
  char                    command[MAXCOMMLEN+5]  ; //Padded Command
  MQLONG                  commandlen             ; // to send to QM
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null parms"},
         {  -3, "Zero parms"},
@@ -5575,8 +14919,8 @@ if ( rc == 0 )
 //
  if ( rc == 0 )
    {
-    TRACE(traceid, ("Doing malloc for %d bytes\n",bufflen) ) ;
-    buffer = malloc(bufflen)                                 ;
+    TRACE(traceid, ("Getting buffer for %d bytes\n",bufflen) ) ;
+    buffer = buf_get(anchor, BUF_WORK, bufflen)              ;
     if ( buffer == NULL )
       {
        mqac = errno                                               ;
@@ -5593,7 +14937,7 @@ if ( rc == 0 )
 
  if (rc == 0)
    {
-    if ( (anchor->QMh == 0) || strcmp(anchor->QMname, qm) ) // Is it connected to correct QM ?
+    if ( (qmh = conn_qm(anchor, qm)) == 0 )                 // Is it connected to correct QM ?
       {                                                     // No
        DisconnectFinally = 1                                        ;
        TRACE(traceid, ("Connecting to QM %s\n",qm) )                ;
@@ -5601,7 +14945,6 @@ if ( rc == 0 )
        TRACE(traceid, ("MQCONN rc = %"PRId32"\n",(int32_t)mqrc ) )  ;
        if ( mqrc != 0 )  rc = -11                                   ;
       }
-    else qmh = anchor->QMh                                          ;
    }
 
  if ( rc == 0 )                      // Open the command Q for Put access
@@ -5816,19 +15159,10 @@ if ( rc == 0 )
     TRACE(traceid, ("Disconnecting from QM\n") ) ; //Disconnect from QM
     MQDISC ( &qmh, &dummy, &dummy ) ;
    }
-
-//
-// Free data buffer, if allocated.
-//
- if ( buffer != 0 )
-   {
-    TRACE(traceid, ("Free area\n") ) ;
-    free(buffer) ;
-   }
 //
 // Set the function return string
 //
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
 //
 // Return to caller
@@ -5838,6 +15172,58 @@ return 0;
  } // End of RXMQC function
 #endif
 
+//
+// RXMQV and RXMQVC function lists
+//
+//   The operation name is looked up by way of a hash index of the list,
+//   made the first time it is used in each thread (z/OS having one).
+//
+ typedef struct
+         {
+          char * func_name;
+          int (APIENTRY *func_ptr) RXMQPARM;
+         } mqftypes;
+
+ #define VHASHSIZE 64     // Hash index slots (a power of 2, over twice the functions)
+
+ typedef struct _VHASH {
+     int           built                     ; // Index made
+     unsigned char slot[VHASHSIZE]           ; // Function list entry + 1 (0 empty)
+ } VHASH;
+
+//
+// vfunc_find - the entry of the function list for an (uppercased) name,
+//              or -1 if it is not there
+//
+int vfunc_find ( const mqftypes * list   // function list, ending "?"
+               , VHASH          * index  // its hash index
+               , char           * name   // name wanted (0-terminated)
+               )
+{
+ uint32_t                h                ;  // Hash slot
+ char                  * p                ;  // Name scan
+ int                     i                ;  // List entry
+
+ if ( !index->built )
+   {
+    for ( i = 0 ; list[i].func_name[0] != '?' ; i++ )
+      {
+       for ( h = 2166136261u, p = list[i].func_name ; *p != '\0' ; p++ )
+          h = (h ^ (unsigned char)*p) * 16777619u                ;
+       for ( h &= VHASHSIZE-1 ; index->slot[h] != 0 ; h = (h + 1) & (VHASHSIZE-1) ) ;
+       index->slot[h] = (unsigned char)(i + 1)                   ;
+      }
+    index->built = 1 ;
+   }
+
+ for ( h = 2166136261u, p = name ; *p != '\0' ; p++ )
+    h = (h ^ (unsigned char)*p) * 16777619u ;
+ for ( h &= VHASHSIZE-1 ; index->slot[h] != 0 ; h = (h + 1) & (VHASHSIZE-1) )
+   if ( !strcmp(list[index->slot[h]-1].func_name, name) ) return index->slot[h]-1 ;
+
+ return -1 ;
+} // End of vfunc_find
+
 //
 // Perform one of RXMQ operations  RXMQV
 //
@@ -5863,6 +15249,29 @@ return 0;
 //                     HXT      ->  RXMQHXT,  do a Header extract, MQHXT
 //                     EVENT    ->  RXMQEVNT, extract the Event Data from the 'message' data
 //                     TM       ->  RXMQTM,   process a Trigger Message
+//                     DEF      ->  RXMQDEF,  compile a descriptor template
+//                     PUTD     ->  RXMQPUTD, do a MQPUT of string data
+//                     GETD     ->  RXMQGETD, do a MQGET returning the data
+//                     BROWSED  ->  RXMQBRWD, do a browse returning the data
+//                     CACHE    ->  RXMQCACH, size or flush the open handle cache
+//                     CONNX    ->  RXMQCONX, connect with options (MQCONNX)
+//                     SESSION  ->  RXMQSESS, share connections between threads
+//                     TRACE    ->  RXMQTRAC, set the trace for this thread
+//                     RETMODE  ->  RXMQRETM, set which LASTxx variables are set
+//                     GETN     ->  RXMQGETN, get several messages
+//                     BROWSEN  ->  RXMQBRWN, browse several messages
+//                     PUTN     ->  RXMQPUTN, put several messages
+//                     AUTOCMIT ->  RXMQAUTO, set the auto-commit policy
+//                     COPY     ->  RXMQCOPY, copy or move messages
+//                     ASYNC    ->  RXMQASYN, consume queues asynchronously
+//                     POLL     ->  RXMQPOLL, take messages consumed asynchronously
+//                     STAT     ->  RXMQSTAT, check asynchronous puts (MQSTAT)
+//                     REQUEST  ->  RXMQREQ,  send a request, and wait for its reply
+//                     REPLY    ->  RXMQRPLY, take the replies to requests in flight
+//                     WAITANY  ->  RXMQWANY, wait for a message on any of a list of queues
+//                     SUBMIT   ->  RXMQSUBM, give a put, get or request to the worker pool
+//                     WAIT     ->  RXMQWAIT, wait for tasks given to the worker pool
+//                     FANOUT   ->  RXMQFAN,  put a message to queues on several QMs at once
 //
 FTYPE RXMQV  RXMQPARM
 {
@@ -5870,11 +15279,14 @@ FTYPE RXMQV  RXMQPARM
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
  MQULONG                 traceid = MQV    ;  // This function trace id
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
  MQULONG                 i                ;  // Looper
- char                    name[8]          ;  // Uppercased function name
+ char                    name[9]          ;  // Uppercased function name
  MQULONG                 namelen          ;  // Name length
+ int                     n                ;  // Function list entry
+ static RXMQTLS VHASH    index            ;  // Hash index of funclist
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null MQ function name"},
         {  -3, "Zero length MQ function name"},
@@ -5886,14 +15298,7 @@ FTYPE RXMQV  RXMQPARM
  if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc = -2 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc = -3 ;
 
- typedef struct
-         {
-          char * func_name;
-          int (APIENTRY *func_ptr) RXMQPARM;
-
- } mqftypes;
-
- mqftypes funclist[] = {
+ static const mqftypes funclist[] = {
           {"INIT"  , RXMQINIT},
           {"TERM"  , RXMQTERM},
           {"CONS"  , RXMQCONS},
@@ -5913,26 +15318,51 @@ FTYPE RXMQV  RXMQPARM
           {"HXT"   , RXMQHXT},
           {"EVENT" , RXMQEVNT},
           {"TM"    , RXMQTM},
+          {"DEF"   , RXMQDEF},
+          {"PUTD"  , RXMQPUTD},
+          {"GETD"  , RXMQGETD},
+          {"BROWSED", RXMQBRWD},
+          {"CACHE" , RXMQCACH},
+          {"CONNX" , RXMQCONX},
+          {"SESSION", RXMQSESS},
+          {"TRACE" , RXMQTRAC},
+          {"RETMODE", RXMQRETM},
+          {"GETN"  , RXMQGETN},
+          {"BROWSEN", RXMQBRWN},
+          {"PUTN"  , RXMQPUTN},
+          {"AUTOCMIT", RXMQAUTO},
+          {"COPY"  , RXMQCOPY},
+          {"ASYNC" , RXMQASYN},
+          {"POLL"  , RXMQPOLL},
+          {"STAT"  , RXMQSTAT},
+          {"REQUEST", RXMQREQ},
+          {"REPLY" , RXMQRPLY},
+          {"WAITANY", RXMQWANY},
+          {"SUBMIT", RXMQSUBM},
+          {"WAIT"  , RXMQWAIT},
+          {"FANOUT", RXMQFAN},
           {"?"     , NULL}  };
 
-// Uppercase specified function name
- namelen = (aargv[0].strlength < 8) ? aargv[0].strlength : 8 ;
- for (i = 0; i < namelen; i++)
-   name[i] = toupper(aargv[0].strptr[i]);
- name[namelen] = '\0' ;
-
-// Find and call appropriate function
- if (rc == 0)  for (i = 0; ; i++)
+// Uppercase specified function name, the whole of it (no name is
+// longer than 8)
+ if ( (rc == 0) && ((aargv[0].strlength > 8)
+                 || (memchr(aargv[0].strptr, '\0', aargv[0].strlength) != NULL)) ) rc = -20 ;
+ if ( rc == 0 )
    {
-    if (funclist[i].func_name[0] == '?') break;
-    if ( ( strlen(funclist[i].func_name) == namelen ) &&
-         ( memcmp(funclist[i].func_name, name, namelen) == 0) )
-      return funclist[i].func_ptr(name, aargc-1, &(aargv[1]), aqname, aretstr);
+    namelen = aargv[0].strlength ;
+    for (i = 0; i < namelen; i++)
+      name[i] = toupper(aargv[0].strptr[i]);
+    name[namelen] = '\0' ;
    }
 
+// Find and call appropriate function
+ if ( (rc == 0) && ((n = vfunc_find(funclist, &index, name)) >= 0) )
+   return funclist[n].func_ptr(name, aargc-1, &(aargv[1]), aqname, aretstr);
+
  rc = -20 ;
 
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_envir (afuncname, &traceid, &anchor) ; // For the return mode
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
  return 0;
 }
@@ -5953,11 +15383,14 @@ FTYPE RXMQVC  RXMQPARM
  MQLONG                  mqrc = 0         ;  // MQ RC
  MQLONG                  mqac = 0         ;  // MQ AC
  MQULONG                 traceid = MQV    ;  // This function trace id
+ RXMQCB                * anchor = 0       ;  // RXMQ Control Block
  MQULONG                 i                ;  // Looper
- char                    name[8]          ;  // Uppercased function name
+ char                    name[9]          ;  // Uppercased function name
  MQULONG                 namelen          ;  // Name length
+ int                     n                ;  // Function list entry
+ static RXMQTLS VHASH    index            ;  // Hash index of funclist
 
- RETMSG ReturnMsg[] = {
+ static const RETMSG ReturnMsg[] = {
         {  -1, "Bad number of parms" },
         {  -2, "Null MQ function name"},
         {  -3, "Zero length MQ function name"},
@@ -5969,36 +15402,32 @@ FTYPE RXMQVC  RXMQPARM
  if ( (rc == 0) && RXNULLSTRING(aargv[0]) )    rc = -2 ;
  if ( (rc == 0) && RXZEROLENSTRING(aargv[0]) ) rc = -3 ;
 
- typedef struct
-         {
-          char * func_name;
-          int (APIENTRY *func_ptr) RXMQPARM;
-         } mqftypes;
-
- mqftypes funclist[] = {
+ static const mqftypes funclist[] = {
           {"INIT"   , RXMQINIT},
           {"TERM"   , RXMQTERM},
           {"COMMAND", RXMQC},
           {"?"      , NULL}  };
 
-// Uppercase specified function name
- namelen = (aargv[0].strlength < 8) ? aargv[0].strlength : 8 ;
- for (i = 0; i < namelen; i++)
-   name[i] = toupper(aargv[0].strptr[i]);
- name[namelen] = '\0' ;
+// Uppercase specified function name, the whole of it (no name is
+// longer than 8)
+ if ( (rc == 0) && ((aargv[0].strlength > 8)
+                 || (memchr(aargv[0].strptr, '\0', aargv[0].strlength) != NULL)) ) rc = -20 ;
+ if ( rc == 0 )
+   {
+    namelen = aargv[0].strlength ;
+    for (i = 0; i < namelen; i++)
+      name[i] = toupper(aargv[0].strptr[i]);
+    name[namelen] = '\0' ;
+   }
 
 // Find and call appropriate function
- if (rc == 0) for (i = 0; ; i++)
-   {
-    if (funclist[i].func_name[0] == '?') break;
-    if ( ( strlen(funclist[i].func_name) == namelen ) &&
-         ( memcmp(funclist[i].func_name, name, namelen) == 0) )
-      return funclist[i].func_ptr(name, aargc-1, &(aargv[1]), aqname, aretstr);
-    }
+ if ( (rc == 0) && ((n = vfunc_find(funclist, &index, name)) >= 0) )
+   return funclist[n].func_ptr(name, aargc-1, &(aargv[1]), aqname, aretstr);
 
  rc = -20;
 
- set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,traceid,"") ;
+ set_envir (afuncname, &traceid, &anchor) ; // For the return mode
+ set_return(rc,mqrc,mqac,afuncname,ReturnMsg,aretstr,RETMODE(anchor),traceid,"") ;
 
  return 0;
 }
@@ -6106,6 +15535,121 @@ FTYPE  RXMQNC  RXMQPARM
  {
   return RXMQC (afuncname,aargc,aargv,aqname,aretstr);
  }
+
+FTYPE  RXMQNDEF  RXMQPARM
+ {
+  return RXMQDEF (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNPUTD  RXMQPARM
+ {
+  return RXMQPUTD (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNGETD  RXMQPARM
+ {
+  return RXMQGETD (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNBROWSED  RXMQPARM
+ {
+  return RXMQBRWD (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNCACHE  RXMQPARM
+ {
+  return RXMQCACH (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNCONNX  RXMQPARM
+ {
+  return RXMQCONX (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNSESSION  RXMQPARM
+ {
+  return RXMQSESS (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNTRACE  RXMQPARM
+ {
+  return RXMQTRAC (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNRETMODE  RXMQPARM
+ {
+  return RXMQRETM (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNGETN  RXMQPARM
+ {
+  return RXMQGETN (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNBROWSEN  RXMQPARM
+ {
+  return RXMQBRWN (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNPUTN  RXMQPARM
+ {
+  return RXMQPUTN (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNAUTOCOMMIT  RXMQPARM
+ {
+  return RXMQAUTO (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNCOPY  RXMQPARM
+ {
+  return RXMQCOPY (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNASYNC  RXMQPARM
+ {
+  return RXMQASYN (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNPOLL  RXMQPARM
+ {
+  return RXMQPOLL (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNSTAT  RXMQPARM
+ {
+  return RXMQSTAT (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNREQUEST  RXMQPARM
+ {
+  return RXMQREQ (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNREPLY  RXMQPARM
+ {
+  return RXMQRPLY (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNWAITANY  RXMQPARM
+ {
+  return RXMQWANY (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNSUBMIT  RXMQPARM
+ {
+  return RXMQSUBM (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNWAIT  RXMQPARM
+ {
+  return RXMQWAIT (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQNFANOUT  RXMQPARM
+ {
+  return RXMQFAN (afuncname,aargc,aargv,aqname,aretstr);
+ }
 #endif
 
 #ifdef _RXMQT
@@ -6208,4 +15752,119 @@ FTYPE  RXMQTC  RXMQPARM
  {
   return RXMQC (afuncname,aargc,aargv,aqname,aretstr);
  }
+
+FTYPE  RXMQTDEF  RXMQPARM
+ {
+  return RXMQDEF (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTPUTD  RXMQPARM
+ {
+  return RXMQPUTD (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTGETD  RXMQPARM
+ {
+  return RXMQGETD (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTBROWSED  RXMQPARM
+ {
+  return RXMQBRWD (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTCACHE  RXMQPARM
+ {
+  return RXMQCACH (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTCONNX  RXMQPARM
+ {
+  return RXMQCONX (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTSESSION  RXMQPARM
+ {
+  return RXMQSESS (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTTRACE  RXMQPARM
+ {
+  return RXMQTRAC (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTRETMODE  RXMQPARM
+ {
+  return RXMQRETM (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTGETN  RXMQPARM
+ {
+  return RXMQGETN (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTBROWSEN  RXMQPARM
+ {
+  return RXMQBRWN (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTPUTN  RXMQPARM
+ {
+  return RXMQPUTN (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTAUTOCOMMIT  RXMQPARM
+ {
+  return RXMQAUTO (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTCOPY  RXMQPARM
+ {
+  return RXMQCOPY (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTASYNC  RXMQPARM
+ {
+  return RXMQASYN (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTPOLL  RXMQPARM
+ {
+  return RXMQPOLL (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTSTAT  RXMQPARM
+ {
+  return RXMQSTAT (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTREQUEST  RXMQPARM
+ {
+  return RXMQREQ (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTREPLY  RXMQPARM
+ {
+  return RXMQRPLY (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTWAITANY  RXMQPARM
+ {
+  return RXMQWANY (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTSUBMIT  RXMQPARM
+ {
+  return RXMQSUBM (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTWAIT  RXMQPARM
+ {
+  return RXMQWAIT (afuncname,aargc,aargv,aqname,aretstr);
+ }
+
+FTYPE  RXMQTFANOUT  RXMQPARM
+ {
+  return RXMQFAN (afuncname,aargc,aargv,aqname,aretstr);
+ }
 #endif
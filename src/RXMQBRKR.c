@@ -0,0 +1,797 @@
+//
+// RXMQBRKR.c - rxmqbrkr, the connection broker for MA95 in broker mode
+//
+//   rxmqbrkr [-s socket] [-n idle] [-c QM]... [-o queue[,options]]...
+//
+//     -s  the UNIX domain socket to listen on (default $RXMQBROKER,
+//         else BRK_SOCKET)
+//     -n  how many connections to keep once their scripts are done with
+//         them (default 8)
+//     -c  a queue manager to connect to at start (repeatable)
+//     -o  a queue to open, with these open options (default MQOO_OUTPUT),
+//         on each of the -c connections at start (repeatable)
+//
+//   Each MA95 connection (see RXMQBRKR.h) is a session here, on its own
+//   thread. Its MQCONN(X) takes a kept connection made with the same
+//   QM name, options, application name and MQCD, or makes one. Its MQOPEN
+//   of a queue takes one kept open, with the same name and options, on
+//   that connection, or opens it. When the session ends (MQDISC, or its
+//   socket closes) what it left uncommitted is backed out, the queues
+//   it opened are kept open (or closed if they cannot be reused) and
+//   the connection is kept for the next, up to the -n limit.
+//
+//   Queues are kept only when opened without browse, exclusive input or
+//   alternate user authority, and by name (not as a model). A connection
+//   that reports it is broken is not kept.
+//
+//   Ends (closing the kept connections) on SIGINT or SIGTERM.
+//
+
+ #include <string.h>
+ #include <stdlib.h>
+ #include <stdio.h>
+ #include <errno.h>
+ #include <signal.h>
+ #include <pthread.h>
+ #include <sys/types.h>
+ #include <sys/socket.h>
+ #include <sys/un.h>
+
+ #include <cmqc.h>
+ #include <cmqxc.h>
+
+ #include "RXMQBRKR.h"
+
+ #define BRKOBJS   32     // Objects open on a connection
+ #define BRKIDLE   8      // Connections kept by default
+
+//
+// A queue opened on a connection
+//
+ typedef struct _BRKOBJ {
+     MQHOBJ     Qh                           ; // Its handle (MQHO_NONE free)
+     MQLONG     options                      ; // Open options
+     MQLONG     keep                         ; // Can be reused
+     MQLONG     busy                         ; // Open for a session
+     uint64_t   used                         ; // When last closed (LRU)
+     MQOD       od                           ; // As it was opened
+ } BRKOBJ;
+
+//
+// A connection, and what it was made with
+//
+ typedef struct _BRKCONN {
+     struct _BRKCONN * next                  ; // Next kept
+     MQCHAR48   QMname                       ; // QM name given
+     MQCNO      cno                          ; // Connect options given
+     MQLONG     cdlen                        ; // Length of the MQCD (0 none)
+     MQCD       cd                           ; // Client channel given
+     MQHCONN    hconn                        ; // The connection
+     MQLONG     dirty                        ; // Work under syncpoint
+     MQLONG     broken                       ; // Not to be kept
+     uint64_t   tick                         ; // Closes done (for LRU)
+     BRKOBJ     obj[BRKOBJS]                 ; // Objects open on it
+ } BRKCONN;
+
+//
+// A session (an MA95 connection) and its buffers
+//
+ typedef struct _BRKSESS {
+     int        fd                           ; // Its socket
+     BRKCONN  * c                            ; // Its connection
+     char     * body                         ; // Request body
+     size_t     bodylen                      ; //   room
+     char     * buf                          ; // Message or attributes
+     size_t     buflen                       ; //   room
+ } BRKSESS;
+
+ static BRKCONN       * brk_idle   = NULL    ;  // Connections kept
+ static int             brk_nidle  = 0       ;  //   how many
+ static int             brk_maxidle = BRKIDLE ; //   at most
+ static pthread_mutex_t brk_lock   = PTHREAD_MUTEX_INITIALIZER ; // Guards them
+ static const char    * brk_path   = NULL    ;  // Socket
+
+ static unsigned long   brk_conns  = 0       ;  // MQCONNX done
+ static unsigned long   brk_reconn = 0       ;  // Kept connections reused
+ static unsigned long   brk_opens  = 0       ;  // MQOPEN done
+ static unsigned long   brk_reopen = 0       ;  // Kept queues reused
+
+//
+// brk_broken - note a connection that cannot be kept after this reason
+//
+static void brk_broken ( BRKCONN  * c            // The connection
+                       , MQLONG     rc           // MQ RC
+                       )
+{
+ switch ( rc )
+   {
+    case MQRC_CONNECTION_BROKEN   :
+    case MQRC_Q_MGR_NOT_AVAILABLE :
+    case MQRC_Q_MGR_STOPPING      :
+    case MQRC_Q_MGR_QUIESCING     :
+    case MQRC_CONNECTION_QUIESCING:
+    case MQRC_CONNECTION_STOPPING :
+    case MQRC_HCONN_ERROR         : c->broken = 1 ;
+                                    break         ;
+    default                       : break         ;
+   }
+
+ return ;
+} // End of brk_broken
+
+//
+// brk_connect - a connection made as asked, kept or new (NULL if it
+//               cannot be made, the CC and RC set)
+//
+static BRKCONN * brk_connect ( PMQCHAR    qmname       // QM name
+                             , PMQCNO     cnop         // Connect options
+                             , MQLONG     cdlen        // MQCD length (0 none)
+                             , PMQCD      cdp          // Client channel
+                             , PMQLONG    cc           // MQ CC
+                             , PMQLONG    rc           // MQ RC
+                             )
+{
+ BRKCONN               * c                ;  // The connection
+ BRKCONN              ** pc               ;  // Where it is kept
+ MQCNO                   cno              ;  // Connect options used
+ int                     i                ;  // Looper
+
+ pthread_mutex_lock(&brk_lock) ;
+ for ( pc = &brk_idle ; *pc != NULL ; pc = &(*pc)->next )
+   {
+    c = *pc ;
+    if ( (memcmp(c->QMname, qmname, sizeof(MQCHAR48)) == 0)
+      && (memcmp(&c->cno, cnop, sizeof(MQCNO)) == 0)
+      && (c->cdlen == cdlen)
+      && ((cdlen == 0) || (memcmp(&c->cd, cdp, sizeof(MQCD)) == 0)) )
+      {
+       *pc     = c->next ;
+       c->next = NULL    ;
+       brk_nidle-- ;
+       brk_reconn++ ;
+       pthread_mutex_unlock(&brk_lock) ;
+       *cc = MQCC_OK   ;
+       *rc = MQRC_NONE ;
+       return c ;
+      }
+   }
+ brk_conns++ ;
+ pthread_mutex_unlock(&brk_lock) ;
+
+ if ( (c = (BRKCONN *) calloc(1, sizeof(BRKCONN))) == NULL )
+   {
+    *cc = MQCC_FAILED              ;
+    *rc = MQRC_STORAGE_NOT_AVAILABLE ;
+    return NULL ;
+   }
+ memcpy(c->QMname, qmname, sizeof(MQCHAR48)) ;
+ memcpy(&c->cno, cnop, sizeof(MQCNO))        ;
+ c->cdlen = cdlen                            ;
+ if ( cdlen != 0 ) memcpy(&c->cd, cdp, sizeof(MQCD)) ;
+ for ( i = 0 ; i < BRKOBJS ; i++ ) c->obj[i].Qh = MQHO_NONE ;
+
+ memcpy(&cno, cnop, sizeof(MQCNO)) ;
+ if ( cno.Version >= MQCNO_VERSION_2 ) cno.ClientConnPtr = ( cdlen != 0 ) ? &c->cd : NULL ;
+ MQCONNX ( c->QMname, &cno, &c->hconn, cc, rc ) ;
+ if ( *cc == MQCC_FAILED )
+   {
+    free(c) ;
+    return NULL ;
+   }
+
+ return c ;
+} // End of brk_connect
+
+//
+// brk_release - a session is done with a connection: back out what it
+//               left, close or keep its queues, and keep or end it
+//
+static void brk_release ( BRKCONN  * c            // The connection
+                        )
+{
+ MQLONG                  cc               ;  // MQ CC
+ MQLONG                  rc               ;  // MQ RC
+ int                     i                ;  // Looper
+
+ if ( c->dirty && !c->broken )
+   {
+    MQBACK ( c->hconn, &cc, &rc ) ;
+    brk_broken(c, rc) ;
+    c->dirty = 0      ;
+   }
+ for ( i = 0 ; i < BRKOBJS ; i++ )
+   {
+    if ( (c->obj[i].Qh == MQHO_NONE) || !c->obj[i].busy ) continue ;
+    c->obj[i].busy = 0 ;
+    c->obj[i].used = ++c->tick ;
+    if ( c->obj[i].keep && !c->broken ) continue ;
+    MQCLOSE ( c->hconn, &c->obj[i].Qh, MQCO_NONE, &cc, &rc ) ;
+    brk_broken(c, rc)           ;
+    c->obj[i].Qh = MQHO_NONE    ;
+   }
+
+ pthread_mutex_lock(&brk_lock) ;
+ if ( !c->broken && (brk_nidle < brk_maxidle) )
+   {
+    c->next  = brk_idle ;
+    brk_idle = c        ;
+    brk_nidle++         ;
+    c = NULL            ;
+   }
+ pthread_mutex_unlock(&brk_lock) ;
+
+ if ( c != NULL )
+   {
+    MQDISC ( &c->hconn, &cc, &rc ) ;
+    free(c) ;
+   }
+
+ return ;
+} // End of brk_release
+
+//
+// brk_open - open an object on a connection for a session, or take one
+//            kept open. Returns its index (-1 if it fails, the CC and RC
+//            set) and the MQOD as opened.
+//
+static int brk_open ( BRKCONN  * c            // The connection
+                    , PMQOD      od           // Object descriptor
+                    , MQLONG     options      // Open options
+                    , PMQLONG    cc           // MQ CC
+                    , PMQLONG    rc           // MQ RC
+                    )
+{
+ MQCHAR48                name             ;  // ObjectName given
+ int                     free_ = -1       ;  // A free slot
+ int                     lru   = -1       ;  // The oldest kept one
+ int                     i                ;  // Looper
+
+ for ( i = 0 ; i < BRKOBJS ; i++ )
+   {
+    BRKOBJ * o = &c->obj[i] ;
+    if ( o->Qh == MQHO_NONE )
+      {
+       if ( free_ < 0 ) free_ = i ;
+       continue ;
+      }
+    if ( o->busy || !o->keep ) continue ;
+    if ( (o->options == options)
+      && (o->od.ObjectType == od->ObjectType)
+      && (o->od.Version == od->Version)
+      && (memcmp(o->od.ObjectName, od->ObjectName, sizeof(MQCHAR48)) == 0)
+      && (memcmp(o->od.ObjectQMgrName, od->ObjectQMgrName, sizeof(MQCHAR48)) == 0) )
+      {
+       o->busy = 1 ;
+       memcpy(od, &o->od, sizeof(MQOD)) ;
+       pthread_mutex_lock(&brk_lock) ;
+       brk_reopen++ ;
+       pthread_mutex_unlock(&brk_lock) ;
+       *cc = MQCC_OK   ;
+       *rc = MQRC_NONE ;
+       return i ;
+      }
+    if ( (lru < 0) || (o->used < c->obj[lru].used) ) lru = i ;
+   }
+
+ if ( free_ < 0 )
+   {
+    if ( lru < 0 )
+      {
+       *cc = MQCC_FAILED               ;
+       *rc = MQRC_HANDLE_NOT_AVAILABLE ;
+       return -1 ;
+      }
+    MQCLOSE ( c->hconn, &c->obj[lru].Qh, MQCO_NONE, cc, rc ) ;
+    c->obj[lru].Qh = MQHO_NONE ;
+    free_ = lru ;
+   }
+
+ memcpy(name, od->ObjectName, sizeof(MQCHAR48)) ;
+ pthread_mutex_lock(&brk_lock) ;
+ brk_opens++ ;
+ pthread_mutex_unlock(&brk_lock) ;
+ MQOPEN ( c->hconn, od, options, &c->obj[free_].Qh, cc, rc ) ;
+ brk_broken(c, *rc) ;
+ if ( *cc == MQCC_FAILED )
+   {
+    c->obj[free_].Qh = MQHO_NONE ;
+    return -1 ;
+   }
+
+ c->obj[free_].options = options ;
+ c->obj[free_].busy    = 1       ;
+ c->obj[free_].keep    = ( od->ObjectType == MQOT_Q )
+                      && ( (options & (MQOO_BROWSE | MQOO_INPUT_EXCLUSIVE | MQOO_ALTERNATE_USER_AUTHORITY)) == 0 )
+                      && ( memcmp(name, od->ObjectName, sizeof(MQCHAR48)) == 0 ) ;
+ memcpy(&c->obj[free_].od, od, sizeof(MQOD)) ;
+
+ return free_ ;
+} // End of brk_open
+
+//
+// brk_obj - the object a session's handle is for (NULL if none, the CC
+//           and RC set)
+//
+static BRKOBJ * brk_obj ( BRKCONN  * c            // The connection
+                        , MQHOBJ     hobj         // The session's handle
+                        , PMQLONG    cc           // MQ CC
+                        , PMQLONG    rc           // MQ RC
+                        )
+{
+ if ( (hobj < 1) || (hobj > BRKOBJS) || (c->obj[hobj-1].Qh == MQHO_NONE) || !c->obj[hobj-1].busy )
+   {
+    *cc = MQCC_FAILED      ;
+    *rc = MQRC_HOBJ_ERROR  ;
+    return NULL ;
+   }
+
+ return &c->obj[hobj-1] ;
+} // End of brk_obj
+
+//
+// Body parsing: brk_take the next part of a request's body (NULL if the
+// body is too short)
+//
+ typedef struct _BRKBODY {
+     char     * p                            ; // Next part
+     size_t     left                         ; // Length left
+ } BRKBODY;
+
+static void * brk_take ( BRKBODY  * b            // The body
+                       , size_t     len          // Length of the part
+                       , void     * to           // Copy it here (or NULL)
+                       )
+{
+ void                  * part = b->p      ;  // The part
+
+ if ( len > b->left ) return NULL ;
+ if ( to != NULL ) memcpy(to, part, len) ;
+ b->p    += len ;
+ b->left -= len ;
+
+ return part ;
+} // End of brk_take
+
+//
+// brk_room - make a session's message buffer at least this big
+//
+static int brk_room ( BRKSESS  * s            // The session
+                    , size_t     len          // Room needed
+                    )
+{
+ char                  * p                ;  // New buffer
+
+ if ( len <= s->buflen ) return 1 ;
+ if ( (p = (char *) realloc(s->buf, len)) == NULL ) return 0 ;
+ s->buf    = p   ;
+ s->buflen = len ;
+
+ return 1 ;
+} // End of brk_room
+
+//
+// Clear what only has meaning in the session's process
+//
+static void brk_od_clear ( PMQOD      od           // Object descriptor
+                         )
+{
+ od->ObjectRecPtr   = NULL ;
+ od->ResponseRecPtr = NULL ;
+ if ( od->Version >= MQOD_VERSION_4 )
+   {
+    memset(&od->ObjectString,    0, sizeof(MQCHARV)) ;
+    memset(&od->SelectionString, 0, sizeof(MQCHARV)) ;
+    memset(&od->ResObjectString, 0, sizeof(MQCHARV)) ;
+   }
+
+ return ;
+} // End of brk_od_clear
+
+static void brk_pmo_clear ( PMQPMO     pmo          // Put message options
+                          )
+{
+ pmo->PutMsgRecPtr      = NULL        ;
+ pmo->ResponseRecPtr    = NULL        ;
+ pmo->OriginalMsgHandle = MQHM_NONE   ;
+ pmo->NewMsgHandle      = MQHM_NONE   ;
+
+ return ;
+} // End of brk_pmo_clear
+
+//
+// brk_request - do one request of a session. Returns -1 if the session
+//               is to end.
+//
+static int brk_request ( BRKSESS  * s            // The session
+                       , uint32_t   op           // BRK_xxx
+                       , BRKBODY  * b            // Its body
+                       )
+{
+ RXMQBRKA                a                ;  // Reply header
+ struct iovec            out[5]           ;  // Reply
+ int                     nout = 1         ;  //   parts
+ BRKCONN               * c = s->c         ;  // The connection
+ BRKOBJ                * o                ;  // An object on it
+ MQCHAR48                qm               ;  // QM name
+ MQCNO                   cno              ;  // Connect options
+ MQCD                    cd               ;  // Client channel
+ MQLONG                  cdlen            ;  //   length
+ MQOD                    od               ;  // Object descriptor
+ MQMD                    md               ;  // Message descriptor
+ MQPMO                   pmo              ;  // Put message options
+ MQGMO                   gmo              ;  // Get message options
+ MQHOBJ                  hobj = 0         ;  // Object handle
+ MQLONG                  options          ;  // Open or close options
+ MQLONG                  datalen          ;  // Data length
+ MQLONG                  buflen           ;  // Buffer length
+ MQLONG                  nsel, nint, nchar ; // MQINQ counts
+ void                  * data             ;  // Data
+ MQLONG                  cc = MQCC_FAILED ;  // MQ CC
+ MQLONG                  rc = MQRC_NONE   ;  // MQ RC
+ int                     i                ;  // Looper
+
+ if ( (op != BRK_CONN) && (c == NULL) ) op = 0 ;   // Not connected yet
+ switch ( op )
+   {
+    case BRK_CONN :
+      if ( c != NULL )
+        {
+         cc = MQCC_WARNING          ;
+         rc = MQRC_ALREADY_CONNECTED ;
+         break ;
+        }
+      if ( (brk_take(b, sizeof(qm), qm) == NULL)
+        || (brk_take(b, sizeof(cno), &cno) == NULL)
+        || (brk_take(b, sizeof(cdlen), &cdlen) == NULL)
+        || ((cdlen != 0) && ((cdlen != sizeof(MQCD)) || (brk_take(b, sizeof(MQCD), &cd) == NULL))) )
+        return -1 ;
+      if ( ((cno.Version >= MQCNO_VERSION_2) && (cno.ClientConnOffset != 0))
+        || ((cno.Version >= MQCNO_VERSION_4) && ((cno.SSLConfigPtr != NULL) || (cno.SSLConfigOffset != 0)))
+        || ((cno.Version >= MQCNO_VERSION_5) && ((cno.SecurityParmsPtr != NULL) || (cno.SecurityParmsOffset != 0)))
+        || ((cno.Version >= MQCNO_VERSION_6) && ((cno.CCDTUrlPtr != NULL) || (cno.CCDTUrlOffset != 0))) )
+        {
+         rc = MQRC_FUNCTION_NOT_SUPPORTED ;
+         break ;
+        }
+      // Any thread may use a kept connection, whatever the session asked
+      cno.Options = ( cno.Options & ~(MQCNO_HANDLE_SHARE_NONE | MQCNO_HANDLE_SHARE_BLOCK | MQCNO_HANDLE_SHARE_NO_BLOCK) )
+                  | MQCNO_HANDLE_SHARE_BLOCK ;
+      if ( cno.Version >= MQCNO_VERSION_2 ) cno.ClientConnPtr = NULL ;
+      if ( cno.Version >= MQCNO_VERSION_3 ) memset(cno.ConnectionId, 0, sizeof(cno.ConnectionId)) ;
+      s->c = brk_connect(qm, &cno, cdlen, &cd, &cc, &rc) ;
+      break ;
+
+    case BRK_DISC :
+      brk_release(c) ;
+      s->c = NULL     ;
+      cc   = MQCC_OK  ;
+      break ;
+
+    case BRK_OPEN :
+      if ( (brk_take(b, sizeof(options), &options) == NULL)
+        || (brk_take(b, sizeof(od), &od) == NULL) )
+        return -1 ;
+      brk_od_clear(&od) ;
+      if ( (od.Version >= MQOD_VERSION_2) && (od.RecsPresent != 0) )
+        {
+         rc = MQRC_FUNCTION_NOT_SUPPORTED ;
+         break ;
+        }
+      if ( (i = brk_open(c, &od, options, &cc, &rc)) >= 0 ) hobj = i + 1 ;
+      brk_od_clear(&od) ;
+      out[1].iov_base = &hobj ; out[1].iov_len = sizeof(MQHOBJ) ;
+      out[2].iov_base = &od   ; out[2].iov_len = sizeof(MQOD)   ;
+      nout = 3 ;
+      break ;
+
+    case BRK_CLOSE :
+      if ( (brk_take(b, sizeof(hobj), &hobj) == NULL)
+        || (brk_take(b, sizeof(options), &options) == NULL) )
+        return -1 ;
+      if ( (o = brk_obj(c, hobj, &cc, &rc)) == NULL ) break ;
+      if ( o->keep && (options == MQCO_NONE) )
+        {
+         o->busy = 0           ;
+         o->used = ++c->tick   ;
+         cc      = MQCC_OK     ;
+         break ;
+        }
+      MQCLOSE ( c->hconn, &o->Qh, options, &cc, &rc ) ;
+      brk_broken(c, rc) ;
+      if ( cc != MQCC_FAILED ) o->Qh = MQHO_NONE ;
+      break ;
+
+    case BRK_PUT :
+    case BRK_PUT1 :
+      if ( op == BRK_PUT ) data = brk_take(b, sizeof(hobj), &hobj) ;
+      else                 data = brk_take(b, sizeof(od), &od)     ;
+      if ( (data == NULL)
+        || (brk_take(b, sizeof(md), &md) == NULL)
+        || (brk_take(b, sizeof(pmo), &pmo) == NULL)
+        || (brk_take(b, sizeof(datalen), &datalen) == NULL)
+        || (datalen < 0)
+        || ((data = brk_take(b, (size_t) datalen, NULL)) == NULL) )
+        return -1 ;
+      brk_pmo_clear(&pmo) ;
+      if ( (pmo.Version >= MQPMO_VERSION_2) && (pmo.RecsPresent != 0) )
+        {
+         rc = MQRC_FUNCTION_NOT_SUPPORTED ;
+         break ;
+        }
+      if ( op == BRK_PUT )
+        {
+         if ( (o = brk_obj(c, hobj, &cc, &rc)) == NULL ) break ;
+         MQPUT ( c->hconn, o->Qh, &md, &pmo, datalen, data, &cc, &rc ) ;
+        }
+      else
+        {
+         brk_od_clear(&od) ;
+         if ( (od.Version >= MQOD_VERSION_2) && (od.RecsPresent != 0) )
+           {
+            rc = MQRC_FUNCTION_NOT_SUPPORTED ;
+            break ;
+           }
+         MQPUT1 ( c->hconn, &od, &md, &pmo, datalen, data, &cc, &rc ) ;
+         brk_od_clear(&od) ;
+         out[nout].iov_base = &od ; out[nout].iov_len = sizeof(MQOD) ; nout++ ;
+        }
+      brk_broken(c, rc) ;
+      if ( (cc != MQCC_FAILED) && (pmo.Options & (MQPMO_SYNCPOINT | MQPMO_SYNCPOINT_IF_PERSISTENT)) ) c->dirty = 1 ;
+      brk_pmo_clear(&pmo) ;
+      out[nout].iov_base = &md  ; out[nout].iov_len = sizeof(MQMD)  ; nout++ ;
+      out[nout].iov_base = &pmo ; out[nout].iov_len = sizeof(MQPMO) ; nout++ ;
+      break ;
+
+    case BRK_GET :
+      if ( (brk_take(b, sizeof(hobj), &hobj) == NULL)
+        || (brk_take(b, sizeof(md), &md) == NULL)
+        || (brk_take(b, sizeof(gmo), &gmo) == NULL)
+        || (brk_take(b, sizeof(buflen), &buflen) == NULL)
+        || (buflen < 0) )
+        return -1 ;
+      datalen = 0 ;
+      if ( gmo.Version >= MQGMO_VERSION_4 ) gmo.MsgHandle = MQHM_NONE ;
+      if ( !brk_room(s, (size_t) buflen + 1) ) rc = MQRC_STORAGE_NOT_AVAILABLE ;
+      else if ( (o = brk_obj(c, hobj, &cc, &rc)) != NULL )
+        {
+         MQGET ( c->hconn, o->Qh, &md, &gmo, buflen, s->buf, &datalen, &cc, &rc ) ;
+         brk_broken(c, rc) ;
+         if ( (cc != MQCC_FAILED) && (gmo.Options & (MQGMO_SYNCPOINT | MQGMO_SYNCPOINT_IF_PERSISTENT)) ) c->dirty = 1 ;
+        }
+      if ( gmo.Version >= MQGMO_VERSION_4 ) gmo.MsgHandle = MQHM_NONE ;
+      out[1].iov_base = &md      ; out[1].iov_len = sizeof(MQMD)   ;
+      out[2].iov_base = &gmo     ; out[2].iov_len = sizeof(MQGMO)  ;
+      out[3].iov_base = &datalen ; out[3].iov_len = sizeof(MQLONG) ;
+      out[4].iov_base = s->buf   ;
+      out[4].iov_len  = ( cc == MQCC_FAILED ) ? 0 : (size_t)( (datalen < buflen) ? datalen : buflen ) ;
+      nout = 5 ;
+      break ;
+
+    case BRK_INQ :
+      if ( (brk_take(b, sizeof(hobj), &hobj) == NULL)
+        || (brk_take(b, sizeof(nsel), &nsel) == NULL)
+        || (brk_take(b, sizeof(nint), &nint) == NULL)
+        || (brk_take(b, sizeof(nchar), &nchar) == NULL)
+        || (nsel < 0) || (nint < 0) || (nchar < 0) || (nchar > BRK_MAXBODY)
+        || ((size_t) nsel * sizeof(MQLONG) != b->left)
+        || ((size_t) nint > (BRK_MAXBODY - (size_t) nchar) / sizeof(MQLONG)) )
+        return -1 ;
+      if ( !brk_room(s, (size_t) nint * sizeof(MQLONG) + (size_t) nchar + 1) ) return -1 ;
+      memset(s->buf, 0, (size_t) nint * sizeof(MQLONG) + (size_t) nchar) ;
+      if ( (o = brk_obj(c, hobj, &cc, &rc)) != NULL )
+        {
+         MQINQ ( c->hconn, o->Qh, nsel, (PMQLONG) b->p
+               , nint, (PMQLONG) s->buf, nchar, s->buf + (size_t) nint * sizeof(MQLONG)
+               , &cc, &rc ) ;
+         brk_broken(c, rc) ;
+        }
+      out[1].iov_base = s->buf ;
+      out[1].iov_len  = (size_t) nint * sizeof(MQLONG) + (size_t) nchar ;
+      nout = 2 ;
+      break ;
+
+    case BRK_CMIT :
+    case BRK_BACK :
+      if ( op == BRK_CMIT ) MQCMIT ( c->hconn, &cc, &rc ) ;
+      else                  MQBACK ( c->hconn, &cc, &rc ) ;
+      brk_broken(c, rc) ;
+      if ( cc != MQCC_FAILED ) c->dirty = 0 ;
+      break ;
+
+    default :
+      rc = ( c == NULL ) ? MQRC_HCONN_ERROR : MQRC_FUNCTION_NOT_SUPPORTED ;
+      break ;
+   }
+
+ a.cc     = cc ;
+ a.rc     = rc ;
+ a.length = 0  ;
+ for ( i = 1 ; i < nout ; i++ ) a.length += (uint32_t) out[i].iov_len ;
+ out[0].iov_base = &a        ;
+ out[0].iov_len  = sizeof(a) ;
+
+ return brk_writev(s->fd, out, nout) ;
+} // End of brk_request
+
+//
+// brk_session - serve the requests of one MA95 connection until it
+//               closes its socket
+//
+static void * brk_session ( void     * arg          // Its socket
+                          )
+{
+ BRKSESS                 s                ;  // The session
+ RXMQBRKQ                q                ;  // A request header
+ BRKBODY                 b                ;  // Its body
+ char                  * p                ;  // New body buffer
+
+ memset(&s, 0, sizeof(s))   ;
+ s.fd = (int)(intptr_t) arg ;
+ while ( brk_read(s.fd, &q, sizeof(q)) == 0 )
+   {
+    if ( q.length > BRK_MAXBODY ) break ;
+    if ( q.length + 1 > s.bodylen )
+      {
+       if ( (p = (char *) realloc(s.body, q.length + 1)) == NULL ) break ;
+       s.body    = p            ;
+       s.bodylen = q.length + 1 ;
+      }
+    if ( brk_read(s.fd, s.body, q.length) != 0 ) break ;
+    b.p    = s.body   ;
+    b.left = q.length ;
+    if ( brk_request(&s, q.op, &b) != 0 ) break ;
+   }
+
+ if ( s.c != NULL ) brk_release(s.c) ;
+ close(s.fd) ;
+ free(s.body) ;
+ free(s.buf)  ;
+
+ return NULL ;
+} // End of brk_session
+
+//
+// brk_signals - end on SIGINT or SIGTERM, closing the kept connections
+//
+static void * brk_signals ( void     * arg          // Signals waited for
+                          )
+{
+ BRKCONN               * c                ;  // A kept connection
+ MQLONG                  cc               ;  // MQ CC
+ MQLONG                  rc               ;  // MQ RC
+ int                     sig              ;  // Signal
+
+ sigwait((sigset_t *) arg, &sig) ;
+ unlink(brk_path) ;
+
+ pthread_mutex_lock(&brk_lock) ;
+ printf("rxmqbrkr: %lu connections made, %lu reused, %lu opens, %lu reused\n"
+       , brk_conns, brk_reconn, brk_opens, brk_reopen) ;
+ fflush(stdout) ;
+ brk_maxidle = 0 ;
+ while ( (c = brk_idle) != NULL )
+   {
+    brk_idle = c->next ;
+    MQDISC ( &c->hconn, &cc, &rc ) ;
+    free(c) ;
+   }
+ exit(0) ;
+
+ return NULL ;
+} // End of brk_signals
+
+static void brk_usage ( void )
+{
+ fprintf(stderr, "usage: rxmqbrkr [-s socket] [-n idle] [-c QM]... [-o queue[,options]]...\n") ;
+ exit(2) ;
+} // End of brk_usage
+
+int main ( int argc, char ** argv )
+{
+ struct sockaddr_un      sa               ;  // Socket address
+ static sigset_t         sigs             ;  // SIGINT and SIGTERM
+ pthread_attr_t          attr             ;  // Detached threads
+ pthread_t               tid              ;  // A thread
+ const char            * qms[BRKIDLE*4]   ;  // -c QMs
+ const char            * qs[BRKOBJS]      ;  // -o queues
+ int                     nqm = 0, nq = 0  ;  //   how many
+ BRKCONN               * c                ;  // A connection
+ MQCNO                   cno = {MQCNO_DEFAULT} ; // Connect options
+ MQCHAR48                qm               ;  // QM name
+ MQOD                    od               ;  // Object descriptor
+ MQOD                    od_default = {MQOD_DEFAULT} ; // An initial one
+ MQLONG                  options          ;  // Open options
+ MQLONG                  cc               ;  // MQ CC
+ MQLONG                  rc               ;  // MQ RC
+ char                  * comma            ;  // In -o
+ size_t                  len              ;  //   name length
+ int                     fd, sfd          ;  // Sockets
+ int                     i, j             ;  // Loopers
+
+ brk_path = getenv("RXMQBROKER") ;
+ if ( (brk_path == NULL) || (*brk_path == '\0') ) brk_path = BRK_SOCKET ;
+ for ( i = 1 ; i < argc ; i++ )
+   {
+    if ( (argv[i][0] != '-') || (argv[i][1] == '\0') || (argv[i][2] != '\0') || (i + 1 >= argc) ) brk_usage() ;
+    switch ( argv[i++][1] )
+      {
+       case 's' : brk_path = argv[i] ;                                      break ;
+       case 'n' : brk_maxidle = atoi(argv[i]) ;                             break ;
+       case 'c' : if ( nqm < (int)(sizeof(qms)/sizeof(qms[0])) ) qms[nqm++] = argv[i] ; break ;
+       case 'o' : if ( nq  < BRKOBJS ) qs[nq++] = argv[i] ;                 break ;
+       default  : brk_usage() ;
+      }
+   }
+
+ // Any thread may use a kept connection (as in brk_request)
+ cno.Options = ( cno.Options & ~(MQCNO_HANDLE_SHARE_NONE | MQCNO_HANDLE_SHARE_BLOCK | MQCNO_HANDLE_SHARE_NO_BLOCK) )
+             | MQCNO_HANDLE_SHARE_BLOCK ;
+ for ( i = 0 ; i < nqm ; i++ )
+   {
+    if ( strlen(qms[i]) > sizeof(qm) )
+      {
+       fprintf(stderr, "rxmqbrkr: QM name %s is too long\n", qms[i]) ;
+       continue ;
+      }
+    memset(qm, 0, sizeof(qm))           ;
+    memcpy(qm, qms[i], strlen(qms[i]))  ;
+    if ( (c = brk_connect(qm, &cno, 0, NULL, &cc, &rc)) == NULL )
+      {
+       fprintf(stderr, "rxmqbrkr: MQCONNX %s failed, reason %d\n", qms[i], (int) rc) ;
+       continue ;
+      }
+    for ( j = 0 ; j < nq ; j++ )
+      {
+       memcpy(&od, &od_default, sizeof(MQOD)) ;
+       options = MQOO_OUTPUT             ;
+       if ( (comma = strchr(qs[j], ',')) != NULL ) options = (MQLONG) strtol(comma + 1, NULL, 0) ;
+       len = strcspn(qs[j], ",")         ;
+       if ( len > sizeof(od.ObjectName) )
+         {
+          fprintf(stderr, "rxmqbrkr: queue name %.*s is too long\n", (int) len, qs[j]) ;
+          continue ;
+         }
+       memset(od.ObjectName, 0, sizeof(od.ObjectName)) ;
+       memcpy(od.ObjectName, qs[j], len) ;
+       if ( brk_open(c, &od, options, &cc, &rc) < 0 )
+         fprintf(stderr, "rxmqbrkr: MQOPEN %s on %s failed, reason %d\n", qs[j], qms[i], (int) rc) ;
+      }
+    brk_release(c) ;
+   }
+
+ signal(SIGPIPE, SIG_IGN)    ;
+ sigemptyset(&sigs)          ;
+ sigaddset(&sigs, SIGINT)    ;
+ sigaddset(&sigs, SIGTERM)   ;
+ pthread_sigmask(SIG_BLOCK, &sigs, NULL) ;
+ pthread_attr_init(&attr)    ;
+ pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) ;
+
+ memset(&sa, 0, sizeof(sa))                            ;
+ sa.sun_family = AF_UNIX                               ;
+ strncpy(sa.sun_path, brk_path, sizeof(sa.sun_path)-1) ;
+ unlink(brk_path)                                      ;
+ if ( ((sfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+   || (bind(sfd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+   || (listen(sfd, 64) != 0) )
+   {
+    fprintf(stderr, "rxmqbrkr: cannot listen on %s: %s\n", brk_path, strerror(errno)) ;
+    return 1 ;
+   }
+ pthread_create(&tid, &attr, brk_signals, &sigs) ;
+ printf("rxmqbrkr: listening on %s\n", brk_path) ;
+ fflush(stdout) ;
+
+ for ( ;; )
+   {
+    if ( (fd = accept(sfd, NULL, NULL)) < 0 )
+      {
+       if ( errno == EINTR ) continue ;
+       fprintf(stderr, "rxmqbrkr: accept failed: %s\n", strerror(errno)) ;
+       return 1 ;
+      }
+    if ( pthread_create(&tid, &attr, brk_session, (void *)(intptr_t) fd) != 0 ) close(fd) ;
+   }
+
+ return 0 ;
+} // End of main
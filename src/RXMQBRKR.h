@@ -0,0 +1,138 @@
+//
+// RXMQBRKR.h - The protocol between MA95 (built with RXMQ_BROKER) and
+//              the rxmqbrkr connection broker, over a UNIX domain socket
+//
+//   Each MQ connection of a broker mode MA95 is a socket to the broker,
+//   which does the MQ calls on one of its own connections, kept with
+//   the queues opened on it once the script has finished with them.
+//
+//   A request is an RXMQBRKQ header and its body, and the reply an
+//   RXMQBRKA header (the MQ CC and RC) and its body. Both ends are on
+//   one machine and built with the same MQ headers, so MQ structures
+//   are sent as they are, the broker clearing their pointers and message
+//   handles (distribution lists and object strings are refused).
+//
+//        Request (body)                    Reply (body)
+//
+//   CONN  MQCHAR48 QM, MQCNO, MQLONG       -
+//         CD length, [MQCD]
+//   DISC  -                                -
+//   OPEN  MQLONG options, MQOD             MQHOBJ, MQOD
+//   CLOSE MQHOBJ, MQLONG options           -
+//   PUT   MQHOBJ, MQMD, MQPMO,             MQMD, MQPMO
+//         MQLONG length, data
+//   PUT1  MQOD, MQMD, MQPMO,               MQOD, MQMD, MQPMO
+//         MQLONG length, data
+//   GET   MQHOBJ, MQMD, MQGMO,             MQMD, MQGMO, MQLONG length,
+//         MQLONG buffer length             data (up to buffer length)
+//   INQ   MQHOBJ, MQLONG selectors, int    MQLONG int attrs[],
+//         attrs, char length, selectors[]  char attrs
+//   CMIT  -                                -
+//   BACK  -                                -
+//
+
+#ifndef RXMQBRKR_H
+#define RXMQBRKR_H
+
+ #include <stdint.h>
+ #include <string.h>
+ #include <errno.h>
+ #include <unistd.h>
+ #include <sys/socket.h>
+ #include <sys/uio.h>
+
+ #define BRK_SOCKET  "/tmp/rxmqbrkr.sock"   // Socket if RXMQBROKER names none
+
+ #define BRK_CONN    1
+ #define BRK_DISC    2
+ #define BRK_OPEN    3
+ #define BRK_CLOSE   4
+ #define BRK_PUT     5
+ #define BRK_PUT1    6
+ #define BRK_GET     7
+ #define BRK_INQ     8
+ #define BRK_CMIT    9
+ #define BRK_BACK    10
+
+ #define BRK_MAXBODY 0x7FFFFFF0 // Largest body (above any MQ message)
+
+ typedef struct _RXMQBRKQ {
+     uint32_t   length                       ; // Body length
+     uint32_t   op                           ; // BRK_xxx
+ } RXMQBRKQ;
+
+ typedef struct _RXMQBRKA {
+     uint32_t   length                       ; // Body length
+     MQLONG     cc                           ; // MQ CC
+     MQLONG     rc                           ; // MQ RC
+ } RXMQBRKA;
+
+//
+// brk_writev - write all of the parts given to the socket (there is no
+//              SIGPIPE where MSG_NOSIGNAL is known). Returns -1 if they
+//              could not be.
+//
+ #ifdef MSG_NOSIGNAL
+  #define BRK_NOSIGNAL MSG_NOSIGNAL
+ #else
+  #define BRK_NOSIGNAL 0
+ #endif
+
+static int brk_writev ( int        fd           // Socket
+                      , struct iovec * iov      // Parts (updated)
+                      , int        n            //   how many
+                      )
+{
+ struct msghdr           mh               ;  // For sendmsg
+ ssize_t                 w                ;  // Written
+
+ while ( (n > 0) && (iov->iov_len == 0) ) { iov++ ; n-- ; }
+ while ( n > 0 )
+   {
+    memset(&mh, 0, sizeof(mh)) ;
+    mh.msg_iov    = iov ;
+    mh.msg_iovlen = n   ;
+    w = sendmsg(fd, &mh, BRK_NOSIGNAL) ;
+    if ( (w < 0) && (errno == EINTR) ) continue ;
+    if ( w <= 0 ) return -1 ;
+    while ( (n > 0) && ((size_t) w >= iov->iov_len) )
+      {
+       w -= (ssize_t) iov->iov_len ;
+       iov++ ;
+       n--   ;
+      }
+    if ( n > 0 )
+      {
+       iov->iov_base = (char *) iov->iov_base + w ;
+       iov->iov_len -= (size_t) w ;
+      }
+   }
+
+ return 0 ;
+} // End of brk_writev
+
+//
+// brk_read - read a whole buffer from the socket. Returns -1 if it ends
+//            or fails first.
+//
+static int brk_read ( int        fd           // Socket
+                    , void     * buf          // Buffer
+                    , size_t     len          // Length wanted
+                    )
+{
+ char                  * p = (char *) buf ;  //-> room left
+ ssize_t                 n                ;  // Read
+
+ while ( len > 0 )
+   {
+    n = read(fd, p, len) ;
+    if ( (n < 0) && (errno == EINTR) ) continue ;
+    if ( n <= 0 ) return -1 ;
+    p   += n ;
+    len -= (size_t) n ;
+   }
+
+ return 0 ;
+} // End of brk_read
+
+#endif
@@ -0,0 +1,636 @@
+//
+// RXMQMEM.c - An in-memory stand-in for the MQI, to measure MA95 and the
+//             rxmqbrkr connection broker without a queue manager
+//
+//   Linked in place of the MQ library, it holds the queues of the process
+//   in memory: any queue name can be opened (and is made when first
+//   opened), a name with MODEL in it and a DynamicQName given opens a new
+//   queue of that name ('*' made unique). MQPUT and MQPUT1 add messages
+//   (with new MsgIds, and CorrelIds if asked) and MQGET takes or browses
+//   them, matching MsgId and CorrelId, waiting if asked to. Syncpoint is
+//   not kept: MQCMIT and MQBACK do nothing. MQINQ knows a queue's depth,
+//   type, name, description and largest message; MQSET, MQSUB, MQCB,
+//   MQCTL and MQSTAT fail with MQRC_FUNCTION_NOT_SUPPORTED.
+//
+//   What an MQCONN(X) and MQOPEN cost a real queue manager is made up by
+//   waiting RXMQMEM_CONN_US and RXMQMEM_OPEN_US microseconds (default 0).
+//
+
+ #include <string.h>
+ #include <stdlib.h>
+ #include <stdio.h>
+ #include <errno.h>
+ #include <pthread.h>
+ #include <sys/time.h>
+ #include <time.h>
+
+ #include <cmqc.h>
+ #include <cmqxc.h>
+
+ #define MEMHOBJS  1024   // Objects open at once
+ #define MEMHCONNS 1024   // Connections at once
+
+ typedef struct _MEMMSG {
+     struct _MEMMSG * next                   ; // Next on the queue
+     uint64_t   seq                          ; // Order put (for browse)
+     MQMD       md                           ; // Its descriptor
+     MQLONG     length                       ; // Data length
+     char       data[1]                      ; // Data
+ } MEMMSG;
+
+ typedef struct _MEMQ {
+     struct _MEMQ * next                     ; // Next queue
+     MQCHAR48   name                         ; // Queue name
+     MEMMSG   * first                        ; // Messages
+     MEMMSG   * last                         ; //   the last
+     MQLONG     depth                        ; //   how many
+ } MEMQ;
+
+ typedef struct _MEMOBJ {
+     MEMQ     * q                            ; // The queue (NULL free)
+     MQHCONN    hconn                        ; // Opened on
+     MQLONG     options                      ; // Open options
+     uint64_t   cursor                       ; // Browse cursor (seq)
+ } MEMOBJ;
+
+ static pthread_mutex_t mem_lock = PTHREAD_MUTEX_INITIALIZER ; // Guards all
+ static pthread_cond_t  mem_cond = PTHREAD_COND_INITIALIZER  ; // A message put
+ static MEMQ          * mem_qs   = NULL      ;  // Queues
+ static MEMOBJ          mem_obj[MEMHOBJS]    ;  // Objects (MQHOBJ n+1)
+ static char            mem_conn[MEMHCONNS]  ;  // Connections (MQHCONN n+1)
+ static uint64_t        mem_seq  = 0         ;  // Messages put
+ static unsigned long   mem_dyn  = 0         ;  // Dynamic queues made
+
+//
+// mem_wait - wait the time an env var says
+//
+static void mem_wait ( const char * var       // Env var
+                     )
+{
+ const char            * v = getenv(var)  ;  // Microseconds
+ struct timespec         ts               ;  // To wait
+ long                    us               ;  //   in microseconds
+
+ if ( (v == NULL) || ((us = atol(v)) <= 0) ) return ;
+ ts.tv_sec  = us / 1000000 ;
+ ts.tv_nsec = (us % 1000000) * 1000 ;
+ while ( (nanosleep(&ts, &ts) != 0) && (errno == EINTR) ) ;
+
+ return ;
+} // End of mem_wait
+
+//
+// mem_queue - a queue by name, made if it is not there (mem_lock held)
+//
+static MEMQ * mem_queue ( PMQCHAR    name         // Queue name
+                        )
+{
+ MEMQ                  * q                ;  // The queue
+
+ for ( q = mem_qs ; q != NULL ; q = q->next )
+   if ( strncmp(q->name, name, sizeof(MQCHAR48)) == 0 ) return q ;
+ if ( (q = (MEMQ *) calloc(1, sizeof(MEMQ))) == NULL ) return NULL ;
+ strncpy(q->name, name, sizeof(MQCHAR48)) ;
+ q->next = mem_qs ;
+ mem_qs  = q      ;
+
+ return q ;
+} // End of mem_queue
+
+//
+// mem_get_obj - the object of a handle (NULL if not one, RC set)
+//
+static MEMOBJ * mem_get_obj ( MQHCONN    hconn        // Connection handle
+                            , MQHOBJ     hobj         // Object handle
+                            , PMQLONG    cc           // MQ CC
+                            , PMQLONG    rc           // MQ RC
+                            )
+{
+ *cc = MQCC_FAILED ;
+ if ( (hconn < 1) || (hconn > MEMHCONNS) || !mem_conn[hconn-1] )
+   {
+    *rc = MQRC_HCONN_ERROR ;
+    return NULL ;
+   }
+ if ( (hobj < 1) || (hobj > MEMHOBJS) || (mem_obj[hobj-1].q == NULL) || (mem_obj[hobj-1].hconn != hconn) )
+   {
+    *rc = MQRC_HOBJ_ERROR ;
+    return NULL ;
+   }
+ *cc = MQCC_OK   ;
+ *rc = MQRC_NONE ;
+
+ return &mem_obj[hobj-1] ;
+} // End of mem_get_obj
+
+//
+// mem_stamp - make an id unique
+//
+static void mem_stamp ( PMQBYTE    id           // MsgId or CorrelId
+                      )
+{
+ static const char       tag[8] = "RXMQMEM " ; // What made it
+ uint64_t                n = ++mem_seq    ;  // Unique part
+
+ memset(id, 0, MQ_MSG_ID_LENGTH)   ;
+ memcpy(id, tag, sizeof(tag))      ;
+ memcpy(id + sizeof(tag), &n, sizeof(n)) ;
+
+ return ;
+} // End of mem_stamp
+
+//
+// mem_put - put a message on a queue (mem_lock held)
+//
+static void mem_put ( MEMQ     * q            // The queue
+                    , PMQMD      md           // Message descriptor
+                    , PMQPMO     pmo          // Put message options
+                    , MQLONG     datalen      // Data length
+                    , PMQVOID    data         // Data
+                    , PMQLONG    cc           // MQ CC
+                    , PMQLONG    rc           // MQ RC
+                    )
+{
+ MEMMSG                * m                ;  // The message
+ struct timeval          tv               ;  // Time put
+ struct tm               tm               ;  //   split
+ char                    stamp[80]        ;  //   as PutDate and PutTime
+ MQMD                    md2 = {MQMD_DEFAULT} ; // Descriptor (all versions)
+
+ if ( (datalen < 0) || ((datalen > 0) && (data == NULL)) )
+   {
+    *cc = MQCC_FAILED          ;
+    *rc = MQRC_DATA_LENGTH_ERROR ;
+    return ;
+   }
+ if ( (m = (MEMMSG *) malloc(sizeof(MEMMSG) + (size_t) datalen)) == NULL )
+   {
+    *cc = MQCC_FAILED                ;
+    *rc = MQRC_STORAGE_NOT_AVAILABLE ;
+    return ;
+   }
+
+ memcpy(&md2, md, ( md->Version >= MQMD_VERSION_2 ) ? sizeof(MQMD) : sizeof(MQMD1)) ;
+ if ( (pmo->Options & MQPMO_NEW_MSG_ID) || (memcmp(md2.MsgId, MQMI_NONE, MQ_MSG_ID_LENGTH) == 0) )
+   mem_stamp(md2.MsgId) ;
+ if ( pmo->Options & MQPMO_NEW_CORREL_ID ) mem_stamp(md2.CorrelId) ;
+ gettimeofday(&tv, NULL) ;
+ gmtime_r(&tv.tv_sec, &tm) ;
+ snprintf(stamp, sizeof(stamp), "%04d%02d%02d%02d%02d%02d%02d"
+         , tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday
+         , tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(tv.tv_usec / 10000)) ;
+ memcpy(md2.PutDate, stamp,     sizeof(md2.PutDate)) ;
+ memcpy(md2.PutTime, stamp + 8, sizeof(md2.PutTime)) ;
+ memcpy(md, &md2, ( md->Version >= MQMD_VERSION_2 ) ? sizeof(MQMD) : sizeof(MQMD1)) ;
+
+ memcpy(&m->md, &md2, sizeof(MQMD)) ;
+ m->length = datalen ;
+ m->seq    = ++mem_seq ;
+ m->next   = NULL    ;
+ if ( datalen > 0 ) memcpy(m->data, data, (size_t) datalen) ;
+ if ( q->last != NULL ) q->last->next = m ;
+ else                   q->first      = m ;
+ q->last = m ;
+ q->depth++  ;
+ pthread_cond_broadcast(&mem_cond) ;
+
+ *cc = MQCC_OK   ;
+ *rc = MQRC_NONE ;
+
+ return ;
+} // End of mem_put
+
+void MQCONNX ( PMQCHAR    qmname       // QM name
+             , PMQCNO     cnop         // Connect options
+             , PMQHCONN   hconn        // Connection handle
+             , PMQLONG    cc           // MQ CC
+             , PMQLONG    rc           // MQ RC
+             )
+{
+ int                     i                ;  // Looper
+
+ (void) qmname ;
+ (void) cnop   ;
+ mem_wait("RXMQMEM_CONN_US") ;
+ pthread_mutex_lock(&mem_lock) ;
+ for ( i = 0 ; (i < MEMHCONNS) && mem_conn[i] ; i++ ) ;
+ if ( i < MEMHCONNS )
+   {
+    mem_conn[i] = 1       ;
+    *hconn = i + 1        ;
+    *cc    = MQCC_OK      ;
+    *rc    = MQRC_NONE    ;
+   }
+ else
+   {
+    *cc = MQCC_FAILED                  ;
+    *rc = MQRC_MAX_CONNS_LIMIT_REACHED ;
+   }
+ pthread_mutex_unlock(&mem_lock) ;
+
+ return ;
+} // End of MQCONNX
+
+void MQCONN ( PMQCHAR    qmname       // QM name
+            , PMQHCONN   hconn        // Connection handle
+            , PMQLONG    cc           // MQ CC
+            , PMQLONG    rc           // MQ RC
+            )
+{
+ MQCNO                   cno = {MQCNO_DEFAULT} ; // Connect options
+
+ MQCONNX ( qmname, &cno, hconn, cc, rc ) ;
+
+ return ;
+} // End of MQCONN
+
+void MQDISC ( PMQHCONN   hconn        // Connection handle
+            , PMQLONG    cc           // MQ CC
+            , PMQLONG    rc           // MQ RC
+            )
+{
+ int                     i                ;  // Looper
+
+ pthread_mutex_lock(&mem_lock) ;
+ if ( (*hconn < 1) || (*hconn > MEMHCONNS) || !mem_conn[*hconn-1] )
+   {
+    *cc = MQCC_FAILED      ;
+    *rc = MQRC_HCONN_ERROR ;
+   }
+ else
+   {
+    for ( i = 0 ; i < MEMHOBJS ; i++ )
+      if ( mem_obj[i].hconn == *hconn ) mem_obj[i].q = NULL ;
+    mem_conn[*hconn-1] = 0    ;
+    *hconn = MQHC_UNUSABLE_HCONN ;
+    *cc    = MQCC_OK          ;
+    *rc    = MQRC_NONE        ;
+   }
+ pthread_mutex_unlock(&mem_lock) ;
+
+ return ;
+} // End of MQDISC
+
+void MQOPEN ( MQHCONN    hconn        // Connection handle
+            , PMQVOID    odp          // Object descriptor
+            , MQLONG     options      // Open options
+            , PMQHOBJ    hobj         // Object handle
+            , PMQLONG    cc           // MQ CC
+            , PMQLONG    rc           // MQ RC
+            )
+{
+ PMQOD                   od = (PMQOD) odp ;  // Object descriptor
+ MQCHAR48                name             ;  // Queue to open
+ char                    zname[49]        ;  //   as a string
+ char                  * star             ;  // In DynamicQName
+ char                    num[24]          ;  // Unique part of it
+ int                     i                ;  // Looper
+
+ mem_wait("RXMQMEM_OPEN_US") ;
+ pthread_mutex_lock(&mem_lock) ;
+ *cc = MQCC_FAILED ;
+ if ( (hconn < 1) || (hconn > MEMHCONNS) || !mem_conn[hconn-1] ) *rc = MQRC_HCONN_ERROR ;
+ else if ( od->ObjectType != MQOT_Q )                             *rc = MQRC_OBJECT_TYPE_ERROR ;
+ else
+   {
+    memcpy(name, od->ObjectName, sizeof(name)) ;
+    memcpy(zname, name, sizeof(name)) ;
+    zname[sizeof(name)] = '\0'        ;
+    if ( (strstr(zname, "MODEL") != NULL) && (od->DynamicQName[0] != ' ') && (od->DynamicQName[0] != '\0') )
+      {
+       memcpy(name, od->DynamicQName, sizeof(name)) ;
+       if ( (star = memchr(name, '*', sizeof(name))) != NULL )
+         {
+          snprintf(num, sizeof(num), "%lu", ++mem_dyn) ;
+          memset(star, ' ', sizeof(name) - (size_t)(star - name)) ;
+          memcpy(star, num, ( strlen(num) < sizeof(name) - (size_t)(star - name) )
+                            ? strlen(num) : sizeof(name) - (size_t)(star - name)) ;
+         }
+      }
+    for ( i = 0 ; (i < MEMHOBJS) && (mem_obj[i].q != NULL) ; i++ ) ;
+    if ( i >= MEMHOBJS ) *rc = MQRC_HANDLE_NOT_AVAILABLE ;
+    else if ( (mem_obj[i].q = mem_queue(name)) == NULL ) *rc = MQRC_STORAGE_NOT_AVAILABLE ;
+    else
+      {
+       mem_obj[i].hconn   = hconn   ;
+       mem_obj[i].options = options ;
+       mem_obj[i].cursor  = 0       ;
+       memcpy(od->ObjectName, name, sizeof(name)) ;
+       if ( od->Version >= MQOD_VERSION_3 )
+         {
+          memcpy(od->ResolvedQName, name, sizeof(name)) ;
+          memset(od->ResolvedQMgrName, ' ', sizeof(od->ResolvedQMgrName)) ;
+         }
+       *hobj = i + 1     ;
+       *cc   = MQCC_OK   ;
+       *rc   = MQRC_NONE ;
+      }
+   }
+ pthread_mutex_unlock(&mem_lock) ;
+
+ return ;
+} // End of MQOPEN
+
+void MQCLOSE ( MQHCONN    hconn        // Connection handle
+             , PMQHOBJ    hobj         // Object handle
+             , MQLONG     options      // Close options
+             , PMQLONG    cc           // MQ CC
+             , PMQLONG    rc           // MQ RC
+             )
+{
+ MEMOBJ                * o                ;  // The object
+
+ (void) options ;
+ pthread_mutex_lock(&mem_lock) ;
+ if ( (o = mem_get_obj(hconn, *hobj, cc, rc)) != NULL )
+   {
+    o->q  = NULL ;
+    *hobj = MQHO_UNUSABLE_HOBJ ;
+   }
+ pthread_mutex_unlock(&mem_lock) ;
+
+ return ;
+} // End of MQCLOSE
+
+void MQPUT ( MQHCONN    hconn        // Connection handle
+           , MQHOBJ     hobj         // Object handle
+           , PMQVOID    mdp          // Message descriptor
+           , PMQVOID    pmop         // Put message options
+           , MQLONG     datalen      // Data length
+           , PMQVOID    data         // Data
+           , PMQLONG    cc           // MQ CC
+           , PMQLONG    rc           // MQ RC
+           )
+{
+ MEMOBJ                * o                ;  // The object
+
+ pthread_mutex_lock(&mem_lock) ;
+ if ( (o = mem_get_obj(hconn, hobj, cc, rc)) != NULL )
+   {
+    if ( !(o->options & MQOO_OUTPUT) )
+      {
+       *cc = MQCC_FAILED            ;
+       *rc = MQRC_NOT_OPEN_FOR_OUTPUT ;
+      }
+    else mem_put(o->q, (PMQMD) mdp, (PMQPMO) pmop, datalen, data, cc, rc) ;
+   }
+ pthread_mutex_unlock(&mem_lock) ;
+
+ return ;
+} // End of MQPUT
+
+void MQPUT1 ( MQHCONN    hconn        // Connection handle
+            , PMQVOID    odp          // Object descriptor
+            , PMQVOID    mdp          // Message descriptor
+            , PMQVOID    pmop         // Put message options
+            , MQLONG     datalen      // Data length
+            , PMQVOID    data         // Data
+            , PMQLONG    cc           // MQ CC
+            , PMQLONG    rc           // MQ RC
+            )
+{
+ MQHOBJ                  hobj             ;  // Object handle
+
+ MQOPEN ( hconn, odp, MQOO_OUTPUT, &hobj, cc, rc ) ;
+ if ( *cc == MQCC_FAILED ) return ;
+ MQPUT ( hconn, hobj, mdp, pmop, datalen, data, cc, rc ) ;
+ pthread_mutex_lock(&mem_lock) ;
+ mem_obj[hobj-1].q = NULL ;
+ pthread_mutex_unlock(&mem_lock) ;
+
+ return ;
+} // End of MQPUT1
+
+void MQGET ( MQHCONN    hconn        // Connection handle
+           , MQHOBJ     hobj         // Object handle
+           , PMQVOID    mdp          // Message descriptor
+           , PMQVOID    gmop         // Get message options
+           , MQLONG     buflen       // Buffer length
+           , PMQVOID    buf          // Buffer
+           , PMQLONG    datalen      // Message length
+           , PMQLONG    cc           // MQ CC
+           , PMQLONG    rc           // MQ RC
+           )
+{
+ PMQMD                   md   = (PMQMD)  mdp  ;  // Message descriptor
+ PMQGMO                  gmo  = (PMQGMO) gmop ;  // Get message options
+ MEMOBJ                * o                ;  // The object
+ MEMMSG                * m                ;  // A message
+ MEMMSG               ** pm               ;  //   where it is held
+ MEMMSG               ** pprev = NULL     ;  //   the one under the cursor
+ MQLONG                  match            ;  // Match options
+ MQLONG                  browse           ;  // Browse (not take)
+ struct timeval          tv               ;  // Now
+ struct timespec         until            ;  // End of the wait
+ size_t                  mdlen            ;  // Descriptor length
+
+ mdlen  = ( md->Version >= MQMD_VERSION_2 ) ? sizeof(MQMD) : sizeof(MQMD1) ;
+ match  = ( gmo->Version >= MQGMO_VERSION_2 ) ? gmo->MatchOptions : (MQMO_MATCH_MSG_ID | MQMO_MATCH_CORREL_ID) ;
+ browse = gmo->Options & (MQGMO_BROWSE_FIRST | MQGMO_BROWSE_NEXT | MQGMO_BROWSE_MSG_UNDER_CURSOR) ;
+ if ( gmo->Options & MQGMO_WAIT )
+   {
+    gettimeofday(&tv, NULL) ;
+    until.tv_sec  = tv.tv_sec  + ( gmo->WaitInterval / 1000 ) ;
+    until.tv_nsec = tv.tv_usec * 1000 + ( gmo->WaitInterval % 1000 ) * 1000000 ;
+    if ( until.tv_nsec >= 1000000000 )
+      {
+       until.tv_sec++ ;
+       until.tv_nsec -= 1000000000 ;
+      }
+   }
+
+ pthread_mutex_lock(&mem_lock) ;
+ for ( ;; )
+   {
+    if ( (o = mem_get_obj(hconn, hobj, cc, rc)) == NULL ) break ;
+    if ( !(o->options & (browse ? MQOO_BROWSE : (MQOO_INPUT_AS_Q_DEF | MQOO_INPUT_SHARED | MQOO_INPUT_EXCLUSIVE))) )
+      {
+       *cc = MQCC_FAILED ;
+       *rc = browse ? MQRC_NOT_OPEN_FOR_BROWSE : MQRC_NOT_OPEN_FOR_INPUT ;
+       break ;
+      }
+    for ( pm = &o->q->first ; (m = *pm) != NULL ; pm = &m->next )
+      {
+       if ( gmo->Options & (MQGMO_MSG_UNDER_CURSOR | MQGMO_BROWSE_MSG_UNDER_CURSOR) )
+         {
+          if ( m->seq == o->cursor ) break ;
+          continue ;
+         }
+       if ( (gmo->Options & MQGMO_BROWSE_NEXT) && (m->seq <= o->cursor) ) continue ;
+       if ( (match & MQMO_MATCH_MSG_ID) && (memcmp(md->MsgId, MQMI_NONE, MQ_MSG_ID_LENGTH) != 0)
+         && (memcmp(md->MsgId, m->md.MsgId, MQ_MSG_ID_LENGTH) != 0) ) continue ;
+       if ( (match & MQMO_MATCH_CORREL_ID) && (memcmp(md->CorrelId, MQCI_NONE, MQ_CORREL_ID_LENGTH) != 0)
+         && (memcmp(md->CorrelId, m->md.CorrelId, MQ_CORREL_ID_LENGTH) != 0) ) continue ;
+       break ;
+      }
+    if ( m != NULL )
+      {
+       pprev = pm ;
+       break ;
+      }
+    if ( (gmo->Options & (MQGMO_MSG_UNDER_CURSOR | MQGMO_BROWSE_MSG_UNDER_CURSOR))
+      || !(gmo->Options & MQGMO_WAIT)
+      || ((gmo->WaitInterval != MQWI_UNLIMITED)
+       && (pthread_cond_timedwait(&mem_cond, &mem_lock, &until) == ETIMEDOUT)) )
+      {
+       *cc = MQCC_FAILED           ;
+       *rc = MQRC_NO_MSG_AVAILABLE ;
+       break ;
+      }
+    if ( gmo->WaitInterval == MQWI_UNLIMITED ) pthread_cond_wait(&mem_cond, &mem_lock) ;
+   }
+
+ if ( pprev != NULL )
+   {
+    m = *pprev ;
+    *datalen = m->length ;
+    memcpy(md, &m->md, mdlen) ;
+    memcpy(buf, m->data, (size_t)( (m->length < buflen) ? m->length : buflen )) ;
+    if ( gmo->Version >= MQGMO_VERSION_3 ) gmo->ReturnedLength = ( m->length < buflen ) ? m->length : buflen ;
+    *cc = ( m->length > buflen ) ? MQCC_WARNING : MQCC_OK ;
+    *rc = ( m->length > buflen ) ? MQRC_TRUNCATED_MSG_ACCEPTED : MQRC_NONE ;
+    if ( (m->length > buflen) && !(gmo->Options & MQGMO_ACCEPT_TRUNCATED_MSG) )
+       *rc = MQRC_TRUNCATED_MSG_FAILED ;  // Left on the queue
+    else
+      {
+       if ( browse ) o->cursor = m->seq ;
+       else
+         {
+          *pprev = m->next ;
+          if ( o->q->last == m )
+            {
+             MEMMSG * p ;
+             for ( p = o->q->first ; (p != NULL) && (p->next != NULL) ; p = p->next ) ;
+             o->q->last = p ;
+            }
+          o->q->depth-- ;
+          free(m) ;
+         }
+      }
+   }
+ pthread_mutex_unlock(&mem_lock) ;
+
+ return ;
+} // End of MQGET
+
+void MQINQ ( MQHCONN    hconn        // Connection handle
+           , MQHOBJ     hobj         // Object handle
+           , MQLONG     selcount     // Selectors
+           , PMQLONG    sels         //   them
+           , MQLONG     intcount     // Integer attributes
+           , PMQLONG    ints         //   them
+           , MQLONG     charlen      // Character attributes length
+           , PMQCHAR    chars        //   them
+           , PMQLONG    cc           // MQ CC
+           , PMQLONG    rc           // MQ RC
+           )
+{
+ MEMOBJ                * o                ;  // The object
+ MQLONG                  ni = 0           ;  // Integers done
+ MQLONG                  nc = 0           ;  // Characters done
+ MQLONG                  len              ;  // Length of one
+ int                     i                ;  // Looper
+
+ pthread_mutex_lock(&mem_lock) ;
+ if ( (o = mem_get_obj(hconn, hobj, cc, rc)) != NULL )
+   for ( i = 0 ; (i < selcount) && (*cc == MQCC_OK) ; i++ )
+     {
+      if ( (sels[i] >= MQCA_FIRST) && (sels[i] <= MQCA_LAST) )
+        {
+         len = ( sels[i] == MQCA_Q_DESC ) ? MQ_Q_DESC_LENGTH : MQ_Q_NAME_LENGTH ;
+         if ( nc + len > charlen )
+           {
+            *cc = MQCC_FAILED               ;
+            *rc = MQRC_CHAR_ATTRS_TOO_SHORT ;
+            break ;
+           }
+         memset(chars + nc, ' ', (size_t) len) ;
+         switch ( sels[i] )
+           {
+            case MQCA_Q_NAME : memcpy(chars + nc, o->q->name, MQ_Q_NAME_LENGTH) ;         break ;
+            case MQCA_Q_DESC : memcpy(chars + nc, "RXMQMEM in-memory queue", 23) ;        break ;
+            default          : *cc = MQCC_FAILED ; *rc = MQRC_SELECTOR_ERROR ;            break ;
+           }
+         nc += len ;
+        }
+      else
+        {
+         if ( ni >= intcount )
+           {
+            *cc = MQCC_FAILED            ;
+            *rc = MQRC_INT_ATTR_COUNT_TOO_SMALL ;
+            break ;
+           }
+         switch ( sels[i] )
+           {
+            case MQIA_CURRENT_Q_DEPTH : ints[ni] = o->q->depth ;          break ;
+            case MQIA_Q_TYPE          : ints[ni] = MQQT_LOCAL  ;          break ;
+            case MQIA_MAX_MSG_LENGTH  : ints[ni] = 4194304     ;          break ;
+            default                   : *cc = MQCC_FAILED ; *rc = MQRC_SELECTOR_ERROR ; break ;
+           }
+         ni++ ;
+        }
+     }
+ pthread_mutex_unlock(&mem_lock) ;
+
+ return ;
+} // End of MQINQ
+
+void MQCMIT ( MQHCONN    hconn        // Connection handle
+            , PMQLONG    cc           // MQ CC
+            , PMQLONG    rc           // MQ RC
+            )
+{
+ (void) hconn ;
+ *cc = MQCC_OK   ;
+ *rc = MQRC_NONE ;
+
+ return ;
+} // End of MQCMIT
+
+void MQBACK ( MQHCONN    hconn        // Connection handle
+            , PMQLONG    cc           // MQ CC
+            , PMQLONG    rc           // MQ RC
+            )
+{
+ (void) hconn ;
+ *cc = MQCC_OK   ;
+ *rc = MQRC_NONE ;
+
+ return ;
+} // End of MQBACK
+
+//
+// The calls not stood in for
+//
+ #define MEM_NOTSUP(cc,rc) { *(cc) = MQCC_FAILED ; *(rc) = MQRC_FUNCTION_NOT_SUPPORTED ; }
+
+void MQSET ( MQHCONN h, MQHOBJ o, MQLONG n, PMQLONG sels, MQLONG ni, PMQLONG ints, MQLONG nc, PMQCHAR chars, PMQLONG cc, PMQLONG rc )
+{
+ (void) h ; (void) o ; (void) n ; (void) sels ; (void) ni ; (void) ints ; (void) nc ; (void) chars ;
+ MEM_NOTSUP(cc, rc) ;
+} // End of MQSET
+
+void MQSUB ( MQHCONN h, PMQVOID sd, PMQHOBJ o, PMQHOBJ s, PMQLONG cc, PMQLONG rc )
+{
+ (void) h ; (void) sd ; (void) o ; (void) s ;
+ MEM_NOTSUP(cc, rc) ;
+} // End of MQSUB
+
+void MQCB ( MQHCONN h, MQLONG op, PMQVOID cbd, MQHOBJ o, PMQVOID md, PMQVOID gmo, PMQLONG cc, PMQLONG rc )
+{
+ (void) h ; (void) op ; (void) cbd ; (void) o ; (void) md ; (void) gmo ;
+ MEM_NOTSUP(cc, rc) ;
+} // End of MQCB
+
+void MQCTL ( MQHCONN h, MQLONG op, PMQVOID ctlo, PMQLONG cc, PMQLONG rc )
+{
+ (void) h ; (void) op ; (void) ctlo ;
+ MEM_NOTSUP(cc, rc) ;
+} // End of MQCTL
+
+void MQSTAT ( MQHCONN h, MQLONG type, PMQVOID sts, PMQLONG cc, PMQLONG rc )
+{
+ (void) h ; (void) type ; (void) sts ;
+ MEM_NOTSUP(cc, rc) ;
+} // End of MQSTAT